@@ -21,6 +21,7 @@
 
 #include <math.h>
 #include "TT-sRGB.h"
+#include "sRGB-transfer.h"
 
 static float	sRGB_to_XYZ_matrix[3][3] = {
     			{  0.4124564,  0.3575761,  0.1804375 },
@@ -41,20 +42,9 @@ gray_to_Y ( TT_gray gray )
  * Use sRGB decoding from gray
  */
 {
-    float   CsRGBf;
-    float   Clinear;
-
     /* don't have to worry about clipping going this direction! */
 
-    CsRGBf = gray / 255.0;
-
-    if ( CsRGBf <= 0.04045 ) {
-	Clinear = CsRGBf / 12.92;
-    } else {
-	Clinear =  pow ( ( CsRGBf + 0.055 ) / ( 1.0 + 0.055 ), 2.4 );
-    }
-
-    return ( Clinear );
+    return ( DeVAS_sRGB_decode_table[gray] );
 }
 
 TT_float
@@ -101,28 +91,9 @@ Y_to_gray ( TT_float Y )
  * Use sRGB encoding for gray value.
  */
 {
-    float   float_value;
-    TT_gray gray_value;
-
-    /* clip going this direction (may need to tone map first!!!) */
+    /* clips (may need to tone map first!!!) */
 
-    if ( Y < 0.0 ) {	/* always a bad thing! */
-	Y = 0.0;
-    }
-
-    if ( Y > 1.0 ) {	/* probably a bad thing! */
-	Y = 1.0;
-    }
-
-    if ( Y <= 0.0031308 ) {
-	float_value = 12.92 * Y;
-    } else {
-	float_value = ( ( 1.0 + 0.055 ) * powf ( Y, 1.0 / 2.4 ) ) - 0.055;
-    }
-
-    gray_value = (int) round ( 255.0 * float_value );
-
-    return ( gray_value );
+    return ( DeVAS_sRGB_encode ( Y ) );
 }
 
 TT_gray
@@ -0,0 +1,465 @@
+/*
+ * Output color spaces.  See devas-color-space.h.
+ *
+ * Primaries from SMPTE EG 432-1 (Display P3) and ITU-R BT.2020.  Display
+ * P3 uses the sRGB transfer function.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include "devas-color-space.h"
+#include "sRGB-transfer.h"
+#include "sRGB_radiance.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+#ifndef	FALSE
+#define	FALSE	0
+#endif
+#ifndef	TRUE
+#define	TRUE	1
+#endif
+
+#define	BT2020_ALPHA	1.09929682680944
+#define	BT2020_BETA	0.018053968510807
+
+#define	ICC_HEADER_SIZE	128
+#define	ICC_N_TAGS	9
+#define	ICC_CURVE_SIZE	1024	/* entries in TRC tables */
+
+const DeVAS_Color_Space DeVAS_color_spaces[] = {
+    { "sRGB", "sRGB IEC61966-2.1", sRGBPRIMS, DeVAS_transfer_sRGB },
+    { "DisplayP3", "Display P3",
+	{ { 0.680, 0.320 }, { 0.265, 0.690 }, { 0.150, 0.060 },
+	    { 0.3127, 0.3290 } },
+	DeVAS_transfer_sRGB },
+    { "Rec2020", "ITU-R BT.2020",
+	{ { 0.708, 0.292 }, { 0.170, 0.797 }, { 0.131, 0.046 },
+	    { 0.3127, 0.3290 } },
+	DeVAS_transfer_BT2020 },
+    { NULL }
+};
+
+const DeVAS_Color_Space *
+DeVAS_color_space_lookup ( char *name )
+{
+    int	    i;
+
+    for ( i = 0; DeVAS_color_spaces[i].name != NULL; i++ ) {
+	if ( strcasecmp ( name, DeVAS_color_spaces[i].name ) == 0 ) {
+	    return ( &DeVAS_color_spaces[i] );
+	}
+    }
+
+    return ( NULL );
+}
+
+void
+DeVAS_color_space_matrix ( const DeVAS_Color_Space *space, COLORMAT matrix )
+{
+    RGBPRIMS	radiance_prims = STDPRIMS;
+    RGBPRIMS	space_prims;
+
+    memcpy ( space_prims, space->primaries, sizeof ( RGBPRIMS ) );
+
+    comprgb2rgbWBmat ( matrix, radiance_prims, space_prims );
+}
+
+static double
+BT2020_decode ( double V )
+{
+    if ( V < 4.5 * BT2020_BETA ) {
+	return ( V / 4.5 );
+    } else {
+	return ( pow ( ( V + ( BT2020_ALPHA - 1.0 ) ) / BT2020_ALPHA,
+		    1.0 / 0.45 ) );
+    }
+}
+
+static int
+BT2020_reference_encode ( float Y )
+{
+    double  V;
+
+    if ( isnan ( Y ) ) {
+	return ( 0 );
+    }
+
+    if ( Y < 0.0 ) {
+	Y = 0.0;
+    }
+
+    if ( Y > 1.0 ) {
+	Y = 1.0;
+    }
+
+    if ( Y < BT2020_BETA ) {
+	V = 4.5 * Y;
+    } else {
+	V = ( BT2020_ALPHA * pow ( Y, 0.45 ) ) - ( BT2020_ALPHA - 1.0 );
+    }
+
+    return ( (int) round ( 255.0 * V ) );
+}
+
+static float
+float_from_bits ( uint32_t bits )
+{
+    float   value;
+
+    memcpy ( &value, &bits, sizeof ( value ) );
+
+    return ( value );
+}
+
+static void
+BT2020_make_thresholds ( float thresholds[256] )
+/*
+ * thresholds[gray] is the smallest non-negative float that encodes to
+ * gray or higher, found by bisection on the bit patterns (which order the
+ * same way as the values), as in sRGB-transfer.c.
+ */
+{
+    int		gray;
+    uint32_t	low, high, middle;
+
+    thresholds[0] = 0.0;
+
+    for ( gray = 1; gray < 256; gray++ ) {
+	low = 0;
+	high = 0x3f800000;	/* 1.0 */
+	while ( low < high ) {
+	    middle = low + ( ( high - low ) / 2 );
+	    if ( BT2020_reference_encode ( float_from_bits ( middle ) )
+		    >= gray ) {
+		high = middle;
+	    } else {
+		low = middle + 1;
+	    }
+	}
+	thresholds[gray] = float_from_bits ( low );
+    }
+}
+
+uint8_t
+DeVAS_transfer_encode ( DeVAS_Transfer transfer, float Y )
+{
+    static float    BT2020_thresholds[256];
+    static int	    BT2020_thresholds_made = FALSE;
+    int		    low, high, middle;
+
+    switch ( transfer ) {
+	case DeVAS_transfer_sRGB:
+	    return ( DeVAS_sRGB_encode ( Y ) );
+
+	case DeVAS_transfer_BT2020:
+	    if ( !BT2020_thresholds_made ) {
+		BT2020_make_thresholds ( BT2020_thresholds );
+		BT2020_thresholds_made = TRUE;
+	    }
+
+	    if ( !( Y >= BT2020_thresholds[1] ) ) {	/* includes NaN */
+		return ( 0 );
+	    }
+	    if ( Y >= BT2020_thresholds[255] ) {
+		return ( 255 );
+	    }
+
+	    /* largest gray with BT2020_thresholds[gray] <= Y */
+	    low = 1;
+	    high = 254;
+	    while ( low < high ) {
+		middle = ( low + high + 1 ) / 2;
+		if ( BT2020_thresholds[middle] <= Y ) {
+		    low = middle;
+		} else {
+		    high = middle - 1;
+		}
+	    }
+	    return ( low );
+
+	default:
+	    fprintf ( stderr, "DeVAS_transfer_encode: invalid transfer!\n" );
+	    exit ( EXIT_FAILURE );
+    }
+}
+
+static double
+transfer_decode ( DeVAS_Transfer transfer, double V )
+{
+    if ( transfer == DeVAS_transfer_BT2020 ) {
+	return ( BT2020_decode ( V ) );
+    }
+
+    if ( V <= 0.04045 ) {
+	return ( V / 12.92 );
+    } else {
+	return ( pow ( ( V + 0.055 ) / ( 1.0 + 0.055 ), 2.4 ) );
+    }
+}
+
+/*
+ * ICC profile construction.  Everything in a profile is big-endian.
+ */
+
+static void
+icc_put_uint32 ( unsigned char *p, uint32_t value )
+{
+    p[0] = ( value >> 24 ) & 0xff;
+    p[1] = ( value >> 16 ) & 0xff;
+    p[2] = ( value >> 8 ) & 0xff;
+    p[3] = value & 0xff;
+}
+
+static void
+icc_put_uint16 ( unsigned char *p, unsigned int value )
+{
+    p[0] = ( value >> 8 ) & 0xff;
+    p[1] = value & 0xff;
+}
+
+static void
+icc_put_signature ( unsigned char *p, char *signature )
+{
+    memcpy ( p, signature, 4 );
+}
+
+static void
+icc_put_s15Fixed16 ( unsigned char *p, double value )
+{
+    icc_put_uint32 ( p, (uint32_t) (int32_t) lround ( value * 65536.0 ) );
+}
+
+static void
+icc_put_XYZ ( unsigned char *p, double XYZ[3] )
+{
+    icc_put_s15Fixed16 ( p, XYZ[0] );
+    icc_put_s15Fixed16 ( p + 4, XYZ[1] );
+    icc_put_s15Fixed16 ( p + 8, XYZ[2] );
+}
+
+static void
+invert3 ( double inverse[3][3], double m[3][3] )
+{
+    double  determinant;
+    int	    i, j;
+
+    inverse[0][0] = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+    inverse[0][1] = m[0][2] * m[2][1] - m[0][1] * m[2][2];
+    inverse[0][2] = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+    inverse[1][0] = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+    inverse[1][1] = m[0][0] * m[2][2] - m[0][2] * m[2][0];
+    inverse[1][2] = m[0][2] * m[1][0] - m[0][0] * m[1][2];
+    inverse[2][0] = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+    inverse[2][1] = m[0][1] * m[2][0] - m[0][0] * m[2][1];
+    inverse[2][2] = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+
+    determinant = m[0][0] * inverse[0][0] + m[0][1] * inverse[1][0] +
+	m[0][2] * inverse[2][0];
+
+    for ( i = 0; i < 3; i++ ) {
+	for ( j = 0; j < 3; j++ ) {
+	    inverse[i][j] /= determinant;
+	}
+    }
+}
+
+static void
+multiply3 ( double product[3][3], double m1[3][3], double m2[3][3] )
+{
+    int	    i, j, k;
+
+    for ( i = 0; i < 3; i++ ) {
+	for ( j = 0; j < 3; j++ ) {
+	    product[i][j] = 0.0;
+	    for ( k = 0; k < 3; k++ ) {
+		product[i][j] += m1[i][k] * m2[k][j];
+	    }
+	}
+    }
+}
+
+static void
+xy_to_XYZ ( double XYZ[3], const float xy[2] )
+/*
+ * Y = 1.0.
+ */
+{
+    XYZ[0] = xy[0] / xy[1];
+    XYZ[1] = 1.0;
+    XYZ[2] = ( 1.0 - xy[0] - xy[1] ) / xy[1];
+}
+
+static void
+colorants_D50 ( const DeVAS_Color_Space *space, double colorants[3][3] )
+/*
+ * RGB to XYZ for the primaries of space, with white at Y = 1.0, then
+ * chromatically adapted to the D50 profile connection space with the
+ * Bradford transform.  Column i is the XYZ of primary i.
+ */
+{
+    static double   bradford[3][3] = {
+	{  0.8951,  0.2664, -0.1614 },
+	{ -0.7502,  1.7135,  0.0367 },
+	{  0.0389, -0.0685,  1.0296 }
+    };
+    double	    D50[3] = { 0.9642, 1.0, 0.8249 };
+    double	    primaries[3][3], inverse[3][3], rgb2xyz[3][3];
+    double	    white[3], scale[3];
+    double	    white_cone[3], D50_cone[3];
+    double	    adapt[3][3], bradford_inverse[3][3], temp[3][3];
+    int		    i, j;
+
+    for ( j = 0; j < 3; j++ ) {
+	xy_to_XYZ ( white, space->primaries[j] );
+	for ( i = 0; i < 3; i++ ) {
+	    primaries[i][j] = white[i];
+	}
+    }
+    xy_to_XYZ ( white, space->primaries[WHT] );
+
+    invert3 ( inverse, primaries );
+    for ( i = 0; i < 3; i++ ) {
+	scale[i] = inverse[i][0] * white[0] + inverse[i][1] * white[1] +
+	    inverse[i][2] * white[2];
+    }
+    for ( i = 0; i < 3; i++ ) {
+	for ( j = 0; j < 3; j++ ) {
+	    rgb2xyz[i][j] = primaries[i][j] * scale[j];
+	}
+    }
+
+    memset ( adapt, 0, sizeof ( adapt ) );
+    for ( i = 0; i < 3; i++ ) {
+	white_cone[i] = bradford[i][0] * white[0] + bradford[i][1] * white[1] +
+	    bradford[i][2] * white[2];
+	D50_cone[i] = bradford[i][0] * D50[0] + bradford[i][1] * D50[1] +
+	    bradford[i][2] * D50[2];
+	adapt[i][i] = D50_cone[i] / white_cone[i];
+    }
+    invert3 ( bradford_inverse, bradford );
+    multiply3 ( temp, adapt, bradford );
+    multiply3 ( adapt, bradford_inverse, temp );
+
+    multiply3 ( colorants, adapt, rgb2xyz );
+}
+
+unsigned char *
+DeVAS_color_space_icc_profile ( const DeVAS_Color_Space *space,
+	unsigned int *length )
+/*
+ * Tags desc, cprt, wtpt, [rgb]XYZ, and [rgb]TRC, with the three TRC tags
+ * sharing one curveType table.
+ */
+{
+    char	    *copyright = "No copyright, use freely";
+    double	    D50[3] = { 0.9642, 1.0, 0.8249 };
+    double	    colorants[3][3];
+    double	    XYZ[3];
+    unsigned char   *profile;
+    unsigned char   *tag;
+    unsigned int    desc_size, cprt_size, XYZ_size, curv_size;
+    unsigned int    offset;
+    int		    i;
+
+    if ( strcmp ( space->name, "sRGB" ) == 0 ) {
+	*length = 0;
+	return ( NULL );
+    }
+
+    /* textDescriptionType */
+    desc_size = 12 + strlen ( space->description ) + 1 + 8 + 3 + 67;
+    desc_size = ( desc_size + 3 ) & ~3;
+    /* textType */
+    cprt_size = 8 + strlen ( copyright ) + 1;
+    cprt_size = ( cprt_size + 3 ) & ~3;
+    /* XYZType */
+    XYZ_size = 20;
+    /* curveType */
+    curv_size = 12 + 2 * ICC_CURVE_SIZE;
+
+    *length = ICC_HEADER_SIZE + 4 + ( 12 * ICC_N_TAGS ) + desc_size +
+	cprt_size + ( 4 * XYZ_size ) + curv_size;
+
+    profile = (unsigned char *) calloc ( *length, 1 );
+    if ( profile == NULL ) {
+	fprintf ( stderr, "DeVAS_color_space_icc_profile: calloc failed!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    /* header */
+    icc_put_uint32 ( profile, *length );
+    icc_put_uint32 ( profile + 8, 0x02100000 );	/* version 2.1 */
+    icc_put_signature ( profile + 12, "mntr" );
+    icc_put_signature ( profile + 16, "RGB " );
+    icc_put_signature ( profile + 20, "XYZ " );
+    icc_put_signature ( profile + 36, "acsp" );
+    icc_put_uint32 ( profile + 64, 0 );		/* perceptual */
+    icc_put_XYZ ( profile + 68, D50 );
+
+    /* tag table, followed by the tag data */
+    icc_put_uint32 ( profile + ICC_HEADER_SIZE, ICC_N_TAGS );
+    tag = profile + ICC_HEADER_SIZE + 4;
+    offset = ICC_HEADER_SIZE + 4 + ( 12 * ICC_N_TAGS );
+
+    icc_put_signature ( tag, "desc" );
+    icc_put_uint32 ( tag + 4, offset );
+    icc_put_uint32 ( tag + 8, desc_size );
+    icc_put_signature ( profile + offset, "desc" );
+    icc_put_uint32 ( profile + offset + 8,
+	    strlen ( space->description ) + 1 );
+    strcpy ( (char *) profile + offset + 12, space->description );
+    tag += 12;
+    offset += desc_size;
+
+    icc_put_signature ( tag, "cprt" );
+    icc_put_uint32 ( tag + 4, offset );
+    icc_put_uint32 ( tag + 8, cprt_size );
+    icc_put_signature ( profile + offset, "text" );
+    strcpy ( (char *) profile + offset + 8, copyright );
+    tag += 12;
+    offset += cprt_size;
+
+    icc_put_signature ( tag, "wtpt" );
+    icc_put_uint32 ( tag + 4, offset );
+    icc_put_uint32 ( tag + 8, XYZ_size );
+    icc_put_signature ( profile + offset, "XYZ " );
+    xy_to_XYZ ( XYZ, space->primaries[WHT] );
+    icc_put_XYZ ( profile + offset + 8, XYZ );
+    tag += 12;
+    offset += XYZ_size;
+
+    colorants_D50 ( space, colorants );
+    for ( i = 0; i < 3; i++ ) {
+	icc_put_signature ( tag, i == 0 ? "rXYZ" : ( i == 1 ? "gXYZ" :
+		    "bXYZ" ) );
+	icc_put_uint32 ( tag + 4, offset );
+	icc_put_uint32 ( tag + 8, XYZ_size );
+	icc_put_signature ( profile + offset, "XYZ " );
+	XYZ[0] = colorants[0][i];
+	XYZ[1] = colorants[1][i];
+	XYZ[2] = colorants[2][i];
+	icc_put_XYZ ( profile + offset + 8, XYZ );
+	tag += 12;
+	offset += XYZ_size;
+    }
+
+    for ( i = 0; i < 3; i++ ) {
+	icc_put_signature ( tag, i == 0 ? "rTRC" : ( i == 1 ? "gTRC" :
+		    "bTRC" ) );
+	icc_put_uint32 ( tag + 4, offset );
+	icc_put_uint32 ( tag + 8, curv_size );
+	tag += 12;
+    }
+    icc_put_signature ( profile + offset, "curv" );
+    icc_put_uint32 ( profile + offset + 8, ICC_CURVE_SIZE );
+    for ( i = 0; i < ICC_CURVE_SIZE; i++ ) {
+	icc_put_uint16 ( profile + offset + 12 + ( 2 * i ),
+		lround ( 65535.0 * transfer_decode ( space->transfer,
+			(double) i / ( ICC_CURVE_SIZE - 1 ) ) ) );
+    }
+
+    return ( profile );
+}
@@ -0,0 +1,71 @@
+/*
+ * Output color spaces for 8 bit images: sRGB, Display P3, and ITU-R
+ * BT.2020.  All three are RGB primaries plus a per-channel transfer
+ * function, so a conversion from Radiance RGB is a 3x3 matrix followed
+ * by 1-D encoding, which is exact and costs the same for each space.
+ *
+ *   DeVAS_color_space_lookup ( <name> )
+ *
+ *	The color space with the given name (case is ignored), or NULL if
+ *	there is none.  Names are "sRGB", "DisplayP3", and "Rec2020".
+ *	DeVAS_color_spaces lists them all, ending with a NULL name.
+ *
+ *   DeVAS_color_space_matrix ( <space>, <COLORMAT> )
+ *
+ *	Radiance RGB (STDPRIMS) to linear RGB in the primaries of space,
+ *	white balanced, as comprgb2rgbWBmat.
+ *
+ *   DeVAS_transfer_encode ( <transfer>, <float> )
+ *
+ *	8 bit value for a linear value, clipped to [0.0 -- 1.0] (NaN
+ *	encodes as 0).  The same as DeVAS_sRGB_encode for
+ *	DeVAS_transfer_sRGB.  DeVAS_transfer_BT2020 uses the BT.2020 OETF,
+ *	looked up in a table of the 255 decision thresholds, built on first
+ *	use from the direct computation.
+ *
+ *   DeVAS_color_space_icc_profile ( <space>, &<length> )
+ *
+ *	A malloc'ed ICC version 2 matrix/TRC display profile for space, or
+ *	NULL for sRGB, for which the JPEG and PNG writers already have a
+ *	profile (or sRGB chunk) of their own.
+ */
+
+#ifndef __DeVAS_COLOR_SPACE_H
+#define __DeVAS_COLOR_SPACE_H
+
+#include <stdint.h>
+#include "radiance/color.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+typedef enum {
+    DeVAS_transfer_sRGB,
+    DeVAS_transfer_BT2020
+} DeVAS_Transfer;
+
+typedef struct {
+    char	    *name;		/* as given to --colorspace= */
+    char	    *description;	/* ICC profile description */
+    RGBPRIMS	    primaries;
+    DeVAS_Transfer  transfer;
+} DeVAS_Color_Space;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern const DeVAS_Color_Space	DeVAS_color_spaces[];
+
+const DeVAS_Color_Space	*DeVAS_color_space_lookup ( char *name );
+void			DeVAS_color_space_matrix (
+			    const DeVAS_Color_Space *space, COLORMAT matrix );
+uint8_t			DeVAS_transfer_encode ( DeVAS_Transfer transfer,
+			    float Y );
+unsigned char		*DeVAS_color_space_icc_profile (
+			    const DeVAS_Color_Space *space,
+			    unsigned int *length );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __DeVAS_COLOR_SPACE_H */
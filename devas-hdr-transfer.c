@@ -0,0 +1,303 @@
+/*
+ * PQ and HLG encoding.  See devas-hdr-transfer.h.
+ *
+ * Constants from SMPTE ST 2084 and ITU-R BT.2100.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include "devas-hdr-transfer.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+#define	PQ_M1		( 2610.0 / 16384.0 )
+#define	PQ_M2		( 2523.0 / 4096.0 * 128.0 )
+#define	PQ_C1		( 3424.0 / 4096.0 )
+#define	PQ_C2		( 2413.0 / 4096.0 * 32.0 )
+#define	PQ_C3		( 2392.0 / 4096.0 * 32.0 )
+
+#define	HLG_A		0.17883277
+#define	HLG_B		0.28466892	/* 1 - 4 * HLG_A */
+#define	HLG_C		0.55991073	/* 0.5 - HLG_A * ln ( 4 * HLG_A ) */
+
+/* BT.2020 luminance */
+#define	BT2020_Y_R	0.2627
+#define	BT2020_Y_G	0.6780
+#define	BT2020_Y_B	0.0593
+
+/*
+ * Tables cover [2^-DeVAS_HDR_OCTAVES, 1.0], indexed by float bits
+ * shifted right DeVAS_HDR_SHIFT.  Smaller values are treated as 0.0
+ * (PQ at 2^-48 is less than one code value).
+ */
+#define	DeVAS_HDR_SHIFT		16
+#define	DeVAS_HDR_OCTAVES	48
+#define	DeVAS_HDR_FIRST		( ( 127 - DeVAS_HDR_OCTAVES ) << 7 )
+#define	DeVAS_HDR_N		( DeVAS_HDR_OCTAVES << 7 )	/* buckets */
+#define	DeVAS_HDR_MIN		( 1.0 / ( 1ULL << DeVAS_HDR_OCTAVES ) )
+
+typedef struct {
+    float   zero;			/* value for inputs below the table */
+    float   values[DeVAS_HDR_N + 1];	/* at the start of each bucket, */
+					/* and at 1.0 */
+} DeVAS_HDR_Curve;
+
+static double
+PQ_reference ( double Y )
+/*
+ * Y is luminance / DeVAS_PQ_PEAK.  Result in code values.
+ */
+{
+    double  Y_m1;
+
+    Y_m1 = pow ( Y, PQ_M1 );
+
+    return ( 65535.0 * pow ( ( PQ_C1 + PQ_C2 * Y_m1 ) / ( 1.0 + PQ_C3 * Y_m1 ),
+		PQ_M2 ) );
+}
+
+static double
+HLG_reference ( double E )
+/*
+ * E is scene light in [0,1].  Result in code values.
+ */
+{
+    if ( E <= 1.0 / 12.0 ) {
+	return ( 65535.0 * sqrt ( 3.0 * E ) );
+    } else {
+	return ( 65535.0 * ( HLG_A * log ( 12.0 * E - HLG_B ) + HLG_C ) );
+    }
+}
+
+static double
+OOTF_inverse_reference ( double Y )
+/*
+ * Scene / display light ratio for normalized display luminance Y.
+ */
+{
+    return ( pow ( Y, ( 1.0 - DeVAS_HLG_GAMMA ) / DeVAS_HLG_GAMMA ) );
+}
+
+static float
+float_from_bits ( uint32_t bits )
+{
+    float   value;
+
+    memcpy ( &value, &bits, sizeof ( value ) );
+
+    return ( value );
+}
+
+static void
+DeVAS_hdr_curve_make ( DeVAS_HDR_Curve *curve, double (*f) ( double ) )
+{
+    int	    i;
+
+    curve->zero = f ( 0.0 );
+    for ( i = 0; i <= DeVAS_HDR_N; i++ ) {
+	curve->values[i] = f ( float_from_bits ( ( DeVAS_HDR_FIRST + i ) <<
+		    DeVAS_HDR_SHIFT ) );
+    }
+}
+
+static float
+DeVAS_hdr_curve_eval ( const DeVAS_HDR_Curve *curve, float x )
+{
+    uint32_t	bits;
+    int		i;
+    float	fraction;
+
+    if ( !( x >= DeVAS_HDR_MIN ) ) {	/* includes NaN */
+	return ( curve->zero );
+    }
+    if ( x >= 1.0 ) {
+	return ( curve->values[DeVAS_HDR_N] );
+    }
+
+    memcpy ( &bits, &x, sizeof ( bits ) );
+    i = ( bits >> DeVAS_HDR_SHIFT ) - DeVAS_HDR_FIRST;
+    fraction = ( bits & ( ( 1 << DeVAS_HDR_SHIFT ) - 1 ) ) *
+	( 1.0f / ( 1 << DeVAS_HDR_SHIFT ) );
+
+    return ( curve->values[i] +
+	    fraction * ( curve->values[i + 1] - curve->values[i] ) );
+}
+
+static DeVAS_HDR_Curve	PQ_curve;
+static DeVAS_HDR_Curve	HLG_curve;
+static DeVAS_HDR_Curve	OOTF_inverse_curve;
+static int		curves_made = FALSE;
+
+static void
+DeVAS_hdr_make_curves ( void )
+{
+    if ( !curves_made ) {
+	DeVAS_hdr_curve_make ( &PQ_curve, PQ_reference );
+	DeVAS_hdr_curve_make ( &HLG_curve, HLG_reference );
+	DeVAS_hdr_curve_make ( &OOTF_inverse_curve, OOTF_inverse_reference );
+	curves_made = TRUE;
+    }
+}
+
+static uint16_t
+code_value ( float value )
+{
+    if ( !( value > 0.0 ) ) {
+	return ( 0 );
+    }
+    if ( value >= 65535.0 ) {
+	return ( 65535 );
+    }
+
+    return ( (uint16_t) ( value + 0.5 ) );
+}
+
+int
+DeVAS_hdr_transfer_lookup ( char *name, DeVAS_HDR_Transfer *transfer )
+{
+    if ( strcasecmp ( name, "PQ" ) == 0 ) {
+	*transfer = DeVAS_hdr_PQ;
+	return ( TRUE );
+    } else if ( strcasecmp ( name, "HLG" ) == 0 ) {
+	*transfer = DeVAS_hdr_HLG;
+	return ( TRUE );
+    }
+
+    return ( FALSE );
+}
+
+int
+DeVAS_hdr_cicp_transfer ( DeVAS_HDR_Transfer transfer )
+{
+    return ( transfer == DeVAS_hdr_PQ ? 16 : 18 );
+}
+
+void
+DeVAS_hdr_encode_row ( DeVAS_HDR_Transfer transfer, const DeVAS_RGBf *src,
+	uint16_t *dst, int n )
+{
+    int	    i;
+    float   red, green, blue;
+    float   Y, ratio;
+
+    DeVAS_hdr_make_curves ( );
+
+    if ( transfer == DeVAS_hdr_PQ ) {
+	for ( i = 0; i < n; i++ ) {
+	    dst[3 * i] = code_value ( DeVAS_hdr_curve_eval ( &PQ_curve,
+			src[i].red * ( 1.0f / DeVAS_PQ_PEAK ) ) );
+	    dst[3 * i + 1] = code_value ( DeVAS_hdr_curve_eval ( &PQ_curve,
+			src[i].green * ( 1.0f / DeVAS_PQ_PEAK ) ) );
+	    dst[3 * i + 2] = code_value ( DeVAS_hdr_curve_eval ( &PQ_curve,
+			src[i].blue * ( 1.0f / DeVAS_PQ_PEAK ) ) );
+	}
+    } else {
+	for ( i = 0; i < n; i++ ) {
+	    /* display light, normalized and clipped to >= 0 */
+	    red = fmaxf ( src[i].red * ( 1.0f / DeVAS_HLG_PEAK ), 0.0f );
+	    green = fmaxf ( src[i].green * ( 1.0f / DeVAS_HLG_PEAK ), 0.0f );
+	    blue = fmaxf ( src[i].blue * ( 1.0f / DeVAS_HLG_PEAK ), 0.0f );
+	    Y = BT2020_Y_R * red + BT2020_Y_G * green + BT2020_Y_B * blue;
+
+	    /* inverse OOTF to scene light */
+	    if ( !( Y >= DeVAS_HDR_MIN ) ) {
+		ratio = 0.0;
+	    } else if ( Y > 1.0 ) {
+		ratio = OOTF_inverse_reference ( Y );	/* brighter than peak */
+	    } else {
+		ratio = DeVAS_hdr_curve_eval ( &OOTF_inverse_curve, Y );
+	    }
+
+	    dst[3 * i] = code_value ( DeVAS_hdr_curve_eval ( &HLG_curve,
+			red * ratio ) );
+	    dst[3 * i + 1] = code_value ( DeVAS_hdr_curve_eval ( &HLG_curve,
+			green * ratio ) );
+	    dst[3 * i + 2] = code_value ( DeVAS_hdr_curve_eval ( &HLG_curve,
+			blue * ratio ) );
+	}
+    }
+}
+
+#ifdef	DeVAS_HDR_CHECK_TABLES
+
+static uint16_t
+reference_code_value ( double value )
+{
+    if ( !( value > 0.0 ) ) {
+	return ( 0 );
+    }
+    if ( value >= 65535.0 ) {
+	return ( 65535 );
+    }
+
+    return ( (uint16_t) round ( value ) );
+}
+
+int
+main ( int argc, char *argv[] )
+/*
+ * Compare table lookup against the direct computation for every 16th
+ * float in [0,1] (PQ and HLG curves) and for a range of gray and colored
+ * HLG pixels (including the inverse OOTF).
+ */
+{
+    uint32_t	bits;
+    double	x;
+    int		difference, max_PQ, max_HLG, max_pixel;
+    DeVAS_RGBf	pixel;
+    uint16_t	code[3];
+    double	Y, ratio, channel[3];
+    int		i, c;
+
+    DeVAS_hdr_make_curves ( );
+
+    max_PQ = max_HLG = max_pixel = 0;
+    for ( bits = 0; bits <= 0x3f800000; bits += 16 ) {
+	x = float_from_bits ( bits );
+	difference = abs ( (int) code_value ( DeVAS_hdr_curve_eval ( &PQ_curve,
+			    x ) ) - (int) reference_code_value (
+			    PQ_reference ( x ) ) );
+	if ( difference > max_PQ ) {
+	    max_PQ = difference;
+	}
+	difference = abs ( (int) code_value ( DeVAS_hdr_curve_eval (
+			    &HLG_curve, x ) ) - (int) reference_code_value (
+			    HLG_reference ( x ) ) );
+	if ( difference > max_HLG ) {
+	    max_HLG = difference;
+	}
+    }
+
+    srand ( 1 );
+    for ( i = 0; i < 10000000; i++ ) {
+	pixel.red = DeVAS_HLG_PEAK * pow ( 2.0, -30.0 * rand ( ) / RAND_MAX );
+	pixel.green = DeVAS_HLG_PEAK * pow ( 2.0, -30.0 * rand ( ) / RAND_MAX );
+	pixel.blue = DeVAS_HLG_PEAK * pow ( 2.0, -30.0 * rand ( ) / RAND_MAX );
+	DeVAS_hdr_encode_row ( DeVAS_hdr_HLG, &pixel, code, 1 );
+
+	channel[0] = pixel.red / DeVAS_HLG_PEAK;
+	channel[1] = pixel.green / DeVAS_HLG_PEAK;
+	channel[2] = pixel.blue / DeVAS_HLG_PEAK;
+	Y = BT2020_Y_R * channel[0] + BT2020_Y_G * channel[1] +
+	    BT2020_Y_B * channel[2];
+	ratio = OOTF_inverse_reference ( Y );
+	for ( c = 0; c < 3; c++ ) {
+	    x = fmin ( channel[c] * ratio, 1.0 );
+	    difference = abs ( (int) code[c] - (int) reference_code_value (
+			HLG_reference ( x ) ) );
+	    if ( difference > max_pixel ) {
+		max_pixel = difference;
+	    }
+	}
+    }
+
+    fprintf ( stderr, "maximum difference: PQ %d, HLG %d, HLG pixels %d\n",
+	    max_PQ, max_HLG, max_pixel );
+
+    return ( ( max_PQ <= 1 && max_HLG <= 1 && max_pixel <= 1 ) ?
+	    EXIT_SUCCESS : EXIT_FAILURE );
+}
+
+#endif	/* DeVAS_HDR_CHECK_TABLES */
@@ -0,0 +1,68 @@
+/*
+ * 16 bit HDR encodings: SMPTE ST 2084 (PQ) and ITU-R BT.2100 hybrid
+ * log-gamma (HLG), from absolute luminance.
+ *
+ *   DeVAS_hdr_transfer_lookup ( <name>, &<transfer> )
+ *
+ *	TRUE and sets transfer if name is "PQ" or "HLG" (case is ignored),
+ *	otherwise FALSE.
+ *
+ *   DeVAS_hdr_encode_row ( <transfer>, <src>, <dst>, n )
+ *
+ *	Encodes n pixels of linear BT.2020 RGB in cd/m^2 as 3 * n 16 bit
+ *	values (full range).  PQ covers 0 -- DeVAS_PQ_PEAK cd/m^2.  HLG is
+ *	relative to a DeVAS_HLG_PEAK cd/m^2 display: the BT.2100 inverse
+ *	OOTF (system gamma DeVAS_HLG_GAMMA) gives scene light, which is then
+ *	HLG encoded.  Values out of range are clipped.
+ *
+ *   DeVAS_hdr_cicp_transfer ( <transfer> )
+ *
+ *	The ITU-T H.273 transfer characteristics code (as in the PNG cICP
+ *	chunk): 16 for PQ, 18 for HLG.  The matching primaries code for
+ *	BT.2020 is DeVAS_CICP_BT2020.
+ *
+ * The curves are evaluated through tables rather than with pow and log:
+ * the table index is the high-order bits (exponent and 7 bits of
+ * mantissa) of the float value, with linear interpolation on the rest.
+ * The tables are built on first use.  Compiling devas-hdr-transfer.c with
+ * DeVAS_HDR_CHECK_TABLES defined gives a program that compares the tables
+ * with the direct computation (a difference of at most one 16 bit code
+ * value):
+ *
+ *   cc -O2 -DDeVAS_HDR_CHECK_TABLES -I. -Iradiance -o check-hdr \
+ *	    devas-hdr-transfer.c -lm
+ *   ./check-hdr
+ */
+
+#ifndef __DeVAS_HDR_TRANSFER_H
+#define __DeVAS_HDR_TRANSFER_H
+
+#include <stdint.h>
+#include "devas-image.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+#define	DeVAS_PQ_PEAK		10000.0	/* cd/m^2 */
+#define	DeVAS_HLG_PEAK		1000.0	/* cd/m^2, nominal display peak */
+#define	DeVAS_HLG_GAMMA		1.2	/* system gamma for DeVAS_HLG_PEAK */
+
+#define	DeVAS_CICP_BT2020	9	/* H.273 colour primaries */
+
+typedef enum {
+    DeVAS_hdr_PQ,
+    DeVAS_hdr_HLG
+} DeVAS_HDR_Transfer;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int	DeVAS_hdr_transfer_lookup ( char *name, DeVAS_HDR_Transfer *transfer );
+void	DeVAS_hdr_encode_row ( DeVAS_HDR_Transfer transfer,
+	    const DeVAS_RGBf *src, uint16_t *dst, int n );
+int	DeVAS_hdr_cicp_transfer ( DeVAS_HDR_Transfer transfer );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __DeVAS_HDR_TRANSFER_H */
@@ -0,0 +1,22 @@
+/*
+ * Parallel loops over image pixels for the DeVAS pixel types.  See
+ * devas-image-map.h.  (The TT pixel types are in devas-tt-image.c.)
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "devas-image.h"
+#include "devas-parallel.h"
+#include "devas-image-map.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+DeVAS_DEFINE_IMAGE_MAP ( DeVAS_gray, DeVAS_image_modified )
+DeVAS_DEFINE_IMAGE_MAP ( DeVAS_float, DeVAS_image_modified )
+DeVAS_DEFINE_IMAGE_MAP ( DeVAS_double, DeVAS_image_modified )
+DeVAS_DEFINE_IMAGE_MAP ( DeVAS_RGB, DeVAS_image_modified )
+DeVAS_DEFINE_IMAGE_MAP ( DeVAS_RGBf, DeVAS_image_modified )
+DeVAS_DEFINE_IMAGE_MAP ( DeVAS_XYZ, DeVAS_image_modified )
+DeVAS_DEFINE_IMAGE_MAP ( DeVAS_xyY, DeVAS_image_modified )
+DeVAS_DEFINE_IMAGE_MAP ( DeVAS_complexf, DeVAS_image_modified )
+/* DeVAS_DEFINE_IMAGE_MAP ( DeVAS_complexd, DeVAS_image_modified ) */
@@ -0,0 +1,296 @@
+/*
+ * Parallel loops over the pixels of an image, for each DeVAS and TT
+ * (devas-tt-image.h) pixel type, on the worker pool of devas-parallel.h.
+ *
+ * The work is split into bands of rows (DeVAS_parallel_band_rows).
+ * Functions are called on spans: a pointer to the first of n adjacent
+ * pixels.  A band of rows that are adjacent in memory is passed as a
+ * single span, otherwise each row is a span, so the inner loop is a plain
+ * loop over an array that the compiler can vectorize.  Spans of different
+ * bands are processed concurrently, so functions should only write the
+ * pixels they are given (and, for reductions, their partial result).
+ *
+ *   <type>_image_map ( <image>, <function>, <context> )
+ *
+ *	Calls function ( context, span, n ) on every pixel of image, in
+ *	place, and then marks image as modified.
+ *
+ *   <type>_image_map2 ( <src>, <dst>, <function>, <context> )
+ *
+ *	Calls function ( context, src_span, dst_span, n ) on corresponding
+ *	spans of two images of the same size, and then marks dst as
+ *	modified.  dst may be src.
+ *
+ *   <type>_image_reduce ( <image>, <function>, <combine>, <context>,
+ *	    <result>, <result_size> )
+ *
+ *	*result (result_size bytes) holds the initial value of the
+ *	reduction on entry (e.g., 0.0 for a sum).  Each band starts a
+ *	partial result as a copy of it, and calls function ( context,
+ *	partial, span, n ) for each of its spans.  The partial results are
+ *	then folded into *result with combine ( context, result, partial ),
+ *	in band order.  The bands depend only on the image size, so the
+ *	answer is the same for any number of threads.
+ *
+ *   <type>_image_rowband_for ( <image>, <function>, <context> )
+ *
+ *	Calls function ( context, image, first_row, n_rows ) for each band
+ *	of rows, for loops that need more than a span (neighboring rows,
+ *	other images, or the row index).  Call DeVAS_image_modified (or
+ *	TT_image_modified) afterward if pixels were changed.
+ *
+ * for <type> = DeVAS_gray, DeVAS_float, DeVAS_double, DeVAS_RGB,
+ * DeVAS_RGBf, DeVAS_XYZ, DeVAS_xyY, DeVAS_complexf, and TT_gray, TT_float,
+ * TT_RGB, TT_RGBf, TT_XYZ, TT_xyY.
+ *
+ * The functions may themselves call these loops, which then run serially
+ * on the calling thread.  Any tables a function builds on first use
+ * should be built before the loop.
+ */
+
+#ifndef __DeVAS_IMAGE_MAP_H
+#define __DeVAS_IMAGE_MAP_H
+
+#include <stdlib.h>
+#include <string.h>
+#include "devas-image.h"
+#include "devas-parallel.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+typedef void (*DeVAS_Combine_Function) ( void *context, void *result,
+	    const void *partial );
+
+/* TRUE if rows first_row ... first_row + n_rows - 1 are adjacent */
+#define	DeVAS_image_rows_adjacent(image,first_row,n_rows)		\
+		( (image)->data[(first_row) + (n_rows) - 1] ==		\
+		    (image)->data[first_row] +				\
+		    (size_t) ( (n_rows) - 1 ) * (image)->n_cols )
+
+#define DeVAS_PROTOTYPE_IMAGE_MAP( TYPE )				\
+typedef void (*TYPE##_span_function) ( void *context, TYPE *span,	\
+	    int n );							\
+typedef void (*TYPE##_span2_function) ( void *context,			\
+	    const TYPE *src_span, TYPE *dst_span, int n );		\
+typedef void (*TYPE##_reduce_function) ( void *context, void *partial,	\
+	    const TYPE *span, int n );					\
+typedef void (*TYPE##_rowband_function) ( void *context,		\
+	    TYPE##_image *image, int first_row, int n_rows );		\
+void	TYPE##_image_map ( TYPE##_image *image,				\
+	    TYPE##_span_function function, void *context );		\
+void	TYPE##_image_map2 ( TYPE##_image *src, TYPE##_image *dst,	\
+	    TYPE##_span2_function function, void *context );		\
+void	TYPE##_image_reduce ( TYPE##_image *image,			\
+	    TYPE##_reduce_function function,				\
+	    DeVAS_Combine_Function combine, void *context, void *result, \
+	    size_t result_size );					\
+void	TYPE##_image_rowband_for ( TYPE##_image *image,			\
+	    TYPE##_rowband_function function, void *context );
+
+/*
+ * Definitions, expanded once per pixel type in devas-image-map.c (DeVAS
+ * types) and devas-tt-image.c (TT types).  MODIFIED is DeVAS_image_modified
+ * or TT_image_modified.
+ */
+#define DeVAS_DEFINE_IMAGE_MAP( TYPE, MODIFIED )			\
+typedef struct {							\
+    TYPE##_image	    *image;					\
+    TYPE##_image	    *dst;	/* map2 */			\
+    TYPE##_span_function    span;					\
+    TYPE##_span2_function   span2;					\
+    TYPE##_reduce_function  reduce;					\
+    TYPE##_rowband_function rowband;					\
+    void		    *context;					\
+    char		    *partials;	/* reduce, one per band */	\
+    size_t		    result_size;				\
+} TYPE##_Map_Work;							\
+									\
+static void								\
+TYPE##_map_band ( void *context, int band, int first_row,		\
+	int n_band_rows )						\
+{									\
+    TYPE##_Map_Work *work;						\
+    int		    n_cols, row;					\
+									\
+    work = (TYPE##_Map_Work *) context;					\
+    n_cols = work->image->n_cols;					\
+									\
+    if ( DeVAS_image_rows_adjacent ( work->image, first_row,		\
+		n_band_rows ) ) {					\
+	( *work->span ) ( work->context, work->image->data[first_row],	\
+		n_band_rows * n_cols );					\
+    } else {								\
+	for ( row = first_row; row < first_row + n_band_rows; row++ ) {	\
+	    ( *work->span ) ( work->context, work->image->data[row],	\
+		    n_cols );						\
+	}								\
+    }									\
+}									\
+									\
+void									\
+TYPE##_image_map ( TYPE##_image *image, TYPE##_span_function function,	\
+	void *context )							\
+{									\
+    TYPE##_Map_Work work;						\
+									\
+    work.image = image;							\
+    work.span = function;						\
+    work.context = context;						\
+									\
+    DeVAS_parallel_bands ( image->n_rows, DeVAS_parallel_band_rows (	\
+		image->n_cols ), TYPE##_map_band, (void *) &work );	\
+									\
+    MODIFIED ( image );							\
+}									\
+									\
+static void								\
+TYPE##_map2_band ( void *context, int band, int first_row,		\
+	int n_band_rows )						\
+{									\
+    TYPE##_Map_Work *work;						\
+    int		    n_cols, row;					\
+									\
+    work = (TYPE##_Map_Work *) context;					\
+    n_cols = work->image->n_cols;					\
+									\
+    if ( DeVAS_image_rows_adjacent ( work->image, first_row,		\
+		n_band_rows ) &&					\
+	    DeVAS_image_rows_adjacent ( work->dst, first_row,		\
+		n_band_rows ) ) {					\
+	( *work->span2 ) ( work->context, work->image->data[first_row],	\
+		work->dst->data[first_row], n_band_rows * n_cols );	\
+    } else {								\
+	for ( row = first_row; row < first_row + n_band_rows; row++ ) {	\
+	    ( *work->span2 ) ( work->context, work->image->data[row],	\
+		    work->dst->data[row], n_cols );			\
+	}								\
+    }									\
+}									\
+									\
+void									\
+TYPE##_image_map2 ( TYPE##_image *src, TYPE##_image *dst,		\
+	TYPE##_span2_function function, void *context )			\
+{									\
+    TYPE##_Map_Work work;						\
+									\
+    if ( ( src->n_rows != dst->n_rows ) ||				\
+	    ( src->n_cols != dst->n_cols ) ) {				\
+	fprintf ( stderr, #TYPE "_image_map2: image sizes differ!\n" );	\
+	exit ( EXIT_FAILURE );						\
+    }									\
+									\
+    work.image = src;							\
+    work.dst = dst;							\
+    work.span2 = function;						\
+    work.context = context;						\
+									\
+    DeVAS_parallel_bands ( src->n_rows, DeVAS_parallel_band_rows (	\
+		src->n_cols ), TYPE##_map2_band, (void *) &work );	\
+									\
+    MODIFIED ( dst );							\
+}									\
+									\
+static void								\
+TYPE##_reduce_band ( void *context, int band, int first_row,		\
+	int n_band_rows )						\
+{									\
+    TYPE##_Map_Work *work;						\
+    void	    *partial;						\
+    int		    n_cols, row;					\
+									\
+    work = (TYPE##_Map_Work *) context;					\
+    n_cols = work->image->n_cols;					\
+    partial = work->partials + band * work->result_size;		\
+									\
+    if ( DeVAS_image_rows_adjacent ( work->image, first_row,		\
+		n_band_rows ) ) {					\
+	( *work->reduce ) ( work->context, partial,			\
+		work->image->data[first_row], n_band_rows * n_cols );	\
+    } else {								\
+	for ( row = first_row; row < first_row + n_band_rows; row++ ) {	\
+	    ( *work->reduce ) ( work->context, partial,			\
+		    work->image->data[row], n_cols );			\
+	}								\
+    }									\
+}									\
+									\
+void									\
+TYPE##_image_reduce ( TYPE##_image *image,				\
+	TYPE##_reduce_function function, DeVAS_Combine_Function combine, \
+	void *context, void *result, size_t result_size )		\
+{									\
+    TYPE##_Map_Work work;						\
+    int		    band_rows, n_bands, band;				\
+									\
+    band_rows = DeVAS_parallel_band_rows ( image->n_cols );		\
+    n_bands = DeVAS_parallel_n_bands ( image->n_rows, band_rows );	\
+									\
+    work.image = image;							\
+    work.reduce = function;						\
+    work.context = context;						\
+    work.result_size = result_size;					\
+    work.partials = (char *) malloc ( ( n_bands + 1 ) * result_size );	\
+    if ( work.partials == NULL ) {					\
+	fprintf ( stderr, #TYPE "_image_reduce: malloc failed!\n" );	\
+	exit ( EXIT_FAILURE );						\
+    }									\
+    for ( band = 0; band < n_bands; band++ ) {				\
+	memcpy ( work.partials + band * result_size, result,		\
+		result_size );						\
+    }									\
+									\
+    DeVAS_parallel_bands ( image->n_rows, band_rows, TYPE##_reduce_band, \
+	    (void *) &work );						\
+									\
+    for ( band = 0; band < n_bands; band++ ) {				\
+	( *combine ) ( context, result,					\
+		work.partials + band * result_size );			\
+    }									\
+									\
+    free ( work.partials );						\
+}									\
+									\
+static void								\
+TYPE##_rowband_band ( void *context, int band, int first_row,		\
+	int n_band_rows )						\
+{									\
+    TYPE##_Map_Work *work;						\
+									\
+    work = (TYPE##_Map_Work *) context;					\
+									\
+    ( *work->rowband ) ( work->context, work->image, first_row,		\
+	    n_band_rows );						\
+}									\
+									\
+void									\
+TYPE##_image_rowband_for ( TYPE##_image *image,				\
+	TYPE##_rowband_function function, void *context )		\
+{									\
+    TYPE##_Map_Work work;						\
+									\
+    work.image = image;							\
+    work.rowband = function;						\
+    work.context = context;						\
+									\
+    DeVAS_parallel_bands ( image->n_rows, DeVAS_parallel_band_rows (	\
+		image->n_cols ), TYPE##_rowband_band, (void *) &work );	\
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+DeVAS_PROTOTYPE_IMAGE_MAP ( DeVAS_gray )
+DeVAS_PROTOTYPE_IMAGE_MAP ( DeVAS_float )
+DeVAS_PROTOTYPE_IMAGE_MAP ( DeVAS_double )
+DeVAS_PROTOTYPE_IMAGE_MAP ( DeVAS_RGB )
+DeVAS_PROTOTYPE_IMAGE_MAP ( DeVAS_RGBf )
+DeVAS_PROTOTYPE_IMAGE_MAP ( DeVAS_XYZ )
+DeVAS_PROTOTYPE_IMAGE_MAP ( DeVAS_xyY )
+DeVAS_PROTOTYPE_IMAGE_MAP ( DeVAS_complexf )
+/* DeVAS_PROTOTYPE_IMAGE_MAP ( DeVAS_complexd ) */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __DeVAS_IMAGE_MAP_H */
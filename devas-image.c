@@ -78,6 +78,123 @@
  *
  * 					The exposure value (only valid if
  *					DeVAS_image_exposure_set is TRUE).
+ *
+ * Sharing pixel storage:
+ *
+ *   Pixel storage is reference counted, so several image objects can use
+ *   the same block of pixels.  The block is freed when the last image
+ *   object using it is deleted, in whatever order that happens.
+ *
+ *   <DeVAS_type>_image_region ( <parent>, <first_row>, <first_col>,
+ *		<n_rows>, <n_cols> )
+ *
+ *   	A new image object for the n_rows x n_cols region of <parent>
+ *   	with upper left corner at (first_row, first_col).  No pixels are
+ *   	copied.  Writes through the region show up in the parent and vice
+ *   	versa.  Rows of a region are not adjacent in memory unless the
+ *   	region spans the full width of its parent; DeVAS_image_row_stride
+ *   	gives the distance between rows, in pixels.
+ *
+ *   <DeVAS_type>_image_share ( <image_object> )
+ *
+ *   	A new image object sharing all of the pixels of <image_object>.
+ *
+ *   <DeVAS_type>_image_make_writable ( <image_object> )
+ *
+ *   	Copy-on-write support.  If the storage of <image_object> is also
+ *   	used by other image objects, give <image_object> its own private,
+ *   	contiguous copy of its pixels.  Otherwise, do nothing.  Call this
+ *   	before modifying an image that was obtained from another pipeline
+ *   	stage using <DeVAS_type>_image_share.
+ *
+ *   DeVAS_image_row_stride ( <devas_image> )
+ *
+ *   DeVAS_image_is_contiguous ( <devas_image> )
+ *
+ *   DeVAS_image_is_shared ( <devas_image> )
+ *
+ *   Image info (view and description) is copied, not shared.
+ *
+ * File-backed storage:
+ *
+ *   <DeVAS_type>_image_new_mapped ( <n_rows>, <n_cols> )
+ *
+ *   	Like <DeVAS_type>_image_new, except that the pixels are kept in a
+ *   	memory-mapped temporary file (in $TMPDIR, default /tmp) instead of
+ *   	in RAM, so images larger than physical memory can be processed.
+ *   	Access in row order is fastest.
+ *
+ *   <DeVAS_type>_image_new uses file-backed storage when malloc fails, and
+ *   for images at least DeVAS_image_mapped_threshold ( ) bytes in size.
+ *   The threshold is set with DeVAS_image_set_mapped_threshold ( ) or the
+ *   DeVAS_MAPPED_THRESHOLD environment variable (e.g., "2G").  It is 0,
+ *   meaning no threshold, by default.
+ *
+ * Cached statistics:
+ *
+ *   DeVAS_RGBf_image_stats ( <image_object> )
+ *
+ *   	Minimum and maximum over all channels, the sum of the per-pixel
+ *   	maximum over channels, and a log-binned histogram of that
+ *   	per-pixel maximum, all computed in a single pass over the pixels.
+ *   	The result is kept with the image object and reused until the
+ *   	pixels change.
+ *
+ *   DeVAS_image_modified ( <image_object> )
+ *
+ *   	Must be called after changing pixel values through
+ *   	DeVAS_image_data.  Invalidates the cached statistics of every image
+ *   	object sharing the pixels.  Methods in this file that change pixels
+ *   	(e.g., <DeVAS_type>_image_setvalue) do this themselves.
+ *
+ *   DeVAS_RGBf_image_set_stats ( <image_object>, <stats> )
+ *
+ *   	For operations that accumulate new statistics (with
+ *   	DeVAS_image_stats_add_RGBf_row) in the same pass that modifies the
+ *   	pixels, so no separate statistics pass is needed afterward.
+ *
+ *   DeVAS_image_stats_add_RGBf_rows ( <stats>, <rows>, n_rows, n_cols )
+ *
+ *   	Accumulates statistics for n_rows rows of pixels, in parallel over
+ *   	bands of rows (see devas-parallel.h).  Per-band results are merged
+ *   	pairwise, and the sum is added up a row at a time in row order, so
+ *   	the statistics are the same for any number of threads, and the same
+ *   	as DeVAS_image_stats_add_RGBf_row applied to each row.
+ *
+ *   DeVAS_image_stats_merge ( <stats>, <part> )
+ *
+ *   	Adds statistics accumulated separately (e.g., for a band of rows)
+ *   	into stats, so that bands can be done independently.
+ *
+ *   DeVAS_image_stats_glare_threshold ( <stats> )
+ *
+ *   	The --autoadjust glare threshold, from the statistics alone (no
+ *   	further pass over the pixels).
+ *
+ * Pixel storage is accounted for by pixel type.  See devas-memory.h.
+ *
+ * Batched colorimetry:
+ *
+ *   DeVAS_RGBf_row_to_XYZ ( <src>, <dst>, n ), DeVAS_XYZ_row_to_RGBf,
+ *   DeVAS_XYZ_row_to_xyY, DeVAS_xyY_row_to_XYZ, DeVAS_RGBf_row_to_xyY,
+ *   DeVAS_xyY_row_to_RGBf, DeVAS_RGBf_row_to_Y
+ *
+ *   	Convert n pixels, giving exactly the same values as DeVAS_RGBf2XYZ,
+ *   	DeVAS_XYZ2RGBf, etc. applied to each pixel, four pixels at a time
+ *   	where SSE2 is available.  dst may be the same array as src, to
+ *   	convert in place (except for DeVAS_RGBf_row_to_Y).
+ *
+ *   DeVAS_RGBf_row_colortrans ( <matrix>, <src>, <dst>, n )
+ *
+ *   	Radiance colortrans applied to n pixels (e.g., for a change of RGB
+ *   	primaries), the same way.
+ *
+ *   DeVAS_RGBf_image_to_XYZ ( <src_image>, <dst_image> ), ...,
+ *   DeVAS_RGBf_image_to_Y ( <src_image>, <DeVAS_float_image> )
+ *
+ *   	The same, a row at a time, for images of the same size.  The pixel
+ *   	types are all three floats, so an image can be converted in place
+ *   	by passing it as both src_image and dst_image (with a cast).
  */
 
 /*
@@ -88,8 +205,21 @@
  */
 
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
 #include <assert.h>
+#ifndef	_mingw64_cross
+#include <unistd.h>
+#include <sys/mman.h>
+#endif	/* _mingw64_cross */
+#ifdef	__SSE2__
+#include <emmintrin.h>
+#endif	/* __SSE2__ */
 #include "devas-image.h"
+#include "devas-memory.h"
+#include "devas-parallel.h"
+#include "devas-image-map.h"
 #include "devas-license.h"	/* DeVAS open source license */
 #include "radiance/color.h"
 
@@ -214,13 +344,428 @@ DeVAS_RGBf2Y ( DeVAS_RGBf RGBf )
     return ( luminance ( rad_rgb ) );
 }
 
+#ifdef	__SSE2__
+static void
+DeVAS_load_pixels4 ( const float *src, __m128 *c0, __m128 *c1, __m128 *c2 )
+/*
+ * Four interleaved three float pixels, one register per channel.
+ */
+{
+    __m128  a, b, c;
+
+    /* a = 0 1 2 0, b = 1 2 0 1, c = 2 0 1 2 (channel of each element) */
+    a = _mm_loadu_ps ( src );
+    b = _mm_loadu_ps ( src + 4 );
+    c = _mm_loadu_ps ( src + 8 );
+
+    *c0 = _mm_shuffle_ps ( _mm_shuffle_ps ( a, a, _MM_SHUFFLE ( 0, 0, 3, 0 ) ),
+	    _mm_shuffle_ps ( b, c, _MM_SHUFFLE ( 1, 1, 2, 2 ) ),
+	    _MM_SHUFFLE ( 2, 0, 1, 0 ) );
+    *c1 = _mm_shuffle_ps ( _mm_shuffle_ps ( a, b, _MM_SHUFFLE ( 0, 0, 0, 1 ) ),
+	    _mm_shuffle_ps ( b, c, _MM_SHUFFLE ( 2, 2, 3, 3 ) ),
+	    _MM_SHUFFLE ( 2, 0, 2, 0 ) );
+    *c2 = _mm_shuffle_ps ( _mm_shuffle_ps ( a, b, _MM_SHUFFLE ( 1, 1, 2, 2 ) ),
+	    _mm_shuffle_ps ( c, c, _MM_SHUFFLE ( 3, 3, 0, 0 ) ),
+	    _MM_SHUFFLE ( 2, 0, 2, 0 ) );
+}
+
+static void
+DeVAS_store_pixels4 ( float *dst, __m128 c0, __m128 c1, __m128 c2 )
+/*
+ * Inverse of DeVAS_load_pixels4.
+ */
+{
+    _mm_storeu_ps ( dst, _mm_shuffle_ps (
+		_mm_shuffle_ps ( c0, c1, _MM_SHUFFLE ( 0, 0, 0, 0 ) ),
+		_mm_shuffle_ps ( c2, c0, _MM_SHUFFLE ( 1, 1, 0, 0 ) ),
+		_MM_SHUFFLE ( 2, 0, 2, 0 ) ) );
+    _mm_storeu_ps ( dst + 4, _mm_shuffle_ps (
+		_mm_shuffle_ps ( c1, c2, _MM_SHUFFLE ( 1, 1, 1, 1 ) ),
+		_mm_shuffle_ps ( c0, c1, _MM_SHUFFLE ( 2, 2, 2, 2 ) ),
+		_MM_SHUFFLE ( 2, 0, 2, 0 ) ) );
+    _mm_storeu_ps ( dst + 8, _mm_shuffle_ps (
+		_mm_shuffle_ps ( c2, c0, _MM_SHUFFLE ( 3, 3, 2, 2 ) ),
+		_mm_shuffle_ps ( c1, c2, _MM_SHUFFLE ( 3, 3, 3, 3 ) ),
+		_MM_SHUFFLE ( 2, 0, 2, 0 ) ) );
+}
+
+static __m128
+DeVAS_div_ps_as_double ( __m128 numerator, __m128d denominator )
+/*
+ * float / double, rounded to float, as in the scalar code.
+ */
+{
+    return ( _mm_movelh_ps (
+		_mm_cvtpd_ps ( _mm_div_pd ( _mm_cvtps_pd ( numerator ),
+			denominator ) ),
+		_mm_cvtpd_ps ( _mm_div_pd ( _mm_cvtps_pd (
+			_mm_movehl_ps ( numerator, numerator ) ),
+			denominator ) ) ) );
+}
+#endif	/* __SSE2__ */
+
+static void
+DeVAS_matrix3_pixels ( COLORMAT mat, double scale, int divide,
+	const float *src, float *dst, int n )
+/*
+ * dst = ( mat * src ) * scale, or ( mat * src ) / scale if divide is TRUE,
+ * for n three float pixels, with the matrix product in float as in
+ * Radiance colortrans, and the scaling as float * double.  dst may be src.
+ */
+{
+    int	    i = 0;
+    float   p0, p1, p2;
+#ifdef	__SSE2__
+    __m128  m00, m01, m02, m10, m11, m12, m20, m21, m22;
+    __m128  x0, x1, x2, y0, y1, y2, fscale;
+    __m128d dscale;
+
+    m00 = _mm_set1_ps ( mat[0][0] );
+    m01 = _mm_set1_ps ( mat[0][1] );
+    m02 = _mm_set1_ps ( mat[0][2] );
+    m10 = _mm_set1_ps ( mat[1][0] );
+    m11 = _mm_set1_ps ( mat[1][1] );
+    m12 = _mm_set1_ps ( mat[1][2] );
+    m20 = _mm_set1_ps ( mat[2][0] );
+    m21 = _mm_set1_ps ( mat[2][1] );
+    m22 = _mm_set1_ps ( mat[2][2] );
+    fscale = _mm_set1_ps ( (float) scale );
+    dscale = _mm_set1_pd ( scale );
+
+    for ( ; i + 4 <= n; i += 4 ) {
+	DeVAS_load_pixels4 ( src + ( 3 * i ), &x0, &x1, &x2 );
+
+	y0 = _mm_add_ps ( _mm_add_ps ( _mm_mul_ps ( m00, x0 ),
+		    _mm_mul_ps ( m01, x1 ) ), _mm_mul_ps ( m02, x2 ) );
+	y1 = _mm_add_ps ( _mm_add_ps ( _mm_mul_ps ( m10, x0 ),
+		    _mm_mul_ps ( m11, x1 ) ), _mm_mul_ps ( m12, x2 ) );
+	y2 = _mm_add_ps ( _mm_add_ps ( _mm_mul_ps ( m20, x0 ),
+		    _mm_mul_ps ( m21, x1 ) ), _mm_mul_ps ( m22, x2 ) );
+
+	if ( divide ) {
+	    y0 = DeVAS_div_ps_as_double ( y0, dscale );
+	    y1 = DeVAS_div_ps_as_double ( y1, dscale );
+	    y2 = DeVAS_div_ps_as_double ( y2, dscale );
+	} else {
+	    /* float * float is exact in double, so this rounds the same */
+	    y0 = _mm_mul_ps ( y0, fscale );
+	    y1 = _mm_mul_ps ( y1, fscale );
+	    y2 = _mm_mul_ps ( y2, fscale );
+	}
+
+	DeVAS_store_pixels4 ( dst + ( 3 * i ), y0, y1, y2 );
+    }
+#endif	/* __SSE2__ */
+
+    for ( ; i < n; i++ ) {
+	p0 = mat[0][0] * src[3 * i] + mat[0][1] * src[( 3 * i ) + 1] +
+	    mat[0][2] * src[( 3 * i ) + 2];
+	p1 = mat[1][0] * src[3 * i] + mat[1][1] * src[( 3 * i ) + 1] +
+	    mat[1][2] * src[( 3 * i ) + 2];
+	p2 = mat[2][0] * src[3 * i] + mat[2][1] * src[( 3 * i ) + 1] +
+	    mat[2][2] * src[( 3 * i ) + 2];
+	if ( divide ) {
+	    dst[3 * i] = p0 / scale;
+	    dst[( 3 * i ) + 1] = p1 / scale;
+	    dst[( 3 * i ) + 2] = p2 / scale;
+	} else {
+	    dst[3 * i] = p0 * scale;
+	    dst[( 3 * i ) + 1] = p1 * scale;
+	    dst[( 3 * i ) + 2] = p2 * scale;
+	}
+    }
+}
+
+void
+DeVAS_RGBf_row_to_XYZ ( const DeVAS_RGBf *src, DeVAS_XYZ *dst, int n )
+/* Same as DeVAS_RGBf2XYZ. */
+{
+    DeVAS_matrix3_pixels ( rgb2xyzmat, WHTEFFICACY, FALSE,
+	    (const float *) src, (float *) dst, n );
+}
+
+void
+DeVAS_XYZ_row_to_RGBf ( const DeVAS_XYZ *src, DeVAS_RGBf *dst, int n )
+/* Same as DeVAS_XYZ2RGBf. */
+{
+    DeVAS_matrix3_pixels ( xyz2rgbmat, WHTEFFICACY, TRUE,
+	    (const float *) src, (float *) dst, n );
+}
+
+void
+DeVAS_RGBf_row_colortrans ( float matrix[3][3], const DeVAS_RGBf *src,
+	DeVAS_RGBf *dst, int n )
+/* Same as Radiance colortrans applied to each pixel. */
+{
+    /* multiplying by 1.0 changes nothing */
+    DeVAS_matrix3_pixels ( matrix, 1.0, FALSE, (const float *) src,
+	    (float *) dst, n );
+}
+
+void
+DeVAS_XYZ_row_to_xyY ( const DeVAS_XYZ *src, DeVAS_xyY *dst, int n )
+/*
+ * Same as DeVAS_XYZ2xyY, but without a branch per pixel.
+ */
+{
+    int	    i = 0;
+    float   norm, X, Y, Z;
+#ifdef	__SSE2__
+    __m128  vX, vY, vZ, vnorm, black, white_x, white_y, zero;
+
+    white_x = _mm_set1_ps ( (float) DeVAS_x_WHITEPOINT );
+    white_y = _mm_set1_ps ( (float) DeVAS_y_WHITEPOINT );
+    zero = _mm_setzero_ps ( );
+
+    for ( ; i + 4 <= n; i += 4 ) {
+	DeVAS_load_pixels4 ( (const float *) ( src + i ), &vX, &vY, &vZ );
+	vnorm = _mm_add_ps ( _mm_add_ps ( vX, vY ), vZ );
+	black = _mm_cmple_ps ( vnorm, zero );	/* all ones if black */
+
+	DeVAS_store_pixels4 ( (float *) ( dst + i ),
+		_mm_or_ps ( _mm_and_ps ( black, white_x ),
+		    _mm_andnot_ps ( black, _mm_div_ps ( vX, vnorm ) ) ),
+		_mm_or_ps ( _mm_and_ps ( black, white_y ),
+		    _mm_andnot_ps ( black, _mm_div_ps ( vY, vnorm ) ) ),
+		_mm_andnot_ps ( black, vY ) );
+    }
+#endif	/* __SSE2__ */
+
+    for ( ; i < n; i++ ) {
+	X = src[i].X;
+	Y = src[i].Y;
+	Z = src[i].Z;
+	norm = X + Y + Z;
+	if ( norm <= 0.0 ) {
+	    dst[i].x = DeVAS_x_WHITEPOINT;
+	    dst[i].y = DeVAS_y_WHITEPOINT;
+	    dst[i].Y = 0.0;
+	} else {
+	    dst[i].x = X / norm;
+	    dst[i].y = Y / norm;
+	    dst[i].Y = Y;
+	}
+    }
+}
+
+void
+DeVAS_xyY_row_to_XYZ ( const DeVAS_xyY *src, DeVAS_XYZ *dst, int n )
+/*
+ * Same as DeVAS_xyY2XYZ, but without a branch per pixel.
+ */
+{
+    int	    i = 0;
+    float   x, y, Y;
+#ifdef	__SSE2__
+    __m128  vx, vy, vY, black, zero, Z_lo, Z_hi;
+    __m128d one_d;
+
+    zero = _mm_setzero_ps ( );
+    one_d = _mm_set1_pd ( 1.0 );
+
+    for ( ; i + 4 <= n; i += 4 ) {
+	DeVAS_load_pixels4 ( (const float *) ( src + i ), &vx, &vy, &vY );
+	black = _mm_cmple_ps ( vy, zero );	/* all ones if y <= 0 */
+
+	/* Z = ( ( 1.0 - x - y ) * Y ) / y, in double */
+	Z_lo = _mm_cvtpd_ps ( _mm_div_pd ( _mm_mul_pd ( _mm_sub_pd (
+			_mm_sub_pd ( one_d, _mm_cvtps_pd ( vx ) ),
+			_mm_cvtps_pd ( vy ) ), _mm_cvtps_pd ( vY ) ),
+		    _mm_cvtps_pd ( vy ) ) );
+	Z_hi = _mm_cvtpd_ps ( _mm_div_pd ( _mm_mul_pd ( _mm_sub_pd (
+			_mm_sub_pd ( one_d, _mm_cvtps_pd (
+				_mm_movehl_ps ( vx, vx ) ) ),
+			_mm_cvtps_pd ( _mm_movehl_ps ( vy, vy ) ) ),
+			_mm_cvtps_pd ( _mm_movehl_ps ( vY, vY ) ) ),
+		    _mm_cvtps_pd ( _mm_movehl_ps ( vy, vy ) ) ) );
+
+	DeVAS_store_pixels4 ( (float *) ( dst + i ),
+		_mm_andnot_ps ( black,
+		    _mm_div_ps ( _mm_mul_ps ( vx, vY ), vy ) ),
+		_mm_andnot_ps ( black, vY ),
+		_mm_andnot_ps ( black, _mm_movelh_ps ( Z_lo, Z_hi ) ) );
+    }
+#endif	/* __SSE2__ */
+
+    for ( ; i < n; i++ ) {
+	x = src[i].x;
+	y = src[i].y;
+	Y = src[i].Y;
+	if ( y <= 0.0 ) {
+	    dst[i].X = dst[i].Y = dst[i].Z = 0.0;
+	} else {
+	    dst[i].X = ( x * Y ) / y;
+	    dst[i].Y = Y;
+	    dst[i].Z = ( ( 1.0 - x - y ) * Y ) / y;
+	}
+    }
+}
+
+void
+DeVAS_RGBf_row_to_xyY ( const DeVAS_RGBf *src, DeVAS_xyY *dst, int n )
+/* Same as DeVAS_RGBf2xyY. */
+{
+    DeVAS_RGBf_row_to_XYZ ( src, (DeVAS_XYZ *) dst, n );
+    DeVAS_XYZ_row_to_xyY ( (DeVAS_XYZ *) dst, dst, n );
+}
+
+void
+DeVAS_xyY_row_to_RGBf ( const DeVAS_xyY *src, DeVAS_RGBf *dst, int n )
+/* Same as DeVAS_xyY2RGBf. */
+{
+    DeVAS_xyY_row_to_XYZ ( src, (DeVAS_XYZ *) dst, n );
+    DeVAS_XYZ_row_to_RGBf ( (DeVAS_XYZ *) dst, dst, n );
+}
+
+void
+DeVAS_RGBf_row_to_Y ( const DeVAS_RGBf *src, float *dst, int n )
+/*
+ * Same as DeVAS_RGBf2Y (Radiance luminance, computed in double).
+ */
+{
+    int	    i = 0;
+#ifdef	__SSE2__
+    __m128d rf, gf, bf, efficacy;
+    __m128  r, g, b;
+    __m128  lo, hi;
+
+    rf = _mm_set1_pd ( CIE_rf );
+    gf = _mm_set1_pd ( CIE_gf );
+    bf = _mm_set1_pd ( CIE_bf );
+    efficacy = _mm_set1_pd ( WHTEFFICACY );
+
+    for ( ; i + 4 <= n; i += 4 ) {
+	DeVAS_load_pixels4 ( (const float *) ( src + i ), &r, &g, &b );
+	lo = _mm_cvtpd_ps ( _mm_mul_pd ( efficacy, _mm_add_pd ( _mm_add_pd (
+			_mm_mul_pd ( rf, _mm_cvtps_pd ( r ) ),
+			_mm_mul_pd ( gf, _mm_cvtps_pd ( g ) ) ),
+		    _mm_mul_pd ( bf, _mm_cvtps_pd ( b ) ) ) ) );
+	r = _mm_movehl_ps ( r, r );
+	g = _mm_movehl_ps ( g, g );
+	b = _mm_movehl_ps ( b, b );
+	hi = _mm_cvtpd_ps ( _mm_mul_pd ( efficacy, _mm_add_pd ( _mm_add_pd (
+			_mm_mul_pd ( rf, _mm_cvtps_pd ( r ) ),
+			_mm_mul_pd ( gf, _mm_cvtps_pd ( g ) ) ),
+		    _mm_mul_pd ( bf, _mm_cvtps_pd ( b ) ) ) ) );
+	_mm_storeu_ps ( dst + i, _mm_movelh_ps ( lo, hi ) );
+    }
+#endif	/* __SSE2__ */
+
+    for ( ; i < n; i++ ) {
+	dst[i] = WHTEFFICACY * ( CIE_rf * src[i].red + CIE_gf * src[i].green +
+		CIE_bf * src[i].blue );
+    }
+}
+
+#define DeVAS_IMAGE_COLORIMETRY( FROM, TO )				\
+static void								\
+DeVAS_##FROM##_rows_to_##TO ( void *dst, DeVAS_##FROM##_image *src,	\
+	int first_row, int n_rows )					\
+{									\
+    int	    row;							\
+									\
+    for ( row = first_row; row < first_row + n_rows; row++ ) {		\
+	DeVAS_##FROM##_row_to_##TO ( src->data[row],			\
+		( (DeVAS_##TO##_image *) dst )->data[row],		\
+		DeVAS_image_n_cols ( src ) );				\
+    }									\
+}									\
+									\
+void									\
+DeVAS_##FROM##_image_to_##TO ( DeVAS_##FROM##_image *src,		\
+	DeVAS_##TO##_image *dst )					\
+/* DeVAS_##FROM##_row_to_##TO applied to each row, in parallel. */	\
+{									\
+    if ( !DeVAS_image_samesize ( src, dst ) ) {				\
+	fprintf ( stderr,						\
+		"DeVAS_" #FROM "_image_to_" #TO ": image sizes differ!\n" ); \
+	exit ( EXIT_FAILURE );						\
+    }									\
+									\
+    DeVAS_##FROM##_image_rowband_for ( src, DeVAS_##FROM##_rows_to_##TO, \
+	    (void *) dst );						\
+									\
+    DeVAS_image_modified ( dst );					\
+}
+
+DeVAS_IMAGE_COLORIMETRY ( RGBf, XYZ )
+DeVAS_IMAGE_COLORIMETRY ( XYZ, RGBf )
+DeVAS_IMAGE_COLORIMETRY ( XYZ, xyY )
+DeVAS_IMAGE_COLORIMETRY ( xyY, XYZ )
+DeVAS_IMAGE_COLORIMETRY ( RGBf, xyY )
+DeVAS_IMAGE_COLORIMETRY ( xyY, RGBf )
+
+static void
+DeVAS_RGBf_rows_to_Y ( void *dst, DeVAS_RGBf_image *src, int first_row,
+	int n_rows )
+{
+    int	    row;
+
+    for ( row = first_row; row < first_row + n_rows; row++ ) {
+	DeVAS_RGBf_row_to_Y ( src->data[row],
+		( (DeVAS_float_image *) dst )->data[row],
+		DeVAS_image_n_cols ( src ) );
+    }
+}
+
+void
+DeVAS_RGBf_image_to_Y ( DeVAS_RGBf_image *src, DeVAS_float_image *dst )
+/* DeVAS_RGBf_row_to_Y applied to each row, in parallel. */
+{
+    if ( !DeVAS_image_samesize ( src, dst ) ) {
+	fprintf ( stderr, "DeVAS_RGBf_image_to_Y: image sizes differ!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    DeVAS_RGBf_image_rowband_for ( src, DeVAS_RGBf_rows_to_Y, (void *) dst );
+
+    DeVAS_image_modified ( dst );
+}
+
+#define DeVAS_IMAGE_LINE_POINTERS( TYPE )				\
+static TYPE **								\
+TYPE##_image_line_pointers ( TYPE **line_pointers, TYPE *start_data,	\
+	int n_rows, int row_stride, char *caller )			\
+/*									\
+ * Sets line_pointers (allocated first if NULL) to n_rows rows of	\
+ * row_stride pixels starting at start_data.  The offsets are size_t:	\
+ * row * row_stride exceeds INT_MAX for images of more than 2^31 pixels. \
+ */									\
+{									\
+    int		    row;						\
+									\
+    if ( line_pointers == NULL ) {					\
+	line_pointers = (TYPE **) malloc ( ( n_rows > 0 ? n_rows : 1 ) * \
+		sizeof ( TYPE * ) );					\
+	if ( line_pointers == NULL ) {					\
+	    fprintf ( stderr, "%s: malloc failed!", caller );		\
+	    DeVAS_print_file_lineno ( __FILE__, __LINE__ );		\
+	    exit ( EXIT_FAILURE );					\
+	}								\
+    }									\
+									\
+    for ( row = 0; row < n_rows; row++ ) {				\
+	line_pointers[row] = start_data + ( ( (size_t) row ) * row_stride ); \
+    }									\
+									\
+    return ( line_pointers );						\
+}
+
+DeVAS_IMAGE_LINE_POINTERS ( DeVAS_gray )
+DeVAS_IMAGE_LINE_POINTERS ( DeVAS_double )
+DeVAS_IMAGE_LINE_POINTERS ( DeVAS_RGB )
+DeVAS_IMAGE_LINE_POINTERS ( DeVAS_RGBf )
+DeVAS_IMAGE_LINE_POINTERS ( DeVAS_XYZ )
+DeVAS_IMAGE_LINE_POINTERS ( DeVAS_xyY )
+DeVAS_IMAGE_LINE_POINTERS ( DeVAS_float )
+DeVAS_IMAGE_LINE_POINTERS ( DeVAS_complexf )
+/* DeVAS_IMAGE_LINE_POINTERS ( DeVAS_complexd ) */
+
 #define DeVAS_IMAGE_NEW( TYPE )						\
 TYPE##_image *								\
 TYPE##_image_new ( unsigned int n_rows, unsigned int n_cols  )		\
 {									\
     TYPE##_image    *new_image;						\
-    int		    row;						\
-    TYPE	    **line_pointers;					\
     VIEW	    nullview = NULLVIEW;				\
 									\
     new_image = ( TYPE##_image * ) malloc ( sizeof ( TYPE##_image ) );	\
@@ -239,26 +784,14 @@ TYPE##_image_new ( unsigned int n_rows, unsigned int n_cols  )		\
     new_image->image_info.view = nullview;				\
     new_image->image_info.description = NULL;				\
 									\
-    new_image->start_data = (TYPE *) malloc ( n_rows * n_cols *		\
-	        sizeof ( TYPE ) );					\
-    if ( new_image->start_data == NULL ) {				\
-	fprintf ( stderr, "DeVAS_image_new: malloc failed!" );		\
-	DeVAS_print_file_lineno ( __FILE__, __LINE__ );			\
-        exit ( EXIT_FAILURE );						\
-    }									\
+    new_image->stats = NULL;						\
+    new_image->storage = DeVAS_image_storage_new ( ( (size_t) n_rows ) *	\
+	    n_cols * sizeof ( TYPE ), DeVAS_STORAGE_MALLOC, #TYPE );	\
+    new_image->start_data = (TYPE *) new_image->storage->block;		\
+    new_image->row_stride = n_cols;					\
 									\
-    line_pointers = (TYPE **) malloc ( n_rows * sizeof ( TYPE * ) );	\
-    if ( line_pointers == NULL ) {					\
-	fprintf ( stderr, "DeVAS_image_new: malloc failed!" );		\
-	DeVAS_print_file_lineno ( __FILE__, __LINE__ );			\
-        exit ( EXIT_FAILURE );						\
-    }									\
-									\
-    for ( row = 0; row < n_rows; row++ ) {				\
-	line_pointers[row] = new_image->start_data + ( row * n_cols );	\
-    }									\
-									\
-    new_image->data = &line_pointers[0];				\
+    new_image->data = TYPE##_image_line_pointers ( NULL,		\
+	    new_image->start_data, n_rows, n_cols, "DeVAS_image_new" );	\
 									\
     return ( new_image );						\
 }
@@ -268,8 +801,6 @@ TYPE##_image *								\
 TYPE##_image_new ( unsigned int n_rows, unsigned int n_cols  )		\
 {									\
     TYPE##_image    *new_image;						\
-    int		    row;						\
-    TYPE	    **line_pointers;					\
     VIEW	    nullview = NULLVIEW;				\
 									\
     new_image = ( TYPE##_image * ) malloc ( sizeof ( TYPE##_image ) );	\
@@ -291,26 +822,50 @@ TYPE##_image_new ( unsigned int n_rows, unsigned int n_cols  )		\
     new_image->image_info.view = nullview;				\
     new_image->image_info.description = NULL;				\
 									\
-    new_image->start_data = (TYPE *) fftwf_malloc ( n_rows * n_cols *	\
-	        sizeof ( TYPE ) );					\
-    if ( new_image->start_data == NULL ) {				\
-	fprintf ( stderr, "DeVAS_image_new: malloc failed!" );		\
-	DeVAS_print_file_lineno ( __FILE__, __LINE__ );			\
-        exit ( EXIT_FAILURE );						\
-    }									\
+    new_image->stats = NULL;						\
+    new_image->storage = DeVAS_image_storage_new ( ( (size_t) n_rows ) *	\
+	    n_cols * sizeof ( TYPE ), DeVAS_STORAGE_FFTW, #TYPE );	\
+    new_image->start_data = (TYPE *) new_image->storage->block;		\
+    new_image->row_stride = n_cols;					\
 									\
-    line_pointers = (TYPE **) malloc ( n_rows * sizeof ( TYPE * ) );	\
-    if ( line_pointers == NULL ) {					\
-	fprintf ( stderr, "DeVAS_image_new: malloc failed!" );		\
+    new_image->data = TYPE##_image_line_pointers ( NULL,		\
+	    new_image->start_data, n_rows, n_cols, "DeVAS_image_new" );	\
+									\
+    return ( new_image );						\
+}
+
+#define DeVAS_IMAGE_NEW_MAPPED( TYPE )					\
+TYPE##_image *								\
+TYPE##_image_new_mapped ( unsigned int n_rows, unsigned int n_cols  )	\
+{									\
+    TYPE##_image    *new_image;						\
+    VIEW	    nullview = NULLVIEW;				\
+									\
+    new_image = ( TYPE##_image * ) malloc ( sizeof ( TYPE##_image ) );	\
+    if ( new_image == NULL ) {						\
+	fprintf ( stderr, "DeVAS_image_new_mapped: malloc failed!" );	\
 	DeVAS_print_file_lineno ( __FILE__, __LINE__ );			\
         exit ( EXIT_FAILURE );						\
     }									\
 									\
-    for ( row = 0; row < n_rows; row++ ) {				\
-	line_pointers[row] = new_image->start_data + ( row * n_cols );	\
-    }									\
+    new_image->n_rows = n_rows;						\
+    new_image->n_cols = n_cols;						\
 									\
-    new_image->data = &line_pointers[0];				\
+    new_image->exposure_set = FALSE;					\
+    new_image->exposure = 1.0;	/* default value */			\
+									\
+    new_image->image_info.view = nullview;				\
+    new_image->image_info.description = NULL;				\
+									\
+    new_image->stats = NULL;						\
+    new_image->storage = DeVAS_image_storage_new ( ( (size_t) n_rows ) *	\
+	    n_cols * sizeof ( TYPE ), DeVAS_STORAGE_MAPPED, #TYPE );	\
+    new_image->start_data = (TYPE *) new_image->storage->block;		\
+    new_image->row_stride = n_cols;					\
+									\
+    new_image->data = TYPE##_image_line_pointers ( NULL,		\
+	    new_image->start_data, n_rows, n_cols,			\
+	    "DeVAS_image_new_mapped" );					\
 									\
     return ( new_image );						\
 }
@@ -331,6 +886,16 @@ DeVAS_IMAGE_NEW_FFTW_SINGLE ( DeVAS_complexf )
 /* DeVAS_IMAGE_NEW_FFTW_DOUBLE ( DeVAS_complexd ) */
 #endif	/* DeVAS_USE_FFTW3_ALLOCATORS */
 
+DeVAS_IMAGE_NEW_MAPPED ( DeVAS_gray )
+DeVAS_IMAGE_NEW_MAPPED ( DeVAS_double )
+DeVAS_IMAGE_NEW_MAPPED ( DeVAS_RGB )
+DeVAS_IMAGE_NEW_MAPPED ( DeVAS_RGBf )
+DeVAS_IMAGE_NEW_MAPPED ( DeVAS_XYZ )
+DeVAS_IMAGE_NEW_MAPPED ( DeVAS_xyY )
+DeVAS_IMAGE_NEW_MAPPED ( DeVAS_float )
+DeVAS_IMAGE_NEW_MAPPED ( DeVAS_complexf )
+/* DeVAS_IMAGE_NEW_MAPPED ( DeVAS_complexd ) */
+
 #define DeVAS_IMAGE_DELETE( TYPE )					\
 void									\
 TYPE##_image_delete ( TYPE##_image *image )				\
@@ -345,40 +910,467 @@ TYPE##_image_delete ( TYPE##_image *image )				\
 	free ( image->image_info.description );				\
 	image->image_info.description = NULL;				\
     }									\
-    free ( image->start_data );						\
-    free ( image->data );						\
-    free ( image );							\
-}
-
-#define DeVAS_IMAGE_DELETE_FFTW_SINGLE( TYPE )				\
-void									\
-TYPE##_image_delete ( TYPE##_image *image )				\
-{									\
-    if ( image->image_info.description != NULL ) {			\
-	free ( image->image_info.description );				\
-	image->image_info.description = NULL;				\
-    }									\
-    fftwf_free ( image->start_data );					\
+    DeVAS_image_storage_release ( image->storage );			\
+    free ( image->stats );						\
     free ( image->data );						\
     free ( image );							\
 }
 
+/* storage knows how it was allocated, so one version serves for FFTW too */
 DeVAS_IMAGE_DELETE ( DeVAS_gray )
 DeVAS_IMAGE_DELETE ( DeVAS_double )
 DeVAS_IMAGE_DELETE ( DeVAS_RGB )
 DeVAS_IMAGE_DELETE ( DeVAS_RGBf )
 DeVAS_IMAGE_DELETE ( DeVAS_XYZ )
 DeVAS_IMAGE_DELETE ( DeVAS_xyY )
-#ifndef	DeVAS_USE_FFTW3_ALLOCATORS
 DeVAS_IMAGE_DELETE ( DeVAS_float )
 DeVAS_IMAGE_DELETE ( DeVAS_complexf )
 /* DeVAS_IMAGE_DELETE ( DeVAS_complexd ) */
+
+#define DeVAS_IMAGE_REGION( TYPE )					\
+TYPE##_image *								\
+TYPE##_image_region ( TYPE##_image *parent, int first_row, int first_col, \
+	int n_rows, int n_cols )					\
+/*									\
+ * Zero-copy sub-image.  The region holds a reference to the parent's	\
+ * storage, so the parent can be deleted while the region is still in	\
+ * use.									\
+ */									\
+{									\
+    TYPE##_image    *region;						\
+									\
+    if ( ( first_row < 0 ) || ( first_col < 0 ) || ( n_rows < 0 ) ||	\
+	    ( n_cols < 0 ) ||						\
+	    ( first_row > DeVAS_image_n_rows ( parent ) - n_rows ) ||	\
+	    ( first_col > DeVAS_image_n_cols ( parent ) - n_cols ) ) {	\
+	fprintf ( stderr, "DeVAS_image_region: region out of bounds!\n" ); \
+	DeVAS_print_file_lineno ( __FILE__, __LINE__ );			\
+	exit ( EXIT_FAILURE );						\
+    }									\
+									\
+    region = ( TYPE##_image * ) malloc ( sizeof ( TYPE##_image ) );	\
+    if ( region == NULL ) {						\
+	fprintf ( stderr, "DeVAS_image_region: malloc failed!" );	\
+	DeVAS_print_file_lineno ( __FILE__, __LINE__ );			\
+        exit ( EXIT_FAILURE );						\
+    }									\
+									\
+    region->n_rows = n_rows;						\
+    region->n_cols = n_cols;						\
+									\
+    region->exposure_set = parent->exposure_set;			\
+    region->exposure = parent->exposure;				\
+									\
+    region->image_info.view = parent->image_info.view;			\
+    if ( parent->image_info.description != NULL ) {			\
+	region->image_info.description =				\
+	    strdup ( parent->image_info.description );			\
+	if ( region->image_info.description == NULL ) {			\
+	    fprintf ( stderr, "DeVAS_image_region: malloc failed!" );	\
+	    DeVAS_print_file_lineno ( __FILE__, __LINE__ );		\
+	    exit ( EXIT_FAILURE );					\
+	}								\
+    } else {								\
+	region->image_info.description = NULL;				\
+    }									\
+									\
+    region->start_data = ( n_rows > 0 ) ?				\
+	( parent->data[first_row] + first_col ) : parent->start_data;	\
+    region->row_stride = parent->row_stride;				\
+    region->data = TYPE##_image_line_pointers ( NULL, region->start_data, \
+	    n_rows, region->row_stride, "DeVAS_image_region" );		\
+									\
+    region->storage = parent->storage;					\
+    region->storage->ref_count++;					\
+    region->stats = NULL;						\
+									\
+    return ( region );							\
+}
+
+DeVAS_IMAGE_REGION ( DeVAS_gray )
+DeVAS_IMAGE_REGION ( DeVAS_double )
+DeVAS_IMAGE_REGION ( DeVAS_RGB )
+DeVAS_IMAGE_REGION ( DeVAS_RGBf )
+DeVAS_IMAGE_REGION ( DeVAS_XYZ )
+DeVAS_IMAGE_REGION ( DeVAS_xyY )
+DeVAS_IMAGE_REGION ( DeVAS_float )
+DeVAS_IMAGE_REGION ( DeVAS_complexf )
+/* DeVAS_IMAGE_REGION ( DeVAS_complexd ) */
+
+#define DeVAS_IMAGE_SHARE( TYPE )					\
+TYPE##_image *								\
+TYPE##_image_share ( TYPE##_image *image )				\
+{									\
+    return ( TYPE##_image_region ( image, 0, 0, DeVAS_image_n_rows ( image ), \
+		DeVAS_image_n_cols ( image ) ) );			\
+}
+
+DeVAS_IMAGE_SHARE ( DeVAS_gray )
+DeVAS_IMAGE_SHARE ( DeVAS_double )
+DeVAS_IMAGE_SHARE ( DeVAS_RGB )
+DeVAS_IMAGE_SHARE ( DeVAS_RGBf )
+DeVAS_IMAGE_SHARE ( DeVAS_XYZ )
+DeVAS_IMAGE_SHARE ( DeVAS_xyY )
+DeVAS_IMAGE_SHARE ( DeVAS_float )
+DeVAS_IMAGE_SHARE ( DeVAS_complexf )
+/* DeVAS_IMAGE_SHARE ( DeVAS_complexd ) */
+
+#define DeVAS_IMAGE_MAKE_WRITABLE( TYPE )				\
+void									\
+TYPE##_image_make_writable ( TYPE##_image *image )			\
+/*									\
+ * Copy-on-write.  An image object that is the only user of its storage	\
+ * is left alone, even if it started out as a region.		\
+ */									\
+{									\
+    DeVAS_Image_Storage	*old_storage;					\
+    TYPE		*new_start_data;				\
+    int			row;						\
+									\
+    old_storage = image->storage;					\
+    if ( old_storage->ref_count <= 1 ) {				\
+	return;								\
+    }									\
+									\
+    image->storage = DeVAS_image_storage_new (				\
+	    ( (size_t) DeVAS_image_n_rows ( image ) ) *			\
+	    DeVAS_image_n_cols ( image ) * sizeof ( TYPE ),		\
+	    old_storage->allocator, old_storage->pixel_type );		\
+    if ( ( image->stats != NULL ) &&					\
+	    ( image->stats->generation == old_storage->generation ) ) {	\
+	/* same pixel values, so cached statistics are still good */	\
+	image->stats->generation = image->storage->generation;		\
+    }									\
+    new_start_data = (TYPE *) image->storage->block;			\
+									\
+    for ( row = 0; row < DeVAS_image_n_rows ( image ); row++ ) {	\
+	memcpy ( new_start_data +					\
+		( ( (size_t) row ) * DeVAS_image_n_cols ( image ) ),	\
+		image->data[row],					\
+		DeVAS_image_n_cols ( image ) * sizeof ( TYPE ) );	\
+    }									\
+									\
+    image->start_data = new_start_data;					\
+    image->row_stride = DeVAS_image_n_cols ( image );			\
+    TYPE##_image_line_pointers ( image->data, new_start_data,		\
+	    DeVAS_image_n_rows ( image ), image->row_stride,		\
+	    "DeVAS_image_make_writable" );				\
+									\
+    DeVAS_image_storage_release ( old_storage );			\
+}
+
+DeVAS_IMAGE_MAKE_WRITABLE ( DeVAS_gray )
+DeVAS_IMAGE_MAKE_WRITABLE ( DeVAS_double )
+DeVAS_IMAGE_MAKE_WRITABLE ( DeVAS_RGB )
+DeVAS_IMAGE_MAKE_WRITABLE ( DeVAS_RGBf )
+DeVAS_IMAGE_MAKE_WRITABLE ( DeVAS_XYZ )
+DeVAS_IMAGE_MAKE_WRITABLE ( DeVAS_xyY )
+DeVAS_IMAGE_MAKE_WRITABLE ( DeVAS_float )
+DeVAS_IMAGE_MAKE_WRITABLE ( DeVAS_complexf )
+/* DeVAS_IMAGE_MAKE_WRITABLE ( DeVAS_complexd ) */
+
+static size_t	mapped_threshold = 0;		/* 0 => never automatic */
+static int	mapped_threshold_initialized = FALSE;
+
+size_t
+DeVAS_image_mapped_threshold ( void )
+/*
+ * Images with at least this many bytes of pixels are given file-backed
+ * storage by <DeVAS_type>_image_new.  The initial value comes from the
+ * environment variable DeVAS_MAPPED_THRESHOLD (e.g., "4G"), if set.
+ * 0 means file-backed storage is only used when malloc fails.
+ */
+{
+    char    *env_value;
+
+    if ( !mapped_threshold_initialized ) {
+	mapped_threshold_initialized = TRUE;
+	env_value = getenv ( "DeVAS_MAPPED_THRESHOLD" );
+	if ( ( env_value != NULL ) &&
+		!DeVAS_parse_memory_size ( env_value, &mapped_threshold ) ) {
+	    fprintf ( stderr,
+		    "invalid DeVAS_MAPPED_THRESHOLD value (%s), ignored\n",
+		    env_value );
+	    mapped_threshold = 0;
+	}
+    }
+
+    return ( mapped_threshold );
+}
+
+void
+DeVAS_image_set_mapped_threshold ( size_t threshold )
+{
+    mapped_threshold_initialized = TRUE;
+    mapped_threshold = threshold;
+}
+
+int
+DeVAS_parse_memory_size ( char *string, size_t *size )
+/*
+ * Parse a byte count with an optional K, M, G, or T suffix (powers of
+ * 1024, case insensitive).  Returns FALSE if string is not valid.
+ */
+{
+    double  value;
+    char    *end;
+
+    value = strtod ( string, &end );
+    if ( ( end == string ) || ( value < 0.0 ) ) {
+	return ( FALSE );
+    }
+
+    switch ( *end ) {
+	case 'k':
+	case 'K':
+	    value *= 1024.0;
+	    end++;
+	    break;
+
+	case 'm':
+	case 'M':
+	    value *= 1024.0 * 1024.0;
+	    end++;
+	    break;
+
+	case 'g':
+	case 'G':
+	    value *= 1024.0 * 1024.0 * 1024.0;
+	    end++;
+	    break;
+
+	case 't':
+	case 'T':
+	    value *= 1024.0 * 1024.0 * 1024.0 * 1024.0;
+	    end++;
+	    break;
+    }
+    if ( ( *end == 'b' ) || ( *end == 'B' ) ) {
+	end++;
+    }
+    if ( *end != '\0' ) {
+	return ( FALSE );
+    }
+
+    *size = (size_t) value;
+
+    return ( TRUE );
+}
+
+static void *
+DeVAS_map_temp_file ( size_t size )
+/*
+ * Memory map an unlinked temporary file of the requested size, in the
+ * directory given by TMPDIR (default /tmp).  The OS pages the contents in
+ * and out as needed.  Returns NULL on failure.
+ */
+{
+#ifndef	_mingw64_cross
+    char    *directory;
+    char    *filename;
+    int	    fd;
+    void    *block;
+
+    if ( size == 0 ) {
+	return ( NULL );
+    }
+
+    directory = getenv ( "TMPDIR" );
+    if ( ( directory == NULL ) || ( *directory == '\0' ) ) {
+	directory = "/tmp";
+    }
+    filename = (char *) malloc ( strlen ( directory ) +
+	    strlen ( "/DeVAS-image-XXXXXX" ) + 1 );
+    if ( filename == NULL ) {
+	return ( NULL );
+    }
+    strcpy ( filename, directory );
+    strcat ( filename, "/DeVAS-image-XXXXXX" );
+
+    fd = mkstemp ( filename );
+    if ( fd < 0 ) {
+	perror ( filename );
+	free ( filename );
+	return ( NULL );
+    }
+    unlink ( filename );	/* file goes away when the mapping does */
+    free ( filename );
+
+    if ( ftruncate ( fd, (off_t) size ) != 0 ) {
+	perror ( "DeVAS_image_new_mapped" );
+	close ( fd );
+	return ( NULL );
+    }
+
+    block = mmap ( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    close ( fd );
+    if ( block == MAP_FAILED ) {
+	perror ( "DeVAS_image_new_mapped" );
+	return ( NULL );
+    }
+
+    /* images are mostly walked in row order */
+    (void) madvise ( block, size, MADV_SEQUENTIAL );
+
+    return ( block );
 #else
-DeVAS_IMAGE_DELETE_FFTW_SINGLE ( DeVAS_float )
-DeVAS_IMAGE_DELETE_FFTW_SINGLE ( DeVAS_complexf )
-/* DeVAS_IMAGE_DELETE_FFTW_SINGLE ( DeVAS_complexd ) */
+    return ( NULL );	/* no mmap, caller falls back on malloc */
+#endif	/* _mingw64_cross */
+}
+
+static unsigned long	storage_generation = 0;
+
+DeVAS_Image_Storage *
+DeVAS_image_storage_new ( size_t size, int allocator, char *pixel_type )
+/*
+ * Allocate a block of pixel storage with a reference count of 1.  The
+ * block is accounted for under pixel_type (see devas-memory.h).
+ *
+ * DeVAS_STORAGE_MALLOC storage that is at least
+ * DeVAS_image_mapped_threshold ( ) bytes, or that malloc can't provide,
+ * is file-backed instead.  DeVAS_STORAGE_MAPPED storage falls back on
+ * malloc where memory mapping is not available.
+ */
+{
+    DeVAS_Image_Storage	*storage;
+    size_t		threshold;
+
+    storage = (DeVAS_Image_Storage *) malloc ( sizeof ( DeVAS_Image_Storage ) );
+    if ( storage == NULL ) {
+	fprintf ( stderr, "DeVAS_image_new: malloc failed!" );
+	DeVAS_print_file_lineno ( __FILE__, __LINE__ );
+        exit ( EXIT_FAILURE );
+    }
+
+    storage->ref_count = 1;
+    storage->allocator = allocator;
+    storage->size = size;
+    storage->block = NULL;
+    storage->pixel_type = pixel_type;
+    storage->generation = ++storage_generation;
+
+    switch ( allocator ) {
+
+	case DeVAS_STORAGE_MALLOC:
+	    threshold = DeVAS_image_mapped_threshold ( );
+	    if ( ( threshold > 0 ) && ( size >= threshold ) ) {
+		storage->block = DeVAS_map_temp_file ( size );
+		if ( storage->block != NULL ) {
+		    storage->allocator = DeVAS_STORAGE_MAPPED;
+		    break;
+		}
+	    }
+	    storage->block = malloc ( size );
+	    if ( ( storage->block == NULL ) && ( size > 0 ) ) {
+		storage->block = DeVAS_map_temp_file ( size );
+		if ( storage->block != NULL ) {
+		    storage->allocator = DeVAS_STORAGE_MAPPED;
+		}
+	    }
+	    break;
+
+	case DeVAS_STORAGE_MAPPED:
+	    storage->block = DeVAS_map_temp_file ( size );
+	    if ( storage->block == NULL ) {
+		storage->allocator = DeVAS_STORAGE_MALLOC;
+		storage->block = malloc ( size );
+	    }
+	    break;
+
+#ifdef DeVAS_USE_FFTW3_ALLOCATORS
+	case DeVAS_STORAGE_FFTW:
+	    storage->block = fftwf_malloc ( size );
+	    break;
 #endif	/* DeVAS_USE_FFTW3_ALLOCATORS */
 
+	default:
+	    fprintf ( stderr, "DeVAS_image_storage_new: invalid allocator!\n" );
+	    DeVAS_print_file_lineno ( __FILE__, __LINE__ );
+	    exit ( EXIT_FAILURE );
+    }
+
+    if ( storage->block == NULL ) {
+	fprintf ( stderr, "DeVAS_image_new: malloc failed!" );
+	DeVAS_print_file_lineno ( __FILE__, __LINE__ );
+        exit ( EXIT_FAILURE );
+    }
+
+    DeVAS_memory_allocated ( pixel_type, size );
+
+    return ( storage );
+}
+
+DeVAS_Image_Storage *
+DeVAS_image_storage_adopt ( void *block, size_t size, int allocator,
+	char *pixel_type )
+/*
+ * Take over an already allocated block of pixels, which will be freed
+ * using the specified allocator along with the last reference.  The
+ * block must already have been accounted for under pixel_type.
+ */
+{
+    DeVAS_Image_Storage	*storage;
+
+    storage = (DeVAS_Image_Storage *) malloc ( sizeof ( DeVAS_Image_Storage ) );
+    if ( storage == NULL ) {
+	fprintf ( stderr, "DeVAS_image_storage_adopt: malloc failed!" );
+	DeVAS_print_file_lineno ( __FILE__, __LINE__ );
+        exit ( EXIT_FAILURE );
+    }
+
+    storage->ref_count = 1;
+    storage->allocator = allocator;
+    storage->size = size;
+    storage->block = block;
+    storage->pixel_type = pixel_type;
+    storage->generation = ++storage_generation;
+
+    return ( storage );
+}
+
+void
+DeVAS_image_storage_release ( DeVAS_Image_Storage *storage )
+/*
+ * Drop one reference.  The block is freed along with the last reference.
+ */
+{
+    if ( --storage->ref_count > 0 ) {
+	return;
+    }
+
+    switch ( storage->allocator ) {
+
+	case DeVAS_STORAGE_MALLOC:
+	    free ( storage->block );
+	    break;
+
+#ifndef	_mingw64_cross
+	case DeVAS_STORAGE_MAPPED:
+	    munmap ( storage->block, storage->size );
+	    break;
+#endif	/* _mingw64_cross */
+
+#ifdef DeVAS_USE_FFTW3_ALLOCATORS
+	case DeVAS_STORAGE_FFTW:
+	    fftwf_free ( storage->block );
+	    break;
+#endif	/* DeVAS_USE_FFTW3_ALLOCATORS */
+    }
+
+    DeVAS_memory_freed ( storage->pixel_type, storage->size );
+
+    free ( storage );
+}
+
+void
+DeVAS_image_storage_modified ( DeVAS_Image_Storage *storage )
+/*
+ * Invalidates statistics cached by any image object using storage.
+ */
+{
+    storage->generation = ++storage_generation;
+}
+
 void
 DeVAS_image_check_bounds ( DeVAS_gray_image *devas_image, int row, int col,
        int line, char *file )
@@ -416,19 +1408,25 @@ DeVAS_IMAGE_SAMESIZE ( DeVAS_complexf )
 /* DeVAS_IMAGE_SAMESIZE ( DeVAS_complexd ) */
 
 #define	DeVAS_IMAGE_SETVALUE( TYPE )					\
+static void								\
+TYPE##_span_setvalue ( void *value, TYPE *span, int n )		\
+{									\
+    TYPE    pixel;							\
+    int	    i;								\
+									\
+    pixel = *( (TYPE *) value );					\
+    for ( i = 0; i < n; i++ ) {						\
+	span[i] = pixel;						\
+    }									\
+}									\
+									\
 void									\
 TYPE##_image_setvalue ( TYPE##_image *image, TYPE value )		\
 /*									\
  * Set every pixel to a given value.					\
  */									\
 {									\
-    int	    row, col;							\
-									\
-    for ( row = 0; row < DeVAS_image_n_rows ( image ); row++ ) {	\
-	for ( col = 0; col < DeVAS_image_n_cols ( image ); col++ ) {	\
-	    DeVAS_image_data ( image, row, col ) = value;		\
-	}								\
-    }									\
+    TYPE##_image_map ( image, TYPE##_span_setvalue, (void *) &value );	\
 }
 
 DeVAS_IMAGE_SETVALUE ( DeVAS_gray )
@@ -440,3 +1438,366 @@ DeVAS_IMAGE_SETVALUE ( DeVAS_xyY )
 DeVAS_IMAGE_SETVALUE ( DeVAS_float )
 DeVAS_IMAGE_SETVALUE ( DeVAS_complexf )
 /* DeVAS_IMAGE_SETVALUE ( DeVAS_complexd ) */
+
+static int
+DeVAS_image_stats_bin ( float value )
+/*
+ * Histogram bin for value.  The bits of a positive float are, in order,
+ * the exponent and then the mantissa, so the exponent and the leading
+ * mantissa bits together give the octave and the position within it.
+ */
+{
+    uint32_t	bits;
+    int		bin;
+
+    if ( !( value > 0.0 ) ) {
+	return ( 0 );	/* zero, negative values, and NaN */
+    }
+
+    memcpy ( &bits, &value, sizeof ( bits ) );
+    bin = ( (int) ( bits >> 20 ) ) - ( ( 127 + DeVAS_STATS_MIN_OCTAVE ) << 3 )
+	+ 1;		/* 8 bins/octave: 3 leading mantissa bits of 23 */
+
+    if ( bin < 0 ) {
+	return ( 0 );
+    }
+    return ( bin < DeVAS_STATS_N_BINS ? bin : DeVAS_STATS_N_BINS - 1 );
+}
+
+void
+DeVAS_image_stats_clear ( DeVAS_Image_Stats *stats )
+{
+    int	    bin;
+
+    stats->generation = 0;
+    stats->n_pixels = 0.0;
+    stats->min = HUGE_VAL;
+    stats->max = -HUGE_VAL;
+    stats->sum = 0.0;
+
+    for ( bin = 0; bin < DeVAS_STATS_N_BINS; bin++ ) {
+	stats->histogram[bin] = 0;
+	stats->bin_min[bin] = HUGE_VAL;
+	stats->bin_max[bin] = -HUGE_VAL;
+    }
+}
+
+void
+DeVAS_image_stats_add_RGBf_pixels ( DeVAS_Image_Stats *stats,
+	DeVAS_RGBf *pixels, int n, double *row_sum )
+/*
+ * Accumulates the statistics for n pixels, in a single pass, except that
+ * the per-pixel maxima are added to *row_sum rather than to stats->sum.
+ * Adding each row's sum to stats->sum in row order, as
+ * DeVAS_image_stats_add_RGBf_row does, makes the sum independent of how
+ * rows are split into blocks or divided among threads.
+ */
+{
+    int	    col;
+    float   pixel_max, pixel_min;
+    int	    bin;
+
+    for ( col = 0; col < n; col++ ) {
+	pixel_max = pixel_min = pixels[col].red;
+	if ( pixels[col].green > pixel_max ) {
+	    pixel_max = pixels[col].green;
+	}
+	if ( pixels[col].blue > pixel_max ) {
+	    pixel_max = pixels[col].blue;
+	}
+	if ( pixels[col].green < pixel_min ) {
+	    pixel_min = pixels[col].green;
+	}
+	if ( pixels[col].blue < pixel_min ) {
+	    pixel_min = pixels[col].blue;
+	}
+
+	if ( pixel_max > stats->max ) {
+	    stats->max = pixel_max;
+	}
+	if ( pixel_min < stats->min ) {
+	    stats->min = pixel_min;
+	}
+	*row_sum += pixel_max;
+
+	bin = DeVAS_image_stats_bin ( pixel_max );
+	stats->histogram[bin]++;
+	if ( pixel_max < stats->bin_min[bin] ) {
+	    stats->bin_min[bin] = pixel_max;
+	}
+	if ( pixel_max > stats->bin_max[bin] ) {
+	    stats->bin_max[bin] = pixel_max;
+	}
+    }
+
+    stats->n_pixels += n;
+}
+
+void
+DeVAS_image_stats_add_RGBf_row ( DeVAS_Image_Stats *stats, DeVAS_RGBf *row,
+	int n_cols )
+/*
+ * Accumulates the statistics for one row of pixels, in a single pass.
+ */
+{
+    double  row_sum;
+
+    row_sum = 0.0;
+    DeVAS_image_stats_add_RGBf_pixels ( stats, row, n_cols, &row_sum );
+    stats->sum += row_sum;
+}
+
+typedef struct {		/* for DeVAS_image_stats_add_RGBf_rows */
+    DeVAS_RGBf		**rows;
+    int			n_cols;
+    int			band_rows;
+    DeVAS_Image_Stats	*band_stats;	/* per band */
+    double		*row_sums;	/* per row */
+} DeVAS_Stats_Rows;
+
+static void
+DeVAS_image_stats_band ( void *context, int band, int first_row,
+	int n_band_rows )
+{
+    DeVAS_Stats_Rows	*work;
+    int			row;
+
+    work = (DeVAS_Stats_Rows *) context;
+
+    DeVAS_image_stats_clear ( &work->band_stats[band] );
+    for ( row = first_row; row < first_row + n_band_rows; row++ ) {
+	work->row_sums[row] = 0.0;
+	DeVAS_image_stats_add_RGBf_pixels ( &work->band_stats[band],
+		work->rows[row], work->n_cols, &work->row_sums[row] );
+    }
+}
+
+DeVAS_Image_Stats *
+DeVAS_image_stats_bands_new ( int n_rows, int n_cols, int *band_rows,
+	double **row_sums )
+/*
+ * Scratch space for a parallel pass accumulating statistics: one
+ * DeVAS_Image_Stats per band of rows (see devas-parallel.h) and one sum
+ * per row.  Free both when done.
+ */
+{
+    DeVAS_Image_Stats	*band_stats;
+
+    *band_rows = DeVAS_parallel_band_rows ( n_cols );
+    band_stats = (DeVAS_Image_Stats *) malloc ( ( DeVAS_parallel_n_bands (
+		    n_rows, *band_rows ) + 1 ) * sizeof ( DeVAS_Image_Stats ) );
+    *row_sums = (double *) malloc ( ( n_rows + 1 ) * sizeof ( double ) );
+    if ( ( band_stats == NULL ) || ( *row_sums == NULL ) ) {
+	fprintf ( stderr, "DeVAS_image_stats_bands_new: malloc failed!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    return ( band_stats );
+}
+
+void
+DeVAS_image_stats_bands_merge ( DeVAS_Image_Stats *stats,
+	DeVAS_Image_Stats *band_stats, int n_bands, double *row_sums,
+	int n_rows )
+/*
+ * Merges the per-band statistics pairwise (a tree, so the depth is
+ * log2 n_bands) and adds the result, and then the row sums in row order,
+ * into stats.
+ */
+{
+    int	    step, band, row;
+
+    for ( step = 1; step < n_bands; step *= 2 ) {
+	for ( band = 0; band + step < n_bands; band += 2 * step ) {
+	    DeVAS_image_stats_merge ( &band_stats[band],
+		    &band_stats[band + step] );
+	}
+    }
+
+    if ( n_bands > 0 ) {
+	band_stats[0].sum = 0.0;
+	DeVAS_image_stats_merge ( stats, &band_stats[0] );
+    }
+    for ( row = 0; row < n_rows; row++ ) {
+	stats->sum += row_sums[row];
+    }
+}
+
+void
+DeVAS_image_stats_add_RGBf_rows ( DeVAS_Image_Stats *stats,
+	DeVAS_RGBf **rows, int n_rows, int n_cols )
+/*
+ * As DeVAS_image_stats_add_RGBf_row for each of n_rows rows, in parallel
+ * over bands of rows.
+ */
+{
+    DeVAS_Stats_Rows	work;
+
+    work.rows = rows;
+    work.n_cols = n_cols;
+    work.band_stats = DeVAS_image_stats_bands_new ( n_rows, n_cols,
+	    &work.band_rows, &work.row_sums );
+
+    DeVAS_parallel_bands ( n_rows, work.band_rows, DeVAS_image_stats_band,
+	    (void *) &work );
+
+    DeVAS_image_stats_bands_merge ( stats, work.band_stats,
+	    DeVAS_parallel_n_bands ( n_rows, work.band_rows ), work.row_sums,
+	    n_rows );
+
+    free ( work.band_stats );
+    free ( work.row_sums );
+}
+
+DeVAS_Image_Stats *
+DeVAS_RGBf_image_stats ( DeVAS_RGBf_image *image )
+/*
+ * Statistics for image, computed on first use and then cached until the
+ * pixels are modified.  Code that changes pixel values directly (through
+ * DeVAS_image_data) must call DeVAS_image_modified afterward, which
+ * invalidates the statistics of every image object sharing the pixels.
+ * The result belongs to the image object and should not be freed.
+ */
+{
+    if ( ( image->stats != NULL ) &&
+	    ( image->stats->generation == image->storage->generation ) ) {
+	return ( image->stats );
+    }
+
+    if ( image->stats == NULL ) {
+	image->stats = (DeVAS_Image_Stats *)
+	    malloc ( sizeof ( DeVAS_Image_Stats ) );
+	if ( image->stats == NULL ) {
+	    fprintf ( stderr, "DeVAS_RGBf_image_stats: malloc failed!\n" );
+	    exit ( EXIT_FAILURE );
+	}
+    }
+
+    DeVAS_image_stats_clear ( image->stats );
+    DeVAS_image_stats_add_RGBf_rows ( image->stats, image->data,
+	    DeVAS_image_n_rows ( image ), DeVAS_image_n_cols ( image ) );
+    image->stats->generation = image->storage->generation;
+
+    return ( image->stats );
+}
+
+void
+DeVAS_RGBf_image_set_stats ( DeVAS_RGBf_image *image,
+	DeVAS_Image_Stats *stats )
+/*
+ * Install statistics accumulated while pixels were being modified, so
+ * that the next DeVAS_RGBf_image_stats doesn't have to make another pass.
+ * Call after DeVAS_image_modified.
+ */
+{
+    if ( image->stats == NULL ) {
+	image->stats = (DeVAS_Image_Stats *)
+	    malloc ( sizeof ( DeVAS_Image_Stats ) );
+	if ( image->stats == NULL ) {
+	    fprintf ( stderr, "DeVAS_RGBf_image_set_stats: malloc failed!\n" );
+	    exit ( EXIT_FAILURE );
+	}
+    }
+
+    *image->stats = *stats;
+    image->stats->generation = image->storage->generation;
+}
+
+int
+DeVAS_image_stats_max_at_or_below ( DeVAS_Image_Stats *stats, double cutoff,
+	double *max_value )
+/*
+ * Uses the histogram to find the largest per-pixel maximum over channels
+ * that is <= cutoff (-HUGE_VAL if there is none).  Returns FALSE if that
+ * can't be determined exactly because the bin containing cutoff has
+ * values on both sides of it, in which case the pixels have to be
+ * examined.
+ */
+{
+    int	    bin;
+
+    for ( bin = DeVAS_STATS_N_BINS - 1; bin >= 0; bin-- ) {
+	if ( ( stats->histogram[bin] == 0 ) ||
+		( stats->bin_min[bin] > cutoff ) ) {
+	    continue;		/* empty, or all above cutoff */
+	}
+	if ( stats->bin_max[bin] <= cutoff ) {
+	    *max_value = stats->bin_max[bin];
+	    return ( TRUE );	/* bins are ordered, so this is it */
+	}
+	return ( FALSE );
+    }
+
+    *max_value = -HUGE_VAL;
+    return ( TRUE );
+}
+
+void
+DeVAS_image_stats_merge ( DeVAS_Image_Stats *stats, DeVAS_Image_Stats *part )
+/*
+ * Adds the statistics in part to stats.  The result is the same as
+ * accumulating both sets of pixels into stats, except that the sum can
+ * differ in the last bits, since it is added up in a different order.
+ */
+{
+    int	    bin;
+
+    stats->n_pixels += part->n_pixels;
+    if ( part->min < stats->min ) {
+	stats->min = part->min;
+    }
+    if ( part->max > stats->max ) {
+	stats->max = part->max;
+    }
+    stats->sum += part->sum;
+
+    for ( bin = 0; bin < DeVAS_STATS_N_BINS; bin++ ) {
+	stats->histogram[bin] += part->histogram[bin];
+	if ( part->bin_min[bin] < stats->bin_min[bin] ) {
+	    stats->bin_min[bin] = part->bin_min[bin];
+	}
+	if ( part->bin_max[bin] > stats->bin_max[bin] ) {
+	    stats->bin_max[bin] = part->bin_max[bin];
+	}
+    }
+}
+
+double
+DeVAS_image_stats_glare_threshold ( DeVAS_Image_Stats *stats )
+/*
+ * Suggests a level above which a pixel should be considered a glare
+ * source, using the maximum over R, G, and B instead of luminance.
+ *
+ * A variant of the RADIANCE glare identification heuristic: the average
+ * of the per-pixel maximum sets a preliminary threshold,
+ * DeVAS_GLARE_LEVEL_RATIO times the average.  If there are brighter
+ * pixels, the result is the largest per-pixel maximum at or below that
+ * threshold, found in the histogram.  When the bin containing the
+ * threshold also has values above it, the threshold itself is returned,
+ * which is above the exact answer by less than the width of a bin
+ * (a factor of 2^(1/DeVAS_STATS_BINS_PER_OCTAVE)).
+ */
+{
+    double  max_value;
+    double  glare_cutoff_initial;
+
+    if ( stats->n_pixels <= 0.0 ) {
+	return ( 0.0 );
+    }
+
+    max_value = ( stats->max > 0.0 ) ? stats->max : 0.0;
+    glare_cutoff_initial = DeVAS_GLARE_LEVEL_RATIO *
+	( stats->sum / stats->n_pixels );
+
+    if ( glare_cutoff_initial >= max_value ) {
+	/* no need for glare source clipping */
+	return ( max_value );
+    }
+
+    if ( !DeVAS_image_stats_max_at_or_below ( stats, glare_cutoff_initial,
+		&max_value ) ) {
+	return ( glare_cutoff_initial );	/* within bin precision */
+    }
+
+    return ( ( max_value > 0.0 ) ? max_value : 0.0 );
+}
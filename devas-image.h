@@ -95,6 +95,52 @@ typedef struct {
     				/* often, this will be history info */
 } DeVAS_Image_Info;
 
+#define	DeVAS_STORAGE_MALLOC	0	/* storage allocated with malloc */
+#define	DeVAS_STORAGE_FFTW	1	/* storage allocated with fftwf_malloc */
+#define	DeVAS_STORAGE_MAPPED	2	/* memory-mapped temporary file */
+
+typedef struct {		/* pixel storage, possibly shared by */
+    				/* several image objects */
+    int	    ref_count;		/* number of image objects using block */
+    int	    allocator;		/* DeVAS_STORAGE_MALLOC or ..._FFTW */
+    size_t  size;		/* size of block in bytes */
+    void    *block;		/* start of allocated data block */
+    char    *pixel_type;	/* for devas-memory.h accounting */
+    unsigned long generation;	/* changes whenever pixels are modified */
+} DeVAS_Image_Storage;
+
+/*
+ * Histogram bins for DeVAS_Image_Stats are spaced logarithmically,
+ * DeVAS_STATS_BINS_PER_OCTAVE (which the binning code assumes is 8) to a
+ * factor of two.  Bin 0 holds values below 2^DeVAS_STATS_MIN_OCTAVE
+ * (including zero and negative values) and the last bin holds values at
+ * or above 2^DeVAS_STATS_MAX_OCTAVE.
+ */
+#define	DeVAS_STATS_BINS_PER_OCTAVE	8
+#define	DeVAS_STATS_MIN_OCTAVE		(-40)
+#define	DeVAS_STATS_MAX_OCTAVE		40
+#define	DeVAS_STATS_N_BINS						\
+	( ( ( DeVAS_STATS_MAX_OCTAVE - DeVAS_STATS_MIN_OCTAVE ) *	\
+	    DeVAS_STATS_BINS_PER_OCTAVE ) + 2 )
+
+typedef struct {		/* statistics of a three channel float */
+    				/* image, cached with the image object */
+    unsigned long generation;	/* storage generation when computed */
+    double  n_pixels;
+    double  min, max;		/* over all three channels */
+    double  sum;		/* of the per-pixel maximum over channels */
+    unsigned long histogram[DeVAS_STATS_N_BINS];
+				/* of the per-pixel maximum over channels */
+    float   bin_min[DeVAS_STATS_N_BINS];	/* range of values actually */
+    float   bin_max[DeVAS_STATS_N_BINS];	/* in each bin */
+} DeVAS_Image_Stats;
+
+#define	DeVAS_GLARE_LEVEL_RATIO	5.0	/* RADIANCE identifies glare sources */
+					/* as being brighter than 7 times */
+					/* the average luminance level. */
+					/* This is slightly more */
+					/* conservative. */
+
 #define	NULLVIEW	{'\0',{0.,0.,0.},{0.,0.,0.},{0.,0.,0.}, \
 				0.,0.,0.,0.,0.,0.,0., \
 				{0.,0.,0.},{0.,0.,0.},0.,0.}
@@ -110,8 +156,11 @@ typedef struct {							      \
     					/* 1.0 if exposure not explicitly */  \
 					/* set */			      \
     DeVAS_Image_Info image_info;		/* info needed by devas-filter */      \
-    TYPE            *start_data;        /* start of allocated data block */   \
+    TYPE            *start_data;        /* first pixel of this image */	      \
     TYPE            **data;             /* array of pointers to array rows */ \
+    int		    row_stride;		/* pixels between starts of rows */   \
+    DeVAS_Image_Storage *storage;	/* shared, reference counted */	      \
+    DeVAS_Image_Stats *stats;		/* cached, or NULL */		      \
 } TYPE##_image;
 
 DeVAS_DEFINE_IMAGE_TYPE ( DeVAS_gray )
@@ -172,6 +221,22 @@ DeVAS_DEFINE_IMAGE_TYPE ( DeVAS_complexf )
 #define	DeVAS_image_exposure(devas_image)	(devas_image)->exposure
     			/* read/write */
 
+#define	DeVAS_image_row_stride(devas_image)	(devas_image)->row_stride
+    			/* read only; n_cols unless image is a region */
+
+#define	DeVAS_image_is_contiguous(devas_image)				\
+		( DeVAS_image_row_stride ( devas_image ) ==		\
+		    DeVAS_image_n_cols ( devas_image ) )
+    			/* TRUE if rows are adjacent in memory */
+
+#define	DeVAS_image_is_shared(devas_image)				\
+		( (devas_image)->storage->ref_count > 1 )
+    			/* TRUE if storage is used by other image objects */
+
+#define	DeVAS_image_modified(devas_image)				\
+		DeVAS_image_storage_modified ( (devas_image)->storage )
+    			/* call after changing pixel values */
+
 /*
  * function prototypes:
  */
@@ -192,6 +257,22 @@ DeVAS_xyY    DeVAS_RGBf2xyY ( DeVAS_RGBf RGBf );
 DeVAS_RGBf   DeVAS_Y2RGBf ( DeVAS_float Y );
 float	    DeVAS_RGBf2Y ( DeVAS_RGBf RGBf );
 
+void	    DeVAS_RGBf_row_to_XYZ ( const DeVAS_RGBf *src, DeVAS_XYZ *dst,
+		int n );
+void	    DeVAS_XYZ_row_to_RGBf ( const DeVAS_XYZ *src, DeVAS_RGBf *dst,
+		int n );
+void	    DeVAS_XYZ_row_to_xyY ( const DeVAS_XYZ *src, DeVAS_xyY *dst,
+		int n );
+void	    DeVAS_xyY_row_to_XYZ ( const DeVAS_xyY *src, DeVAS_XYZ *dst,
+		int n );
+void	    DeVAS_RGBf_row_to_xyY ( const DeVAS_RGBf *src, DeVAS_xyY *dst,
+		int n );
+void	    DeVAS_xyY_row_to_RGBf ( const DeVAS_xyY *src, DeVAS_RGBf *dst,
+		int n );
+void	    DeVAS_RGBf_row_to_Y ( const DeVAS_RGBf *src, float *dst, int n );
+void	    DeVAS_RGBf_row_colortrans ( float matrix[3][3],
+		const DeVAS_RGBf *src, DeVAS_RGBf *dst, int n );
+
 /* Note that order is (n_rows,n_cols), not (x,y) or (width,height)!!! */
 #define DeVAS_PROTOTYPE_IMAGE_NEW( TYPE )				\
 TYPE##_image    *TYPE##_image_new ( unsigned int n_rows, unsigned int n_cols );
@@ -206,6 +287,20 @@ DeVAS_PROTOTYPE_IMAGE_NEW ( DeVAS_xyY )
 DeVAS_PROTOTYPE_IMAGE_NEW ( DeVAS_complexf )
 /* DeVAS_PROTOTYPE_IMAGE_NEW ( DeVAS_complexd ) */
 
+#define DeVAS_PROTOTYPE_IMAGE_NEW_MAPPED( TYPE )			\
+TYPE##_image    *TYPE##_image_new_mapped ( unsigned int n_rows,		\
+		    unsigned int n_cols );
+
+DeVAS_PROTOTYPE_IMAGE_NEW_MAPPED ( DeVAS_gray )
+DeVAS_PROTOTYPE_IMAGE_NEW_MAPPED ( DeVAS_float )
+DeVAS_PROTOTYPE_IMAGE_NEW_MAPPED ( DeVAS_double )
+DeVAS_PROTOTYPE_IMAGE_NEW_MAPPED ( DeVAS_RGB )
+DeVAS_PROTOTYPE_IMAGE_NEW_MAPPED ( DeVAS_RGBf )
+DeVAS_PROTOTYPE_IMAGE_NEW_MAPPED ( DeVAS_XYZ )
+DeVAS_PROTOTYPE_IMAGE_NEW_MAPPED ( DeVAS_xyY )
+DeVAS_PROTOTYPE_IMAGE_NEW_MAPPED ( DeVAS_complexf )
+/* DeVAS_PROTOTYPE_IMAGE_NEW_MAPPED ( DeVAS_complexd ) */
+
 #define DeVAS_PROTOTYPE_IMAGE_DELETE( TYPE )				\
 void    TYPE##_image_delete ( TYPE##_image *i );
 
@@ -219,6 +314,91 @@ DeVAS_PROTOTYPE_IMAGE_DELETE ( DeVAS_xyY )
 DeVAS_PROTOTYPE_IMAGE_DELETE ( DeVAS_complexf )
 /* DeVAS_PROTOTYPE_IMAGE_DELETE ( DeVAS_complexd ) */
 
+#define DeVAS_PROTOTYPE_IMAGE_REGION( TYPE )				\
+TYPE##_image	*TYPE##_image_region ( TYPE##_image *parent,		\
+		    int first_row, int first_col, int n_rows,		\
+		    int n_cols );
+
+DeVAS_PROTOTYPE_IMAGE_REGION ( DeVAS_gray )
+DeVAS_PROTOTYPE_IMAGE_REGION ( DeVAS_float )
+DeVAS_PROTOTYPE_IMAGE_REGION ( DeVAS_double )
+DeVAS_PROTOTYPE_IMAGE_REGION ( DeVAS_RGB )
+DeVAS_PROTOTYPE_IMAGE_REGION ( DeVAS_RGBf )
+DeVAS_PROTOTYPE_IMAGE_REGION ( DeVAS_XYZ )
+DeVAS_PROTOTYPE_IMAGE_REGION ( DeVAS_xyY )
+DeVAS_PROTOTYPE_IMAGE_REGION ( DeVAS_complexf )
+/* DeVAS_PROTOTYPE_IMAGE_REGION ( DeVAS_complexd ) */
+
+#define DeVAS_PROTOTYPE_IMAGE_SHARE( TYPE )				\
+TYPE##_image	*TYPE##_image_share ( TYPE##_image *image );
+
+DeVAS_PROTOTYPE_IMAGE_SHARE ( DeVAS_gray )
+DeVAS_PROTOTYPE_IMAGE_SHARE ( DeVAS_float )
+DeVAS_PROTOTYPE_IMAGE_SHARE ( DeVAS_double )
+DeVAS_PROTOTYPE_IMAGE_SHARE ( DeVAS_RGB )
+DeVAS_PROTOTYPE_IMAGE_SHARE ( DeVAS_RGBf )
+DeVAS_PROTOTYPE_IMAGE_SHARE ( DeVAS_XYZ )
+DeVAS_PROTOTYPE_IMAGE_SHARE ( DeVAS_xyY )
+DeVAS_PROTOTYPE_IMAGE_SHARE ( DeVAS_complexf )
+/* DeVAS_PROTOTYPE_IMAGE_SHARE ( DeVAS_complexd ) */
+
+#define DeVAS_PROTOTYPE_IMAGE_MAKE_WRITABLE( TYPE )			\
+void	TYPE##_image_make_writable ( TYPE##_image *image );
+
+DeVAS_PROTOTYPE_IMAGE_MAKE_WRITABLE ( DeVAS_gray )
+DeVAS_PROTOTYPE_IMAGE_MAKE_WRITABLE ( DeVAS_float )
+DeVAS_PROTOTYPE_IMAGE_MAKE_WRITABLE ( DeVAS_double )
+DeVAS_PROTOTYPE_IMAGE_MAKE_WRITABLE ( DeVAS_RGB )
+DeVAS_PROTOTYPE_IMAGE_MAKE_WRITABLE ( DeVAS_RGBf )
+DeVAS_PROTOTYPE_IMAGE_MAKE_WRITABLE ( DeVAS_XYZ )
+DeVAS_PROTOTYPE_IMAGE_MAKE_WRITABLE ( DeVAS_xyY )
+DeVAS_PROTOTYPE_IMAGE_MAKE_WRITABLE ( DeVAS_complexf )
+/* DeVAS_PROTOTYPE_IMAGE_MAKE_WRITABLE ( DeVAS_complexd ) */
+
+DeVAS_Image_Storage *DeVAS_image_storage_new ( size_t size, int allocator,
+		    char *pixel_type );
+size_t	DeVAS_image_mapped_threshold ( void );
+void	DeVAS_image_set_mapped_threshold ( size_t threshold );
+int	DeVAS_parse_memory_size ( char *string, size_t *size );
+DeVAS_Image_Storage *DeVAS_image_storage_adopt ( void *block, size_t size,
+		    int allocator, char *pixel_type );
+void	DeVAS_image_storage_release ( DeVAS_Image_Storage *storage );
+void	DeVAS_image_storage_modified ( DeVAS_Image_Storage *storage );
+
+DeVAS_Image_Stats *DeVAS_RGBf_image_stats ( DeVAS_RGBf_image *image );
+void	DeVAS_RGBf_image_set_stats ( DeVAS_RGBf_image *image,
+	    DeVAS_Image_Stats *stats );
+void	DeVAS_image_stats_clear ( DeVAS_Image_Stats *stats );
+void	DeVAS_image_stats_add_RGBf_pixels ( DeVAS_Image_Stats *stats,
+	    DeVAS_RGBf *pixels, int n, double *row_sum );
+void	DeVAS_image_stats_add_RGBf_row ( DeVAS_Image_Stats *stats,
+	    DeVAS_RGBf *row, int n_cols );
+void	DeVAS_image_stats_add_RGBf_rows ( DeVAS_Image_Stats *stats,
+	    DeVAS_RGBf **rows, int n_rows, int n_cols );
+DeVAS_Image_Stats *DeVAS_image_stats_bands_new ( int n_rows, int n_cols,
+	    int *band_rows, double **row_sums );
+void	DeVAS_image_stats_bands_merge ( DeVAS_Image_Stats *stats,
+	    DeVAS_Image_Stats *band_stats, int n_bands, double *row_sums,
+	    int n_rows );
+int	DeVAS_image_stats_max_at_or_below ( DeVAS_Image_Stats *stats,
+	    double cutoff, double *max_value );
+void	DeVAS_image_stats_merge ( DeVAS_Image_Stats *stats,
+	    DeVAS_Image_Stats *part );
+double	DeVAS_image_stats_glare_threshold ( DeVAS_Image_Stats *stats );
+
+#define DeVAS_PROTOTYPE_IMAGE_COLORIMETRY( FROM, TO )			\
+void	DeVAS_##FROM##_image_to_##TO ( DeVAS_##FROM##_image *src,	\
+	    DeVAS_##TO##_image *dst );
+
+DeVAS_PROTOTYPE_IMAGE_COLORIMETRY ( RGBf, XYZ )
+DeVAS_PROTOTYPE_IMAGE_COLORIMETRY ( XYZ, RGBf )
+DeVAS_PROTOTYPE_IMAGE_COLORIMETRY ( XYZ, xyY )
+DeVAS_PROTOTYPE_IMAGE_COLORIMETRY ( xyY, XYZ )
+DeVAS_PROTOTYPE_IMAGE_COLORIMETRY ( RGBf, xyY )
+DeVAS_PROTOTYPE_IMAGE_COLORIMETRY ( xyY, RGBf )
+void	DeVAS_RGBf_image_to_Y ( DeVAS_RGBf_image *src,
+	    DeVAS_float_image *dst );
+
 void	DeVAS_image_check_bounds ( DeVAS_gray_image *devas_image, int row,
 	    int col, int lineno, char *file );
 
@@ -0,0 +1,533 @@
+/*
+ * C++17 interface to devas-image.h.  Header only.
+ *
+ *   DeVAS::Image<pixel>
+ *
+ *	Owns one DeVAS image object (<pixel>_image *), deleting it when the
+ *	Image goes away.  Move-only.  Image ( n_rows, n_cols ) makes a new
+ *	image; Image::adopt ( <c_image> ) takes over an existing one, and
+ *	release ( ) hands it back.  share ( ) and region ( first_row,
+ *	first_col, n_rows, n_cols ) give new Images on the same pixels
+ *	(see <type>_image_share and <type>_image_region), so as in C, writes
+ *	through one show up in the other until make_writable ( ) is called.
+ *
+ *   DeVAS::ImageRef<pixel>
+ *
+ *	Non-owning handle on a <pixel>_image * that belongs to C code.
+ *
+ * Both convert to the C object with get ( ), so the C functions can be
+ * called on them directly, and both give typed access with
+ * ( row, col ), row ( row ), n_rows ( ), and n_cols ( ).  Assigning an
+ * ImageRef copies pixels; for an Image, that is a = b.ref ( ).
+ *
+ * Arithmetic on images builds an expression, not an image.  Nothing is
+ * computed until the expression is assigned to an Image or ImageRef (or
+ * used to construct an Image), and then each output pixel is computed in
+ * a single loop over rows and columns, run in parallel over bands of
+ * rows (devas-parallel.h), with no temporary images:
+ *
+ *	DeVAS::Image<DeVAS_RGBf>    out ( in.n_rows ( ), in.n_cols ( ) );
+ *
+ *	out = DeVAS::clamp ( in * exposure + offset, 0.0f, 1.0f );
+ *
+ * Operands are images (Image or ImageRef), other expressions, scalars,
+ * and constant pixels.  Supported operations are +, -, *, / (channel by
+ * channel for three-channel pixels, and with scalars applied to every
+ * channel), DeVAS::min, DeVAS::max, DeVAS::clamp ( e, lo, hi ), and
+ * DeVAS::map ( e, f ), which applies a function object f to each pixel
+ * value.  Arithmetic is defined for DeVAS_float, DeVAS_double,
+ * DeVAS_RGBf, and DeVAS_XYZ pixels; DeVAS_RGBf and DeVAS_XYZ are kept
+ * apart, and mixing them is a compile-time error (use map with
+ * DeVAS_RGBf2XYZ or DeVAS_XYZ2RGBf).
+ *
+ * All images in an expression must be the same size as the output
+ * (otherwise a fatal error).  The output may also appear in the
+ * expression, since each pixel is read only to compute the same pixel.
+ * Assignment calls DeVAS_image_modified.
+ */
+
+#ifndef __DeVAS_IMAGE_HPP
+#define __DeVAS_IMAGE_HPP
+
+#if __cplusplus < 201703L
+#error "devas-image.hpp requires C++17"
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <type_traits>
+#include <utility>
+#include "devas-image.h"
+#include "devas-parallel.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+namespace DeVAS {
+
+/*
+ * C functions for each pixel type.
+ */
+
+template <class Pixel> struct image_traits;
+
+#define DeVAS_CXX_IMAGE_TRAITS( TYPE )					\
+template <> struct image_traits<TYPE> {					\
+    typedef TYPE##_image    c_image;					\
+    static c_image *create ( int n_rows, int n_cols )			\
+	{ return ( TYPE##_image_new ( n_rows, n_cols ) ); }		\
+    static void destroy ( c_image *image )				\
+	{ TYPE##_image_delete ( image ); }				\
+    static c_image *region ( c_image *parent, int first_row,		\
+	    int first_col, int n_rows, int n_cols )			\
+	{ return ( TYPE##_image_region ( parent, first_row, first_col,	\
+		    n_rows, n_cols ) ); }				\
+    static c_image *share ( c_image *image )				\
+	{ return ( TYPE##_image_share ( image ) ); }			\
+    static void make_writable ( c_image *image )			\
+	{ TYPE##_image_make_writable ( image ); }			\
+};
+
+DeVAS_CXX_IMAGE_TRAITS ( DeVAS_gray )
+DeVAS_CXX_IMAGE_TRAITS ( DeVAS_float )
+DeVAS_CXX_IMAGE_TRAITS ( DeVAS_double )
+DeVAS_CXX_IMAGE_TRAITS ( DeVAS_RGB )
+DeVAS_CXX_IMAGE_TRAITS ( DeVAS_RGBf )
+DeVAS_CXX_IMAGE_TRAITS ( DeVAS_XYZ )
+DeVAS_CXX_IMAGE_TRAITS ( DeVAS_xyY )
+DeVAS_CXX_IMAGE_TRAITS ( DeVAS_complexf )
+
+#undef DeVAS_CXX_IMAGE_TRAITS
+
+/*
+ * Pixel arithmetic.  For three-channel types, operations apply to each
+ * channel, and a scalar operand applies to all three.
+ */
+
+namespace pixel {
+
+inline float	add ( float a, float b ) { return ( a + b ); }
+inline float	sub ( float a, float b ) { return ( a - b ); }
+inline float	mul ( float a, float b ) { return ( a * b ); }
+inline float	div ( float a, float b ) { return ( a / b ); }
+inline float	min ( float a, float b ) { return ( b < a ? b : a ); }
+inline float	max ( float a, float b ) { return ( a < b ? b : a ); }
+
+inline double	add ( double a, double b ) { return ( a + b ); }
+inline double	sub ( double a, double b ) { return ( a - b ); }
+inline double	mul ( double a, double b ) { return ( a * b ); }
+inline double	div ( double a, double b ) { return ( a / b ); }
+inline double	min ( double a, double b ) { return ( b < a ? b : a ); }
+inline double	max ( double a, double b ) { return ( a < b ? b : a ); }
+
+#define DeVAS_CXX_MIXED_OP( OP )					\
+inline double OP ( float a, double b ) { return ( OP ( (double) a, b ) ); } \
+inline double OP ( double a, float b ) { return ( OP ( a, (double) b ) ); }
+
+DeVAS_CXX_MIXED_OP ( add )
+DeVAS_CXX_MIXED_OP ( sub )
+DeVAS_CXX_MIXED_OP ( mul )
+DeVAS_CXX_MIXED_OP ( div )
+DeVAS_CXX_MIXED_OP ( min )
+DeVAS_CXX_MIXED_OP ( max )
+
+#undef DeVAS_CXX_MIXED_OP
+
+#define DeVAS_CXX_CHANNEL_OP( TYPE, A, B, C, OP )			\
+inline TYPE OP ( TYPE x, TYPE y )					\
+    { return ( TYPE { OP ( x.A, y.A ), OP ( x.B, y.B ), OP ( x.C, y.C ) } ); } \
+inline TYPE OP ( TYPE x, float y )					\
+    { return ( TYPE { OP ( x.A, y ), OP ( x.B, y ), OP ( x.C, y ) } ); } \
+inline TYPE OP ( float x, TYPE y )					\
+    { return ( TYPE { OP ( x, y.A ), OP ( x, y.B ), OP ( x, y.C ) } ); }
+
+#define DeVAS_CXX_CHANNEL_OPS( TYPE, A, B, C )				\
+DeVAS_CXX_CHANNEL_OP ( TYPE, A, B, C, add )				\
+DeVAS_CXX_CHANNEL_OP ( TYPE, A, B, C, sub )				\
+DeVAS_CXX_CHANNEL_OP ( TYPE, A, B, C, mul )				\
+DeVAS_CXX_CHANNEL_OP ( TYPE, A, B, C, div )				\
+DeVAS_CXX_CHANNEL_OP ( TYPE, A, B, C, min )				\
+DeVAS_CXX_CHANNEL_OP ( TYPE, A, B, C, max )
+
+DeVAS_CXX_CHANNEL_OPS ( DeVAS_RGBf, red, green, blue )
+DeVAS_CXX_CHANNEL_OPS ( DeVAS_XYZ, X, Y, Z )
+
+#undef DeVAS_CXX_CHANNEL_OPS
+#undef DeVAS_CXX_CHANNEL_OP
+
+}	/* namespace pixel */
+
+/*
+ * Expressions.  Every expression type derives from Expression and has
+ *
+ *   row ( r )	    an object whose [ col ] is the value at ( r, col )
+ *   size ( &n_rows, &n_cols )
+ *		    TRUE and the size of the first image in the expression,
+ *		    or FALSE if there is none
+ *   fits ( n_rows, n_cols )
+ *		    TRUE if every image in the expression is that size
+ */
+
+struct Expression { };
+
+template <class T>
+constexpr bool is_expression = std::is_base_of_v<Expression,
+	std::decay_t<T>>;
+
+template <class Pixel>
+class Terminal : public Expression {	/* an image, in an expression */
+  public:
+    typedef typename image_traits<Pixel>::c_image   c_image;
+
+    explicit Terminal ( const c_image *image ) : image_ ( image ) { }
+
+    const Pixel *row ( int r ) const { return ( image_->data[r] ); }
+    bool size ( int *n_rows, int *n_cols ) const
+    {
+	*n_rows = image_->n_rows;
+	*n_cols = image_->n_cols;
+	return ( true );
+    }
+    bool fits ( int n_rows, int n_cols ) const
+	{ return ( ( image_->n_rows == n_rows ) &&
+		( image_->n_cols == n_cols ) ); }
+
+  private:
+    const c_image   *image_;
+};
+
+template <class Value>
+class Constant : public Expression {	/* a scalar or a pixel value */
+  public:
+    struct Row {
+	Value	value;
+	Value operator[] ( int ) const { return ( value ); }
+    };
+
+    explicit Constant ( Value value ) : value_ ( value ) { }
+
+    Row row ( int ) const { return ( Row { value_ } ); }
+    bool size ( int *, int * ) const { return ( false ); }
+    bool fits ( int, int ) const { return ( true ); }
+
+  private:
+    Value   value_;
+};
+
+template <class Op, class Left, class Right>
+class Binary : public Expression {
+  public:
+    template <class L, class R>
+    struct Row {
+	L	left;
+	R	right;
+	auto operator[] ( int col ) const
+	    { return ( Op::apply ( left[col], right[col] ) ); }
+    };
+
+    Binary ( Left left, Right right ) : left_ ( left ), right_ ( right ) { }
+
+    auto row ( int r ) const
+    {
+	return ( Row<decltype ( left_.row ( r ) ),
+		decltype ( right_.row ( r ) )> { left_.row ( r ),
+		    right_.row ( r ) } );
+    }
+    bool size ( int *n_rows, int *n_cols ) const
+	{ return ( left_.size ( n_rows, n_cols ) ||
+		right_.size ( n_rows, n_cols ) ); }
+    bool fits ( int n_rows, int n_cols ) const
+	{ return ( left_.fits ( n_rows, n_cols ) &&
+		right_.fits ( n_rows, n_cols ) ); }
+
+  private:
+    Left    left_;
+    Right   right_;
+};
+
+template <class Operand, class Function>
+class Map : public Expression {
+  public:
+    template <class R>
+    struct Row {
+	R		operand;
+	const Function	*function;
+	auto operator[] ( int col ) const
+	    { return ( ( *function ) ( operand[col] ) ); }
+    };
+
+    Map ( Operand operand, Function function ) :
+	operand_ ( operand ), function_ ( function ) { }
+
+    auto row ( int r ) const
+    {
+	return ( Row<decltype ( operand_.row ( r ) )> { operand_.row ( r ),
+		&function_ } );
+    }
+    bool size ( int *n_rows, int *n_cols ) const
+	{ return ( operand_.size ( n_rows, n_cols ) ); }
+    bool fits ( int n_rows, int n_cols ) const
+	{ return ( operand_.fits ( n_rows, n_cols ) ); }
+
+  private:
+    Operand	operand_;
+    Function	function_;
+};
+
+#define DeVAS_CXX_OP( NAME )						\
+struct Op_##NAME {							\
+    template <class A, class B>						\
+    static auto apply ( A a, B b ) { return ( pixel::NAME ( a, b ) ); } \
+};
+
+DeVAS_CXX_OP ( add )
+DeVAS_CXX_OP ( sub )
+DeVAS_CXX_OP ( mul )
+DeVAS_CXX_OP ( div )
+DeVAS_CXX_OP ( min )
+DeVAS_CXX_OP ( max )
+
+#undef DeVAS_CXX_OP
+
+/*
+ * Images.
+ */
+
+template <class Pixel, class Self>
+class Image_Access : public Expression {   /* shared by Image and ImageRef */
+  public:
+    typedef typename image_traits<Pixel>::c_image   c_image;
+
+    int n_rows ( ) const { return ( self ( )->n_rows ); }
+    int n_cols ( ) const { return ( self ( )->n_cols ); }
+    Pixel &operator() ( int r, int c ) { return ( self ( )->data[r][c] ); }
+    const Pixel &operator() ( int r, int c ) const
+	{ return ( self ( )->data[r][c] ); }
+    Pixel *row ( int r ) { return ( self ( )->data[r] ); }
+    const Pixel *row ( int r ) const { return ( self ( )->data[r] ); }
+    bool size ( int *n_rows, int *n_cols ) const
+	{ return ( Terminal<Pixel> ( self ( ) ).size ( n_rows, n_cols ) ); }
+    bool fits ( int n_rows, int n_cols ) const
+	{ return ( Terminal<Pixel> ( self ( ) ).fits ( n_rows, n_cols ) ); }
+    void modified ( ) { DeVAS_image_modified ( self ( ) ); }
+
+  protected:
+    c_image *self ( ) const
+	{ return ( static_cast<const Self *> ( this )->get ( ) ); }
+
+    template <class E>
+    void assign ( const E &expression );
+};
+
+template <class Pixel>
+class ImageRef : public Image_Access<Pixel, ImageRef<Pixel>> {
+  public:
+    typedef typename image_traits<Pixel>::c_image   c_image;
+
+    explicit ImageRef ( c_image *image ) : image_ ( image ) { }
+
+    ImageRef &operator= ( const ImageRef &other )	/* copies pixels */
+	{ this->assign ( other ); return ( *this ); }
+
+    template <class E, class = std::enable_if_t<is_expression<E>>>
+    ImageRef &operator= ( const E &expression )
+	{ this->assign ( expression ); return ( *this ); }
+
+    c_image *get ( ) const { return ( image_ ); }
+
+  private:
+    c_image *image_;
+};
+
+template <class Pixel>
+class Image : public Image_Access<Pixel, Image<Pixel>> {
+  public:
+    typedef typename image_traits<Pixel>::c_image   c_image;
+    typedef image_traits<Pixel>			    traits;
+
+    Image ( ) : image_ ( nullptr ) { }
+    Image ( int n_rows, int n_cols ) :
+	image_ ( traits::create ( n_rows, n_cols ) ) { }
+    template <class E, class = std::enable_if_t<is_expression<E>>>
+    Image ( const E &expression ) : image_ ( nullptr )
+    {
+	int	n_rows, n_cols;
+
+	if ( !expression.size ( &n_rows, &n_cols ) ) {
+	    fprintf ( stderr,
+		    "DeVAS::Image: expression has no image to give a size!\n" );
+	    exit ( EXIT_FAILURE );
+	}
+	image_ = traits::create ( n_rows, n_cols );
+	this->assign ( expression );
+    }
+    Image ( const Image & ) = delete;
+    Image ( Image &&other ) noexcept : image_ ( other.image_ )
+	{ other.image_ = nullptr; }
+    ~Image ( ) { reset ( ); }
+
+    Image &operator= ( const Image & ) = delete;
+    Image &operator= ( Image &&other ) noexcept
+    {
+	if ( this != &other ) {
+	    reset ( );
+	    image_ = other.image_;
+	    other.image_ = nullptr;
+	}
+	return ( *this );
+    }
+    template <class E, class = std::enable_if_t<is_expression<E>>>
+    Image &operator= ( const E &expression )
+	{ this->assign ( expression ); return ( *this ); }
+
+    static Image adopt ( c_image *image ) { return ( Image ( image, 0 ) ); }
+    c_image *release ( )
+	{ c_image *image = image_; image_ = nullptr; return ( image ); }
+    void reset ( )
+	{ if ( image_ != nullptr ) traits::destroy ( image_ );
+	  image_ = nullptr; }
+    c_image *get ( ) const { return ( image_ ); }
+    ImageRef<Pixel> ref ( ) const { return ( ImageRef<Pixel> ( image_ ) ); }
+
+    Image share ( ) const { return ( adopt ( traits::share ( image_ ) ) ); }
+    Image region ( int first_row, int first_col, int n_rows, int n_cols )
+	const
+	{ return ( adopt ( traits::region ( image_, first_row, first_col,
+			n_rows, n_cols ) ) ); }
+    void make_writable ( ) { traits::make_writable ( image_ ); }
+
+  private:
+    Image ( c_image *image, int ) : image_ ( image ) { }
+
+    c_image *image_;
+};
+
+/*
+ * Operands of expressions: images become Terminals, scalars and pixels
+ * become Constants, and expressions stay as they are.
+ */
+
+template <class E>
+std::enable_if_t<is_expression<E>, E> operand ( const E &expression )
+    { return ( expression ); }
+
+template <class Pixel>
+Terminal<Pixel> operand ( const Image<Pixel> &image )
+    { return ( Terminal<Pixel> ( image.get ( ) ) ); }
+
+template <class Pixel>
+Terminal<Pixel> operand ( const ImageRef<Pixel> &image )
+    { return ( Terminal<Pixel> ( image.get ( ) ) ); }
+
+inline Constant<float> operand ( float value )
+    { return ( Constant<float> ( value ) ); }
+inline Constant<double> operand ( double value )
+    { return ( Constant<double> ( value ) ); }
+inline Constant<float> operand ( int value )
+    { return ( Constant<float> ( (float) value ) ); }
+inline Constant<DeVAS_RGBf> operand ( DeVAS_RGBf value )
+    { return ( Constant<DeVAS_RGBf> ( value ) ); }
+inline Constant<DeVAS_XYZ> operand ( DeVAS_XYZ value )
+    { return ( Constant<DeVAS_XYZ> ( value ) ); }
+
+template <class T>
+using operand_t = decltype ( operand ( std::declval<const T &> ( ) ) );
+
+template <class T, class = void>
+struct has_operand : std::false_type { };
+template <class T>
+struct has_operand<T, std::void_t<operand_t<T>>> : std::true_type { };
+
+/* TRUE if a binary operation on A and B builds an expression */
+template <class A, class B>
+constexpr bool is_operation = ( is_expression<A> || is_expression<B> ) &&
+	has_operand<A>::value && has_operand<B>::value;
+
+#define DeVAS_CXX_BINARY( FUNCTION, NAME )				\
+template <class A, class B,						\
+	class = std::enable_if_t<is_operation<A, B>>>			\
+Binary<Op_##NAME, operand_t<A>, operand_t<B>>				\
+FUNCTION ( const A &a, const B &b )					\
+{									\
+    return ( Binary<Op_##NAME, operand_t<A>, operand_t<B>> (		\
+		operand ( a ), operand ( b ) ) );			\
+}
+
+DeVAS_CXX_BINARY ( operator+, add )
+DeVAS_CXX_BINARY ( operator-, sub )
+DeVAS_CXX_BINARY ( operator*, mul )
+DeVAS_CXX_BINARY ( operator/, div )
+DeVAS_CXX_BINARY ( min, min )
+DeVAS_CXX_BINARY ( max, max )
+
+#undef DeVAS_CXX_BINARY
+
+template <class E, class Lo, class Hi,
+	class = std::enable_if_t<is_expression<E>>>
+auto
+clamp ( const E &expression, Lo lo, Hi hi )
+{
+    return ( DeVAS::min ( DeVAS::max ( expression, lo ), hi ) );
+}
+
+template <class E, class Function,
+	class = std::enable_if_t<is_expression<E>>>
+Map<operand_t<E>, Function>
+map ( const E &expression, Function function )
+{
+    return ( Map<operand_t<E>, Function> ( operand ( expression ),
+		function ) );
+}
+
+/*
+ * Evaluation.
+ */
+
+template <class Pixel, class E>
+struct Assign_Work {
+    typename image_traits<Pixel>::c_image   *output;
+    const E				    *expression;
+};
+
+template <class Pixel, class E>
+void
+assign_band ( void *context, int /* band */, int first_row, int n_band_rows )
+{
+    Assign_Work<Pixel, E>   *work;
+    int			    n_cols, row, col;
+
+    work = static_cast<Assign_Work<Pixel, E> *> ( context );
+    n_cols = work->output->n_cols;
+
+    for ( row = first_row; row < first_row + n_band_rows; row++ ) {
+	auto	source = work->expression->row ( row );
+	Pixel	*destination = work->output->data[row];
+
+	for ( col = 0; col < n_cols; col++ ) {
+	    destination[col] = static_cast<Pixel> ( source[col] );
+	}
+    }
+}
+
+template <class Pixel, class Self>
+template <class E>
+void
+Image_Access<Pixel, Self>::assign ( const E &expression )
+{
+    c_image			*output = self ( );
+    auto			source = operand ( expression );
+    Assign_Work<Pixel, operand_t<E>> work { output, &source };
+
+    if ( !source.fits ( output->n_rows, output->n_cols ) ) {
+	fprintf ( stderr, "DeVAS::Image: image sizes differ!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    DeVAS_parallel_bands ( output->n_rows,
+	    DeVAS_parallel_band_rows ( output->n_cols ),
+	    assign_band<Pixel, operand_t<E>>, (void *) &work );
+
+    DeVAS_image_modified ( output );
+}
+
+}	/* namespace DeVAS */
+
+#endif	/* __DeVAS_IMAGE_HPP */
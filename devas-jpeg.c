@@ -157,9 +157,6 @@ DeVAS_RGB_image_from_file_jpg ( FILE *input, char **comment,
 
 	if ( comment != NULL ) {
 	    if ( marker_list->marker == JPEG_COM ) {
-		comment_malloc = (char *) malloc ( sizeof ( char ) *
-			( marker_list->data_length + 1 ) );
-				/* leave room for trailing null */
 		comment_malloc = strndup ( (const char *) marker_list->data,
 					(size_t ) marker_list->data_length );
 		if ( comment_malloc == NULL ) {
@@ -282,15 +279,68 @@ void
 DeVAS_RGB_image_to_file_jpg ( FILE *output, DeVAS_RGB_image *image,
 	char *comment )
 {
+    DeVAS_JPEG_writer	*writer;
+    int			row;
+
+    writer = DeVAS_RGB_open_write_jpg ( output, DeVAS_image_n_rows ( image ),
+	    DeVAS_image_n_cols ( image ), comment );
+
+    /*
+     * Go through the row pointers rather than assuming the rows are
+     * contiguous, since image may be a region of a larger image.
+     */
+    for ( row = 0; row < DeVAS_image_n_rows ( image ); row++ ) {
+	DeVAS_RGB_write_jpg ( writer, &DeVAS_image_data ( image, row, 0 ) );
+    }
+
+    DeVAS_RGB_close_write_jpg ( writer );
+}
+
+/*
+ * Row-at-a-time JPEG writing, so that callers producing output in bands
+ * never need the whole 8-bit image in memory.  libjpeg only buffers a few
+ * MCU rows (at most 16 scanlines) internally.
+ */
+
+struct DeVAS_JPEG_writer {
     struct jpeg_compress_struct	cinfo;
     struct jpeg_DeVAS_error_mgr	jerr;
+    FILE			*output;
+};
 
-    JSAMPROW	    row_pointer[1];	/* pointer to JSAMPLE row[s] */
-    int		    image_data_offset;	/* in units of DeVAS_RGB! */
-    unsigned int    n_rows, n_cols;
-    int		    quality;
+DeVAS_JPEG_writer *
+DeVAS_RGB_open_write_jpg ( FILE *output, unsigned int n_rows,
+	unsigned int n_cols, char *comment )
+/*
+ * Writes the JPEG header, comment (if not NULL or empty), and sRGB
+ * profile.  n_rows scanlines must then be written with DeVAS_RGB_write_jpg
+ * before calling DeVAS_RGB_close_write_jpg.
+ */
+{
+    return ( DeVAS_RGB_open_write_jpg_profile ( output, n_rows, n_cols,
+		comment, NULL, 0 ) );
+}
+
+DeVAS_JPEG_writer *
+DeVAS_RGB_open_write_jpg_profile ( FILE *output, unsigned int n_rows,
+	unsigned int n_cols, char *comment, const unsigned char *profile,
+	unsigned int profile_length )
+/*
+ * As DeVAS_RGB_open_write_jpg, but attaches the given ICC profile instead
+ * of the sRGB profile, unless profile is NULL.
+ */
+{
+    DeVAS_JPEG_writer	*writer;
+    int			quality;
 #include "sRGB_IEC61966-2-1_black_scaled.c"	/* hardwared binary profile */
 
+    writer = (DeVAS_JPEG_writer *) malloc ( sizeof ( DeVAS_JPEG_writer ) );
+    if ( writer == NULL ) {
+	fprintf ( stderr, "DeVAS_RGB_open_write_jpg: malloc failed!\n" );
+	exit ( EXIT_FAILURE );
+    }
+    writer->output = output;
+
     /* Step 1: allocate and initialize JPEG compression object */
 
     /* We have to set up the error handler first, in case the initialization
@@ -298,21 +348,21 @@ DeVAS_RGB_image_to_file_jpg ( FILE *output, DeVAS_RGB_image *image,
      * This routine fills in the contents of struct jerr, and returns jerr's
      * address which we place into the link field in cinfo.
      */
-    cinfo.err = jpeg_std_error ( &jerr.pub );
-    jerr.pub.error_exit = jpeg_DeVAS_error_exit;
+    writer->cinfo.err = jpeg_std_error ( &writer->jerr.pub );
+    writer->jerr.pub.error_exit = jpeg_DeVAS_error_exit;
     /* Establish the setjmp return context for jpeg_DeVAS_error_exit to use. */
-    if ( setjmp ( jerr.setjmp_buffer ) ) {
+    if ( setjmp ( writer->jerr.setjmp_buffer ) ) {
 	/*
 	 * If we get here, the JPEG code has signaled an error.  We need to
 	 * clean up the JPEG object, close the input file, and return.
 	 */
-	jpeg_destroy_compress ( &cinfo );
+	jpeg_destroy_compress ( &writer->cinfo );
 	fclose ( output );
 	exit ( EXIT_FAILURE );
     }
 
     /* Now we can initialize the JPEG compression object. */
-    jpeg_create_compress ( &cinfo );
+    jpeg_create_compress ( &writer->cinfo );
 
     /* Step 2: specify data destination (eg, a file) */
     /* Note: steps 2 and 3 can be done in either order. */
@@ -322,30 +372,27 @@ DeVAS_RGB_image_to_file_jpg ( FILE *output, DeVAS_RGB_image *image,
      * VERY IMPORTANT: use "b" option to fopen() if you are on a machine that
      * requires it in order to write binary files.
      */
-    jpeg_stdio_dest ( &cinfo, output );
-
-    n_rows = DeVAS_image_n_rows ( image );
-    n_cols = DeVAS_image_n_cols ( image );
+    jpeg_stdio_dest ( &writer->cinfo, output );
 
     /* Step 3: set parameters for compression */
 
     /* First we supply a description of the input image.
      * Four fields of the cinfo struct must be filled in:
      */
-    cinfo.image_width = n_cols; 	/* image width and height, in pixels */
-    cinfo.image_height = n_rows;
-    cinfo.input_components = 3;		/* # of color components per pixel */
-    cinfo.in_color_space = JCS_RGB; 	/* colorspace of input image */
+    writer->cinfo.image_width = n_cols;	/* image width and height, */
+    writer->cinfo.image_height = n_rows;	/* in pixels */
+    writer->cinfo.input_components = 3;	/* # of color components per pixel */
+    writer->cinfo.in_color_space = JCS_RGB; /* colorspace of input image */
     /* Now use the library's routine to set default compression parameters.
      * (You must set at least cinfo.in_color_space before calling this,
      * since the defaults depend on the source color space.)
      */
-    jpeg_set_defaults ( &cinfo );
+    jpeg_set_defaults ( &writer->cinfo );
     /* Now you can set any non-default parameters you wish to.
      * Here we just illustrate the use of quality (quantization table) scaling:
      */
     quality = DEFAULT_QUALITY;
-    jpeg_set_quality ( &cinfo, quality, TRUE );
+    jpeg_set_quality ( &writer->cinfo, quality, TRUE );
 	    			/* limit to baseline-JPEG values */
 
     /* Step 4: Start compressor */
@@ -353,54 +400,75 @@ DeVAS_RGB_image_to_file_jpg ( FILE *output, DeVAS_RGB_image *image,
     /* TRUE ensures that we will write a complete interchange-JPEG file.
      * Pass TRUE unless you are very sure of what you're doing.
      */
-    jpeg_start_compress ( &cinfo, TRUE );
+    jpeg_start_compress ( &writer->cinfo, TRUE );
 
     /* Step 4.25: copy comment. */
 
     if ( ( comment != NULL ) && ( *comment != '\0' ) ) {
-	jpeg_write_marker ( &cinfo, JPEG_COM, (const JOCTET *) comment,
+	jpeg_write_marker ( &writer->cinfo, JPEG_COM, (const JOCTET *) comment,
 		strlen ( comment ) );
     }
 
     /* Step 4.5: Attache sRGB profile (*not* optional!!!) */
-    jpeg_write_icc_profile ( &cinfo, (const JOCTET *) icc_sRGB,
-	    sizeof ( icc_sRGB ) );
+    if ( profile != NULL ) {
+	jpeg_write_icc_profile ( &writer->cinfo, (const JOCTET *) profile,
+		profile_length );
+    } else {
+	jpeg_write_icc_profile ( &writer->cinfo, (const JOCTET *) icc_sRGB,
+		sizeof ( icc_sRGB ) );
+    }
 
-    /* Step 5: while (scan lines remain to be written) */
-    /*           jpeg_write_scanlines(...); */
+    return ( writer );
+}
 
-    /* Here we use the library's state variable cinfo.next_scanline as the
-     * loop counter, so that we don't have to keep track ourselves.
-     * To keep things simple, we pass one scanline per call; you can pass
-     * more if you wish, though.
-     */
-    while (cinfo.next_scanline < cinfo.image_height) {
-	/*
-	 * jpeg_write_scanlines expects an array of pointers to scanlines.
-	 * Here the array is only one element long, but you could pass
-	 * more than one scanline at a time if that's more convenient.
-	 */
-	image_data_offset = cinfo.next_scanline * n_cols;
-	/*
-	 * Assume DeVAS_RGB_image_new allocates image data contiguously
-	 * with no padding.
-	 */
-	assert ( sizeof ( DeVAS_RGB ) == 3 );      /* just checking... */
-	row_pointer[0] =
-	   (JSAMPROW) ( &DeVAS_image_data ( image, 0, 0 ) + image_data_offset );
-	(void) jpeg_write_scanlines ( &cinfo, row_pointer, 1 );
+void
+DeVAS_RGB_write_jpg ( DeVAS_JPEG_writer *writer, DeVAS_RGB *row )
+/*
+ * Step 5: write the next scanline.
+ */
+{
+    JSAMPROW	    row_pointer[1];	/* pointer to JSAMPLE row[s] */
+
+    if ( setjmp ( writer->jerr.setjmp_buffer ) ) {
+	jpeg_destroy_compress ( &writer->cinfo );
+	fclose ( writer->output );
+	exit ( EXIT_FAILURE );
+    }
+
+    if ( writer->cinfo.next_scanline >= writer->cinfo.image_height ) {
+	fprintf ( stderr, "DeVAS_RGB_write_jpg: too many scanlines!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    assert ( sizeof ( DeVAS_RGB ) == 3 );      /* just checking... */
+    row_pointer[0] = (JSAMPROW) row;
+    (void) jpeg_write_scanlines ( &writer->cinfo, row_pointer, 1 );
+}
+
+void
+DeVAS_RGB_close_write_jpg ( DeVAS_JPEG_writer *writer )
+/*
+ * Steps 6 and 7.  The output file is flushed but not closed.
+ */
+{
+    if ( setjmp ( writer->jerr.setjmp_buffer ) ) {
+	jpeg_destroy_compress ( &writer->cinfo );
+	fclose ( writer->output );
+	exit ( EXIT_FAILURE );
     }
 
     /* Step 6: Finish compression */
 
-    jpeg_finish_compress ( &cinfo );
+    jpeg_finish_compress ( &writer->cinfo );
 
-    fflush ( output );	/* don't actually close file */
+    fflush ( writer->output );	/* don't actually close file */
 
     /* Step 7: release JPEG compression object */
 
     /* This is an important step since it will release a good deal of memory. */
-    jpeg_destroy_compress ( &cinfo );
+    jpeg_destroy_compress ( &writer->cinfo );
+
+    free ( writer );
 
     /* And we're done! */
 }
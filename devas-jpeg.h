@@ -17,6 +17,8 @@
 
 #include "devas-image.h"
 
+typedef struct DeVAS_JPEG_writer DeVAS_JPEG_writer;	/* opaque */
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -31,6 +33,17 @@ void		DeVAS_RGB_image_to_filename_jpg ( char *filename,
 void		DeVAS_RGB_image_to_file_jpg ( FILE *output,
 		    DeVAS_RGB_image *image, char *comment );
 
+DeVAS_JPEG_writer	*DeVAS_RGB_open_write_jpg ( FILE *output,
+			    unsigned int n_rows, unsigned int n_cols,
+			    char *comment );
+DeVAS_JPEG_writer	*DeVAS_RGB_open_write_jpg_profile ( FILE *output,
+			    unsigned int n_rows, unsigned int n_cols,
+			    char *comment, const unsigned char *profile,
+			    unsigned int profile_length );
+void			DeVAS_RGB_write_jpg ( DeVAS_JPEG_writer *writer,
+			    DeVAS_RGB *row );
+void			DeVAS_RGB_close_write_jpg ( DeVAS_JPEG_writer *writer );
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,557 @@
+/*
+ * Bit-packed binary mask images.  See devas-mask.h.
+ *
+ * Pixel storage comes from DeVAS_image_storage_new, so masks are counted
+ * by devas-memory.h (as "DeVAS_mask") and very large masks are
+ * file-backed, as for other DeVAS images.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#ifdef	__SSE2__
+#include <emmintrin.h>
+#endif	/* __SSE2__ */
+#include "devas-mask.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+static int
+DeVAS_mask_popcount ( DeVAS_mask_word word )
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return ( __builtin_popcountll ( word ) );
+#else
+    word = word - ( ( word >> 1 ) & 0x5555555555555555ULL );
+    word = ( word & 0x3333333333333333ULL ) +
+	( ( word >> 2 ) & 0x3333333333333333ULL );
+    word = ( word + ( word >> 4 ) ) & 0x0f0f0f0f0f0f0f0fULL;
+    return ( (int) ( ( word * 0x0101010101010101ULL ) >> 56 ) );
+#endif
+}
+
+static int
+DeVAS_mask_lowest_bit ( DeVAS_mask_word word )
+/*
+ * Index of the lowest set bit.  word must not be 0.
+ */
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return ( __builtin_ctzll ( word ) );
+#else
+    int	    bit = 0;
+
+    while ( ( word & 1 ) == 0 ) {
+	word >>= 1;
+	bit++;
+    }
+    return ( bit );
+#endif
+}
+
+static DeVAS_mask_word
+DeVAS_mask_last_word ( DeVAS_mask_image *mask )
+/*
+ * Bits of the last word of each row that are in the image.
+ */
+{
+    int	    extra;
+
+    extra = mask->n_cols % DeVAS_MASK_WORD_BITS;
+    if ( extra == 0 ) {
+	return ( ~( (DeVAS_mask_word) 0 ) );
+    }
+
+    return ( ( ( (DeVAS_mask_word) 1 ) << extra ) - 1 );
+}
+
+static float
+DeVAS_mask_float_threshold ( double threshold )
+/*
+ * The largest float not greater than threshold.  For any float value,
+ * value > threshold exactly when value > DeVAS_mask_float_threshold (
+ * threshold ), so the threshold kernels can compare in single precision.
+ */
+{
+    float   float_threshold;
+
+    float_threshold = (float) threshold;
+    if ( ( (double) float_threshold ) > threshold ) {
+	float_threshold = nextafterf ( float_threshold, -HUGE_VALF );
+    }
+
+    return ( float_threshold );
+}
+
+static void
+DeVAS_mask_check_size ( char *function, DeVAS_mask_image *mask, int n_rows,
+	int n_cols )
+{
+    if ( ( mask->n_rows != n_rows ) || ( mask->n_cols != n_cols ) ) {
+	fprintf ( stderr, "%s: image sizes differ!\n", function );
+	exit ( EXIT_FAILURE );
+    }
+}
+
+DeVAS_mask_image *
+DeVAS_mask_image_new ( unsigned int n_rows, unsigned int n_cols )
+/*
+ * All pixels are initially clear.
+ */
+{
+    DeVAS_mask_image	*mask;
+    size_t		size;
+
+    mask = (DeVAS_mask_image *) malloc ( sizeof ( DeVAS_mask_image ) );
+    if ( mask == NULL ) {
+	fprintf ( stderr, "DeVAS_mask_image_new: malloc failed!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    mask->n_rows = n_rows;
+    mask->n_cols = n_cols;
+    mask->words_per_row = ( n_cols + DeVAS_MASK_WORD_BITS - 1 ) /
+	DeVAS_MASK_WORD_BITS;
+
+    size = ( (size_t) n_rows ) * ( (size_t) mask->words_per_row ) *
+	sizeof ( DeVAS_mask_word );
+    mask->storage = DeVAS_image_storage_new ( size, DeVAS_STORAGE_MALLOC,
+	    "DeVAS_mask" );
+    mask->bits = (DeVAS_mask_word *) mask->storage->block;
+
+    DeVAS_mask_image_clear ( mask );
+
+    return ( mask );
+}
+
+void
+DeVAS_mask_image_delete ( DeVAS_mask_image *mask )
+{
+    DeVAS_image_storage_release ( mask->storage );
+    free ( mask );
+}
+
+void
+DeVAS_mask_image_clear ( DeVAS_mask_image *mask )
+{
+    memset ( mask->bits, 0, ( (size_t) mask->n_rows ) *
+	    ( (size_t) mask->words_per_row ) * sizeof ( DeVAS_mask_word ) );
+}
+
+void
+DeVAS_mask_image_fill ( DeVAS_mask_image *mask )
+/*
+ * Set every pixel, leaving the bits past the last column clear.
+ */
+{
+    int		    row, word;
+    DeVAS_mask_word *bits;
+
+    for ( row = 0; row < mask->n_rows; row++ ) {
+	bits = DeVAS_mask_row ( mask, row );
+	for ( word = 0; word < mask->words_per_row - 1; word++ ) {
+	    bits[word] = ~( (DeVAS_mask_word) 0 );
+	}
+	if ( mask->words_per_row > 0 ) {
+	    bits[mask->words_per_row - 1] = DeVAS_mask_last_word ( mask );
+	}
+    }
+}
+
+int
+DeVAS_mask_image_samesize ( DeVAS_mask_image *mask1, DeVAS_mask_image *mask2 )
+{
+    return ( ( mask1->n_rows == mask2->n_rows ) &&
+	    ( mask1->n_cols == mask2->n_cols ) );
+}
+
+/*
+ * Rows are contiguous and padded identically in masks of the same size,
+ * so the binary operations run over all of the words as a single array.
+ */
+#define	DeVAS_MASK_BINARY_OP( NAME, EXPRESSION )			\
+void									\
+NAME ( DeVAS_mask_image *result, DeVAS_mask_image *a,			\
+	DeVAS_mask_image *b )						\
+{									\
+    size_t	    word, n_words;					\
+    DeVAS_mask_word *r_bits, *a_bits, *b_bits;				\
+									\
+    if ( !DeVAS_mask_image_samesize ( result, a ) ||			\
+	    !DeVAS_mask_image_samesize ( result, b ) ) {		\
+	fprintf ( stderr, #NAME ": image sizes differ!\n" );		\
+	exit ( EXIT_FAILURE );						\
+    }									\
+									\
+    n_words = ( (size_t) result->n_rows ) *				\
+	( (size_t) result->words_per_row );				\
+    r_bits = result->bits;						\
+    a_bits = a->bits;							\
+    b_bits = b->bits;							\
+									\
+    for ( word = 0; word < n_words; word++ ) {				\
+	r_bits[word] = EXPRESSION;					\
+    }									\
+}
+
+DeVAS_MASK_BINARY_OP ( DeVAS_mask_and, a_bits[word] & b_bits[word] )
+DeVAS_MASK_BINARY_OP ( DeVAS_mask_or, a_bits[word] | b_bits[word] )
+DeVAS_MASK_BINARY_OP ( DeVAS_mask_xor, a_bits[word] ^ b_bits[word] )
+DeVAS_MASK_BINARY_OP ( DeVAS_mask_andnot, a_bits[word] & ~b_bits[word] )
+
+void
+DeVAS_mask_not ( DeVAS_mask_image *result, DeVAS_mask_image *a )
+{
+    int		    row, word;
+    DeVAS_mask_word *r_bits, *a_bits;
+    DeVAS_mask_word last_word;
+
+    if ( !DeVAS_mask_image_samesize ( result, a ) ) {
+	fprintf ( stderr, "DeVAS_mask_not: image sizes differ!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    last_word = DeVAS_mask_last_word ( a );
+
+    for ( row = 0; row < a->n_rows; row++ ) {
+	r_bits = DeVAS_mask_row ( result, row );
+	a_bits = DeVAS_mask_row ( a, row );
+	for ( word = 0; word < a->words_per_row - 1; word++ ) {
+	    r_bits[word] = ~a_bits[word];
+	}
+	if ( a->words_per_row > 0 ) {
+	    r_bits[word] = ~a_bits[word] & last_word;
+	}
+    }
+}
+
+size_t
+DeVAS_mask_count ( DeVAS_mask_image *mask )
+{
+    size_t	    word, n_words;
+    size_t	    count;
+
+    n_words = ( (size_t) mask->n_rows ) * ( (size_t) mask->words_per_row );
+    count = 0;
+
+    for ( word = 0; word < n_words; word++ ) {
+	count += DeVAS_mask_popcount ( mask->bits[word] );
+    }
+
+    return ( count );
+}
+
+size_t
+DeVAS_mask_count_and ( DeVAS_mask_image *a, DeVAS_mask_image *b )
+/*
+ * Same as DeVAS_mask_count of DeVAS_mask_and ( a, b ), without making the
+ * intermediate mask.
+ */
+{
+    size_t	    word, n_words;
+    size_t	    count;
+
+    if ( !DeVAS_mask_image_samesize ( a, b ) ) {
+	fprintf ( stderr, "DeVAS_mask_count_and: image sizes differ!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    n_words = ( (size_t) a->n_rows ) * ( (size_t) a->words_per_row );
+    count = 0;
+
+    for ( word = 0; word < n_words; word++ ) {
+	count += DeVAS_mask_popcount ( a->bits[word] & b->bits[word] );
+    }
+
+    return ( count );
+}
+
+double
+DeVAS_mask_area ( DeVAS_mask_image *mask )
+{
+    if ( ( mask->n_rows == 0 ) || ( mask->n_cols == 0 ) ) {
+	return ( 0.0 );
+    }
+
+    return ( ( (double) DeVAS_mask_count ( mask ) ) /
+	    ( ( (double) mask->n_rows ) * ( (double) mask->n_cols ) ) );
+}
+
+DeVAS_mask_image *
+DeVAS_mask_image_from_gray ( DeVAS_gray_image *gray )
+/*
+ * Pixels with non-zero values are set.
+ */
+{
+    DeVAS_mask_image	*mask;
+    int			row, col;
+
+    mask = DeVAS_mask_image_new ( DeVAS_image_n_rows ( gray ),
+	    DeVAS_image_n_cols ( gray ) );
+
+    for ( row = 0; row < mask->n_rows; row++ ) {
+	for ( col = 0; col < mask->n_cols; col++ ) {
+	    if ( DeVAS_image_data ( gray, row, col ) != 0 ) {
+		DeVAS_mask_set_bit ( mask, row, col );
+	    }
+	}
+    }
+
+    return ( mask );
+}
+
+DeVAS_gray_image *
+DeVAS_gray_image_from_mask ( DeVAS_mask_image *mask, DeVAS_gray set_value )
+/*
+ * Pixels that are set get set_value, others 0.
+ */
+{
+    DeVAS_gray_image	*gray;
+    int			row, col;
+
+    gray = DeVAS_gray_image_new ( mask->n_rows, mask->n_cols );
+
+    for ( row = 0; row < mask->n_rows; row++ ) {
+	for ( col = 0; col < mask->n_cols; col++ ) {
+	    DeVAS_image_data ( gray, row, col ) =
+		DeVAS_mask_bit ( mask, row, col ) ? set_value : 0;
+	}
+    }
+
+    return ( gray );
+}
+
+void
+DeVAS_float_image_threshold_mask ( DeVAS_float_image *image, double threshold,
+	DeVAS_mask_image *mask )
+{
+    int		    row, word;
+    int		    first_col, n_bits, bit;
+    float	    float_threshold;
+    DeVAS_float	    *values;
+    DeVAS_mask_word *bits;
+    DeVAS_mask_word bits_value;
+#ifdef	__SSE2__
+    __m128	    threshold4;
+#endif	/* __SSE2__ */
+
+    DeVAS_mask_check_size ( "DeVAS_float_image_threshold_mask", mask,
+	    DeVAS_image_n_rows ( image ), DeVAS_image_n_cols ( image ) );
+
+    float_threshold = DeVAS_mask_float_threshold ( threshold );
+#ifdef	__SSE2__
+    threshold4 = _mm_set1_ps ( float_threshold );
+#endif	/* __SSE2__ */
+
+    for ( row = 0; row < mask->n_rows; row++ ) {
+	values = &DeVAS_image_data ( image, row, 0 );
+	bits = DeVAS_mask_row ( mask, row );
+
+	for ( word = 0; word < mask->words_per_row; word++ ) {
+	    first_col = word * DeVAS_MASK_WORD_BITS;
+	    n_bits = mask->n_cols - first_col;
+	    if ( n_bits > DeVAS_MASK_WORD_BITS ) {
+		n_bits = DeVAS_MASK_WORD_BITS;
+	    }
+
+	    bits_value = 0;
+	    bit = 0;
+#ifdef	__SSE2__
+	    for ( ; bit + 4 <= n_bits; bit += 4 ) {
+		bits_value |= ( (DeVAS_mask_word) _mm_movemask_ps ( _mm_cmpgt_ps (
+				_mm_loadu_ps ( values + first_col + bit ),
+				threshold4 ) ) ) << bit;
+	    }
+#endif	/* __SSE2__ */
+	    for ( ; bit < n_bits; bit++ ) {
+		bits_value |= ( (DeVAS_mask_word)
+			( values[first_col + bit] > float_threshold ) ) << bit;
+	    }
+
+	    bits[word] = bits_value;
+	}
+    }
+}
+
+void
+DeVAS_RGBf_image_threshold_mask ( DeVAS_RGBf_image *image, double threshold,
+	DeVAS_mask_image *mask )
+/*
+ * max ( R, G, B ) > threshold is the same as any of R, G, or B being
+ * > threshold (including for NaN values, which fmax ignores), so each
+ * channel value is compared independently and the three results for a
+ * pixel or'ed together.
+ */
+{
+    int		    row, word;
+    int		    first_col, n_bits, bit;
+    float	    float_threshold;
+    float	    *values;
+    DeVAS_mask_word *bits;
+    DeVAS_mask_word bits_value;
+#ifdef	__SSE2__
+    __m128	    threshold4;
+    int		    channel_bits;
+#endif	/* __SSE2__ */
+
+    DeVAS_mask_check_size ( "DeVAS_RGBf_image_threshold_mask", mask,
+	    DeVAS_image_n_rows ( image ), DeVAS_image_n_cols ( image ) );
+
+    float_threshold = DeVAS_mask_float_threshold ( threshold );
+#ifdef	__SSE2__
+    threshold4 = _mm_set1_ps ( float_threshold );
+#endif	/* __SSE2__ */
+
+    for ( row = 0; row < mask->n_rows; row++ ) {
+	values = (float *) &DeVAS_image_data ( image, row, 0 );
+	bits = DeVAS_mask_row ( mask, row );
+
+	for ( word = 0; word < mask->words_per_row; word++ ) {
+	    first_col = word * DeVAS_MASK_WORD_BITS;
+	    n_bits = mask->n_cols - first_col;
+	    if ( n_bits > DeVAS_MASK_WORD_BITS ) {
+		n_bits = DeVAS_MASK_WORD_BITS;
+	    }
+
+	    bits_value = 0;
+	    bit = 0;
+#ifdef	__SSE2__
+	    for ( ; bit + 4 <= n_bits; bit += 4 ) {
+		/* 12 comparisons, channel c of pixel p in bit 3p+c */
+		channel_bits = _mm_movemask_ps ( _mm_cmpgt_ps ( _mm_loadu_ps (
+				values + ( 3 * ( first_col + bit ) ) ),
+			    threshold4 ) ) |
+		    ( _mm_movemask_ps ( _mm_cmpgt_ps ( _mm_loadu_ps (
+				values + ( 3 * ( first_col + bit ) ) + 4 ),
+			    threshold4 ) ) << 4 ) |
+		    ( _mm_movemask_ps ( _mm_cmpgt_ps ( _mm_loadu_ps (
+				values + ( 3 * ( first_col + bit ) ) + 8 ),
+			    threshold4 ) ) << 8 );
+		channel_bits |= ( channel_bits >> 1 ) | ( channel_bits >> 2 );
+		bits_value |= ( (DeVAS_mask_word) ( ( channel_bits & 1 ) |
+			    ( ( channel_bits >> 2 ) & 2 ) |
+			    ( ( channel_bits >> 4 ) & 4 ) |
+			    ( ( channel_bits >> 6 ) & 8 ) ) ) << bit;
+	    }
+#endif	/* __SSE2__ */
+	    for ( ; bit < n_bits; bit++ ) {
+		bits_value |= ( (DeVAS_mask_word)
+			( ( values[3 * ( first_col + bit )] >
+			    float_threshold ) |
+			  ( values[( 3 * ( first_col + bit ) ) + 1] >
+			    float_threshold ) |
+			  ( values[( 3 * ( first_col + bit ) ) + 2] >
+			    float_threshold ) ) ) << bit;
+	    }
+
+	    bits[word] = bits_value;
+	}
+    }
+}
+
+/*
+ * Visits the pixels in (or, if outside, not in) the mask, in row-major
+ * order, a word of the mask at a time.  Words with no pixels selected are
+ * skipped without looking at the image.  VISIT is executed with row and
+ * col set.
+ */
+#define	DeVAS_MASK_FOR_EACH_SELECTED( MASK, OUTSIDE, VISIT )		\
+{									\
+    int		    mask_word;						\
+    DeVAS_mask_word *mask_bits;						\
+    DeVAS_mask_word selected;						\
+    DeVAS_mask_word last_word;						\
+									\
+    last_word = DeVAS_mask_last_word ( MASK );				\
+									\
+    for ( row = 0; row < (MASK)->n_rows; row++ ) {			\
+	mask_bits = DeVAS_mask_row ( MASK, row );			\
+	for ( mask_word = 0; mask_word < (MASK)->words_per_row;		\
+		mask_word++ ) {						\
+	    selected = mask_bits[mask_word];				\
+	    if ( OUTSIDE ) {						\
+		selected = ~selected;					\
+		if ( mask_word == (MASK)->words_per_row - 1 ) {		\
+		    selected &= last_word;				\
+		}							\
+	    }								\
+	    while ( selected != 0 ) {					\
+		col = ( mask_word * DeVAS_MASK_WORD_BITS ) +		\
+		    DeVAS_mask_lowest_bit ( selected );			\
+		selected &= selected - 1;				\
+		VISIT;							\
+	    }								\
+	}								\
+    }									\
+}
+
+double
+DeVAS_float_image_masked_sum ( DeVAS_float_image *image,
+	DeVAS_mask_image *mask, int outside, size_t *n_pixels )
+/*
+ * n_pixels may be NULL.
+ */
+{
+    int	    row, col;
+    double  sum;
+    size_t  count;
+
+    DeVAS_mask_check_size ( "DeVAS_float_image_masked_sum", mask,
+	    DeVAS_image_n_rows ( image ), DeVAS_image_n_cols ( image ) );
+
+    sum = 0.0;
+    count = 0;
+
+    DeVAS_MASK_FOR_EACH_SELECTED ( mask, outside,
+	    sum += DeVAS_image_data ( image, row, col ); count++ )
+
+    if ( n_pixels != NULL ) {
+	*n_pixels = count;
+    }
+
+    return ( sum );
+}
+
+double
+DeVAS_float_image_masked_mean ( DeVAS_float_image *image,
+	DeVAS_mask_image *mask, int outside )
+{
+    double  sum;
+    size_t  n_pixels;
+
+    sum = DeVAS_float_image_masked_sum ( image, mask, outside, &n_pixels );
+
+    if ( n_pixels == 0 ) {
+	return ( 0.0 );
+    }
+
+    return ( sum / ( (double) n_pixels ) );
+}
+
+double
+DeVAS_RGBf_image_masked_mean_Y ( DeVAS_RGBf_image *image,
+	DeVAS_mask_image *mask, int outside )
+/*
+ * Mean of DeVAS_RGBf2Y over the selected pixels.
+ */
+{
+    int	    row, col;
+    double  sum;
+    size_t  count;
+
+    DeVAS_mask_check_size ( "DeVAS_RGBf_image_masked_mean_Y", mask,
+	    DeVAS_image_n_rows ( image ), DeVAS_image_n_cols ( image ) );
+
+    sum = 0.0;
+    count = 0;
+
+    DeVAS_MASK_FOR_EACH_SELECTED ( mask, outside,
+	    sum += DeVAS_RGBf2Y ( DeVAS_image_data ( image, row, col ) );
+	    count++ )
+
+    if ( count == 0 ) {
+	return ( 0.0 );
+    }
+
+    return ( sum / ( (double) count ) );
+}
@@ -0,0 +1,140 @@
+/*
+ * Bit-packed binary mask images (e.g., glare sources, pixels above a
+ * threshold), one bit per pixel.
+ *
+ * Each row is packed into 64 bit words, with column col of a row in bit
+ * ( col % 64 ) of word ( col / 64 ).  Rows start on a word boundary, and
+ * bits past the last column of a row are always 0, so that logical
+ * operations and counts work a whole word at a time.  A mask takes 1/8 of
+ * the memory of the equivalent DeVAS_gray_image.
+ *
+ *   DeVAS_mask_and, DeVAS_mask_or, DeVAS_mask_xor, DeVAS_mask_andnot,
+ *   DeVAS_mask_not
+ *
+ *	Word-parallel logical operations.  The result may be the same
+ *	object as either operand.  DeVAS_mask_andnot ( result, a, b ) is
+ *	a AND NOT b.
+ *
+ *   DeVAS_mask_count ( <mask> ), DeVAS_mask_count_and ( <mask>, <mask> )
+ *
+ *	Number of pixels set (in both masks).
+ *
+ *   DeVAS_mask_area ( <mask> )
+ *
+ *	Fraction of the image covered by the mask.
+ *
+ *   DeVAS_float_image_threshold_mask ( <image>, threshold, <mask> )
+ *   DeVAS_RGBf_image_threshold_mask ( <image>, threshold, <mask> )
+ *
+ *	Set exactly those pixels greater than threshold (for RGBf, those
+ *	with the maximum of R, G, and B greater than threshold, as in the
+ *	glare source tests in rad2jpeg, rad2png, and rad2tiff).  The
+ *	comparisons give the same result as comparing each value, promoted
+ *	to double, against threshold.
+ *
+ *   DeVAS_float_image_masked_sum ( <image>, <mask>, outside, &n_pixels )
+ *   DeVAS_float_image_masked_mean ( <image>, <mask>, outside )
+ *   DeVAS_RGBf_image_masked_mean_Y ( <image>, <mask>, outside )
+ *
+ *	Sum or mean over the pixels in the mask or, if outside is TRUE,
+ *	the pixels not in the mask (e.g., the mean luminance excluding glare
+ *	sources).  Sums are accumulated in double, in row-major order.  The
+ *	mean of no pixels is 0.0.
+ */
+
+#ifndef __DeVAS_MASK_H
+#define __DeVAS_MASK_H
+
+#include <stdint.h>
+#include "devas-image.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+typedef uint64_t	DeVAS_mask_word;
+
+#define	DeVAS_MASK_WORD_BITS	64
+
+/* Note that order is (n_rows,n_cols), not (x,y) or (width,height)!!! */
+typedef struct {
+    int			n_rows, n_cols;	/* order reversed from x,y! */
+    int			words_per_row;
+    DeVAS_mask_word	*bits;		/* first word of first row */
+    DeVAS_Image_Storage	*storage;
+} DeVAS_mask_image;
+
+/*
+ * methods on DeVAS_mask_image objects:
+ */
+
+#define	DeVAS_mask_n_rows(mask)		(mask)->n_rows
+#define	DeVAS_mask_n_cols(mask)		(mask)->n_cols
+    			/* read only (but not enforced ) */
+
+#define	DeVAS_mask_row(mask,row)					\
+	    ( (mask)->bits + ( ( (size_t) (row) ) * (mask)->words_per_row ) )
+
+#define	DeVAS_mask_bit(mask,row,col)					\
+	    ( (int) ( ( DeVAS_mask_row ( mask, row )[(col) >> 6] >>	\
+			( (col) & 63 ) ) & 1 ) )
+
+#define	DeVAS_mask_set_bit(mask,row,col)				\
+	    ( DeVAS_mask_row ( mask, row )[(col) >> 6] |=		\
+		( ( (DeVAS_mask_word) 1 ) << ( (col) & 63 ) ) )
+
+#define	DeVAS_mask_clear_bit(mask,row,col)				\
+	    ( DeVAS_mask_row ( mask, row )[(col) >> 6] &=		\
+		~( ( (DeVAS_mask_word) 1 ) << ( (col) & 63 ) ) )
+
+/*
+ * function prototypes:
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+DeVAS_mask_image *DeVAS_mask_image_new ( unsigned int n_rows,
+			unsigned int n_cols );
+void		DeVAS_mask_image_delete ( DeVAS_mask_image *mask );
+void		DeVAS_mask_image_clear ( DeVAS_mask_image *mask );
+void		DeVAS_mask_image_fill ( DeVAS_mask_image *mask );
+int		DeVAS_mask_image_samesize ( DeVAS_mask_image *mask1,
+			DeVAS_mask_image *mask2 );
+
+void		DeVAS_mask_and ( DeVAS_mask_image *result,
+			DeVAS_mask_image *a, DeVAS_mask_image *b );
+void		DeVAS_mask_or ( DeVAS_mask_image *result,
+			DeVAS_mask_image *a, DeVAS_mask_image *b );
+void		DeVAS_mask_xor ( DeVAS_mask_image *result,
+			DeVAS_mask_image *a, DeVAS_mask_image *b );
+void		DeVAS_mask_andnot ( DeVAS_mask_image *result,
+			DeVAS_mask_image *a, DeVAS_mask_image *b );
+void		DeVAS_mask_not ( DeVAS_mask_image *result,
+			DeVAS_mask_image *a );
+
+size_t		DeVAS_mask_count ( DeVAS_mask_image *mask );
+size_t		DeVAS_mask_count_and ( DeVAS_mask_image *a,
+			DeVAS_mask_image *b );
+double		DeVAS_mask_area ( DeVAS_mask_image *mask );
+
+DeVAS_mask_image *DeVAS_mask_image_from_gray ( DeVAS_gray_image *gray );
+DeVAS_gray_image *DeVAS_gray_image_from_mask ( DeVAS_mask_image *mask,
+			DeVAS_gray set_value );
+
+void		DeVAS_float_image_threshold_mask ( DeVAS_float_image *image,
+			double threshold, DeVAS_mask_image *mask );
+void		DeVAS_RGBf_image_threshold_mask ( DeVAS_RGBf_image *image,
+			double threshold, DeVAS_mask_image *mask );
+
+double		DeVAS_float_image_masked_sum ( DeVAS_float_image *image,
+			DeVAS_mask_image *mask, int outside,
+			size_t *n_pixels );
+double		DeVAS_float_image_masked_mean ( DeVAS_float_image *image,
+			DeVAS_mask_image *mask, int outside );
+double		DeVAS_RGBf_image_masked_mean_Y ( DeVAS_RGBf_image *image,
+			DeVAS_mask_image *mask, int outside );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __DeVAS_MASK_H */
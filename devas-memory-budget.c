@@ -0,0 +1,165 @@
+/*
+ * Memory budget planning for the converters.  See devas-memory-budget.h.
+ *
+ * Setting the environment variable DeVAS_MEMORY_PLAN reports the chosen
+ * strategy on stderr.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "devas-memory-budget.h"
+#include "radiance/color.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+static int
+DeVAS_band_rows ( double available, int n_rows, int n_cols,
+	size_t band_bytes_per_pixel )
+/*
+ * Number of rows of band_bytes_per_pixel pixels that fit in available
+ * bytes, limited to n_rows and DeVAS_MAX_BAND_ROWS.  0 if not even one
+ * row fits.
+ */
+{
+    double  rows;
+
+    if ( band_bytes_per_pixel == 0 ) {
+	rows = n_rows;
+    } else {
+	rows = available / ( ( (double) n_cols ) *
+		( (double) band_bytes_per_pixel ) );
+    }
+
+    if ( rows < 1.0 ) {
+	return ( 0 );
+    }
+    if ( rows > n_rows ) {
+	rows = n_rows;
+    }
+    if ( rows > DeVAS_MAX_BAND_ROWS ) {
+	rows = DeVAS_MAX_BAND_ROWS;
+    }
+
+    return ( (int) rows );
+}
+
+DeVAS_Memory_Plan
+DeVAS_plan_memory ( size_t max_memory, int n_rows, int n_cols,
+	size_t image_bytes_per_pixel, size_t band_bytes_per_pixel,
+	size_t fixed_bytes, int n_passes )
+/*
+ * Pick the fastest strategy for processing an n_rows x n_cols image that
+ * stays within max_memory bytes.  max_memory == 0 means no limit.
+ *
+ * image_bytes_per_pixel:  Memory used per pixel when the whole image is
+ *			   processed in memory.
+ *
+ * band_bytes_per_pixel:   Memory used per pixel of a band of rows when
+ *			   processing in bands.
+ *
+ * fixed_bytes:		   Memory that does not depend on the strategy
+ *			   (codec state, output scanlines, ...).
+ *
+ * n_passes:		   Number of passes over the pixels needed.  Only
+ *			   single-pass processing can discard rows once they
+ *			   have been used.
+ *
+ * It is a fatal error for the budget to be too small for even a single
+ * band row.
+ */
+{
+    DeVAS_Memory_Plan	plan;
+    double		n_pixels;
+    double		overhead;
+    double		packed_bytes;
+    double		compressed_bytes;
+    double		budget;
+
+    n_pixels = ( (double) n_rows ) * ( (double) n_cols );
+    overhead = DeVAS_MEMORY_RESERVE + ( (double) fixed_bytes ) +
+	( ( (double) n_cols ) * ( sizeof ( COLR ) + sizeof ( COLOR ) ) );
+				/* scanline read buffers */
+    packed_bytes = n_pixels * sizeof ( COLR );
+    compressed_bytes = packed_bytes / DeVAS_RLE_EXPECTED_RATIO;
+    budget = (double) max_memory;
+
+    plan.strategy = DeVAS_strategy_in_memory;
+    plan.band_rows = n_rows;
+    plan.bytes = overhead + ( n_pixels * ( (double) image_bytes_per_pixel ) );
+    plan.retain_bytes = 0;
+
+    if ( ( max_memory == 0 ) || ( plan.bytes <= budget ) ) {
+	/* fits, or no limit */
+    } else if ( n_passes <= 1 ) {
+	plan.strategy = DeVAS_strategy_row_bands;
+	plan.band_rows = DeVAS_band_rows ( budget - overhead, n_rows, n_cols,
+		band_bytes_per_pixel );
+	plan.bytes = overhead + ( ( (double) plan.band_rows ) *
+		( (double) n_cols ) * ( (double) band_bytes_per_pixel ) );
+    } else if ( DeVAS_band_rows ( budget - overhead - packed_bytes, n_rows,
+		n_cols, band_bytes_per_pixel ) > 0 ) {
+	plan.strategy = DeVAS_strategy_packed;
+	plan.band_rows = DeVAS_band_rows ( budget - overhead - packed_bytes,
+		n_rows, n_cols, band_bytes_per_pixel );
+	plan.bytes = overhead + packed_bytes + ( ( (double) plan.band_rows ) *
+		( (double) n_cols ) * ( (double) band_bytes_per_pixel ) );
+    } else if ( DeVAS_band_rows ( budget - overhead - compressed_bytes, n_rows,
+		    n_cols, band_bytes_per_pixel ) > 0 ) {
+	plan.strategy = DeVAS_strategy_compressed;
+	plan.band_rows = DeVAS_band_rows ( budget - overhead - compressed_bytes,
+		n_rows, n_cols, band_bytes_per_pixel );
+	/* whatever the band doesn't need is available for the image */
+	plan.retain_bytes = (size_t) ( budget - overhead -
+		( ( (double) plan.band_rows ) * ( (double) n_cols ) *
+		  ( (double) band_bytes_per_pixel ) ) );
+	plan.bytes = overhead + ( (double) plan.retain_bytes ) +
+	    ( ( (double) plan.band_rows ) * ( (double) n_cols ) *
+	      ( (double) band_bytes_per_pixel ) );
+    } else {
+	plan.strategy = DeVAS_strategy_file_backed;
+	plan.band_rows = DeVAS_band_rows ( budget - overhead, n_rows, n_cols,
+		band_bytes_per_pixel );
+	plan.bytes = overhead + ( ( (double) plan.band_rows ) *
+		( (double) n_cols ) * ( (double) band_bytes_per_pixel ) );
+    }
+
+    if ( plan.band_rows < 1 ) {
+	fprintf ( stderr,
+	    "memory limit of %.0f bytes too small for %d x %d image "
+	    "(at least %.0f bytes needed)!\n", budget, n_rows, n_cols,
+	    overhead + ( ( (double) n_cols ) *
+		( (double) band_bytes_per_pixel ) ) );
+	exit ( EXIT_FAILURE );
+    }
+
+    if ( getenv ( "DeVAS_MEMORY_PLAN" ) != NULL ) {
+	fprintf ( stderr, "memory plan: %s, %d rows at a time, ~%.0f bytes\n",
+		DeVAS_memory_strategy_name ( plan.strategy ), plan.band_rows,
+		plan.bytes );
+    }
+
+    return ( plan );
+}
+
+char *
+DeVAS_memory_strategy_name ( DeVAS_Memory_Strategy strategy )
+{
+    switch ( strategy ) {
+	case DeVAS_strategy_in_memory:
+	    return ( "in-memory" );
+
+	case DeVAS_strategy_row_bands:
+	    return ( "row-bands" );
+
+	case DeVAS_strategy_packed:
+	    return ( "packed" );
+
+	case DeVAS_strategy_compressed:
+	    return ( "compressed" );
+
+	case DeVAS_strategy_file_backed:
+	    return ( "file-backed" );
+
+	default:
+	    return ( "unknown" );
+    }
+}
@@ -0,0 +1,80 @@
+/*
+ * Chooses how a converter should hold an image so as to stay within a
+ * memory budget.
+ *
+ * The image size is known from the Radiance header before any pixels are
+ * read, so the choice is made up front.  Strategies, fastest first:
+ *
+ *   DeVAS_strategy_in_memory	  Whole image held as floats (the behavior
+ *				  without a budget).
+ *
+ *   DeVAS_strategy_row_bands	  Single-pass processing: read, convert,
+ *				  and write a band of rows at a time.
+ *
+ *   DeVAS_strategy_packed	  Multi-pass processing (e.g., rescaling to
+ *				  a global maximum), with the image retained
+ *				  between passes as 4 byte/pixel Radiance
+ *				  COLR values rather than 12 byte/pixel floats.
+ *
+ *   DeVAS_strategy_compressed	  Multi-pass processing, with the image
+ *				  retained in the run-length encoded form of
+ *				  Radiance files (typically 3-6 times smaller
+ *				  than COLR values) and decoded again, a band
+ *				  at a time, on later passes.  Chosen when
+ *				  DeVAS_RLE_EXPECTED_RATIO times compression
+ *				  would fit.  If the image turns out not to
+ *				  compress that well, the stream falls back
+ *				  to re-reading the input as for
+ *				  DeVAS_strategy_file_backed.
+ *
+ *   DeVAS_strategy_file_backed	  Multi-pass processing, re-reading the
+ *				  input file (or a temporary copy, if the
+ *				  input is not seekable) on each pass.
+ *
+ * The budget covers pixel buffers, scanline scratch space, and the
+ * per-column codec state given by the caller, plus a fixed
+ * DeVAS_MEMORY_RESERVE for everything else.
+ */
+
+#ifndef __DeVAS_MEMORY_BUDGET_H
+#define __DeVAS_MEMORY_BUDGET_H
+
+#include <stdlib.h>
+#include "devas-license.h"	/* DeVAS open source license */
+
+#define	DeVAS_MEMORY_RESERVE	( 256 * 1024 )	/* libraries, stdio, etc. */
+#define	DeVAS_MAX_BAND_ROWS	256	/* larger bands don't run faster */
+#define	DeVAS_RLE_EXPECTED_RATIO 3	/* conservative COLR : RLE size */
+
+typedef enum {
+    DeVAS_strategy_in_memory,
+    DeVAS_strategy_row_bands,
+    DeVAS_strategy_packed,
+    DeVAS_strategy_compressed,
+    DeVAS_strategy_file_backed
+} DeVAS_Memory_Strategy;
+
+typedef struct {
+    DeVAS_Memory_Strategy strategy;
+    int		    band_rows;	/* rows per band (n_rows if in memory) */
+    double	    bytes;	/* estimated memory use */
+    size_t	    retain_bytes;	/* budget for the retained image */
+    				/* (DeVAS_strategy_compressed) */
+} DeVAS_Memory_Plan;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+DeVAS_Memory_Plan	DeVAS_plan_memory ( size_t max_memory, int n_rows,
+			    int n_cols, size_t image_bytes_per_pixel,
+			    size_t band_bytes_per_pixel, size_t fixed_bytes,
+			    int n_passes );
+char			*DeVAS_memory_strategy_name (
+			    DeVAS_Memory_Strategy strategy );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __DeVAS_MEMORY_BUDGET_H */
@@ -0,0 +1,219 @@
+/*
+ * Accounting of image pixel memory.  See devas-memory.h.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "devas-memory.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+#ifndef	FALSE
+#define	FALSE	0
+#endif
+#ifndef	TRUE
+#define	TRUE	1
+#endif
+
+#define	DeVAS_MEMORY_NAME_LENGTH	32
+
+typedef struct {
+    char	    name[DeVAS_MEMORY_NAME_LENGTH];
+    size_t	    live_bytes;
+    size_t	    peak_bytes;
+    unsigned long   allocations;
+    unsigned long   frees;
+} DeVAS_Memory_Count;
+
+static DeVAS_Memory_Count   memory_counts[DeVAS_MEMORY_MAX_TYPES];
+static int		    n_memory_types = 0;
+static DeVAS_Memory_Count   memory_total = { "total", 0, 0, 0, 0 };
+static int		    report_registered = FALSE;
+
+static void
+DeVAS_memory_report_at_exit ( void )
+{
+    DeVAS_memory_report ( stderr );
+}
+
+static DeVAS_Memory_Count *
+DeVAS_memory_count ( char *pixel_type, int create )
+/*
+ * Counts for pixel_type, or the totals if pixel_type is NULL.  Returns
+ * NULL if pixel_type has never been seen and create is FALSE.
+ */
+{
+    int	    type;
+
+    if ( pixel_type == NULL ) {
+	return ( &memory_total );
+    }
+
+    for ( type = 0; type < n_memory_types; type++ ) {
+	if ( strncmp ( memory_counts[type].name, pixel_type,
+		    DeVAS_MEMORY_NAME_LENGTH - 1 ) == 0 ) {
+	    return ( &memory_counts[type] );
+	}
+    }
+
+    if ( n_memory_types >= DeVAS_MEMORY_MAX_TYPES ) {
+	/* table full, so use the last entry for everything else */
+	type = DeVAS_MEMORY_MAX_TYPES - 1;
+	strcpy ( memory_counts[type].name, "other" );
+	return ( &memory_counts[type] );
+    }
+
+    if ( !create ) {
+	return ( NULL );
+    }
+
+    type = n_memory_types++;
+    strncpy ( memory_counts[type].name, pixel_type,
+	    DeVAS_MEMORY_NAME_LENGTH - 1 );
+    memory_counts[type].name[DeVAS_MEMORY_NAME_LENGTH - 1] = '\0';
+    memory_counts[type].live_bytes = 0;
+    memory_counts[type].peak_bytes = 0;
+    memory_counts[type].allocations = 0;
+    memory_counts[type].frees = 0;
+
+    return ( &memory_counts[type] );
+}
+
+void
+DeVAS_memory_allocated ( char *pixel_type, size_t bytes )
+/*
+ * Record the allocation of a block of bytes of pixel_type pixels.
+ */
+{
+    DeVAS_Memory_Count	*count;
+
+    if ( !report_registered ) {
+	report_registered = TRUE;
+	if ( getenv ( "DeVAS_MEMORY_REPORT" ) != NULL ) {
+	    atexit ( DeVAS_memory_report_at_exit );
+	}
+    }
+
+    count = DeVAS_memory_count ( pixel_type, TRUE );
+    count->live_bytes += bytes;
+    count->allocations++;
+    if ( count->live_bytes > count->peak_bytes ) {
+	count->peak_bytes = count->live_bytes;
+    }
+
+    memory_total.live_bytes += bytes;
+    memory_total.allocations++;
+    if ( memory_total.live_bytes > memory_total.peak_bytes ) {
+	memory_total.peak_bytes = memory_total.live_bytes;
+    }
+}
+
+void
+DeVAS_memory_freed ( char *pixel_type, size_t bytes )
+/*
+ * Record the freeing of a block recorded by DeVAS_memory_allocated.
+ */
+{
+    DeVAS_Memory_Count	*count;
+
+    count = DeVAS_memory_count ( pixel_type, FALSE );
+    if ( ( count == NULL ) || ( count->live_bytes < bytes ) ||
+	    ( memory_total.live_bytes < bytes ) ) {
+	fprintf ( stderr,
+	    "DeVAS_memory_freed: more %s memory freed than allocated (warning)\n",
+		pixel_type );
+	return;
+    }
+
+    count->live_bytes -= bytes;
+    count->frees++;
+
+    memory_total.live_bytes -= bytes;
+    memory_total.frees++;
+}
+
+size_t
+DeVAS_memory_live_bytes ( char *pixel_type )
+{
+    DeVAS_Memory_Count	*count;
+
+    count = DeVAS_memory_count ( pixel_type, FALSE );
+
+    return ( count == NULL ? 0 : count->live_bytes );
+}
+
+size_t
+DeVAS_memory_peak_bytes ( char *pixel_type )
+{
+    DeVAS_Memory_Count	*count;
+
+    count = DeVAS_memory_count ( pixel_type, FALSE );
+
+    return ( count == NULL ? 0 : count->peak_bytes );
+}
+
+unsigned long
+DeVAS_memory_allocations ( char *pixel_type )
+{
+    DeVAS_Memory_Count	*count;
+
+    count = DeVAS_memory_count ( pixel_type, FALSE );
+
+    return ( count == NULL ? 0 : count->allocations );
+}
+
+unsigned long
+DeVAS_memory_live_blocks ( char *pixel_type )
+{
+    DeVAS_Memory_Count	*count;
+
+    count = DeVAS_memory_count ( pixel_type, FALSE );
+
+    return ( count == NULL ? 0 : count->allocations - count->frees );
+}
+
+void
+DeVAS_memory_reset_peak ( void )
+/*
+ * Start a new high-water mark at the current usage, e.g., to measure a
+ * single stage of a pipeline.
+ */
+{
+    int	    type;
+
+    for ( type = 0; type < n_memory_types; type++ ) {
+	memory_counts[type].peak_bytes = memory_counts[type].live_bytes;
+    }
+    memory_total.peak_bytes = memory_total.live_bytes;
+}
+
+void
+DeVAS_memory_report ( FILE *report_fp )
+{
+    int	    type;
+
+    fprintf ( report_fp, "pixel memory:\n" );
+    fprintf ( report_fp, "  %-20s %14s %14s %12s %12s\n", "type",
+	    "peak bytes", "live bytes", "allocations", "live blocks" );
+    for ( type = 0; type < n_memory_types; type++ ) {
+	fprintf ( report_fp, "  %-20s %14lu %14lu %12lu %12lu\n",
+		memory_counts[type].name,
+		(unsigned long) memory_counts[type].peak_bytes,
+		(unsigned long) memory_counts[type].live_bytes,
+		memory_counts[type].allocations,
+		memory_counts[type].allocations - memory_counts[type].frees );
+    }
+    fprintf ( report_fp, "  %-20s %14lu %14lu %12lu %12lu\n",
+	    memory_total.name, (unsigned long) memory_total.peak_bytes,
+	    (unsigned long) memory_total.live_bytes, memory_total.allocations,
+	    memory_total.allocations - memory_total.frees );
+
+    for ( type = 0; type < n_memory_types; type++ ) {
+	if ( memory_counts[type].allocations > memory_counts[type].frees ) {
+	    fprintf ( report_fp, "  not freed: %lu %s block(s), %lu bytes\n",
+		    memory_counts[type].allocations - memory_counts[type].frees,
+		    memory_counts[type].name,
+		    (unsigned long) memory_counts[type].live_bytes );
+	}
+    }
+}
@@ -0,0 +1,67 @@
+/*
+ * Accounting of image pixel memory.
+ *
+ * The image constructors and destructors in devas-image.c and
+ * tifftoolsimage.c record each pixel block they allocate or free, keyed
+ * by pixel type name (e.g., "DeVAS_RGBf", "TT_RGB").  Other large buffers
+ * may be recorded the same way under a name of their own.
+ *
+ *   DeVAS_memory_live_bytes ( <pixel_type> )
+ *
+ *	Bytes of pixel storage currently allocated.
+ *
+ *   DeVAS_memory_peak_bytes ( <pixel_type> )
+ *
+ *	High-water mark of DeVAS_memory_live_bytes since the start of the
+ *	program or the last DeVAS_memory_reset_peak ( ).
+ *
+ *   DeVAS_memory_allocations ( <pixel_type> )
+ *
+ *	Number of blocks allocated.
+ *
+ *   DeVAS_memory_live_blocks ( <pixel_type> )
+ *
+ *	Number of blocks allocated and not yet freed.
+ *
+ * A <pixel_type> of NULL gives totals over all types.  Note that the total
+ * peak is the high-water mark of the sum, not the sum of the per-type
+ * high-water marks.
+ *
+ * DeVAS_memory_report ( <FILE> ) prints the counts for each type, along
+ * with any blocks still allocated.  Setting the environment variable
+ * DeVAS_MEMORY_REPORT causes the report to be printed on stderr when the
+ * program exits, so blocks that were never freed show up as leaks.
+ *
+ * File-backed (memory mapped) storage is counted along with everything
+ * else.
+ */
+
+#ifndef __DeVAS_MEMORY_H
+#define __DeVAS_MEMORY_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "devas-license.h"	/* DeVAS open source license */
+
+#define	DeVAS_MEMORY_MAX_TYPES	32	/* others are lumped together */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void		DeVAS_memory_allocated ( char *pixel_type, size_t bytes );
+void		DeVAS_memory_freed ( char *pixel_type, size_t bytes );
+
+size_t		DeVAS_memory_live_bytes ( char *pixel_type );
+size_t		DeVAS_memory_peak_bytes ( char *pixel_type );
+unsigned long	DeVAS_memory_allocations ( char *pixel_type );
+unsigned long	DeVAS_memory_live_blocks ( char *pixel_type );
+void		DeVAS_memory_reset_peak ( void );
+
+void		DeVAS_memory_report ( FILE *report_fp );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __DeVAS_MEMORY_H */
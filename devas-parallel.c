@@ -0,0 +1,231 @@
+/*
+ * Row band parallel loops.  See devas-parallel.h.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#include "devas-parallel.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+#ifndef TRUE
+#define	TRUE		1
+#endif
+#ifndef FALSE
+#define	FALSE		0
+#endif
+
+static int		n_threads = 0;		/* 0 until initialized */
+static int		n_workers = 0;		/* started */
+static pthread_t	workers[DeVAS_PARALLEL_MAX_THREADS];
+
+static pthread_mutex_t	pool_busy = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t	job_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	job_ready = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t	job_done = PTHREAD_COND_INITIALIZER;
+
+static struct {				/* protected by job_lock */
+    DeVAS_Band_Function function;
+    void		*context;
+    int			n_rows;
+    int			band_rows;
+    int			n_bands;
+    int			next_band;	/* next to hand out */
+    int			bands_done;
+    int			participants;	/* workers with index below this */
+} job;
+
+static int
+DeVAS_parallel_n_processors ( void )
+{
+#ifdef _WIN32
+    SYSTEM_INFO	    info;
+
+    GetSystemInfo ( &info );
+    return ( (int) info.dwNumberOfProcessors );
+#else
+    long    n;
+
+    n = sysconf ( _SC_NPROCESSORS_ONLN );
+    return ( ( n > 0 ) ? (int) n : 1 );
+#endif
+}
+
+int
+DeVAS_parallel_n_threads ( void )
+{
+    char    *env_value;
+    char    *end;
+    long    value;
+
+    if ( n_threads == 0 ) {
+	n_threads = DeVAS_parallel_n_processors ( );
+	env_value = getenv ( "DeVAS_THREADS" );
+	if ( env_value != NULL ) {
+	    value = strtol ( env_value, &end, 10 );
+	    if ( ( end == env_value ) || ( *end != '\0' ) || ( value < 1 ) ) {
+		fprintf ( stderr,
+			"invalid DeVAS_THREADS value (%s), ignored\n",
+			env_value );
+	    } else {
+		n_threads = value;
+	    }
+	}
+	if ( n_threads > DeVAS_PARALLEL_MAX_THREADS ) {
+	    n_threads = DeVAS_PARALLEL_MAX_THREADS;
+	}
+    }
+
+    return ( n_threads );
+}
+
+void
+DeVAS_parallel_set_n_threads ( int new_n_threads )
+{
+    if ( new_n_threads < 1 ) {
+	new_n_threads = 1;
+    } else if ( new_n_threads > DeVAS_PARALLEL_MAX_THREADS ) {
+	new_n_threads = DeVAS_PARALLEL_MAX_THREADS;
+    }
+
+    pthread_mutex_lock ( &pool_busy );
+    n_threads = new_n_threads;
+    pthread_mutex_unlock ( &pool_busy );
+}
+
+int
+DeVAS_parallel_n_bands ( int n_rows, int band_rows )
+{
+    if ( ( n_rows <= 0 ) || ( band_rows <= 0 ) ) {
+	return ( 0 );
+    }
+
+    return ( ( n_rows + band_rows - 1 ) / band_rows );
+}
+
+int
+DeVAS_parallel_band_rows ( int n_cols )
+{
+    if ( n_cols >= DeVAS_PARALLEL_BAND_PIXELS ) {
+	return ( 1 );
+    }
+
+    return ( DeVAS_PARALLEL_BAND_PIXELS / ( n_cols > 0 ? n_cols : 1 ) );
+}
+
+static void
+DeVAS_parallel_run_bands ( int index )
+/*
+ * Takes bands from the current job until there are none left.  index is
+ * the worker number, or -1 for the calling thread.  Called with job_lock
+ * held, and returns with it held.
+ */
+{
+    DeVAS_Band_Function function;
+    void		*context;
+    int			band, first_row, n_band_rows;
+
+    while ( ( job.next_band < job.n_bands ) && ( index < job.participants ) ) {
+	band = job.next_band++;
+	function = job.function;
+	context = job.context;
+	first_row = band * job.band_rows;
+	n_band_rows = ( job.n_rows - first_row < job.band_rows ) ?
+	    job.n_rows - first_row : job.band_rows;
+
+	pthread_mutex_unlock ( &job_lock );
+	( *function ) ( context, band, first_row, n_band_rows );
+	pthread_mutex_lock ( &job_lock );
+
+	if ( ++job.bands_done == job.n_bands ) {
+	    pthread_cond_broadcast ( &job_done );
+	}
+    }
+}
+
+static void *
+DeVAS_parallel_worker ( void *arg )
+{
+    int	    index;
+
+    index = (int) (intptr_t) arg;
+
+    pthread_mutex_lock ( &job_lock );
+    while ( TRUE ) {
+	DeVAS_parallel_run_bands ( index );
+	pthread_cond_wait ( &job_ready, &job_lock );
+    }
+
+    return ( NULL );	/* not reached */
+}
+
+static void
+DeVAS_parallel_start_workers ( int wanted )
+/*
+ * Called with pool_busy held.  If a thread can't be started, makes do
+ * with the ones already running.
+ */
+{
+    while ( n_workers < wanted ) {
+	if ( pthread_create ( &workers[n_workers], NULL,
+		    DeVAS_parallel_worker, (void *) (intptr_t) n_workers )
+		!= 0 ) {
+	    fprintf ( stderr,
+		    "DeVAS_parallel_bands: can't start thread (warning)\n" );
+	    break;
+	}
+	pthread_detach ( workers[n_workers] );
+	n_workers++;
+    }
+}
+
+void
+DeVAS_parallel_bands ( int n_rows, int band_rows,
+	DeVAS_Band_Function function, void *context )
+{
+    int	    n_bands;
+    int	    band, first_row;
+
+    n_bands = DeVAS_parallel_n_bands ( n_rows, band_rows );
+
+    if ( ( n_bands <= 1 ) || ( DeVAS_parallel_n_threads ( ) <= 1 ) ||
+	    ( pthread_mutex_trylock ( &pool_busy ) != 0 ) ) {
+	/* serial */
+	for ( band = 0; band < n_bands; band++ ) {
+	    first_row = band * band_rows;
+	    ( *function ) ( context, band, first_row,
+		    ( n_rows - first_row < band_rows ) ?
+		    n_rows - first_row : band_rows );
+	}
+	return;
+    }
+
+    DeVAS_parallel_start_workers ( n_threads - 1 );
+
+    pthread_mutex_lock ( &job_lock );
+    job.function = function;
+    job.context = context;
+    job.n_rows = n_rows;
+    job.band_rows = band_rows;
+    job.n_bands = n_bands;
+    job.next_band = 0;
+    job.bands_done = 0;
+    job.participants = n_threads - 1;	/* workers */
+    pthread_cond_broadcast ( &job_ready );
+
+    DeVAS_parallel_run_bands ( -1 );	/* caller helps */
+
+    while ( job.bands_done < job.n_bands ) {
+	pthread_cond_wait ( &job_done, &job_lock );
+    }
+    job.n_bands = 0;
+    pthread_mutex_unlock ( &job_lock );
+
+    pthread_mutex_unlock ( &pool_busy );
+}
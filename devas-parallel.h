@@ -0,0 +1,56 @@
+/*
+ * Row band parallel loops on a shared pool of worker threads.
+ *
+ *   DeVAS_parallel_bands ( n_rows, band_rows, <function>, <context> )
+ *
+ *	Calls function ( context, band, first_row, n_band_rows ) for each
+ *	band of band_rows rows (the last band may be shorter), for band = 0
+ *	to DeVAS_parallel_n_bands ( n_rows, band_rows ) - 1.  Calls run
+ *	concurrently, in no particular order, on the calling thread and
+ *	the workers, and all are finished when DeVAS_parallel_bands
+ *	returns.  Reductions should keep a result per band and combine
+ *	them afterward, in band order, so that the answer doesn't depend
+ *	on the number of threads.  A call made while the pool is busy
+ *	(e.g., from inside function) runs its bands serially.
+ *
+ *   DeVAS_parallel_band_rows ( n_cols )
+ *
+ *	Rows per band for about DeVAS_PARALLEL_BAND_PIXELS pixels (at least
+ *	one row).  Depends only on n_cols.
+ *
+ *   DeVAS_parallel_n_threads ( )
+ *   DeVAS_parallel_set_n_threads ( n )
+ *
+ *	Number of threads used, including the caller.  The initial value
+ *	comes from the environment variable DeVAS_THREADS, if set, and
+ *	otherwise is the number of processors.  1 means no worker threads.
+ *	Workers are started on first use.
+ */
+
+#ifndef __DeVAS_PARALLEL_H
+#define __DeVAS_PARALLEL_H
+
+#include "devas-license.h"	/* DeVAS open source license */
+
+#define	DeVAS_PARALLEL_BAND_PIXELS	( 64 * 1024 )
+#define	DeVAS_PARALLEL_MAX_THREADS	64
+
+typedef void (*DeVAS_Band_Function) ( void *context, int band, int first_row,
+	    int n_band_rows );
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void	DeVAS_parallel_bands ( int n_rows, int band_rows,
+	    DeVAS_Band_Function function, void *context );
+int	DeVAS_parallel_n_bands ( int n_rows, int band_rows );
+int	DeVAS_parallel_band_rows ( int n_cols );
+int	DeVAS_parallel_n_threads ( void );
+void	DeVAS_parallel_set_n_threads ( int n_threads );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __DeVAS_PARALLEL_H */
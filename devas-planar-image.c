@@ -0,0 +1,580 @@
+/*
+ * Planar versions of the three channel floating point DeVAS image types.
+ * See devas-planar-image.h.
+ *
+ * The SSE2 kernels do their arithmetic in the same precision and order
+ * as the scalar code in devas-image.c (float for the 3 x 3 matrix
+ * products, double where the scalar code promotes to double), so planar
+ * and interleaved conversions give bit-identical results.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#ifdef	__SSE2__
+#include <emmintrin.h>
+#endif	/* __SSE2__ */
+#include "devas-planar-image.h"
+#include "devas-license.h"	/* DeVAS open source license */
+#include "radiance/color.h"
+
+#define DeVAS_PLANAR_IMAGE( TYPE, C0, C1, C2 )				\
+TYPE##_planar_image *							\
+TYPE##_planar_image_new ( unsigned int n_rows, unsigned int n_cols )	\
+{									\
+    TYPE##_planar_image	*new_image;					\
+    VIEW		nullview = NULLVIEW;				\
+									\
+    new_image = (TYPE##_planar_image *)					\
+	malloc ( sizeof ( TYPE##_planar_image ) );			\
+    if ( new_image == NULL ) {						\
+	fprintf ( stderr, "DeVAS_planar_image_new: malloc failed!" );	\
+	DeVAS_print_file_lineno ( __FILE__, __LINE__ );			\
+	exit ( EXIT_FAILURE );						\
+    }									\
+									\
+    new_image->n_rows = n_rows;						\
+    new_image->n_cols = n_cols;						\
+    new_image->exposure_set = FALSE;					\
+    new_image->exposure = 1.0;						\
+    new_image->image_info.view = nullview;				\
+    new_image->image_info.description = NULL;				\
+									\
+    new_image->C0 = DeVAS_float_image_new ( n_rows, n_cols );		\
+    new_image->C1 = DeVAS_float_image_new ( n_rows, n_cols );		\
+    new_image->C2 = DeVAS_float_image_new ( n_rows, n_cols );		\
+									\
+    return ( new_image );						\
+}									\
+									\
+void									\
+TYPE##_planar_image_delete ( TYPE##_planar_image *image )		\
+{									\
+    if ( image->image_info.description != NULL ) {			\
+	free ( image->image_info.description );				\
+    }									\
+    DeVAS_float_image_delete ( image->C0 );				\
+    DeVAS_float_image_delete ( image->C1 );				\
+    DeVAS_float_image_delete ( image->C2 );				\
+    free ( image );							\
+}									\
+									\
+TYPE##_planar_image *							\
+TYPE##_planar_image_from_image ( TYPE##_image *image )			\
+{									\
+    TYPE##_planar_image	*planar_image;					\
+    int			row;						\
+									\
+    assert ( sizeof ( TYPE ) == 3 * sizeof ( float ) );			\
+									\
+    planar_image = TYPE##_planar_image_new (				\
+	    DeVAS_image_n_rows ( image ), DeVAS_image_n_cols ( image ) );	\
+									\
+    planar_image->exposure_set = DeVAS_image_exposure_set ( image );	\
+    planar_image->exposure = DeVAS_image_exposure ( image );		\
+    planar_image->image_info.view = DeVAS_image_view ( image );	\
+    if ( DeVAS_image_description ( image ) != NULL ) {			\
+	planar_image->image_info.description =				\
+	    strdup ( DeVAS_image_description ( image ) );		\
+    }									\
+									\
+    for ( row = 0; row < DeVAS_image_n_rows ( image ); row++ ) {	\
+	DeVAS_deinterleave3 ( (float *) image->data[row],		\
+		planar_image->C0->data[row],				\
+		planar_image->C1->data[row],				\
+		planar_image->C2->data[row],				\
+		DeVAS_image_n_cols ( image ) );				\
+    }									\
+									\
+    return ( planar_image );						\
+}									\
+									\
+TYPE##_image *								\
+TYPE##_image_from_planar_image ( TYPE##_planar_image *planar_image )	\
+{									\
+    TYPE##_image	*image;						\
+    int			row;						\
+									\
+    assert ( sizeof ( TYPE ) == 3 * sizeof ( float ) );			\
+									\
+    image = TYPE##_image_new ( planar_image->n_rows,			\
+	    planar_image->n_cols );					\
+									\
+    DeVAS_image_exposure_set ( image ) = planar_image->exposure_set;	\
+    DeVAS_image_exposure ( image ) = planar_image->exposure;		\
+    DeVAS_image_view ( image ) = planar_image->image_info.view;	\
+    if ( planar_image->image_info.description != NULL ) {		\
+	DeVAS_image_description ( image ) =				\
+	    strdup ( planar_image->image_info.description );		\
+    }									\
+									\
+    for ( row = 0; row < DeVAS_image_n_rows ( image ); row++ ) {	\
+	DeVAS_interleave3 ( planar_image->C0->data[row],		\
+		planar_image->C1->data[row],				\
+		planar_image->C2->data[row],				\
+		(float *) image->data[row],				\
+		DeVAS_image_n_cols ( image ) );				\
+    }									\
+									\
+    return ( image );							\
+}
+
+DeVAS_PLANAR_IMAGE ( DeVAS_RGBf, red, green, blue )
+DeVAS_PLANAR_IMAGE ( DeVAS_XYZ, X, Y, Z )
+DeVAS_PLANAR_IMAGE ( DeVAS_xyY, x, y, Y )
+
+void
+DeVAS_deinterleave3 ( const float *src, float *c0, float *c1, float *c2,
+	int n )
+/*
+ * src holds n interleaved triples.
+ */
+{
+    int	    i = 0;
+#ifdef	__SSE2__
+    __m128  a, b, c, t0, t1;
+
+    for ( ; i + 4 <= n; i += 4 ) {
+	/* a = 0 1 2 0, b = 1 2 0 1, c = 2 0 1 2 (channel of each element) */
+	a = _mm_loadu_ps ( src + ( 3 * i ) );
+	b = _mm_loadu_ps ( src + ( 3 * i ) + 4 );
+	c = _mm_loadu_ps ( src + ( 3 * i ) + 8 );
+
+	t0 = _mm_shuffle_ps ( a, a, _MM_SHUFFLE ( 0, 0, 3, 0 ) );
+	t1 = _mm_shuffle_ps ( b, c, _MM_SHUFFLE ( 1, 1, 2, 2 ) );
+	_mm_storeu_ps ( c0 + i,
+		_mm_shuffle_ps ( t0, t1, _MM_SHUFFLE ( 2, 0, 1, 0 ) ) );
+
+	t0 = _mm_shuffle_ps ( a, b, _MM_SHUFFLE ( 0, 0, 0, 1 ) );
+	t1 = _mm_shuffle_ps ( b, c, _MM_SHUFFLE ( 2, 2, 3, 3 ) );
+	_mm_storeu_ps ( c1 + i,
+		_mm_shuffle_ps ( t0, t1, _MM_SHUFFLE ( 2, 0, 2, 0 ) ) );
+
+	t0 = _mm_shuffle_ps ( a, b, _MM_SHUFFLE ( 1, 1, 2, 2 ) );
+	t1 = _mm_shuffle_ps ( c, c, _MM_SHUFFLE ( 3, 3, 0, 0 ) );
+	_mm_storeu_ps ( c2 + i,
+		_mm_shuffle_ps ( t0, t1, _MM_SHUFFLE ( 2, 0, 2, 0 ) ) );
+    }
+#endif	/* __SSE2__ */
+
+    for ( ; i < n; i++ ) {
+	c0[i] = src[3 * i];
+	c1[i] = src[( 3 * i ) + 1];
+	c2[i] = src[( 3 * i ) + 2];
+    }
+}
+
+void
+DeVAS_interleave3 ( const float *c0, const float *c1, const float *c2,
+	float *dst, int n )
+/*
+ * Inverse of DeVAS_deinterleave3.
+ */
+{
+    int	    i = 0;
+#ifdef	__SSE2__
+    __m128  v0, v1, v2, t0, t1;
+
+    for ( ; i + 4 <= n; i += 4 ) {
+	v0 = _mm_loadu_ps ( c0 + i );
+	v1 = _mm_loadu_ps ( c1 + i );
+	v2 = _mm_loadu_ps ( c2 + i );
+
+	t0 = _mm_shuffle_ps ( v0, v1, _MM_SHUFFLE ( 0, 0, 0, 0 ) );
+	t1 = _mm_shuffle_ps ( v2, v0, _MM_SHUFFLE ( 1, 1, 0, 0 ) );
+	_mm_storeu_ps ( dst + ( 3 * i ),
+		_mm_shuffle_ps ( t0, t1, _MM_SHUFFLE ( 2, 0, 2, 0 ) ) );
+
+	t0 = _mm_shuffle_ps ( v1, v2, _MM_SHUFFLE ( 1, 1, 1, 1 ) );
+	t1 = _mm_shuffle_ps ( v0, v1, _MM_SHUFFLE ( 2, 2, 2, 2 ) );
+	_mm_storeu_ps ( dst + ( 3 * i ) + 4,
+		_mm_shuffle_ps ( t0, t1, _MM_SHUFFLE ( 2, 0, 2, 0 ) ) );
+
+	t0 = _mm_shuffle_ps ( v2, v0, _MM_SHUFFLE ( 3, 3, 2, 2 ) );
+	t1 = _mm_shuffle_ps ( v1, v2, _MM_SHUFFLE ( 3, 3, 3, 3 ) );
+	_mm_storeu_ps ( dst + ( 3 * i ) + 8,
+		_mm_shuffle_ps ( t0, t1, _MM_SHUFFLE ( 2, 0, 2, 0 ) ) );
+    }
+#endif	/* __SSE2__ */
+
+    for ( ; i < n; i++ ) {
+	dst[3 * i] = c0[i];
+	dst[( 3 * i ) + 1] = c1[i];
+	dst[( 3 * i ) + 2] = c2[i];
+    }
+}
+
+static void
+DeVAS_matrix3_row ( COLORMAT mat, double scale, int divide,
+	const float *in0, const float *in1, const float *in2,
+	float *out0, float *out1, float *out2, int n )
+/*
+ * out = ( mat * in ) * scale, or ( mat * in ) / scale if divide is TRUE,
+ * with the matrix product in float as in Radiance colortrans, and the
+ * scaling as float * double.  The output may overwrite the input.
+ */
+{
+    int	    i = 0;
+    float   p0, p1, p2;
+#ifdef	__SSE2__
+    __m128  m00, m01, m02, m10, m11, m12, m20, m21, m22;
+    __m128  x0, x1, x2, y0, y1, y2, fscale;
+    __m128d dscale;
+
+    m00 = _mm_set1_ps ( mat[0][0] );
+    m01 = _mm_set1_ps ( mat[0][1] );
+    m02 = _mm_set1_ps ( mat[0][2] );
+    m10 = _mm_set1_ps ( mat[1][0] );
+    m11 = _mm_set1_ps ( mat[1][1] );
+    m12 = _mm_set1_ps ( mat[1][2] );
+    m20 = _mm_set1_ps ( mat[2][0] );
+    m21 = _mm_set1_ps ( mat[2][1] );
+    m22 = _mm_set1_ps ( mat[2][2] );
+    fscale = _mm_set1_ps ( (float) scale );
+    dscale = _mm_set1_pd ( scale );
+
+    for ( ; i + 4 <= n; i += 4 ) {
+	x0 = _mm_loadu_ps ( in0 + i );
+	x1 = _mm_loadu_ps ( in1 + i );
+	x2 = _mm_loadu_ps ( in2 + i );
+
+	y0 = _mm_add_ps ( _mm_add_ps ( _mm_mul_ps ( m00, x0 ),
+		    _mm_mul_ps ( m01, x1 ) ), _mm_mul_ps ( m02, x2 ) );
+	y1 = _mm_add_ps ( _mm_add_ps ( _mm_mul_ps ( m10, x0 ),
+		    _mm_mul_ps ( m11, x1 ) ), _mm_mul_ps ( m12, x2 ) );
+	y2 = _mm_add_ps ( _mm_add_ps ( _mm_mul_ps ( m20, x0 ),
+		    _mm_mul_ps ( m21, x1 ) ), _mm_mul_ps ( m22, x2 ) );
+
+	if ( divide ) {
+	    /* double division, rounded to float, as in the scalar code */
+	    y0 = _mm_movelh_ps (
+		    _mm_cvtpd_ps ( _mm_div_pd ( _mm_cvtps_pd ( y0 ), dscale ) ),
+		    _mm_cvtpd_ps ( _mm_div_pd ( _mm_cvtps_pd (
+			    _mm_movehl_ps ( y0, y0 ) ), dscale ) ) );
+	    y1 = _mm_movelh_ps (
+		    _mm_cvtpd_ps ( _mm_div_pd ( _mm_cvtps_pd ( y1 ), dscale ) ),
+		    _mm_cvtpd_ps ( _mm_div_pd ( _mm_cvtps_pd (
+			    _mm_movehl_ps ( y1, y1 ) ), dscale ) ) );
+	    y2 = _mm_movelh_ps (
+		    _mm_cvtpd_ps ( _mm_div_pd ( _mm_cvtps_pd ( y2 ), dscale ) ),
+		    _mm_cvtpd_ps ( _mm_div_pd ( _mm_cvtps_pd (
+			    _mm_movehl_ps ( y2, y2 ) ), dscale ) ) );
+	} else {
+	    /* float * float is exact in double, so this rounds the same */
+	    y0 = _mm_mul_ps ( y0, fscale );
+	    y1 = _mm_mul_ps ( y1, fscale );
+	    y2 = _mm_mul_ps ( y2, fscale );
+	}
+
+	_mm_storeu_ps ( out0 + i, y0 );
+	_mm_storeu_ps ( out1 + i, y1 );
+	_mm_storeu_ps ( out2 + i, y2 );
+    }
+#endif	/* __SSE2__ */
+
+    for ( ; i < n; i++ ) {
+	p0 = mat[0][0] * in0[i] + mat[0][1] * in1[i] + mat[0][2] * in2[i];
+	p1 = mat[1][0] * in0[i] + mat[1][1] * in1[i] + mat[1][2] * in2[i];
+	p2 = mat[2][0] * in0[i] + mat[2][1] * in1[i] + mat[2][2] * in2[i];
+	if ( divide ) {
+	    out0[i] = p0 / scale;
+	    out1[i] = p1 / scale;
+	    out2[i] = p2 / scale;
+	} else {
+	    out0[i] = p0 * scale;
+	    out1[i] = p1 * scale;
+	    out2[i] = p2 * scale;
+	}
+    }
+}
+
+void
+DeVAS_RGBf_planar_to_XYZ_planar ( DeVAS_RGBf_planar_image *RGBf,
+	DeVAS_XYZ_planar_image *XYZ )
+/*
+ * Same as DeVAS_RGBf2XYZ.
+ */
+{
+    int	    row;
+
+    if ( ( RGBf->n_rows != XYZ->n_rows ) || ( RGBf->n_cols != XYZ->n_cols ) ) {
+	fprintf ( stderr,
+		"DeVAS_RGBf_planar_to_XYZ_planar: image sizes differ!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    for ( row = 0; row < RGBf->n_rows; row++ ) {
+	DeVAS_matrix3_row ( rgb2xyzmat, WHTEFFICACY, FALSE,
+		RGBf->red->data[row], RGBf->green->data[row],
+		RGBf->blue->data[row], XYZ->X->data[row], XYZ->Y->data[row],
+		XYZ->Z->data[row], RGBf->n_cols );
+    }
+}
+
+void
+DeVAS_XYZ_planar_to_RGBf_planar ( DeVAS_XYZ_planar_image *XYZ,
+	DeVAS_RGBf_planar_image *RGBf )
+/*
+ * Same as DeVAS_XYZ2RGBf.
+ */
+{
+    int	    row;
+
+    if ( ( RGBf->n_rows != XYZ->n_rows ) || ( RGBf->n_cols != XYZ->n_cols ) ) {
+	fprintf ( stderr,
+		"DeVAS_XYZ_planar_to_RGBf_planar: image sizes differ!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    for ( row = 0; row < XYZ->n_rows; row++ ) {
+	DeVAS_matrix3_row ( xyz2rgbmat, WHTEFFICACY, TRUE,
+		XYZ->X->data[row], XYZ->Y->data[row], XYZ->Z->data[row],
+		RGBf->red->data[row], RGBf->green->data[row],
+		RGBf->blue->data[row], XYZ->n_cols );
+    }
+}
+
+void
+DeVAS_XYZ_planar_to_xyY_planar ( DeVAS_XYZ_planar_image *XYZ,
+	DeVAS_xyY_planar_image *xyY )
+/*
+ * Same as DeVAS_XYZ2xyY, but without a branch per pixel.
+ */
+{
+    int	    row, col;
+    float   *X, *Y, *Z, *x, *y, *xyY_Y;
+    float   norm;
+#ifdef	__SSE2__
+    __m128  vX, vY, vZ, vnorm, black, white_x, white_y, zero;
+#endif	/* __SSE2__ */
+
+    if ( ( xyY->n_rows != XYZ->n_rows ) || ( xyY->n_cols != XYZ->n_cols ) ) {
+	fprintf ( stderr,
+		"DeVAS_XYZ_planar_to_xyY_planar: image sizes differ!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+#ifdef	__SSE2__
+    white_x = _mm_set1_ps ( (float) DeVAS_x_WHITEPOINT );
+    white_y = _mm_set1_ps ( (float) DeVAS_y_WHITEPOINT );
+    zero = _mm_setzero_ps ( );
+#endif	/* __SSE2__ */
+
+    for ( row = 0; row < XYZ->n_rows; row++ ) {
+	X = XYZ->X->data[row];
+	Y = XYZ->Y->data[row];
+	Z = XYZ->Z->data[row];
+	x = xyY->x->data[row];
+	y = xyY->y->data[row];
+	xyY_Y = xyY->Y->data[row];
+
+	col = 0;
+#ifdef	__SSE2__
+	for ( ; col + 4 <= XYZ->n_cols; col += 4 ) {
+	    vX = _mm_loadu_ps ( X + col );
+	    vY = _mm_loadu_ps ( Y + col );
+	    vZ = _mm_loadu_ps ( Z + col );
+	    vnorm = _mm_add_ps ( _mm_add_ps ( vX, vY ), vZ );
+	    black = _mm_cmple_ps ( vnorm, zero );   /* all ones if black */
+
+	    _mm_storeu_ps ( x + col, _mm_or_ps (
+			_mm_and_ps ( black, white_x ),
+			_mm_andnot_ps ( black, _mm_div_ps ( vX, vnorm ) ) ) );
+	    _mm_storeu_ps ( y + col, _mm_or_ps (
+			_mm_and_ps ( black, white_y ),
+			_mm_andnot_ps ( black, _mm_div_ps ( vY, vnorm ) ) ) );
+	    _mm_storeu_ps ( xyY_Y + col, _mm_andnot_ps ( black, vY ) );
+	}
+#endif	/* __SSE2__ */
+	for ( ; col < XYZ->n_cols; col++ ) {
+	    norm = X[col] + Y[col] + Z[col];
+	    if ( norm <= 0.0 ) {
+		x[col] = DeVAS_x_WHITEPOINT;
+		y[col] = DeVAS_y_WHITEPOINT;
+		xyY_Y[col] = 0.0;
+	    } else {
+		x[col] = X[col] / norm;
+		y[col] = Y[col] / norm;
+		xyY_Y[col] = Y[col];
+	    }
+	}
+    }
+}
+
+void
+DeVAS_xyY_planar_to_XYZ_planar ( DeVAS_xyY_planar_image *xyY,
+	DeVAS_XYZ_planar_image *XYZ )
+/*
+ * Same as DeVAS_xyY2XYZ, but without a branch per pixel.
+ */
+{
+    int	    row, col;
+    float   *X, *Y, *Z, *x, *y, *xyY_Y;
+    float   Y_value;
+#ifdef	__SSE2__
+    __m128  vx, vy, vY, valid, zero, Z_lo, Z_hi;
+    __m128d one_d;
+#endif	/* __SSE2__ */
+
+    if ( ( xyY->n_rows != XYZ->n_rows ) || ( xyY->n_cols != XYZ->n_cols ) ) {
+	fprintf ( stderr,
+		"DeVAS_xyY_planar_to_XYZ_planar: image sizes differ!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+#ifdef	__SSE2__
+    zero = _mm_setzero_ps ( );
+    one_d = _mm_set1_pd ( 1.0 );
+#endif	/* __SSE2__ */
+
+    for ( row = 0; row < xyY->n_rows; row++ ) {
+	X = XYZ->X->data[row];
+	Y = XYZ->Y->data[row];
+	Z = XYZ->Z->data[row];
+	x = xyY->x->data[row];
+	y = xyY->y->data[row];
+	xyY_Y = xyY->Y->data[row];
+
+	col = 0;
+#ifdef	__SSE2__
+	for ( ; col + 4 <= xyY->n_cols; col += 4 ) {
+	    vx = _mm_loadu_ps ( x + col );
+	    vy = _mm_loadu_ps ( y + col );
+	    vY = _mm_loadu_ps ( xyY_Y + col );
+	    valid = _mm_cmpgt_ps ( vy, zero );	/* all ones unless y <= 0 */
+
+	    /* Z = ( ( 1.0 - x - y ) * Y ) / y, in double */
+	    Z_lo = _mm_cvtpd_ps ( _mm_div_pd ( _mm_mul_pd ( _mm_sub_pd (
+			    _mm_sub_pd ( one_d, _mm_cvtps_pd ( vx ) ),
+			    _mm_cvtps_pd ( vy ) ), _mm_cvtps_pd ( vY ) ),
+			_mm_cvtps_pd ( vy ) ) );
+	    Z_hi = _mm_cvtpd_ps ( _mm_div_pd ( _mm_mul_pd ( _mm_sub_pd (
+			    _mm_sub_pd ( one_d, _mm_cvtps_pd (
+				    _mm_movehl_ps ( vx, vx ) ) ),
+			    _mm_cvtps_pd ( _mm_movehl_ps ( vy, vy ) ) ),
+			    _mm_cvtps_pd ( _mm_movehl_ps ( vY, vY ) ) ),
+			_mm_cvtps_pd ( _mm_movehl_ps ( vy, vy ) ) ) );
+
+	    _mm_storeu_ps ( X + col, _mm_and_ps ( valid,
+			_mm_div_ps ( _mm_mul_ps ( vx, vY ), vy ) ) );
+	    _mm_storeu_ps ( Y + col, _mm_and_ps ( valid, vY ) );
+	    _mm_storeu_ps ( Z + col, _mm_and_ps ( valid,
+			_mm_movelh_ps ( Z_lo, Z_hi ) ) );
+	}
+#endif	/* __SSE2__ */
+	for ( ; col < xyY->n_cols; col++ ) {
+	    if ( y[col] <= 0.0 ) {
+		X[col] = Y[col] = Z[col] = 0.0;
+	    } else {
+		Y_value = xyY_Y[col];
+		X[col] = ( x[col] * Y_value ) / y[col];
+		Z[col] = ( ( 1.0 - x[col] - y[col] ) * Y_value ) / y[col];
+		Y[col] = Y_value;
+	    }
+	}
+    }
+}
+
+void
+DeVAS_RGBf_planar_to_Y ( DeVAS_RGBf_planar_image *RGBf, DeVAS_float_image *Y )
+/*
+ * Same as DeVAS_RGBf2Y (Radiance luminance, computed in double).
+ */
+{
+    int	    row, col;
+    float   *red, *green, *blue, *out;
+#ifdef	__SSE2__
+    __m128d rf, gf, bf, efficacy;
+    __m128  r, g, b;
+    __m128  lo, hi;
+#endif	/* __SSE2__ */
+
+    if ( ( RGBf->n_rows != DeVAS_image_n_rows ( Y ) ) ||
+	    ( RGBf->n_cols != DeVAS_image_n_cols ( Y ) ) ) {
+	fprintf ( stderr, "DeVAS_RGBf_planar_to_Y: image sizes differ!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+#ifdef	__SSE2__
+    rf = _mm_set1_pd ( CIE_rf );
+    gf = _mm_set1_pd ( CIE_gf );
+    bf = _mm_set1_pd ( CIE_bf );
+    efficacy = _mm_set1_pd ( WHTEFFICACY );
+#endif	/* __SSE2__ */
+
+    for ( row = 0; row < RGBf->n_rows; row++ ) {
+	red = RGBf->red->data[row];
+	green = RGBf->green->data[row];
+	blue = RGBf->blue->data[row];
+	out = Y->data[row];
+
+	col = 0;
+#ifdef	__SSE2__
+	for ( ; col + 4 <= RGBf->n_cols; col += 4 ) {
+	    r = _mm_loadu_ps ( red + col );
+	    g = _mm_loadu_ps ( green + col );
+	    b = _mm_loadu_ps ( blue + col );
+	    lo = _mm_cvtpd_ps ( _mm_mul_pd ( efficacy, _mm_add_pd ( _mm_add_pd (
+			    _mm_mul_pd ( rf, _mm_cvtps_pd ( r ) ),
+			    _mm_mul_pd ( gf, _mm_cvtps_pd ( g ) ) ),
+			_mm_mul_pd ( bf, _mm_cvtps_pd ( b ) ) ) ) );
+	    r = _mm_movehl_ps ( r, r );
+	    g = _mm_movehl_ps ( g, g );
+	    b = _mm_movehl_ps ( b, b );
+	    hi = _mm_cvtpd_ps ( _mm_mul_pd ( efficacy, _mm_add_pd ( _mm_add_pd (
+			    _mm_mul_pd ( rf, _mm_cvtps_pd ( r ) ),
+			    _mm_mul_pd ( gf, _mm_cvtps_pd ( g ) ) ),
+			_mm_mul_pd ( bf, _mm_cvtps_pd ( b ) ) ) ) );
+	    _mm_storeu_ps ( out + col, _mm_movelh_ps ( lo, hi ) );
+	}
+#endif	/* __SSE2__ */
+	for ( ; col < RGBf->n_cols; col++ ) {
+	    out[col] = WHTEFFICACY * ( CIE_rf * red[col] + CIE_gf * green[col] +
+		    CIE_bf * blue[col] );
+	}
+    }
+}
+
+void
+DeVAS_RGBf_planar_max ( DeVAS_RGBf_planar_image *RGBf, DeVAS_float_image *max )
+/*
+ * max ( red, green, blue ) for each pixel.
+ */
+{
+    int	    row, col;
+    float   *red, *green, *blue, *out;
+    float   value;
+
+    if ( ( RGBf->n_rows != DeVAS_image_n_rows ( max ) ) ||
+	    ( RGBf->n_cols != DeVAS_image_n_cols ( max ) ) ) {
+	fprintf ( stderr, "DeVAS_RGBf_planar_max: image sizes differ!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    for ( row = 0; row < RGBf->n_rows; row++ ) {
+	red = RGBf->red->data[row];
+	green = RGBf->green->data[row];
+	blue = RGBf->blue->data[row];
+	out = max->data[row];
+
+	col = 0;
+#ifdef	__SSE2__
+	for ( ; col + 4 <= RGBf->n_cols; col += 4 ) {
+	    _mm_storeu_ps ( out + col, _mm_max_ps ( _mm_max_ps (
+			    _mm_loadu_ps ( red + col ),
+			    _mm_loadu_ps ( green + col ) ),
+			_mm_loadu_ps ( blue + col ) ) );
+	}
+#endif	/* __SSE2__ */
+	for ( ; col < RGBf->n_cols; col++ ) {
+	    value = red[col];
+	    if ( green[col] > value ) {
+		value = green[col];
+	    }
+	    if ( blue[col] > value ) {
+		value = blue[col];
+	    }
+	    out[col] = value;
+	}
+    }
+}
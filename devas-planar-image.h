@@ -0,0 +1,83 @@
+/*
+ * Planar (one array per channel) versions of the three channel floating
+ * point DeVAS image types, for channel-at-a-time and SIMD processing.
+ *
+ * Each plane is an ordinary DeVAS_float_image, so all of the DeVAS_float
+ * methods can be applied to an individual channel:
+ *
+ *   DeVAS_RGBf_planar_image	planes red, green, blue
+ *   DeVAS_XYZ_planar_image	planes X, Y, Z
+ *   DeVAS_xyY_planar_image	planes x, y, Y
+ *
+ * Conversions between interleaved and planar images:
+ *
+ *   <type>_planar_image_from_image ( <type>_image * )
+ *   <type>_image_from_planar_image ( <type>_planar_image * )
+ *
+ * Colorimetry on planar images computes the same values as the
+ * corresponding per-pixel functions in devas-image.c (DeVAS_RGBf2XYZ,
+ * DeVAS_XYZ2RGBf, DeVAS_XYZ2xyY, DeVAS_xyY2XYZ, DeVAS_RGBf2Y), four or two
+ * pixels at a time where SSE2 is available.
+ */
+
+#ifndef __DeVAS_PLANAR_IMAGE_H
+#define __DeVAS_PLANAR_IMAGE_H
+
+#include "devas-image.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+/* Note that order is (n_rows,n_cols), not (x,y) or (width,height)!!! */
+#define DeVAS_DEFINE_PLANAR_IMAGE_TYPE( TYPE, C0, C1, C2 )		\
+typedef struct {							\
+    int		    n_rows, n_cols;	/* order reversed from x,y! */	\
+    int		    exposure_set;	/* as in TYPE##_image */	\
+    double	    exposure;						\
+    DeVAS_Image_Info image_info;					\
+    DeVAS_float_image *C0;		/* one image per channel */	\
+    DeVAS_float_image *C1;						\
+    DeVAS_float_image *C2;						\
+} TYPE##_planar_image;
+
+DeVAS_DEFINE_PLANAR_IMAGE_TYPE ( DeVAS_RGBf, red, green, blue )
+DeVAS_DEFINE_PLANAR_IMAGE_TYPE ( DeVAS_XYZ, X, Y, Z )
+DeVAS_DEFINE_PLANAR_IMAGE_TYPE ( DeVAS_xyY, x, y, Y )
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DeVAS_PROTOTYPE_PLANAR_IMAGE( TYPE )				\
+TYPE##_planar_image *TYPE##_planar_image_new ( unsigned int n_rows,	\
+			unsigned int n_cols );				\
+void		    TYPE##_planar_image_delete ( TYPE##_planar_image *image ); \
+TYPE##_planar_image *TYPE##_planar_image_from_image ( TYPE##_image *image ); \
+TYPE##_image	    *TYPE##_image_from_planar_image (			\
+			TYPE##_planar_image *planar_image );
+
+DeVAS_PROTOTYPE_PLANAR_IMAGE ( DeVAS_RGBf )
+DeVAS_PROTOTYPE_PLANAR_IMAGE ( DeVAS_XYZ )
+DeVAS_PROTOTYPE_PLANAR_IMAGE ( DeVAS_xyY )
+
+void	DeVAS_deinterleave3 ( const float *src, float *c0, float *c1,
+	    float *c2, int n );
+void	DeVAS_interleave3 ( const float *c0, const float *c1, const float *c2,
+	    float *dst, int n );
+
+void	DeVAS_RGBf_planar_to_XYZ_planar ( DeVAS_RGBf_planar_image *RGBf,
+	    DeVAS_XYZ_planar_image *XYZ );
+void	DeVAS_XYZ_planar_to_RGBf_planar ( DeVAS_XYZ_planar_image *XYZ,
+	    DeVAS_RGBf_planar_image *RGBf );
+void	DeVAS_XYZ_planar_to_xyY_planar ( DeVAS_XYZ_planar_image *XYZ,
+	    DeVAS_xyY_planar_image *xyY );
+void	DeVAS_xyY_planar_to_XYZ_planar ( DeVAS_xyY_planar_image *xyY,
+	    DeVAS_XYZ_planar_image *XYZ );
+void	DeVAS_RGBf_planar_to_Y ( DeVAS_RGBf_planar_image *RGBf,
+	    DeVAS_float_image *Y );
+void	DeVAS_RGBf_planar_max ( DeVAS_RGBf_planar_image *RGBf,
+	    DeVAS_float_image *max );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __DeVAS_PLANAR_IMAGE_H */
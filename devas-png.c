@@ -151,7 +151,8 @@ DeVAS_RGB_image_to_file_png ( FILE *output, DeVAS_RGB_image *image )
     png_output.message[0] = '\0';
 
     if ( png_image_write_to_stdio ( &png_output, output, 0 /*convert_to_8bit*/,
-	    (void *) ( &DeVAS_image_data ( image, 0, 0 ) ), 0 /*row_stride*/,
+	    (void *) ( &DeVAS_image_data ( image, 0, 0 ) ),
+	    3 * DeVAS_image_row_stride ( image ) /*row_stride*/,
 	    NULL /*colormap*/) == 0 ) {
 	fprintf ( stderr,
 		"DeVAS_RGB_image_to_file_png: error writing file!\n" );
@@ -193,6 +194,198 @@ DeVAS_gray_image_to_file_png ( FILE *output, DeVAS_gray_image *image )
     png_output.message[0] = '\0';
 
     png_image_write_to_stdio ( &png_output, output, 0 /*convert_to_8bit*/,
-	    (void *) ( &DeVAS_image_data ( image, 0, 0 ) ), 0 /*row_stride*/,
+	    (void *) ( &DeVAS_image_data ( image, 0, 0 ) ),
+	    DeVAS_image_row_stride ( image ) /*row_stride*/,
 	    NULL /*colormap*/ );
 }
+
+/*
+ * Row-at-a-time PNG writing, so that callers producing output in bands
+ * never need the whole 8-bit image in memory.  Uses the libpng
+ * row-oriented API, set up to match the output of the simplified API
+ * used by DeVAS_RGB_image_to_file_png.
+ */
+
+struct DeVAS_PNG_writer {
+    png_structp	    png_ptr;
+    png_infop	    info_ptr;
+    unsigned int    n_rows;
+    unsigned int    row;	/* next row to be written */
+};
+
+DeVAS_PNG_writer *
+DeVAS_RGB_open_write_png ( FILE *output, unsigned int n_rows,
+	unsigned int n_cols )
+/*
+ * Writes the PNG header.  n_rows scanlines must then be written with
+ * DeVAS_RGB_write_png before calling DeVAS_RGB_close_write_png.
+ */
+{
+    return ( DeVAS_RGB_open_write_png_profile ( output, n_rows, n_cols,
+		NULL, 0, NULL ) );
+}
+
+DeVAS_PNG_writer *
+DeVAS_RGB_open_write_png_profile ( FILE *output, unsigned int n_rows,
+	unsigned int n_cols, const unsigned char *profile,
+	unsigned int profile_length, char *profile_name )
+/*
+ * As DeVAS_RGB_open_write_png, but with an iCCP chunk holding the given
+ * ICC profile instead of an sRGB chunk, unless profile is NULL.
+ */
+{
+    DeVAS_PNG_writer	*writer;
+
+    writer = (DeVAS_PNG_writer *) malloc ( sizeof ( DeVAS_PNG_writer ) );
+    if ( writer == NULL ) {
+	fprintf ( stderr, "DeVAS_RGB_open_write_png: malloc failed!\n" );
+	exit ( EXIT_FAILURE );
+    }
+    writer->n_rows = n_rows;
+    writer->row = 0;
+
+    writer->png_ptr = png_create_write_struct ( PNG_LIBPNG_VER_STRING,
+	    NULL, NULL, NULL );
+    if ( writer->png_ptr == NULL ) {
+	fprintf ( stderr, "DeVAS_RGB_open_write_png: libpng init failed!\n" );
+	exit ( EXIT_FAILURE );
+    }
+    writer->info_ptr = png_create_info_struct ( writer->png_ptr );
+    if ( writer->info_ptr == NULL ) {
+	fprintf ( stderr, "DeVAS_RGB_open_write_png: libpng init failed!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    if ( setjmp ( png_jmpbuf ( writer->png_ptr ) ) ) {
+	fprintf ( stderr,
+		"DeVAS_RGB_open_write_png: error writing file!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    png_init_io ( writer->png_ptr, output );
+    png_set_IHDR ( writer->png_ptr, writer->info_ptr, n_cols, n_rows, 8,
+	    PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE,
+	    PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE );
+    if ( profile != NULL ) {
+	png_set_iCCP ( writer->png_ptr, writer->info_ptr, profile_name,
+		PNG_COMPRESSION_TYPE_BASE, (png_const_bytep) profile,
+		profile_length );
+    } else {
+	png_set_sRGB ( writer->png_ptr, writer->info_ptr,
+		PNG_sRGB_INTENT_PERCEPTUAL );
+    }
+    png_write_info ( writer->png_ptr, writer->info_ptr );
+
+    return ( writer );
+}
+
+DeVAS_PNG_writer *
+DeVAS_RGB16_open_write_png ( FILE *output, unsigned int n_rows,
+	unsigned int n_cols, int cicp_primaries, int cicp_transfer )
+/*
+ * As DeVAS_RGB_open_write_png, but for 16 bit/color rows written with
+ * DeVAS_RGB16_write_png, and with a cICP chunk (ITU-T H.273 code points,
+ * full range RGB) in place of the sRGB chunk.  libpng doesn't know cICP,
+ * so it goes out as an unknown chunk before the image data.
+ */
+{
+    DeVAS_PNG_writer	*writer;
+    png_unknown_chunk	cicp;
+    png_byte		cicp_data[4];
+    uint16_t		byte_order = 1;
+
+    writer = (DeVAS_PNG_writer *) malloc ( sizeof ( DeVAS_PNG_writer ) );
+    if ( writer == NULL ) {
+	fprintf ( stderr, "DeVAS_RGB16_open_write_png: malloc failed!\n" );
+	exit ( EXIT_FAILURE );
+    }
+    writer->n_rows = n_rows;
+    writer->row = 0;
+
+    writer->png_ptr = png_create_write_struct ( PNG_LIBPNG_VER_STRING,
+	    NULL, NULL, NULL );
+    if ( writer->png_ptr == NULL ) {
+	fprintf ( stderr, "DeVAS_RGB16_open_write_png: libpng init failed!\n" );
+	exit ( EXIT_FAILURE );
+    }
+    writer->info_ptr = png_create_info_struct ( writer->png_ptr );
+    if ( writer->info_ptr == NULL ) {
+	fprintf ( stderr, "DeVAS_RGB16_open_write_png: libpng init failed!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    if ( setjmp ( png_jmpbuf ( writer->png_ptr ) ) ) {
+	fprintf ( stderr,
+		"DeVAS_RGB16_open_write_png: error writing file!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    png_init_io ( writer->png_ptr, output );
+    png_set_IHDR ( writer->png_ptr, writer->info_ptr, n_cols, n_rows, 16,
+	    PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE,
+	    PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE );
+
+    cicp_data[0] = cicp_primaries;
+    cicp_data[1] = cicp_transfer;
+    cicp_data[2] = 0;		/* RGB, no matrix */
+    cicp_data[3] = 1;		/* full range */
+    memcpy ( cicp.name, "cICP", 5 );
+    cicp.data = cicp_data;
+    cicp.size = sizeof ( cicp_data );
+    cicp.location = PNG_HAVE_IHDR;
+    png_set_keep_unknown_chunks ( writer->png_ptr, PNG_HANDLE_CHUNK_ALWAYS,
+	    (png_const_bytep) "cICP", 1 );
+    png_set_unknown_chunks ( writer->png_ptr, writer->info_ptr, &cicp, 1 );
+
+    png_write_info ( writer->png_ptr, writer->info_ptr );
+
+    /* PNG is big-endian */
+    if ( *(unsigned char *) &byte_order == 1 ) {
+	png_set_swap ( writer->png_ptr );
+    }
+
+    return ( writer );
+}
+
+void
+DeVAS_RGB16_write_png ( DeVAS_PNG_writer *writer, uint16_t *row )
+/*
+ * 3 * n_cols values.
+ */
+{
+    DeVAS_RGB_write_png ( writer, (DeVAS_RGB *) row );
+}
+
+void
+DeVAS_RGB_write_png ( DeVAS_PNG_writer *writer, DeVAS_RGB *row )
+{
+    if ( writer->row >= writer->n_rows ) {
+	fprintf ( stderr, "DeVAS_RGB_write_png: too many scanlines!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    if ( setjmp ( png_jmpbuf ( writer->png_ptr ) ) ) {
+	fprintf ( stderr, "DeVAS_RGB_write_png: error writing file!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    png_write_row ( writer->png_ptr, (png_const_bytep) row );
+    writer->row++;
+}
+
+void
+DeVAS_RGB_close_write_png ( DeVAS_PNG_writer *writer )
+/*
+ * The output file is flushed but not closed.
+ */
+{
+    if ( setjmp ( png_jmpbuf ( writer->png_ptr ) ) ) {
+	fprintf ( stderr, "DeVAS_RGB_close_write_png: error writing file!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    png_write_end ( writer->png_ptr, writer->info_ptr );
+    png_destroy_write_struct ( &writer->png_ptr, &writer->info_ptr );
+
+    free ( writer );
+}
@@ -7,8 +7,11 @@
 #ifndef __DeVAS_PNG_H
 #define __DeVAS_PNG_H
 
+#include <stdint.h>
 #include "devas-image.h"
 
+typedef struct DeVAS_PNG_writer DeVAS_PNG_writer;	/* opaque */
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -24,6 +27,21 @@ void		DeVAS_RGB_image_to_filename_png ( char *filename,
 void		DeVAS_RGB_image_to_file_png ( FILE *output,
 		    DeVAS_RGB_image *image );
 
+DeVAS_PNG_writer	*DeVAS_RGB_open_write_png ( FILE *output,
+			    unsigned int n_rows, unsigned int n_cols );
+DeVAS_PNG_writer	*DeVAS_RGB_open_write_png_profile ( FILE *output,
+			    unsigned int n_rows, unsigned int n_cols,
+			    const unsigned char *profile,
+			    unsigned int profile_length, char *profile_name );
+DeVAS_PNG_writer	*DeVAS_RGB16_open_write_png ( FILE *output,
+			    unsigned int n_rows, unsigned int n_cols,
+			    int cicp_primaries, int cicp_transfer );
+void			DeVAS_RGB16_write_png ( DeVAS_PNG_writer *writer,
+			    uint16_t *row );
+void			DeVAS_RGB_write_png ( DeVAS_PNG_writer *writer,
+			    DeVAS_RGB *row );
+void			DeVAS_RGB_close_write_png ( DeVAS_PNG_writer *writer );
+
 void		DeVAS_gray_image_to_filename_png ( char *filename,
 		    DeVAS_gray_image *image );
 void		DeVAS_gray_image_to_file_png ( FILE *output,
@@ -0,0 +1,648 @@
+/*
+ * Gaussian and Laplacian image pyramids.  See devas-pyramid.h.
+ *
+ * The kernel is separable.  Reduce sums five source rows with weights
+ * 1 4 6 4 1 into a row buffer, then sums five pixels of that buffer for
+ * every other column, scaling by 1/256 once at the end.  Expand
+ * interpolates a coarse row buffer from three (even rows) or two (odd
+ * rows) coarse rows, then interpolates the fine row from it the same way.
+ * The row buffers have the reflected pixels past each edge appended, so
+ * the horizontal loops need no bounds checks.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef	__SSE2__
+#include <emmintrin.h>
+#endif	/* __SSE2__ */
+#include "devas-pyramid.h"
+#include "devas-parallel.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+#ifndef TRUE
+#define	TRUE		1
+#endif
+#ifndef FALSE
+#define	FALSE		0
+#endif
+
+typedef struct {		/* shared by the bands of one pass */
+    float		    **src_rows;
+    int			    src_n_rows, src_n_cols;
+    float		    **dst_rows;
+    int			    dst_n_rows, dst_n_cols;
+    int			    channels;
+    DeVAS_Pyramid_Expand    mode;
+} DeVAS_Pyramid_Work;
+
+static void	*DeVAS_pyramid_malloc ( size_t size );
+
+static int
+DeVAS_pyramid_reflect ( int i, int n )
+/*
+ * Index i of n samples, reflected about the first and last samples.
+ */
+{
+    if ( i < 0 ) {
+	i = -i;
+    }
+    if ( i >= n ) {
+	i = ( 2 * ( n - 1 ) ) - i;
+    }
+
+    return ( ( i < 0 ) ? 0 : i );
+}
+
+static int
+DeVAS_pyramid_coarse_index ( int k, int n_coarse, int n_fine )
+/*
+ * Coarse sample k, reflected about the first and last samples of the
+ * fine level (coarse sample k is at fine sample 2k).  Past the end, the
+ * fine level mirrors about sample n_fine - 1, which is a coarse sample
+ * when n_fine is odd and half way between two when it is even.
+ */
+{
+    if ( k < 0 ) {
+	k = -k;
+    } else if ( k >= n_coarse ) {
+	k = ( ( n_fine % 2 ) == 0 ) ? ( ( 2 * n_coarse ) - 1 - k ) :
+	    ( ( 2 * n_coarse ) - 2 - k );
+    }
+
+    if ( k < 0 ) {
+	return ( 0 );
+    } else if ( k >= n_coarse ) {
+	return ( n_coarse - 1 );
+    }
+    return ( k );
+}
+
+static void
+DeVAS_pyramid_sum5 ( float *dst, const float *s0, const float *s1,
+	const float *s2, const float *s3, const float *s4, int n )
+/*
+ * dst[i] = ( s0[i] + s4[i] ) + 4 ( s1[i] + s3[i] ) + 6 s2[i]
+ */
+{
+    int	    i = 0;
+#ifdef	__SSE2__
+    __m128  four, six;
+
+    four = _mm_set1_ps ( 4.0 );
+    six = _mm_set1_ps ( 6.0 );
+    for ( ; i + 4 <= n; i += 4 ) {
+	_mm_storeu_ps ( dst + i, _mm_add_ps ( _mm_add_ps (
+			_mm_add_ps ( _mm_loadu_ps ( s0 + i ),
+			    _mm_loadu_ps ( s4 + i ) ),
+			_mm_mul_ps ( four, _mm_add_ps (
+				_mm_loadu_ps ( s1 + i ),
+				_mm_loadu_ps ( s3 + i ) ) ) ),
+		    _mm_mul_ps ( six, _mm_loadu_ps ( s2 + i ) ) ) );
+    }
+#endif	/* __SSE2__ */
+
+    for ( ; i < n; i++ ) {
+	dst[i] = ( ( s0[i] + s4[i] ) + ( 4.0f * ( s1[i] + s3[i] ) ) ) +
+	    ( 6.0f * s2[i] );
+    }
+}
+
+static void
+DeVAS_pyramid_sum3 ( float *dst, const float *s0, const float *s1,
+	const float *s2, int n )
+/*
+ * dst[i] = ( ( s0[i] + s2[i] ) + 6 s1[i] ) / 8
+ */
+{
+    int	    i = 0;
+#ifdef	__SSE2__
+    __m128  six, eighth;
+
+    six = _mm_set1_ps ( 6.0 );
+    eighth = _mm_set1_ps ( 0.125 );
+    for ( ; i + 4 <= n; i += 4 ) {
+	_mm_storeu_ps ( dst + i, _mm_mul_ps ( eighth, _mm_add_ps (
+			_mm_add_ps ( _mm_loadu_ps ( s0 + i ),
+			    _mm_loadu_ps ( s2 + i ) ),
+			_mm_mul_ps ( six, _mm_loadu_ps ( s1 + i ) ) ) ) );
+    }
+#endif	/* __SSE2__ */
+
+    for ( ; i < n; i++ ) {
+	dst[i] = 0.125f * ( ( s0[i] + s2[i] ) + ( 6.0f * s1[i] ) );
+    }
+}
+
+static void
+DeVAS_pyramid_sum2 ( float *dst, const float *s0, const float *s1, int n )
+/*
+ * dst[i] = ( s0[i] + s1[i] ) / 2
+ */
+{
+    int	    i = 0;
+#ifdef	__SSE2__
+    __m128  half;
+
+    half = _mm_set1_ps ( 0.5 );
+    for ( ; i + 4 <= n; i += 4 ) {
+	_mm_storeu_ps ( dst + i, _mm_mul_ps ( half, _mm_add_ps (
+			_mm_loadu_ps ( s0 + i ), _mm_loadu_ps ( s1 + i ) ) ) );
+    }
+#endif	/* __SSE2__ */
+
+    for ( ; i < n; i++ ) {
+	dst[i] = 0.5f * ( s0[i] + s1[i] );
+    }
+}
+
+static void
+DeVAS_pyramid_combine ( float *dst, const float *src, int n,
+	DeVAS_Pyramid_Expand mode )
+/*
+ * dst[i] = src[i], dst[i] += src[i], or dst[i] -= src[i]
+ */
+{
+    int	    i = 0;
+
+    if ( mode == DeVAS_expand_set ) {
+	memcpy ( dst, src, n * sizeof ( float ) );
+	return;
+    }
+
+#ifdef	__SSE2__
+    if ( mode == DeVAS_expand_add ) {
+	for ( ; i + 4 <= n; i += 4 ) {
+	    _mm_storeu_ps ( dst + i, _mm_add_ps ( _mm_loadu_ps ( dst + i ),
+			_mm_loadu_ps ( src + i ) ) );
+	}
+    } else {
+	for ( ; i + 4 <= n; i += 4 ) {
+	    _mm_storeu_ps ( dst + i, _mm_sub_ps ( _mm_loadu_ps ( dst + i ),
+			_mm_loadu_ps ( src + i ) ) );
+	}
+    }
+#endif	/* __SSE2__ */
+
+    if ( mode == DeVAS_expand_add ) {
+	for ( ; i < n; i++ ) {
+	    dst[i] += src[i];
+	}
+    } else {
+	for ( ; i < n; i++ ) {
+	    dst[i] -= src[i];
+	}
+    }
+}
+
+static void
+DeVAS_pyramid_reduce_band ( void *context, int band, int first_row,
+	int n_band_rows )
+{
+    DeVAS_Pyramid_Work	*work;
+    float		**src;
+    float		*buffer;	/* 2 pixels, src_n_cols, 2 pixels */
+    float		*vertical;
+    const float		*p;
+    float		*dst;
+    int			channels, n_rows, n_cols;
+    int			row, col, channel, pad;
+
+    (void) band;		/* bands are identified by their rows */
+
+    work = (DeVAS_Pyramid_Work *) context;
+    src = work->src_rows;
+    channels = work->channels;
+    n_rows = work->src_n_rows;
+    n_cols = work->src_n_cols;
+
+    buffer = (float *) DeVAS_pyramid_malloc ( ( (size_t) n_cols + 4 ) *
+	    channels * sizeof ( float ) );
+    vertical = buffer + ( 2 * channels );
+
+    for ( row = first_row; row < first_row + n_band_rows; row++ ) {
+	DeVAS_pyramid_sum5 ( vertical,
+		src[DeVAS_pyramid_reflect ( ( 2 * row ) - 2, n_rows )],
+		src[DeVAS_pyramid_reflect ( ( 2 * row ) - 1, n_rows )],
+		src[DeVAS_pyramid_reflect ( 2 * row, n_rows )],
+		src[DeVAS_pyramid_reflect ( ( 2 * row ) + 1, n_rows )],
+		src[DeVAS_pyramid_reflect ( ( 2 * row ) + 2, n_rows )],
+		n_cols * channels );
+
+	for ( pad = 1; pad <= 2; pad++ ) {
+	    for ( channel = 0; channel < channels; channel++ ) {
+		vertical[( -pad * channels ) + channel] =
+		    vertical[( DeVAS_pyramid_reflect ( -pad, n_cols ) *
+			    channels ) + channel];
+		vertical[( ( n_cols - 1 + pad ) * channels ) + channel] =
+		    vertical[( DeVAS_pyramid_reflect ( n_cols - 1 + pad,
+				n_cols ) * channels ) + channel];
+	    }
+	}
+
+	dst = work->dst_rows[row];
+	if ( channels == 1 ) {
+	    for ( col = 0; col < work->dst_n_cols; col++ ) {
+		p = buffer + ( 2 * col );
+		dst[col] = ( 1.0f / 256.0f ) * ( ( ( p[0] + p[4] ) +
+			    ( 4.0f * ( p[1] + p[3] ) ) ) + ( 6.0f * p[2] ) );
+	    }
+	} else {
+	    for ( col = 0; col < work->dst_n_cols; col++ ) {
+		for ( channel = 0; channel < channels; channel++ ) {
+		    p = buffer + ( 2 * col * channels ) + channel;
+		    dst[( col * channels ) + channel] = ( 1.0f / 256.0f ) *
+			( ( ( p[0] + p[4 * channels] ) +
+			    ( 4.0f * ( p[channels] + p[3 * channels] ) ) ) +
+			  ( 6.0f * p[2 * channels] ) );
+		}
+	    }
+	}
+    }
+
+    free ( buffer );
+}
+
+static void
+DeVAS_pyramid_expand_band ( void *context, int band, int first_row,
+	int n_band_rows )
+{
+    DeVAS_Pyramid_Work	*work;
+    float		**src;
+    float		*buffer;	/* 1 pixel, src_n_cols, 1 pixel */
+    float		*vertical;
+    float		*expanded;	/* 2 * src_n_cols */
+    const float		*p;
+    int			channels, n_coarse, n_fine;
+    int			row, k, channel;
+
+    (void) band;		/* bands are identified by their rows */
+
+    work = (DeVAS_Pyramid_Work *) context;
+    src = work->src_rows;
+    channels = work->channels;
+    n_coarse = work->src_n_cols;
+    n_fine = work->dst_n_cols;
+
+    buffer = (float *) DeVAS_pyramid_malloc ( ( (size_t) n_coarse + 2 ) *
+	    channels * sizeof ( float ) );
+    vertical = buffer + channels;
+    expanded = (float *) DeVAS_pyramid_malloc ( ( (size_t) 2 * n_coarse ) *
+	    channels * sizeof ( float ) );
+
+    for ( row = first_row; row < first_row + n_band_rows; row++ ) {
+	k = row / 2;
+	if ( ( row % 2 ) == 0 ) {
+	    DeVAS_pyramid_sum3 ( vertical,
+		    src[DeVAS_pyramid_coarse_index ( k - 1, work->src_n_rows,
+			work->dst_n_rows )],
+		    src[k],
+		    src[DeVAS_pyramid_coarse_index ( k + 1, work->src_n_rows,
+			work->dst_n_rows )],
+		    n_coarse * channels );
+	} else {
+	    DeVAS_pyramid_sum2 ( vertical, src[k],
+		    src[DeVAS_pyramid_coarse_index ( k + 1, work->src_n_rows,
+			work->dst_n_rows )],
+		    n_coarse * channels );
+	}
+
+	for ( channel = 0; channel < channels; channel++ ) {
+	    vertical[-channels + channel] =
+		vertical[( DeVAS_pyramid_coarse_index ( -1, n_coarse,
+			    n_fine ) * channels ) + channel];
+	    vertical[( n_coarse * channels ) + channel] =
+		vertical[( DeVAS_pyramid_coarse_index ( n_coarse, n_coarse,
+			    n_fine ) * channels ) + channel];
+	}
+
+	/*
+	 * Fine columns 2k and 2k + 1 from coarse k - 1, k, and k + 1, which
+	 * are p[0], p[channels], and p[2 * channels].  An odd n_fine has no
+	 * last odd column, but the buffer has room for it.
+	 */
+	for ( k = 0; k < n_coarse; k++ ) {
+	    p = buffer + ( k * channels );
+	    for ( channel = 0; channel < channels; channel++ ) {
+		expanded[( 2 * k * channels ) + channel] = 0.125f *
+		    ( ( p[channel] + p[( 2 * channels ) + channel] ) +
+		      ( 6.0f * p[channels + channel] ) );
+		expanded[( ( ( 2 * k ) + 1 ) * channels ) + channel] = 0.5f *
+		    ( p[channels + channel] + p[( 2 * channels ) + channel] );
+	    }
+	}
+
+	DeVAS_pyramid_combine ( work->dst_rows[row], expanded,
+		n_fine * channels, work->mode );
+    }
+
+    free ( buffer );
+    free ( expanded );
+}
+
+int
+DeVAS_pyramid_max_levels ( int n_rows, int n_cols )
+{
+    int	    n_levels;
+
+    n_levels = 1;
+    while ( ( n_rows > 1 ) || ( n_cols > 1 ) ) {
+	n_rows = ( n_rows + 1 ) / 2;
+	n_cols = ( n_cols + 1 ) / 2;
+	n_levels++;
+    }
+
+    return ( n_levels );
+}
+
+void
+DeVAS_pyramid_reduce_rows ( float **src_rows, int src_n_rows, int src_n_cols,
+	float **dst_rows, int channels )
+/*
+ * dst_rows has ( src_n_rows + 1 ) / 2 rows of ( src_n_cols + 1 ) / 2
+ * pixels.
+ */
+{
+    DeVAS_Pyramid_Work	work;
+
+    work.src_rows = src_rows;
+    work.src_n_rows = src_n_rows;
+    work.src_n_cols = src_n_cols;
+    work.dst_rows = dst_rows;
+    work.dst_n_rows = ( src_n_rows + 1 ) / 2;
+    work.dst_n_cols = ( src_n_cols + 1 ) / 2;
+    work.channels = channels;
+    work.mode = DeVAS_expand_set;
+
+    DeVAS_parallel_bands ( work.dst_n_rows, DeVAS_parallel_band_rows (
+		src_n_cols ), DeVAS_pyramid_reduce_band, (void *) &work );
+}
+
+void
+DeVAS_pyramid_expand_rows ( float **src_rows, int src_n_rows, int src_n_cols,
+	float **dst_rows, int dst_n_rows, int dst_n_cols, int channels,
+	DeVAS_Pyramid_Expand mode )
+/*
+ * src_rows must be the reduced size of dst_rows.  Each band writes only
+ * its own dst rows, so dst can be updated in place.
+ */
+{
+    DeVAS_Pyramid_Work	work;
+
+    if ( ( src_n_rows != ( dst_n_rows + 1 ) / 2 ) ||
+	    ( src_n_cols != ( dst_n_cols + 1 ) / 2 ) ) {
+	fprintf ( stderr, "DeVAS_pyramid_expand_rows: size mismatch!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    work.src_rows = src_rows;
+    work.src_n_rows = src_n_rows;
+    work.src_n_cols = src_n_cols;
+    work.dst_rows = dst_rows;
+    work.dst_n_rows = dst_n_rows;
+    work.dst_n_cols = dst_n_cols;
+    work.channels = channels;
+    work.mode = mode;
+
+    DeVAS_parallel_bands ( dst_n_rows, DeVAS_parallel_band_rows (
+		dst_n_cols ), DeVAS_pyramid_expand_band, (void *) &work );
+}
+
+#define DeVAS_PYRAMID( TYPE, CHANNELS )					\
+static TYPE##_image *							\
+TYPE##_pyramid_copy ( TYPE##_image *image )				\
+{									\
+    TYPE##_image    *copy;						\
+    int		    row;						\
+									\
+    copy = TYPE##_image_new ( DeVAS_image_n_rows ( image ),		\
+	    DeVAS_image_n_cols ( image ) );				\
+    DeVAS_image_view ( copy ) = DeVAS_image_view ( image );		\
+    DeVAS_image_exposure_set ( copy ) = DeVAS_image_exposure_set ( image ); \
+    DeVAS_image_exposure ( copy ) = DeVAS_image_exposure ( image );	\
+    if ( DeVAS_image_description ( image ) != NULL ) {			\
+	DeVAS_image_description ( copy ) =				\
+	    strdup ( DeVAS_image_description ( image ) );		\
+	if ( DeVAS_image_description ( copy ) == NULL ) {		\
+	    fprintf ( stderr, #TYPE "_pyramid: strdup failed!\n" );	\
+	    exit ( EXIT_FAILURE );					\
+	}								\
+    }									\
+									\
+    for ( row = 0; row < DeVAS_image_n_rows ( image ); row++ ) {	\
+	memcpy ( copy->data[row], image->data[row],			\
+		DeVAS_image_n_cols ( image ) * sizeof ( TYPE ) );	\
+    }									\
+									\
+    DeVAS_image_modified ( copy );					\
+									\
+    return ( copy );							\
+}									\
+									\
+TYPE##_image *								\
+TYPE##_image_pyramid_reduce ( TYPE##_image *image )			\
+{									\
+    TYPE##_image    *reduced;						\
+									\
+    reduced = TYPE##_image_new ( ( DeVAS_image_n_rows ( image ) + 1 ) / 2, \
+	    ( DeVAS_image_n_cols ( image ) + 1 ) / 2 );			\
+									\
+    DeVAS_pyramid_reduce_rows ( (float **) image->data,		\
+	    DeVAS_image_n_rows ( image ), DeVAS_image_n_cols ( image ),	\
+	    (float **) reduced->data, CHANNELS );			\
+									\
+    DeVAS_image_modified ( reduced );					\
+									\
+    return ( reduced );							\
+}									\
+									\
+TYPE##_image *								\
+TYPE##_image_pyramid_expand ( TYPE##_image *image, int n_rows,		\
+	int n_cols )							\
+{									\
+    TYPE##_image    *expanded;						\
+									\
+    expanded = TYPE##_image_new ( n_rows, n_cols );			\
+									\
+    DeVAS_pyramid_expand_rows ( (float **) image->data,		\
+	    DeVAS_image_n_rows ( image ), DeVAS_image_n_cols ( image ),	\
+	    (float **) expanded->data, n_rows, n_cols, CHANNELS,	\
+	    DeVAS_expand_set );						\
+									\
+    DeVAS_image_modified ( expanded );					\
+									\
+    return ( expanded );						\
+}									\
+									\
+TYPE##_pyramid *							\
+TYPE##_pyramid_new ( int n_rows, int n_cols, int n_levels )		\
+{									\
+    TYPE##_pyramid  *pyramid;						\
+    int		    level;						\
+									\
+    if ( ( n_rows < 1 ) || ( n_cols < 1 ) || ( n_levels < 0 ) ||	\
+	    ( n_levels > DeVAS_pyramid_max_levels ( n_rows, n_cols ) ) ) { \
+	fprintf ( stderr, #TYPE "_pyramid_new: invalid size!\n" );	\
+	exit ( EXIT_FAILURE );						\
+    }									\
+    if ( n_levels == 0 ) {						\
+	n_levels = DeVAS_pyramid_max_levels ( n_rows, n_cols );		\
+    }									\
+									\
+    pyramid = (TYPE##_pyramid *)					\
+	DeVAS_pyramid_malloc ( sizeof ( TYPE##_pyramid ) );		\
+    pyramid->level = (TYPE##_image **)					\
+	DeVAS_pyramid_malloc ( n_levels * sizeof ( TYPE##_image * ) );	\
+    pyramid->n_levels = n_levels;					\
+    pyramid->laplacian = FALSE;						\
+									\
+    for ( level = 0; level < n_levels; level++ ) {			\
+	pyramid->level[level] = TYPE##_image_new ( n_rows, n_cols );	\
+	n_rows = ( n_rows + 1 ) / 2;					\
+	n_cols = ( n_cols + 1 ) / 2;					\
+    }									\
+									\
+    return ( pyramid );							\
+}									\
+									\
+void									\
+TYPE##_pyramid_delete ( TYPE##_pyramid *pyramid )			\
+{									\
+    int	    level;							\
+									\
+    for ( level = 0; level < pyramid->n_levels; level++ ) {		\
+	TYPE##_image_delete ( pyramid->level[level] );			\
+    }									\
+    free ( pyramid->level );						\
+    free ( pyramid );							\
+}									\
+									\
+TYPE##_pyramid *							\
+TYPE##_pyramid_from_image ( TYPE##_image *image, int n_levels )	\
+{									\
+    TYPE##_pyramid  *pyramid;						\
+									\
+    pyramid = TYPE##_pyramid_new ( DeVAS_image_n_rows ( image ),	\
+	    DeVAS_image_n_cols ( image ), n_levels );			\
+									\
+    TYPE##_image_delete ( pyramid->level[0] );				\
+    pyramid->level[0] = TYPE##_pyramid_copy ( image );			\
+									\
+    TYPE##_pyramid_gaussian ( pyramid );				\
+									\
+    return ( pyramid );							\
+}									\
+									\
+void									\
+TYPE##_pyramid_gaussian ( TYPE##_pyramid *pyramid )			\
+{									\
+    int	    level;							\
+									\
+    for ( level = 1; level < pyramid->n_levels; level++ ) {		\
+	DeVAS_pyramid_reduce_rows (					\
+		(float **) pyramid->level[level - 1]->data,		\
+		DeVAS_image_n_rows ( pyramid->level[level - 1] ),	\
+		DeVAS_image_n_cols ( pyramid->level[level - 1] ),	\
+		(float **) pyramid->level[level]->data, CHANNELS );	\
+	DeVAS_image_modified ( pyramid->level[level] );			\
+    }									\
+    pyramid->laplacian = FALSE;						\
+}									\
+									\
+void									\
+TYPE##_pyramid_laplacian ( TYPE##_pyramid *pyramid )			\
+{									\
+    int	    level;							\
+									\
+    if ( pyramid->laplacian ) {						\
+	fprintf ( stderr,						\
+		#TYPE "_pyramid_laplacian: already a Laplacian pyramid!\n" ); \
+	exit ( EXIT_FAILURE );						\
+    }									\
+									\
+    /* level + 1 is still Gaussian when level is converted */		\
+    for ( level = 0; level < pyramid->n_levels - 1; level++ ) {		\
+	DeVAS_pyramid_expand_rows (					\
+		(float **) pyramid->level[level + 1]->data,		\
+		DeVAS_image_n_rows ( pyramid->level[level + 1] ),	\
+		DeVAS_image_n_cols ( pyramid->level[level + 1] ),	\
+		(float **) pyramid->level[level]->data,			\
+		DeVAS_image_n_rows ( pyramid->level[level] ),		\
+		DeVAS_image_n_cols ( pyramid->level[level] ),		\
+		CHANNELS, DeVAS_expand_subtract );			\
+	DeVAS_image_modified ( pyramid->level[level] );			\
+    }									\
+    pyramid->laplacian = TRUE;						\
+}									\
+									\
+void									\
+TYPE##_pyramid_collapse ( TYPE##_pyramid *pyramid )			\
+{									\
+    int	    level;							\
+									\
+    if ( !pyramid->laplacian ) {					\
+	fprintf ( stderr,						\
+		#TYPE "_pyramid_collapse: not a Laplacian pyramid!\n" ); \
+	exit ( EXIT_FAILURE );						\
+    }									\
+									\
+    /* level + 1 is Gaussian again when level is converted */		\
+    for ( level = pyramid->n_levels - 2; level >= 0; level-- ) {	\
+	DeVAS_pyramid_expand_rows (					\
+		(float **) pyramid->level[level + 1]->data,		\
+		DeVAS_image_n_rows ( pyramid->level[level + 1] ),	\
+		DeVAS_image_n_cols ( pyramid->level[level + 1] ),	\
+		(float **) pyramid->level[level]->data,			\
+		DeVAS_image_n_rows ( pyramid->level[level] ),		\
+		DeVAS_image_n_cols ( pyramid->level[level] ),		\
+		CHANNELS, DeVAS_expand_add );				\
+	DeVAS_image_modified ( pyramid->level[level] );			\
+    }									\
+    pyramid->laplacian = FALSE;						\
+}									\
+									\
+TYPE##_image *								\
+TYPE##_pyramid_reconstruct ( TYPE##_pyramid *pyramid )			\
+{									\
+    TYPE##_image    *image;						\
+    TYPE##_image    *finer;						\
+    int		    level;						\
+									\
+    if ( !pyramid->laplacian ) {					\
+	fprintf ( stderr,						\
+		#TYPE "_pyramid_reconstruct: not a Laplacian pyramid!\n" ); \
+	exit ( EXIT_FAILURE );						\
+    }									\
+									\
+    image = TYPE##_pyramid_copy ( pyramid->level[pyramid->n_levels - 1] ); \
+    for ( level = pyramid->n_levels - 2; level >= 0; level-- ) {	\
+	finer = TYPE##_pyramid_copy ( pyramid->level[level] );		\
+	DeVAS_pyramid_expand_rows ( (float **) image->data,		\
+		DeVAS_image_n_rows ( image ), DeVAS_image_n_cols ( image ), \
+		(float **) finer->data, DeVAS_image_n_rows ( finer ),	\
+		DeVAS_image_n_cols ( finer ), CHANNELS, DeVAS_expand_add ); \
+	TYPE##_image_delete ( image );					\
+	image = finer;							\
+    }									\
+									\
+    DeVAS_image_modified ( image );					\
+									\
+    return ( image );							\
+}
+
+DeVAS_PYRAMID ( DeVAS_float, 1 )
+DeVAS_PYRAMID ( DeVAS_RGBf, 3 )
+
+static void *
+DeVAS_pyramid_malloc ( size_t size )
+{
+    void    *block;
+
+    block = malloc ( size );
+    if ( block == NULL ) {
+	fprintf ( stderr, "DeVAS_pyramid: malloc failed!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    return ( block );
+}
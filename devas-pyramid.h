@@ -0,0 +1,118 @@
+/*
+ * Gaussian and Laplacian image pyramids of DeVAS_float and DeVAS_RGBf
+ * images, using the 5 tap binomial kernel [ 1 4 6 4 1 ] / 16 of Burt and
+ * Adelson in each direction.
+ *
+ * Level 0 is full size, and each level is half the size of the one
+ * before, rounded up, down to 1 x 1 if n_levels is 0.  Pixel (row,col) of
+ * a level is centered on pixel (2*row,2*col) of the level before.  Edges
+ * are handled by reflecting the image about its first and last pixels.
+ *
+ *   <type>_image_pyramid_reduce ( <image> )
+ *
+ *	Returns a new image, blurred and subsampled by 2 in each direction,
+ *	for <type> = DeVAS_float and DeVAS_RGBf.
+ *
+ *   <type>_image_pyramid_expand ( <image>, n_rows, n_cols )
+ *
+ *	Returns a new n_rows x n_cols image interpolated from image, which
+ *	must be the reduced size of n_rows x n_cols.
+ *
+ *   <type>_pyramid_new ( n_rows, n_cols, n_levels )
+ *   <type>_pyramid_delete ( <pyramid> )
+ *
+ *	Allocates the levels of a pyramid for an n_rows x n_cols image, or
+ *	frees them.  n_levels of 0 means as many as there are.  The pixels
+ *	are not initialized.
+ *
+ *   <type>_pyramid_from_image ( <image>, n_levels )
+ *
+ *	Returns the Gaussian pyramid of image.  Level 0 is a copy of image
+ *	(with its view, exposure, and description).
+ *
+ *   <type>_pyramid_gaussian ( <pyramid> )
+ *
+ *	Recomputes levels 1 and up from level 0, so a pyramid can be reused
+ *	for a sequence of same size images by writing each into level 0.
+ *
+ *   <type>_pyramid_laplacian ( <pyramid> )
+ *
+ *	Converts a Gaussian pyramid to a Laplacian pyramid in place: each
+ *	level but the last has the expansion of the next level subtracted
+ *	from it.  No other memory is needed.
+ *
+ *   <type>_pyramid_collapse ( <pyramid> )
+ *
+ *	Converts a Laplacian pyramid back to a Gaussian pyramid in place,
+ *	adding back the expansions from the top down.  Level 0 is then the
+ *	original image, to within float rounding.
+ *
+ *   <type>_pyramid_reconstruct ( <pyramid> )
+ *
+ *	Returns a new image collapsed from a Laplacian pyramid, leaving the
+ *	pyramid unchanged.
+ *
+ * Each reduce and expand runs in parallel bands of rows
+ * (devas-parallel.h), vertically first over whole rows (four floats at
+ * a time where SSE2 is available) and then horizontally.  Results do not
+ * depend on the number of threads.
+ */
+
+#ifndef __DeVAS_PYRAMID_H
+#define __DeVAS_PYRAMID_H
+
+#include "devas-image.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+#define DeVAS_DEFINE_PYRAMID_TYPE( TYPE )				\
+typedef struct {							\
+    int		    n_levels;						\
+    int		    laplacian;		/* TRUE after _pyramid_laplacian */ \
+    TYPE##_image    **level;		/* level[0] is full size */	\
+} TYPE##_pyramid;
+
+DeVAS_DEFINE_PYRAMID_TYPE ( DeVAS_float )
+DeVAS_DEFINE_PYRAMID_TYPE ( DeVAS_RGBf )
+
+/* what DeVAS_pyramid_expand_rows does with the expanded values */
+typedef enum {
+    DeVAS_expand_set,
+    DeVAS_expand_add,
+    DeVAS_expand_subtract
+} DeVAS_Pyramid_Expand;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DeVAS_PROTOTYPE_PYRAMID( TYPE )					\
+TYPE##_image	*TYPE##_image_pyramid_reduce ( TYPE##_image *image );	\
+TYPE##_image	*TYPE##_image_pyramid_expand ( TYPE##_image *image,	\
+		    int n_rows, int n_cols );				\
+TYPE##_pyramid	*TYPE##_pyramid_new ( int n_rows, int n_cols, int n_levels ); \
+void		TYPE##_pyramid_delete ( TYPE##_pyramid *pyramid );	\
+TYPE##_pyramid	*TYPE##_pyramid_from_image ( TYPE##_image *image,	\
+		    int n_levels );					\
+void		TYPE##_pyramid_gaussian ( TYPE##_pyramid *pyramid );	\
+void		TYPE##_pyramid_laplacian ( TYPE##_pyramid *pyramid );	\
+void		TYPE##_pyramid_collapse ( TYPE##_pyramid *pyramid );	\
+TYPE##_image	*TYPE##_pyramid_reconstruct ( TYPE##_pyramid *pyramid );
+
+DeVAS_PROTOTYPE_PYRAMID ( DeVAS_float )
+DeVAS_PROTOTYPE_PYRAMID ( DeVAS_RGBf )
+
+/* number of levels down to 1 x 1 */
+int	DeVAS_pyramid_max_levels ( int n_rows, int n_cols );
+
+/* the kernels, on row pointers to channels floats per pixel */
+void	DeVAS_pyramid_reduce_rows ( float **src_rows, int src_n_rows,
+	    int src_n_cols, float **dst_rows, int channels );
+void	DeVAS_pyramid_expand_rows ( float **src_rows, int src_n_rows,
+	    int src_n_cols, float **dst_rows, int dst_n_rows, int dst_n_cols,
+	    int channels, DeVAS_Pyramid_Expand mode );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __DeVAS_PYRAMID_H */
@@ -0,0 +1,521 @@
+/*
+ * Separable image resizing.  See devas-resample.h.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#ifdef	__SSE2__
+#include <emmintrin.h>
+#endif	/* __SSE2__ */
+#include "devas-resample.h"
+#include "devas-parallel.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+#ifndef M_PI
+#define	M_PI		3.14159265358979323846
+#endif
+
+#ifndef TRUE
+#define	TRUE		1
+#endif
+#ifndef FALSE
+#define	FALSE		0
+#endif
+
+typedef struct {		/* shared by the bands of both passes */
+    void		    **src_rows;
+    int			    src_n_cols;
+    DeVAS_Resample_Load	    load;
+    void		    **dst_rows;
+    int			    dst_n_cols;
+    DeVAS_Resample_Store    store;
+    int			    channels;
+    DeVAS_Resample_Weights  *horizontal;
+    DeVAS_Resample_Weights  *vertical;
+    float		    *temp;	/* src_n_rows x dst_n_cols, filtered */
+					/* horizontally */
+} DeVAS_Resample_Work;
+
+static void	*DeVAS_resample_malloc ( size_t size );
+
+static double
+DeVAS_resample_filter_radius ( DeVAS_Resample_Filter filter )
+{
+    switch ( filter ) {
+	case DeVAS_filter_box:
+	    return ( 0.5 );
+
+	case DeVAS_filter_bilinear:
+	    return ( 1.0 );
+
+	case DeVAS_filter_lanczos3:
+	default:
+	    return ( 3.0 );
+    }
+}
+
+static double
+DeVAS_resample_filter_value ( DeVAS_Resample_Filter filter, double x )
+{
+    double  ax;
+
+    ax = fabs ( x );
+
+    switch ( filter ) {
+	case DeVAS_filter_box:
+	    return ( ( ( x >= -0.5 ) && ( x < 0.5 ) ) ? 1.0 : 0.0 );
+
+	case DeVAS_filter_bilinear:
+	    return ( ( ax < 1.0 ) ? 1.0 - ax : 0.0 );
+
+	case DeVAS_filter_lanczos3:
+	default:
+	    if ( ax < 1.0e-8 ) {
+		return ( 1.0 );
+	    } else if ( ax >= 3.0 ) {
+		return ( 0.0 );
+	    }
+	    return ( ( 3.0 * sin ( M_PI * x ) * sin ( M_PI * x / 3.0 ) ) /
+		    ( M_PI * M_PI * x * x ) );
+    }
+}
+
+DeVAS_Resample_Weights *
+DeVAS_resample_weights_new ( int n_in, int n_out,
+	DeVAS_Resample_Filter filter )
+{
+    DeVAS_Resample_Weights  *weights;
+    double		    scale, filter_scale, support;
+    double		    center, sum;
+    double		    *values;
+    int			    out, in, tap;
+    int			    low, high, start;
+
+    if ( ( n_in < 1 ) || ( n_out < 1 ) ) {
+	fprintf ( stderr, "DeVAS_resample_weights_new: invalid size!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    scale = ( (double) n_out ) / n_in;
+    filter_scale = ( scale < 1.0 ) ? scale : 1.0;  /* widen when shrinking */
+    support = DeVAS_resample_filter_radius ( filter ) / filter_scale;
+
+    weights = (DeVAS_Resample_Weights *)
+	DeVAS_resample_malloc ( sizeof ( DeVAS_Resample_Weights ) );
+    weights->n_in = n_in;
+    weights->n_out = n_out;
+    weights->n_taps = (int) ceil ( 2.0 * support ) + 1;
+    if ( weights->n_taps > n_in ) {
+	weights->n_taps = n_in;
+    }
+    weights->first = (int *) DeVAS_resample_malloc ( n_out * sizeof ( int ) );
+    weights->weights = (float *) DeVAS_resample_malloc ( ( (size_t) n_out ) *
+	    weights->n_taps * sizeof ( float ) );
+    values = (double *) DeVAS_resample_malloc ( n_in * sizeof ( double ) );
+
+    for ( out = 0; out < n_out; out++ ) {
+	/* pixel centers line up: out + 0.5 maps to in + 0.5 */
+	center = ( ( out + 0.5 ) / scale ) - 0.5;
+	low = (int) ceil ( center - support );
+	high = (int) floor ( center + support );
+	if ( low < 0 ) {
+	    low = 0;
+	}
+	if ( high > n_in - 1 ) {
+	    high = n_in - 1;
+	}
+
+	sum = 0.0;
+	for ( in = low; in <= high; in++ ) {
+	    values[in] = DeVAS_resample_filter_value ( filter,
+		    ( in - center ) * filter_scale );
+	    sum += values[in];
+	}
+	if ( sum == 0.0 ) {
+	    /* can't happen for these filters, but use the nearest sample */
+	    in = (int) floor ( center + 0.5 );
+	    low = high = ( in < 0 ) ? 0 : ( ( in > n_in - 1 ) ? n_in - 1 : in );
+	    values[low] = sum = 1.0;
+	}
+
+	start = low;
+	if ( start + weights->n_taps > n_in ) {
+	    start = n_in - weights->n_taps;
+	}
+	weights->first[out] = start;
+
+	for ( tap = 0; tap < weights->n_taps; tap++ ) {
+	    in = start + tap;
+	    weights->weights[( ( (size_t) out ) * weights->n_taps ) + tap] =
+		( ( in >= low ) && ( in <= high ) ) ? values[in] / sum : 0.0;
+	}
+    }
+
+    free ( values );
+
+    return ( weights );
+}
+
+void
+DeVAS_resample_weights_delete ( DeVAS_Resample_Weights *weights )
+{
+    free ( weights->first );
+    free ( weights->weights );
+    free ( weights );
+}
+
+static void
+DeVAS_resample_accumulate ( float *sum, const float *src, float weight,
+	int n )
+/*
+ * sum[i] += weight * src[i]
+ */
+{
+    int	    i = 0;
+#ifdef	__SSE2__
+    __m128  w;
+
+    w = _mm_set1_ps ( weight );
+    for ( ; i + 4 <= n; i += 4 ) {
+	_mm_storeu_ps ( sum + i, _mm_add_ps ( _mm_loadu_ps ( sum + i ),
+		    _mm_mul_ps ( w, _mm_loadu_ps ( src + i ) ) ) );
+    }
+#endif	/* __SSE2__ */
+
+    for ( ; i < n; i++ ) {
+	sum[i] += weight * src[i];
+    }
+}
+
+static void
+DeVAS_resample_horizontal_band ( void *context, int band, int first_row,
+	int n_band_rows )
+{
+    DeVAS_Resample_Work	    *work;
+    DeVAS_Resample_Weights  *weights;
+    float		    *values;
+    float		    *dst;
+    const float		    *src;
+    const float		    *w;
+    float		    sum0, sum1, sum2;
+    int			    row, out, tap, channel;
+    int			    channels;
+
+    work = (DeVAS_Resample_Work *) context;
+    weights = work->horizontal;
+    channels = work->channels;
+
+    values = (float *) DeVAS_resample_malloc ( ( (size_t) work->src_n_cols ) *
+	    channels * sizeof ( float ) );
+
+    for ( row = first_row; row < first_row + n_band_rows; row++ ) {
+	( *work->load ) ( work->src_rows[row], values,
+		work->src_n_cols * channels );
+	dst = work->temp + ( ( (size_t) row ) * work->dst_n_cols * channels );
+
+	for ( out = 0; out < work->dst_n_cols; out++ ) {
+	    src = values + ( ( (size_t) weights->first[out] ) * channels );
+	    w = weights->weights + ( ( (size_t) out ) * weights->n_taps );
+
+	    if ( channels == 3 ) {
+		sum0 = sum1 = sum2 = 0.0;
+		for ( tap = 0; tap < weights->n_taps; tap++ ) {
+		    sum0 += w[tap] * src[3 * tap];
+		    sum1 += w[tap] * src[( 3 * tap ) + 1];
+		    sum2 += w[tap] * src[( 3 * tap ) + 2];
+		}
+		dst[3 * out] = sum0;
+		dst[( 3 * out ) + 1] = sum1;
+		dst[( 3 * out ) + 2] = sum2;
+	    } else {
+		for ( channel = 0; channel < channels; channel++ ) {
+		    sum0 = 0.0;
+		    for ( tap = 0; tap < weights->n_taps; tap++ ) {
+			sum0 += w[tap] * src[( channels * tap ) + channel];
+		    }
+		    dst[( channels * out ) + channel] = sum0;
+		}
+	    }
+	}
+    }
+
+    free ( values );
+}
+
+static void
+DeVAS_resample_vertical_band ( void *context, int band, int first_row,
+	int n_band_rows )
+/*
+ * Whole rows of the horizontally filtered image are weighted and summed,
+ * so the inner loop runs along a row.
+ */
+{
+    DeVAS_Resample_Work	    *work;
+    DeVAS_Resample_Weights  *weights;
+    float		    *sum;
+    size_t		    row_length;
+    int			    row, tap;
+    float		    w;
+
+    work = (DeVAS_Resample_Work *) context;
+    weights = work->vertical;
+    row_length = ( (size_t) work->dst_n_cols ) * work->channels;
+
+    sum = (float *) DeVAS_resample_malloc ( row_length * sizeof ( float ) );
+
+    for ( row = first_row; row < first_row + n_band_rows; row++ ) {
+	memset ( sum, 0, row_length * sizeof ( float ) );
+	for ( tap = 0; tap < weights->n_taps; tap++ ) {
+	    w = weights->weights[( ( (size_t) row ) * weights->n_taps ) + tap];
+	    if ( w != 0.0 ) {
+		DeVAS_resample_accumulate ( sum, work->temp + ( ( (size_t)
+				( weights->first[row] + tap ) ) * row_length ),
+			w, row_length );
+	    }
+	}
+	( *work->store ) ( sum, work->dst_rows[row], row_length );
+    }
+
+    free ( sum );
+}
+
+void
+DeVAS_resample_rows ( void **src_rows, int src_n_rows, int src_n_cols,
+	DeVAS_Resample_Load load, void **dst_rows, int dst_n_rows,
+	int dst_n_cols, DeVAS_Resample_Store store, int channels,
+	DeVAS_Resample_Filter filter )
+/*
+ * src_rows and dst_rows are row pointers, as in the data field of an
+ * image.
+ */
+{
+    DeVAS_Resample_Work	work;
+
+    work.src_rows = src_rows;
+    work.src_n_cols = src_n_cols;
+    work.load = load;
+    work.dst_rows = dst_rows;
+    work.dst_n_cols = dst_n_cols;
+    work.store = store;
+    work.channels = channels;
+    work.horizontal = DeVAS_resample_weights_new ( src_n_cols, dst_n_cols,
+	    filter );
+    work.vertical = DeVAS_resample_weights_new ( src_n_rows, dst_n_rows,
+	    filter );
+    work.temp = (float *) DeVAS_resample_malloc ( ( (size_t) src_n_rows ) *
+	    dst_n_cols * channels * sizeof ( float ) );
+
+    DeVAS_parallel_bands ( src_n_rows, DeVAS_parallel_band_rows (
+		dst_n_cols ), DeVAS_resample_horizontal_band, (void *) &work );
+    DeVAS_parallel_bands ( dst_n_rows, DeVAS_parallel_band_rows (
+		dst_n_cols ), DeVAS_resample_vertical_band, (void *) &work );
+
+    free ( work.temp );
+    DeVAS_resample_weights_delete ( work.horizontal );
+    DeVAS_resample_weights_delete ( work.vertical );
+}
+
+void
+DeVAS_resample_load_uint8 ( const void *row, float *values, int n_values )
+{
+    const uint8_t   *src;
+    int		    i;
+
+    src = (const uint8_t *) row;
+    for ( i = 0; i < n_values; i++ ) {
+	values[i] = src[i];
+    }
+}
+
+void
+DeVAS_resample_load_float ( const void *row, float *values, int n_values )
+{
+    memcpy ( values, row, n_values * sizeof ( float ) );
+}
+
+void
+DeVAS_resample_store_uint8 ( const float *values, void *row, int n_values )
+{
+    uint8_t *dst;
+    int	    i;
+
+    dst = (uint8_t *) row;
+    for ( i = 0; i < n_values; i++ ) {
+	dst[i] = ( values[i] <= 0.0 ) ? 0 :
+	    ( ( values[i] >= 255.0 ) ? 255 : (uint8_t) ( values[i] + 0.5 ) );
+    }
+}
+
+void
+DeVAS_resample_store_float ( const float *values, void *row, int n_values )
+{
+    float   *dst;
+    int	    i;
+
+    dst = (float *) row;
+    for ( i = 0; i < n_values; i++ ) {
+	dst[i] = ( values[i] < 0.0 ) ? 0.0 : values[i];
+    }
+}
+
+#define DeVAS_IMAGE_RESAMPLE( TYPE, CHANNELS, LOAD, STORE )		\
+TYPE##_image *								\
+TYPE##_image_resample ( TYPE##_image *image, int n_rows, int n_cols,	\
+	DeVAS_Resample_Filter filter )					\
+{									\
+    TYPE##_image    *resampled;						\
+									\
+    if ( ( n_rows < 1 ) || ( n_cols < 1 ) ) {				\
+	fprintf ( stderr, #TYPE "_image_resample: invalid size!\n" );	\
+	exit ( EXIT_FAILURE );						\
+    }									\
+									\
+    resampled = TYPE##_image_new ( n_rows, n_cols );			\
+    DeVAS_image_view ( resampled ) = DeVAS_image_view ( image );	\
+    DeVAS_image_exposure_set ( resampled ) =				\
+	DeVAS_image_exposure_set ( image );				\
+    DeVAS_image_exposure ( resampled ) = DeVAS_image_exposure ( image );	\
+    if ( DeVAS_image_description ( image ) != NULL ) {			\
+	DeVAS_image_description ( resampled ) =				\
+	    strdup ( DeVAS_image_description ( image ) );		\
+	if ( DeVAS_image_description ( resampled ) == NULL ) {		\
+	    fprintf ( stderr, #TYPE "_image_resample: strdup failed!\n" ); \
+	    exit ( EXIT_FAILURE );					\
+	}								\
+    }									\
+									\
+    DeVAS_resample_rows ( (void **) image->data, image->n_rows,		\
+	    image->n_cols, LOAD, (void **) resampled->data, n_rows, n_cols, \
+	    STORE, CHANNELS, filter );					\
+									\
+    DeVAS_image_modified ( resampled );					\
+									\
+    return ( resampled );						\
+}
+
+DeVAS_IMAGE_RESAMPLE ( DeVAS_gray, 1, DeVAS_resample_load_uint8,
+	DeVAS_resample_store_uint8 )
+DeVAS_IMAGE_RESAMPLE ( DeVAS_float, 1, DeVAS_resample_load_float,
+	DeVAS_resample_store_float )
+DeVAS_IMAGE_RESAMPLE ( DeVAS_RGB, 3, DeVAS_resample_load_uint8,
+	DeVAS_resample_store_uint8 )
+DeVAS_IMAGE_RESAMPLE ( DeVAS_RGBf, 3, DeVAS_resample_load_float,
+	DeVAS_resample_store_float )
+
+int
+DeVAS_resample_filter_lookup ( char *name, DeVAS_Resample_Filter *filter )
+{
+    if ( strcasecmp ( name, "box" ) == 0 ) {
+	*filter = DeVAS_filter_box;
+	return ( TRUE );
+    } else if ( strcasecmp ( name, "bilinear" ) == 0 ) {
+	*filter = DeVAS_filter_bilinear;
+	return ( TRUE );
+    } else if ( strcasecmp ( name, "lanczos3" ) == 0 ) {
+	*filter = DeVAS_filter_lanczos3;
+	return ( TRUE );
+    }
+
+    return ( FALSE );
+}
+
+int
+DeVAS_resample_parse_size ( char *string, int *n_rows, int *n_cols )
+{
+    char    extra;
+
+    if ( sscanf ( string, "%d,%d%c", n_rows, n_cols, &extra ) != 2 ) {
+	return ( FALSE );
+    }
+
+    return ( ( *n_rows >= 0 ) && ( *n_cols >= 0 ) &&
+	    ( ( *n_rows > 0 ) || ( *n_cols > 0 ) ) );
+}
+
+void
+DeVAS_resample_size ( int n_rows, int n_cols, int *new_n_rows,
+	int *new_n_cols )
+{
+    if ( *new_n_rows <= 0 ) {
+	*new_n_rows = (int) floor ( ( ( (double) n_rows ) * *new_n_cols ) /
+		n_cols + 0.5 );
+    } else if ( *new_n_cols <= 0 ) {
+	*new_n_cols = (int) floor ( ( ( (double) n_cols ) * *new_n_rows ) /
+		n_rows + 0.5 );
+    }
+
+    if ( *new_n_rows < 1 ) {
+	*new_n_rows = 1;
+    }
+    if ( *new_n_cols < 1 ) {
+	*new_n_cols = 1;
+    }
+}
+
+int
+DeVAS_resample_size_for_ppd ( VIEW *view, int n_rows, int n_cols,
+	double ppd, int *new_n_rows, int *new_n_cols )
+{
+    double  half_angle;	/* radians */
+    double  center_ppd;
+
+    if ( ( view->horiz <= 0.0 ) || ( ppd <= 0.0 ) ) {
+	return ( FALSE );
+    }
+
+    half_angle = view->horiz * ( M_PI / 360.0 );
+
+    switch ( view->type ) {
+	case VT_PER:
+	    if ( view->horiz >= 180.0 ) {
+		return ( FALSE );
+	    }
+	    center_ppd = ( ( 0.5 * n_cols ) / tan ( half_angle ) ) *
+		( M_PI / 180.0 );
+	    break;
+
+	case VT_HEM:
+	    if ( view->horiz > 180.0 ) {
+		return ( FALSE );
+	    }
+	    center_ppd = ( ( 0.5 * n_cols ) / sin ( half_angle ) ) *
+		( M_PI / 180.0 );
+	    break;
+
+	case VT_ANG:
+	case VT_CYL:
+	    center_ppd = n_cols / view->horiz;
+	    break;
+
+	default:	/* no VIEW, or no angular size */
+	    return ( FALSE );
+    }
+
+    *new_n_cols = (int) floor ( ( n_cols * ppd / center_ppd ) + 0.5 );
+    *new_n_rows = (int) floor ( ( n_rows * ppd / center_ppd ) + 0.5 );
+    if ( *new_n_rows < 1 ) {
+	*new_n_rows = 1;
+    }
+    if ( *new_n_cols < 1 ) {
+	*new_n_cols = 1;
+    }
+
+    return ( TRUE );
+}
+
+static void *
+DeVAS_resample_malloc ( size_t size )
+{
+    void    *block;
+
+    block = malloc ( size );
+    if ( block == NULL ) {
+	fprintf ( stderr, "DeVAS_resample: malloc failed!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    return ( block );
+}
@@ -0,0 +1,126 @@
+/*
+ * Separable image resizing with box, bilinear, or Lanczos-3 filtering.
+ *
+ *   <type>_image_resample ( <image>, n_rows, n_cols, <filter> )
+ *
+ *	Returns a new n_rows x n_cols image resized from image, for <type>
+ *	= DeVAS_gray, DeVAS_float, DeVAS_RGB, and DeVAS_RGBf (and TT_gray,
+ *	TT_float, TT_RGB, TT_RGBf in devas-tt-image.h).  The view,
+ *	exposure, and description are copied: the image covers the same
+ *	field of view at a different resolution.  Rows are filtered first
+ *	and then columns, each in parallel bands of rows (devas-parallel.h),
+ *	in float.  Results are clamped at 0 (Lanczos-3 rings below 0 near
+ *	sharp edges), and 8 bit results are rounded and clamped at 255.
+ *
+ *   DeVAS_resample_weights_new ( n_in, n_out, <filter> )
+ *   DeVAS_resample_weights_delete ( <weights> )
+ *
+ *	The weight table for resizing n_in samples to n_out, computed once
+ *	per axis: n_taps weights for each output sample, applied to the
+ *	input samples starting at first[out].  When shrinking, the filter is
+ *	widened by n_in / n_out so that every input sample contributes.
+ *	At the edges, the weights of taps outside the image are dropped
+ *	and the rest renormalized, and first[] is moved so that all n_taps
+ *	inputs are inside the image (the extra taps have weight 0), so the
+ *	inner loops need no bounds checks.
+ *
+ *   DeVAS_resample_filter_lookup ( <name>, &<filter> )
+ *
+ *	TRUE and sets filter if name is "box", "bilinear", or "lanczos3"
+ *	(case is ignored), otherwise FALSE.
+ *
+ *   DeVAS_resample_parse_size ( <string>, &n_rows, &n_cols )
+ *
+ *	Parses "n_rows,n_cols" (as for --resize).  Either may be 0, to be
+ *	filled in by DeVAS_resample_size.
+ *
+ *   DeVAS_resample_size ( n_rows, n_cols, &new_n_rows, &new_n_cols )
+ *
+ *	Replaces a 0 new_n_rows or new_n_cols with the size that keeps the
+ *	aspect ratio of an n_rows x n_cols image.
+ *
+ *   DeVAS_resample_size_for_ppd ( <view>, n_rows, n_cols, ppd,
+ *	    &new_n_rows, &new_n_cols )
+ *
+ *	The size at which an n_rows x n_cols image with the given VIEW has
+ *	an angular resolution of ppd pixels per degree at its center, with
+ *	the aspect ratio unchanged.  For perspective views (-vtv), the
+ *	resolution at the center is (n_cols / 2) / tan ( horiz / 2 ) pixels
+ *	per radian.  Hemispherical (-vth) views use sin in place of tan, and
+ *	angular fisheye (-vta) and cylindrical (-vtc) views are linear in
+ *	angle.  FALSE if the view has no field of view (no VIEW record, or
+ *	a parallel or other view type).
+ */
+
+#ifndef __DeVAS_RESAMPLE_H
+#define __DeVAS_RESAMPLE_H
+
+#include "devas-image.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+typedef enum {
+    DeVAS_filter_box,
+    DeVAS_filter_bilinear,
+    DeVAS_filter_lanczos3
+} DeVAS_Resample_Filter;
+
+typedef struct {
+    int	    n_in, n_out;
+    int	    n_taps;		/* per output sample */
+    int	    *first;		/* first input sample, per output sample */
+    float   *weights;		/* n_out x n_taps */
+} DeVAS_Resample_Weights;
+
+/* loads a row of n_values channel values as float, or stores one */
+typedef void (*DeVAS_Resample_Load) ( const void *row, float *values,
+	    int n_values );
+typedef void (*DeVAS_Resample_Store) ( const float *values, void *row,
+	    int n_values );
+
+#define DeVAS_PROTOTYPE_IMAGE_RESAMPLE( TYPE )				\
+TYPE##_image	*TYPE##_image_resample ( TYPE##_image *image, int n_rows, \
+		    int n_cols, DeVAS_Resample_Filter filter );
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+DeVAS_PROTOTYPE_IMAGE_RESAMPLE ( DeVAS_gray )
+DeVAS_PROTOTYPE_IMAGE_RESAMPLE ( DeVAS_float )
+DeVAS_PROTOTYPE_IMAGE_RESAMPLE ( DeVAS_RGB )
+DeVAS_PROTOTYPE_IMAGE_RESAMPLE ( DeVAS_RGBf )
+
+DeVAS_Resample_Weights	*DeVAS_resample_weights_new ( int n_in, int n_out,
+			    DeVAS_Resample_Filter filter );
+void			DeVAS_resample_weights_delete (
+			    DeVAS_Resample_Weights *weights );
+
+/* the separable filter on rows of channels values per pixel */
+void	DeVAS_resample_rows ( void **src_rows, int src_n_rows,
+	    int src_n_cols, DeVAS_Resample_Load load, void **dst_rows,
+	    int dst_n_rows, int dst_n_cols, DeVAS_Resample_Store store,
+	    int channels, DeVAS_Resample_Filter filter );
+
+/* load and store for 8 bit and float channel values */
+void	DeVAS_resample_load_uint8 ( const void *row, float *values,
+	    int n_values );
+void	DeVAS_resample_load_float ( const void *row, float *values,
+	    int n_values );
+void	DeVAS_resample_store_uint8 ( const float *values, void *row,
+	    int n_values );
+void	DeVAS_resample_store_float ( const float *values, void *row,
+	    int n_values );
+
+int	DeVAS_resample_filter_lookup ( char *name,
+	    DeVAS_Resample_Filter *filter );
+int	DeVAS_resample_parse_size ( char *string, int *n_rows, int *n_cols );
+void	DeVAS_resample_size ( int n_rows, int n_cols, int *new_n_rows,
+	    int *new_n_cols );
+int	DeVAS_resample_size_for_ppd ( VIEW *view, int n_rows, int n_cols,
+	    double ppd, int *new_n_rows, int *new_n_cols );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __DeVAS_RESAMPLE_H */
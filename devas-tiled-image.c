@@ -0,0 +1,299 @@
+/*
+ * Tiled storage layout for DeVAS images.  See devas-tiled-image.h.
+ *
+ * Pixel storage comes from DeVAS_image_storage_new, so large tiled images
+ * are file-backed under the same rules as ordinary DeVAS images.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "devas-tiled-image.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+static int
+DeVAS_tile_shift ( int tile_size )
+/*
+ * log2 ( tile_size ), exiting if tile_size is not a power of 2.
+ */
+{
+    int	    shift;
+
+    for ( shift = 0; ( 1 << shift ) < tile_size; shift++ )
+	;
+
+    if ( ( tile_size <= 0 ) || ( ( 1 << shift ) != tile_size ) ) {
+	fprintf ( stderr,
+		"DeVAS_tiled_image: tile size (%d) must be a power of 2!\n",
+		tile_size );
+	exit ( EXIT_FAILURE );
+    }
+
+    return ( shift );
+}
+
+static char *
+DeVAS_tiled_copy_description ( char *description )
+{
+    char    *copy;
+
+    if ( description == NULL ) {
+	return ( NULL );
+    }
+
+    copy = strdup ( description );
+    if ( copy == NULL ) {
+	fprintf ( stderr, "DeVAS_tiled_image: malloc failed!" );
+	DeVAS_print_file_lineno ( __FILE__, __LINE__ );
+	exit ( EXIT_FAILURE );
+    }
+
+    return ( copy );
+}
+
+#define	DeVAS_TILED_IMAGE_NEW( TYPE )					\
+TYPE##_tiled_image *							\
+TYPE##_tiled_image_new ( unsigned int n_rows, unsigned int n_cols,	\
+	int tile_size )							\
+/*									\
+ * tile_size <= 0 gives DeVAS_DEFAULT_TILE_SIZE.			\
+ */									\
+{									\
+    TYPE##_tiled_image	*new_image;					\
+    VIEW		nullview = NULLVIEW;				\
+									\
+    if ( tile_size <= 0 ) {						\
+	tile_size = DeVAS_DEFAULT_TILE_SIZE;				\
+    }									\
+									\
+    new_image = (TYPE##_tiled_image *)					\
+	malloc ( sizeof ( TYPE##_tiled_image ) );			\
+    if ( new_image == NULL ) {						\
+	fprintf ( stderr, "DeVAS_tiled_image_new: malloc failed!" );	\
+	DeVAS_print_file_lineno ( __FILE__, __LINE__ );			\
+	exit ( EXIT_FAILURE );						\
+    }									\
+									\
+    new_image->n_rows = n_rows;						\
+    new_image->n_cols = n_cols;						\
+    new_image->tile_size = tile_size;					\
+    new_image->tile_shift = DeVAS_tile_shift ( tile_size );		\
+    new_image->n_tile_rows = ( n_rows + tile_size - 1 ) >>		\
+	new_image->tile_shift;						\
+    new_image->n_tile_cols = ( n_cols + tile_size - 1 ) >>		\
+	new_image->tile_shift;						\
+									\
+    new_image->exposure_set = FALSE;					\
+    new_image->exposure = 1.0;						\
+    new_image->image_info.view = nullview;				\
+    new_image->image_info.description = NULL;				\
+									\
+    new_image->storage = DeVAS_image_storage_new (			\
+	    ( (size_t) new_image->n_tile_rows ) * new_image->n_tile_cols *	\
+	    tile_size * tile_size * sizeof ( TYPE ), DeVAS_STORAGE_MALLOC,	\
+	    #TYPE );							\
+    new_image->start_data = (TYPE *) new_image->storage->block;		\
+									\
+    return ( new_image );						\
+}
+
+DeVAS_TILED_IMAGE_NEW ( DeVAS_gray )
+DeVAS_TILED_IMAGE_NEW ( DeVAS_float )
+DeVAS_TILED_IMAGE_NEW ( DeVAS_double )
+DeVAS_TILED_IMAGE_NEW ( DeVAS_RGB )
+DeVAS_TILED_IMAGE_NEW ( DeVAS_RGBf )
+DeVAS_TILED_IMAGE_NEW ( DeVAS_XYZ )
+DeVAS_TILED_IMAGE_NEW ( DeVAS_xyY )
+DeVAS_TILED_IMAGE_NEW ( DeVAS_complexf )
+
+#define	DeVAS_TILED_IMAGE_DELETE( TYPE )				\
+void									\
+TYPE##_tiled_image_delete ( TYPE##_tiled_image *image )			\
+{									\
+    if ( image == NULL ) {						\
+	fprintf ( stderr,						\
+		"Attempt to delete empty image object (warning)\n" );	\
+	DeVAS_print_file_lineno ( __FILE__, __LINE__ );			\
+	return;								\
+    }									\
+    if ( image->image_info.description != NULL ) {			\
+	free ( image->image_info.description );				\
+    }									\
+    DeVAS_image_storage_release ( image->storage );			\
+    free ( image );							\
+}
+
+DeVAS_TILED_IMAGE_DELETE ( DeVAS_gray )
+DeVAS_TILED_IMAGE_DELETE ( DeVAS_float )
+DeVAS_TILED_IMAGE_DELETE ( DeVAS_double )
+DeVAS_TILED_IMAGE_DELETE ( DeVAS_RGB )
+DeVAS_TILED_IMAGE_DELETE ( DeVAS_RGBf )
+DeVAS_TILED_IMAGE_DELETE ( DeVAS_XYZ )
+DeVAS_TILED_IMAGE_DELETE ( DeVAS_xyY )
+DeVAS_TILED_IMAGE_DELETE ( DeVAS_complexf )
+
+#define	DeVAS_TILED_IMAGE_TILE( TYPE )					\
+TYPE *									\
+TYPE##_tiled_image_tile ( TYPE##_tiled_image *image, DeVAS_Tile *tile )	\
+/*									\
+ * Fill in the geometry of the tile at (tile->tile_row, tile->tile_col)	\
+ * and return a pointer to its upper left pixel.			\
+ */									\
+{									\
+    tile->first_row = tile->tile_row << image->tile_shift;		\
+    tile->first_col = tile->tile_col << image->tile_shift;		\
+    tile->n_rows = image->n_rows - tile->first_row;			\
+    if ( tile->n_rows > image->tile_size ) {				\
+	tile->n_rows = image->tile_size;				\
+    }									\
+    tile->n_cols = image->n_cols - tile->first_col;			\
+    if ( tile->n_cols > image->tile_size ) {				\
+	tile->n_cols = image->tile_size;				\
+    }									\
+    tile->row_stride = image->tile_size;				\
+									\
+    return ( image->start_data +					\
+	    ( ( ( (size_t) tile->tile_row ) * image->n_tile_cols +	\
+		tile->tile_col ) << ( 2 * image->tile_shift ) ) );	\
+}
+
+DeVAS_TILED_IMAGE_TILE ( DeVAS_gray )
+DeVAS_TILED_IMAGE_TILE ( DeVAS_float )
+DeVAS_TILED_IMAGE_TILE ( DeVAS_double )
+DeVAS_TILED_IMAGE_TILE ( DeVAS_RGB )
+DeVAS_TILED_IMAGE_TILE ( DeVAS_RGBf )
+DeVAS_TILED_IMAGE_TILE ( DeVAS_XYZ )
+DeVAS_TILED_IMAGE_TILE ( DeVAS_xyY )
+DeVAS_TILED_IMAGE_TILE ( DeVAS_complexf )
+
+#define	DeVAS_TILED_IMAGE_FROM_IMAGE( TYPE )				\
+TYPE##_tiled_image *							\
+TYPE##_tiled_image_from_image ( TYPE##_image *image, int tile_size )	\
+/*									\
+ * Row-major to tiled.  Works on regions as well as full images.	\
+ */									\
+{									\
+    TYPE##_tiled_image	*tiled_image;					\
+    DeVAS_Tile		tile;						\
+    TYPE		*tile_data;					\
+    int			row;						\
+									\
+    tiled_image = TYPE##_tiled_image_new ( DeVAS_image_n_rows ( image ), \
+	    DeVAS_image_n_cols ( image ), tile_size );			\
+									\
+    tiled_image->exposure_set = DeVAS_image_exposure_set ( image );	\
+    tiled_image->exposure = DeVAS_image_exposure ( image );		\
+    tiled_image->image_info.view = DeVAS_image_view ( image );		\
+    tiled_image->image_info.description =				\
+	DeVAS_tiled_copy_description ( DeVAS_image_description ( image ) ); \
+									\
+    DeVAS_for_each_tile ( tiled_image, tile ) {				\
+	tile_data = TYPE##_tiled_image_tile ( tiled_image, &tile );	\
+	for ( row = 0; row < tile.n_rows; row++ ) {			\
+	    memcpy ( tile_data + ( row * tile.row_stride ),		\
+		    &DeVAS_image_data ( image, tile.first_row + row,	\
+			tile.first_col ),				\
+		    tile.n_cols * sizeof ( TYPE ) );			\
+	}								\
+    }									\
+									\
+    return ( tiled_image );						\
+}
+
+DeVAS_TILED_IMAGE_FROM_IMAGE ( DeVAS_gray )
+DeVAS_TILED_IMAGE_FROM_IMAGE ( DeVAS_float )
+DeVAS_TILED_IMAGE_FROM_IMAGE ( DeVAS_double )
+DeVAS_TILED_IMAGE_FROM_IMAGE ( DeVAS_RGB )
+DeVAS_TILED_IMAGE_FROM_IMAGE ( DeVAS_RGBf )
+DeVAS_TILED_IMAGE_FROM_IMAGE ( DeVAS_XYZ )
+DeVAS_TILED_IMAGE_FROM_IMAGE ( DeVAS_xyY )
+DeVAS_TILED_IMAGE_FROM_IMAGE ( DeVAS_complexf )
+
+#define	DeVAS_IMAGE_FROM_TILED_IMAGE( TYPE )				\
+TYPE##_image *								\
+TYPE##_image_from_tiled_image ( TYPE##_tiled_image *tiled_image )	\
+/*									\
+ * Tiled to row-major.							\
+ */									\
+{									\
+    TYPE##_image	*image;						\
+    DeVAS_Tile		tile;						\
+    TYPE		*tile_data;					\
+    int			row;						\
+									\
+    image = TYPE##_image_new ( tiled_image->n_rows, tiled_image->n_cols ); \
+									\
+    DeVAS_image_exposure_set ( image ) = tiled_image->exposure_set;	\
+    DeVAS_image_exposure ( image ) = tiled_image->exposure;		\
+    DeVAS_image_view ( image ) = tiled_image->image_info.view;		\
+    DeVAS_image_description ( image ) = DeVAS_tiled_copy_description (	\
+	    tiled_image->image_info.description );			\
+									\
+    DeVAS_for_each_tile ( tiled_image, tile ) {				\
+	tile_data = TYPE##_tiled_image_tile ( tiled_image, &tile );	\
+	for ( row = 0; row < tile.n_rows; row++ ) {			\
+	    memcpy ( &DeVAS_image_data ( image, tile.first_row + row,	\
+			tile.first_col ),				\
+		    tile_data + ( row * tile.row_stride ),		\
+		    tile.n_cols * sizeof ( TYPE ) );			\
+	}								\
+    }									\
+									\
+    return ( image );							\
+}
+
+DeVAS_IMAGE_FROM_TILED_IMAGE ( DeVAS_gray )
+DeVAS_IMAGE_FROM_TILED_IMAGE ( DeVAS_float )
+DeVAS_IMAGE_FROM_TILED_IMAGE ( DeVAS_double )
+DeVAS_IMAGE_FROM_TILED_IMAGE ( DeVAS_RGB )
+DeVAS_IMAGE_FROM_TILED_IMAGE ( DeVAS_RGBf )
+DeVAS_IMAGE_FROM_TILED_IMAGE ( DeVAS_XYZ )
+DeVAS_IMAGE_FROM_TILED_IMAGE ( DeVAS_xyY )
+DeVAS_IMAGE_FROM_TILED_IMAGE ( DeVAS_complexf )
+
+#define	DeVAS_TILED_IMAGE_TRANSPOSE( TYPE )				\
+TYPE##_tiled_image *							\
+TYPE##_tiled_image_transpose ( TYPE##_tiled_image *image )		\
+/*									\
+ * Returns a new tiled image with rows and columns exchanged.  Each	\
+ * tile is transposed into the mirror-image tile position, so both the	\
+ * source and destination tile stay in cache.  The VIEW is not		\
+ * transformed.								\
+ */									\
+{									\
+    TYPE##_tiled_image	*transpose;					\
+    DeVAS_Tile		src_tile, dst_tile;				\
+    TYPE		*src_data, *dst_data;				\
+    int			row, col;					\
+									\
+    transpose = TYPE##_tiled_image_new ( image->n_cols, image->n_rows,	\
+	    image->tile_size );						\
+									\
+    transpose->exposure_set = image->exposure_set;			\
+    transpose->exposure = image->exposure;				\
+    transpose->image_info.description = DeVAS_tiled_copy_description (	\
+	    image->image_info.description );				\
+									\
+    DeVAS_for_each_tile ( image, src_tile ) {				\
+	src_data = TYPE##_tiled_image_tile ( image, &src_tile );	\
+	dst_tile.tile_row = src_tile.tile_col;				\
+	dst_tile.tile_col = src_tile.tile_row;				\
+	dst_data = TYPE##_tiled_image_tile ( transpose, &dst_tile );	\
+	for ( row = 0; row < src_tile.n_rows; row++ ) {			\
+	    for ( col = 0; col < src_tile.n_cols; col++ ) {		\
+		dst_data[( col * dst_tile.row_stride ) + row] =		\
+		    src_data[( row * src_tile.row_stride ) + col];	\
+	    }								\
+	}								\
+    }									\
+									\
+    return ( transpose );						\
+}
+
+DeVAS_TILED_IMAGE_TRANSPOSE ( DeVAS_gray )
+DeVAS_TILED_IMAGE_TRANSPOSE ( DeVAS_float )
+DeVAS_TILED_IMAGE_TRANSPOSE ( DeVAS_double )
+DeVAS_TILED_IMAGE_TRANSPOSE ( DeVAS_RGB )
+DeVAS_TILED_IMAGE_TRANSPOSE ( DeVAS_RGBf )
+DeVAS_TILED_IMAGE_TRANSPOSE ( DeVAS_XYZ )
+DeVAS_TILED_IMAGE_TRANSPOSE ( DeVAS_xyY )
+DeVAS_TILED_IMAGE_TRANSPOSE ( DeVAS_complexf )
@@ -0,0 +1,134 @@
+/*
+ * Tiled storage layout for DeVAS images.
+ *
+ * Pixels are stored in square tiles (64 x 64 by default), each tile
+ * contiguous in memory and stored row by row, with the tiles themselves
+ * in row-major order.  Operations that work on 2-D neighborhoods or
+ * columns (transposes, rotations, vertical filters) then touch far fewer
+ * cache lines and pages than with the row-major layout of devas-image.h,
+ * particularly for very wide images.
+ *
+ * Tile sizes must be a power of 2.  Tiles along the bottom and right
+ * edges are padded out to full size; padding pixels are not part of the
+ * image.
+ */
+
+#ifndef __DeVAS_TILED_IMAGE_H
+#define __DeVAS_TILED_IMAGE_H
+
+#include "devas-image.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+#define	DeVAS_DEFAULT_TILE_SIZE		64
+
+typedef struct {		/* one tile of a tiled image */
+    int	    tile_row, tile_col;	/* position in the array of tiles */
+    int	    first_row, first_col;   /* image location of upper left pixel */
+    int	    n_rows, n_cols;	/* image pixels in tile (less than */
+    				/* tile_size for edge tiles) */
+    int	    row_stride;		/* pixels between starts of tile rows */
+} DeVAS_Tile;
+
+/* Note that order is (n_rows,n_cols), not (x,y) or (width,height)!!! */
+#define DeVAS_DEFINE_TILED_IMAGE_TYPE( TYPE )				\
+typedef struct {							\
+    int		    n_rows, n_cols;	/* image size, not padded size */ \
+    int		    tile_size;		/* tiles are tile_size x tile_size */ \
+    int		    tile_shift;		/* log2 ( tile_size ) */	\
+    int		    n_tile_rows, n_tile_cols;	/* number of tiles */	\
+    int		    exposure_set;	/* as in TYPE##_image */	\
+    double	    exposure;						\
+    DeVAS_Image_Info image_info;					\
+    TYPE	    *start_data;	/* first pixel of first tile */	\
+    DeVAS_Image_Storage *storage;	/* shared, reference counted */	\
+} TYPE##_tiled_image;
+
+DeVAS_DEFINE_TILED_IMAGE_TYPE ( DeVAS_gray )
+DeVAS_DEFINE_TILED_IMAGE_TYPE ( DeVAS_float )
+DeVAS_DEFINE_TILED_IMAGE_TYPE ( DeVAS_double )
+DeVAS_DEFINE_TILED_IMAGE_TYPE ( DeVAS_RGB )
+DeVAS_DEFINE_TILED_IMAGE_TYPE ( DeVAS_RGBf )
+DeVAS_DEFINE_TILED_IMAGE_TYPE ( DeVAS_XYZ )
+DeVAS_DEFINE_TILED_IMAGE_TYPE ( DeVAS_xyY )
+DeVAS_DEFINE_TILED_IMAGE_TYPE ( DeVAS_complexf )
+
+/*
+ * methods on DeVAS_tiled_image objects:
+ */
+
+#define	DeVAS_tiled_image_offset(tiled_image,row,col)			\
+	    ( ( ( ( ( (size_t) ( (row) >> (tiled_image)->tile_shift ) ) *	\
+		    (tiled_image)->n_tile_cols ) +			\
+		  ( (col) >> (tiled_image)->tile_shift ) ) <<		\
+		    ( 2 * (tiled_image)->tile_shift ) ) +		\
+	      ( ( (row) & ( (tiled_image)->tile_size - 1 ) ) <<		\
+		    (tiled_image)->tile_shift ) +			\
+	      ( (col) & ( (tiled_image)->tile_size - 1 ) ) )
+
+#define	DeVAS_tiled_image_data(tiled_image,row,col)			\
+	    (tiled_image)->start_data[DeVAS_tiled_image_offset (	\
+		tiled_image, row, col )]
+    			/* read/write */
+
+#define	DeVAS_tiled_image_n_rows(tiled_image)	(tiled_image)->n_rows
+#define	DeVAS_tiled_image_n_cols(tiled_image)	(tiled_image)->n_cols
+#define	DeVAS_tiled_image_tile_size(tiled_image) (tiled_image)->tile_size
+#define	DeVAS_tiled_image_n_tile_rows(tiled_image) (tiled_image)->n_tile_rows
+#define	DeVAS_tiled_image_n_tile_cols(tiled_image) (tiled_image)->n_tile_cols
+    			/* read only (but not enforced ) */
+
+/*
+ * Visit every tile, in storage order:
+ *
+ *   DeVAS_Tile	tile;
+ *   DeVAS_RGBf	*pixels;
+ *
+ *   DeVAS_for_each_tile ( tiled_image, tile ) {
+ *	pixels = DeVAS_RGBf_tiled_image_tile ( tiled_image, &tile );
+ *	... pixels[row * tile.row_stride + col], for row < tile.n_rows
+ *	    and col < tile.n_cols ...
+ *   }
+ */
+#define	DeVAS_for_each_tile(tiled_image,tile)				\
+	for ( (tile).tile_row = 0;					\
+		(tile).tile_row < (tiled_image)->n_tile_rows;		\
+		(tile).tile_row++ )					\
+	    for ( (tile).tile_col = 0;					\
+		    (tile).tile_col < (tiled_image)->n_tile_cols;	\
+		    (tile).tile_col++ )
+
+/*
+ * function prototypes:
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DeVAS_PROTOTYPE_TILED_IMAGE( TYPE )				\
+TYPE##_tiled_image  *TYPE##_tiled_image_new ( unsigned int n_rows,	\
+			unsigned int n_cols, int tile_size );		\
+void		    TYPE##_tiled_image_delete ( TYPE##_tiled_image *image ); \
+TYPE		    *TYPE##_tiled_image_tile ( TYPE##_tiled_image *image, \
+			DeVAS_Tile *tile );				\
+TYPE##_tiled_image  *TYPE##_tiled_image_from_image ( TYPE##_image *image, \
+			int tile_size );				\
+TYPE##_image	    *TYPE##_image_from_tiled_image (			\
+			TYPE##_tiled_image *tiled_image );		\
+TYPE##_tiled_image  *TYPE##_tiled_image_transpose (			\
+			TYPE##_tiled_image *image );
+
+DeVAS_PROTOTYPE_TILED_IMAGE ( DeVAS_gray )
+DeVAS_PROTOTYPE_TILED_IMAGE ( DeVAS_float )
+DeVAS_PROTOTYPE_TILED_IMAGE ( DeVAS_double )
+DeVAS_PROTOTYPE_TILED_IMAGE ( DeVAS_RGB )
+DeVAS_PROTOTYPE_TILED_IMAGE ( DeVAS_RGBf )
+DeVAS_PROTOTYPE_TILED_IMAGE ( DeVAS_XYZ )
+DeVAS_PROTOTYPE_TILED_IMAGE ( DeVAS_xyY )
+DeVAS_PROTOTYPE_TILED_IMAGE ( DeVAS_complexf )
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __DeVAS_TILED_IMAGE_H */
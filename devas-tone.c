@@ -0,0 +1,500 @@
+/*
+ * Single-pass tone pipelines.  See devas-tone.h.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#ifdef	__SSE2__
+#include <emmintrin.h>
+#endif	/* __SSE2__ */
+#include "devas-tone.h"
+#include "sRGB-transfer.h"
+#include "devas-parallel.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+static DeVAS_Tone_Step *
+DeVAS_tone_new_step ( DeVAS_Tone_Pipeline *pipeline,
+	DeVAS_Tone_Step_Type type )
+{
+    DeVAS_Tone_Step *step;
+
+    if ( pipeline->n_steps >= DeVAS_TONE_MAX_STEPS ) {
+	fprintf ( stderr, "DeVAS_tone_new_step: too many steps!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    step = &pipeline->step[pipeline->n_steps++];
+    memset ( step, 0, sizeof ( DeVAS_Tone_Step ) );
+    step->type = type;
+
+    return ( step );
+}
+
+void
+DeVAS_tone_pipeline_init ( DeVAS_Tone_Pipeline *pipeline )
+{
+    pipeline->n_steps = 0;
+    pipeline->transfer = DeVAS_transfer_sRGB;
+}
+
+void
+DeVAS_tone_set_transfer ( DeVAS_Tone_Pipeline *pipeline,
+	DeVAS_Transfer transfer )
+{
+    pipeline->transfer = transfer;
+}
+
+void
+DeVAS_tone_add_matrix ( DeVAS_Tone_Pipeline *pipeline, float matrix[3][3] )
+{
+    DeVAS_Tone_Step *step;
+
+    step = DeVAS_tone_new_step ( pipeline, DeVAS_tone_step_matrix );
+    memcpy ( step->matrix, matrix, sizeof ( step->matrix ) );
+}
+
+void
+DeVAS_tone_add_scale ( DeVAS_Tone_Pipeline *pipeline, double multiplier )
+{
+    DeVAS_Tone_Step *step;
+
+    step = DeVAS_tone_new_step ( pipeline, DeVAS_tone_step_scale );
+    step->multiplier = multiplier;
+}
+
+void
+DeVAS_tone_add_invert ( DeVAS_Tone_Pipeline *pipeline, double old_max,
+	double old_min )
+{
+    DeVAS_Tone_Step *step;
+
+    step = DeVAS_tone_new_step ( pipeline, DeVAS_tone_step_invert );
+    step->add = old_max;
+    step->offset = old_min;
+}
+
+void
+DeVAS_tone_add_rescale ( DeVAS_Tone_Pipeline *pipeline, double old_max,
+	double old_min, float new_max, float new_min )
+/*
+ * Constants computed as in the rescale_range functions in rad2jpeg,
+ * rad2png, and rad2tiff.
+ */
+{
+    DeVAS_Tone_Step *step;
+
+    if ( old_max == old_min ) {
+	step = DeVAS_tone_new_step ( pipeline, DeVAS_tone_step_constant );
+	step->value = 0.5 * ( new_max + new_min );
+    } else {
+	step = DeVAS_tone_new_step ( pipeline, DeVAS_tone_step_rescale );
+	step->multiplier = ( new_max - new_min ) / ( old_max - old_min );
+	step->offset = old_min;
+	step->add = new_min;
+    }
+}
+
+int
+DeVAS_tone_add_stats_rescale ( DeVAS_Tone_Pipeline *pipeline,
+	DeVAS_Image_Stats *stats, float new_max, float new_min )
+/*
+ * Rescales the range of values in stats to [new_min,new_max].  Returns
+ * FALSE if there was no variability in the values.
+ */
+{
+    DeVAS_tone_add_rescale ( pipeline, stats->max, stats->min, new_max,
+	    new_min );
+
+    return ( stats->max != stats->min );
+}
+
+int
+DeVAS_tone_add_stats_invert_rescale ( DeVAS_Tone_Pipeline *pipeline,
+	DeVAS_Image_Stats *stats, float new_max, float new_min )
+/*
+ * Inversion rounds each value to float, which is monotone, so the
+ * smallest and largest inverted values are the inverted largest and
+ * smallest original values.  Applying the invert step to those gives
+ * exactly the range a pass over the inverted pixels would find.
+ */
+{
+    DeVAS_Tone_Pipeline	invert;
+    DeVAS_RGBf		range[2];
+
+    if ( stats->max == stats->min ) {
+	DeVAS_tone_add_rescale ( pipeline, stats->max, stats->min, new_max,
+		new_min );
+	return ( FALSE );
+    }
+
+    DeVAS_tone_pipeline_init ( &invert );
+    DeVAS_tone_add_invert ( &invert, stats->max, stats->min );
+    range[0].red = range[0].green = range[0].blue = stats->min;
+    range[1].red = range[1].green = range[1].blue = stats->max;
+    DeVAS_tone_row ( &invert, range, range, 2, NULL );
+
+    DeVAS_tone_add_invert ( pipeline, stats->max, stats->min );
+    DeVAS_tone_add_rescale ( pipeline, range[0].red, range[1].red,
+	    new_max, new_min );
+
+    return ( TRUE );
+}
+
+#ifdef	__SSE2__
+/*
+ * Four floats as two pairs of doubles, and back, for the SSE2 versions of
+ * the scale, invert, and rescale steps.  These do the same double
+ * precision operations in the same order as the scalar loops, and so give
+ * identical results.
+ */
+#define	DeVAS_TONE_LOAD4(p,lo,hi)					\
+	{								\
+	    __m128  v = _mm_loadu_ps ( p );				\
+	    lo = _mm_cvtps_pd ( v );					\
+	    hi = _mm_cvtps_pd ( _mm_movehl_ps ( v, v ) );		\
+	}
+#define	DeVAS_TONE_STORE4(p,lo,hi)					\
+	_mm_storeu_ps ( p, _mm_movelh_ps ( _mm_cvtpd_ps ( lo ),		\
+		    _mm_cvtpd_ps ( hi ) ) )
+#endif	/* __SSE2__ */
+
+static void
+DeVAS_tone_step_apply ( DeVAS_Tone_Step *step, const float *src, float *dst,
+	int n )
+/*
+ * One step on n pixels (3 * n values).  dst may be src.
+ */
+{
+    int	    i;
+    double  multiplier, offset, add;
+#ifdef	__SSE2__
+    __m128d lo, hi;
+    __m128d multiplier_2, offset_2, add_2;
+#endif	/* __SSE2__ */
+
+    multiplier = step->multiplier;
+    offset = step->offset;
+    add = step->add;
+    i = 0;
+#ifdef	__SSE2__
+    multiplier_2 = _mm_set1_pd ( multiplier );
+    offset_2 = _mm_set1_pd ( offset );
+    add_2 = _mm_set1_pd ( add );
+#endif	/* __SSE2__ */
+
+    switch ( step->type ) {
+	case DeVAS_tone_step_matrix:
+	    DeVAS_RGBf_row_colortrans ( step->matrix, (const DeVAS_RGBf *) src,
+		    (DeVAS_RGBf *) dst, n );
+	    break;
+
+	case DeVAS_tone_step_scale:
+#ifdef	__SSE2__
+	    for ( ; i + 4 <= 3 * n; i += 4 ) {
+		DeVAS_TONE_LOAD4 ( src + i, lo, hi );
+		DeVAS_TONE_STORE4 ( dst + i, _mm_mul_pd ( lo, multiplier_2 ),
+			_mm_mul_pd ( hi, multiplier_2 ) );
+	    }
+#endif	/* __SSE2__ */
+	    for ( ; i < 3 * n; i++ ) {
+		dst[i] = src[i] * multiplier;
+	    }
+	    break;
+
+	case DeVAS_tone_step_invert:
+#ifdef	__SSE2__
+	    for ( ; i + 4 <= 3 * n; i += 4 ) {
+		DeVAS_TONE_LOAD4 ( src + i, lo, hi );
+		DeVAS_TONE_STORE4 ( dst + i,
+			_mm_sub_pd ( add_2, _mm_sub_pd ( lo, offset_2 ) ),
+			_mm_sub_pd ( add_2, _mm_sub_pd ( hi, offset_2 ) ) );
+	    }
+#endif	/* __SSE2__ */
+	    for ( ; i < 3 * n; i++ ) {
+		dst[i] = add - ( src[i] - offset );
+	    }
+	    break;
+
+	case DeVAS_tone_step_rescale:
+#ifdef	__SSE2__
+	    for ( ; i + 4 <= 3 * n; i += 4 ) {
+		DeVAS_TONE_LOAD4 ( src + i, lo, hi );
+		DeVAS_TONE_STORE4 ( dst + i,
+			_mm_add_pd ( _mm_mul_pd ( multiplier_2,
+				_mm_sub_pd ( lo, offset_2 ) ), add_2 ),
+			_mm_add_pd ( _mm_mul_pd ( multiplier_2,
+				_mm_sub_pd ( hi, offset_2 ) ), add_2 ) );
+	    }
+#endif	/* __SSE2__ */
+	    for ( ; i < 3 * n; i++ ) {
+		dst[i] = ( multiplier * ( src[i] - offset ) ) + add;
+	    }
+	    break;
+
+	case DeVAS_tone_step_constant:
+	    for ( ; i < 3 * n; i++ ) {
+		dst[i] = step->value;
+	    }
+	    break;
+
+	default:
+	    fprintf ( stderr, "DeVAS_tone_step_apply: internal error!\n" );
+	    exit ( EXIT_FAILURE );
+    }
+}
+
+static void
+DeVAS_tone_block ( DeVAS_Tone_Pipeline *pipeline, const DeVAS_RGBf *src,
+	DeVAS_RGBf *dst, int n )
+/*
+ * All steps on a block of n pixels.
+ */
+{
+    int	    i;
+
+    if ( pipeline->n_steps == 0 ) {
+	if ( dst != src ) {
+	    memmove ( dst, src, n * sizeof ( DeVAS_RGBf ) );
+	}
+	return;
+    }
+
+    DeVAS_tone_step_apply ( &pipeline->step[0], (const float *) src,
+	    (float *) dst, n );
+    for ( i = 1; i < pipeline->n_steps; i++ ) {
+	DeVAS_tone_step_apply ( &pipeline->step[i], (const float *) dst,
+		(float *) dst, n );
+    }
+}
+
+static void
+DeVAS_tone_row_sum ( DeVAS_Tone_Pipeline *pipeline, const DeVAS_RGBf *src,
+	DeVAS_RGBf *dst, int n, DeVAS_Image_Stats *stats, double *row_sum )
+/*
+ * As DeVAS_tone_row, but with the sum of the row's statistics left in
+ * *row_sum (see DeVAS_image_stats_add_RGBf_pixels).
+ */
+{
+    int	    first, block_n;
+
+    *row_sum = 0.0;
+    for ( first = 0; first < n; first += DeVAS_TONE_BLOCK ) {
+	block_n = ( n - first < DeVAS_TONE_BLOCK ) ? n - first :
+	    DeVAS_TONE_BLOCK;
+	DeVAS_tone_block ( pipeline, src + first, dst + first, block_n );
+	if ( stats != NULL ) {
+	    DeVAS_image_stats_add_RGBf_pixels ( stats, dst + first, block_n,
+		    row_sum );
+	}
+    }
+}
+
+void
+DeVAS_tone_row ( DeVAS_Tone_Pipeline *pipeline, const DeVAS_RGBf *src,
+	DeVAS_RGBf *dst, int n, DeVAS_Image_Stats *stats )
+{
+    double  row_sum;
+
+    DeVAS_tone_row_sum ( pipeline, src, dst, n, stats, &row_sum );
+    if ( stats != NULL ) {
+	stats->sum += row_sum;
+    }
+}
+
+void
+DeVAS_tone_row_to_sRGB ( DeVAS_Tone_Pipeline *pipeline,
+	const DeVAS_RGBf *src, DeVAS_RGB *dst, int n )
+/*
+ * Encoding as RGBf_to_sRGB: clip so the largest value is <= 1.0, then
+ * encode each channel (which clips to >= 0).
+ */
+{
+    DeVAS_RGBf	block[DeVAS_TONE_BLOCK];
+    DeVAS_RGBf	pixel;
+    float	max_value;
+    int		first, block_n, i;
+
+    for ( first = 0; first < n; first += DeVAS_TONE_BLOCK ) {
+	block_n = ( n - first < DeVAS_TONE_BLOCK ) ? n - first :
+	    DeVAS_TONE_BLOCK;
+	DeVAS_tone_block ( pipeline, src + first, block, block_n );
+
+	for ( i = 0; i < block_n; i++ ) {
+	    pixel = block[i];
+	    max_value = fmaxf ( pixel.red, fmaxf ( pixel.green, pixel.blue ) );
+	    if ( max_value > 1.0 ) {
+		pixel.red /= max_value;
+		pixel.green /= max_value;
+		pixel.blue /= max_value;
+	    }
+	    if ( pipeline->transfer == DeVAS_transfer_sRGB ) {
+		dst[first + i].red = DeVAS_sRGB_encode ( pixel.red );
+		dst[first + i].green = DeVAS_sRGB_encode ( pixel.green );
+		dst[first + i].blue = DeVAS_sRGB_encode ( pixel.blue );
+	    } else {
+		dst[first + i].red =
+		    DeVAS_transfer_encode ( pipeline->transfer, pixel.red );
+		dst[first + i].green =
+		    DeVAS_transfer_encode ( pipeline->transfer, pixel.green );
+		dst[first + i].blue =
+		    DeVAS_transfer_encode ( pipeline->transfer, pixel.blue );
+	    }
+	}
+    }
+}
+
+void
+DeVAS_tone_row_to_HDR ( DeVAS_Tone_Pipeline *pipeline,
+	DeVAS_HDR_Transfer transfer, const DeVAS_RGBf *src, uint16_t *dst,
+	int n )
+{
+    DeVAS_RGBf	block[DeVAS_TONE_BLOCK];
+    int		first, block_n;
+
+    for ( first = 0; first < n; first += DeVAS_TONE_BLOCK ) {
+	block_n = ( n - first < DeVAS_TONE_BLOCK ) ? n - first :
+	    DeVAS_TONE_BLOCK;
+	DeVAS_tone_block ( pipeline, src + first, block, block_n );
+	DeVAS_hdr_encode_row ( transfer, block, dst + ( 3 * first ),
+		block_n );
+    }
+}
+
+typedef struct {		/* for the parallel row functions */
+    DeVAS_Tone_Pipeline	*pipeline;
+    DeVAS_RGBf		**src;
+    DeVAS_RGBf		**dst;
+    DeVAS_RGB		**sRGB_dst;
+    int			n_cols;
+    DeVAS_Image_Stats	*band_stats;	/* per band, or NULL */
+    double		*row_sums;	/* per row */
+} DeVAS_Tone_Rows;
+
+static void
+DeVAS_tone_rows_band ( void *context, int band, int first_row,
+	int n_band_rows )
+{
+    DeVAS_Tone_Rows	*work;
+    DeVAS_Image_Stats	*stats;
+    double		row_sum;
+    int			row;
+
+    work = (DeVAS_Tone_Rows *) context;
+
+    stats = NULL;
+    if ( work->band_stats != NULL ) {
+	stats = &work->band_stats[band];
+	DeVAS_image_stats_clear ( stats );
+    }
+
+    for ( row = first_row; row < first_row + n_band_rows; row++ ) {
+	DeVAS_tone_row_sum ( work->pipeline, work->src[row], work->dst[row],
+		work->n_cols, stats, &row_sum );
+	if ( stats != NULL ) {
+	    work->row_sums[row] = row_sum;
+	}
+    }
+}
+
+void
+DeVAS_tone_rows ( DeVAS_Tone_Pipeline *pipeline, DeVAS_RGBf **src,
+	DeVAS_RGBf **dst, int n_rows, int n_cols, DeVAS_Image_Stats *stats )
+{
+    DeVAS_Tone_Rows	work;
+    int			band_rows;
+
+    work.pipeline = pipeline;
+    work.src = src;
+    work.dst = dst;
+    work.n_cols = n_cols;
+    work.band_stats = NULL;
+    work.row_sums = NULL;
+
+    if ( stats != NULL ) {
+	work.band_stats = DeVAS_image_stats_bands_new ( n_rows, n_cols,
+		&band_rows, &work.row_sums );
+    } else {
+	band_rows = DeVAS_parallel_band_rows ( n_cols );
+    }
+
+    DeVAS_parallel_bands ( n_rows, band_rows, DeVAS_tone_rows_band,
+	    (void *) &work );
+
+    if ( stats != NULL ) {
+	DeVAS_image_stats_bands_merge ( stats, work.band_stats,
+		DeVAS_parallel_n_bands ( n_rows, band_rows ), work.row_sums,
+		n_rows );
+	free ( work.band_stats );
+	free ( work.row_sums );
+    }
+}
+
+static void
+DeVAS_tone_rows_to_sRGB_band ( void *context, int band, int first_row,
+	int n_band_rows )
+{
+    DeVAS_Tone_Rows	*work;
+    int			row;
+
+    work = (DeVAS_Tone_Rows *) context;
+
+    for ( row = first_row; row < first_row + n_band_rows; row++ ) {
+	DeVAS_tone_row_to_sRGB ( work->pipeline, work->src[row],
+		work->sRGB_dst[row], work->n_cols );
+    }
+}
+
+void
+DeVAS_tone_rows_to_sRGB ( DeVAS_Tone_Pipeline *pipeline, DeVAS_RGBf **src,
+	DeVAS_RGB **dst, int n_rows, int n_cols )
+{
+    DeVAS_Tone_Rows	work;
+
+    /* build any encoding tables before the threads need them */
+    DeVAS_transfer_encode ( pipeline->transfer, 0.0 );
+
+    work.pipeline = pipeline;
+    work.src = src;
+    work.sRGB_dst = dst;
+    work.n_cols = n_cols;
+
+    DeVAS_parallel_bands ( n_rows, DeVAS_parallel_band_rows ( n_cols ),
+	    DeVAS_tone_rows_to_sRGB_band, (void *) &work );
+}
+
+void
+DeVAS_tone_RGBf_image ( DeVAS_Tone_Pipeline *pipeline,
+	DeVAS_RGBf_image *image, int keep_stats )
+{
+    DeVAS_Image_Stats	stats;
+
+    if ( keep_stats ) {
+	DeVAS_image_stats_clear ( &stats );
+    }
+
+    DeVAS_tone_rows ( pipeline, image->data, image->data,
+	    DeVAS_image_n_rows ( image ), DeVAS_image_n_cols ( image ),
+	    keep_stats ? &stats : NULL );
+
+    DeVAS_image_modified ( image );
+    if ( keep_stats ) {
+	DeVAS_RGBf_image_set_stats ( image, &stats );
+    }
+}
+
+DeVAS_RGB_image *
+DeVAS_tone_RGBf_image_to_sRGB ( DeVAS_Tone_Pipeline *pipeline,
+	DeVAS_RGBf_image *image )
+{
+    DeVAS_RGB_image *sRGB_image;
+
+    sRGB_image = DeVAS_RGB_image_new ( DeVAS_image_n_rows ( image ),
+	    DeVAS_image_n_cols ( image ) );
+
+    DeVAS_tone_rows_to_sRGB ( pipeline, image->data, sRGB_image->data,
+	    DeVAS_image_n_rows ( image ), DeVAS_image_n_cols ( image ) );
+
+    return ( sRGB_image );
+}
@@ -0,0 +1,172 @@
+/*
+ * Single-pass tone pipelines for three channel float images.
+ *
+ * A pipeline is a short list of per-pixel steps (primaries transform,
+ * exposure or units scaling, inversion, linear rescaling), set up once
+ * per run and then applied to each row in one pass, optionally followed
+ * by 8 bit sRGB encoding.  This replaces a separate pass over the whole
+ * image for each step, so each pixel is read and written once instead of
+ * once per step.
+ *
+ * Each step rounds its result to float exactly as the separate passes
+ * it replaces did, so the output is bit-identical.  Rows are processed a
+ * block of DeVAS_TONE_BLOCK pixels at a time, all steps on one block
+ * before the next, so intermediate values stay in cache.  The scale,
+ * invert, and rescale steps use SSE2, where available, four values at a
+ * time.
+ *
+ *   DeVAS_tone_pipeline_init ( &<pipeline> )
+ *
+ *	No steps, and sRGB encoding.
+ *
+ *   DeVAS_tone_set_transfer ( &<pipeline>, <transfer> )
+ *
+ *	Encode 8 bit output with the given transfer function (see
+ *	devas-color-space.h) rather than sRGB.
+ *
+ *   DeVAS_tone_add_matrix ( &<pipeline>, <COLORMAT> )
+ *
+ *	As Radiance colortrans (e.g., for comprgb2rgbWBmat).
+ *
+ *   DeVAS_tone_add_scale ( &<pipeline>, multiplier )
+ *
+ *	value * multiplier, in double.
+ *
+ *   DeVAS_tone_add_invert ( &<pipeline>, old_max, old_min )
+ *
+ *	old_max - ( value - old_min ), in double.
+ *
+ *   DeVAS_tone_add_rescale ( &<pipeline>, old_max, old_min, new_max,
+ *	    new_min )
+ *
+ *	Linearly maps [old_min,old_max] to [new_min,new_max].  If old_max ==
+ *	old_min, every value becomes 0.5 * ( new_max + new_min ).
+ *
+ *   DeVAS_tone_add_stats_rescale ( &<pipeline>, <stats>, new_max, new_min )
+ *
+ *	DeVAS_tone_add_rescale from the range in stats (e.g., from
+ *	DeVAS_RGBf_image_stats).  FALSE if stats->max == stats->min.
+ *
+ *   DeVAS_tone_add_stats_invert_rescale ( &<pipeline>, <stats>, new_max,
+ *	    new_min )
+ *
+ *	Inversion followed by rescaling to [new_min,new_max], with the range
+ *	of the inverted values worked out from stats, so inverting and
+ *	rescaling take a single pass and no statistics pass in between.
+ *	If stats->max == stats->min, only the rescaling step is added (every
+ *	value becomes the middle of the new range) and the result is FALSE.
+ *
+ *   DeVAS_tone_row ( &<pipeline>, <src>, <dst>, n, <stats> )
+ *   DeVAS_tone_row_to_sRGB ( &<pipeline>, <src>, <dst>, n )
+ *
+ *	Applies the steps to n pixels.  For DeVAS_tone_row, dst may be the
+ *	same as src, and if stats is not NULL, the statistics of the result
+ *	are accumulated into it (see DeVAS_image_stats_add_RGBf_row).
+ *	DeVAS_tone_row_to_sRGB then encodes as RGBf_to_sRGB in
+ *	devas-sRGB.c, using the pipeline's transfer function.  Also usable for TT_RGBf and TT_RGB rows, which have
+ *	the same layout.
+ *
+ *   DeVAS_tone_row_to_HDR ( &<pipeline>, <transfer>, <src>, <dst>, n )
+ *
+ *	Applies the steps to n pixels and then encodes them as 3 * n 16 bit
+ *	PQ or HLG values (see devas-hdr-transfer.h).  The steps should
+ *	give BT.2020 RGB in cd/m^2.
+ *
+ *   DeVAS_tone_rows ( &<pipeline>, <src>, <dst>, n_rows, n_cols, <stats> )
+ *   DeVAS_tone_rows_to_sRGB ( &<pipeline>, <src>, <dst>, n_rows, n_cols )
+ *
+ *	DeVAS_tone_row or DeVAS_tone_row_to_sRGB for arrays of row pointers
+ *	(the data field of a DeVAS or TT image), in parallel over bands of
+ *	rows (see devas-parallel.h).  Statistics are accumulated as by
+ *	DeVAS_image_stats_add_RGBf_rows.
+ *
+ *   DeVAS_tone_RGBf_image ( &<pipeline>, <image>, keep_stats )
+ *
+ *	Applies the steps to image in place, in parallel.  If keep_stats is
+ *	TRUE, the statistics of the result are collected in the same pass
+ *	and kept with the image (DeVAS_RGBf_image_set_stats).
+ *
+ *   DeVAS_tone_RGBf_image_to_sRGB ( &<pipeline>, <image> )
+ *
+ *	A new DeVAS_RGB_image with the steps applied and sRGB encoded.
+ *	image is not changed.
+ */
+
+#ifndef __DeVAS_TONE_H
+#define __DeVAS_TONE_H
+
+#include "devas-image.h"
+#include "devas-color-space.h"
+#include "devas-hdr-transfer.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+#define	DeVAS_TONE_MAX_STEPS	8
+#define	DeVAS_TONE_BLOCK	256	/* pixels */
+
+typedef enum {
+    DeVAS_tone_step_matrix,
+    DeVAS_tone_step_scale,
+    DeVAS_tone_step_invert,
+    DeVAS_tone_step_rescale,
+    DeVAS_tone_step_constant
+} DeVAS_Tone_Step_Type;
+
+typedef struct {
+    DeVAS_Tone_Step_Type type;
+    float	matrix[3][3];	/* DeVAS_tone_step_matrix */
+    double	multiplier;	/* ( value - offset ) * multiplier + add */
+    double	offset;
+    double	add;
+    float	value;		/* DeVAS_tone_step_constant */
+} DeVAS_Tone_Step;
+
+typedef struct {
+    int		    n_steps;
+    DeVAS_Tone_Step step[DeVAS_TONE_MAX_STEPS];
+    DeVAS_Transfer  transfer;	/* for DeVAS_tone_row_to_sRGB */
+} DeVAS_Tone_Pipeline;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void	DeVAS_tone_pipeline_init ( DeVAS_Tone_Pipeline *pipeline );
+void	DeVAS_tone_set_transfer ( DeVAS_Tone_Pipeline *pipeline,
+	    DeVAS_Transfer transfer );
+void	DeVAS_tone_add_matrix ( DeVAS_Tone_Pipeline *pipeline,
+	    float matrix[3][3] );
+void	DeVAS_tone_add_scale ( DeVAS_Tone_Pipeline *pipeline,
+	    double multiplier );
+void	DeVAS_tone_add_invert ( DeVAS_Tone_Pipeline *pipeline,
+	    double old_max, double old_min );
+void	DeVAS_tone_add_rescale ( DeVAS_Tone_Pipeline *pipeline,
+	    double old_max, double old_min, float new_max, float new_min );
+int	DeVAS_tone_add_stats_rescale ( DeVAS_Tone_Pipeline *pipeline,
+	    DeVAS_Image_Stats *stats, float new_max, float new_min );
+int	DeVAS_tone_add_stats_invert_rescale ( DeVAS_Tone_Pipeline *pipeline,
+	    DeVAS_Image_Stats *stats, float new_max, float new_min );
+
+void	DeVAS_tone_row ( DeVAS_Tone_Pipeline *pipeline, const DeVAS_RGBf *src,
+	    DeVAS_RGBf *dst, int n, DeVAS_Image_Stats *stats );
+void	DeVAS_tone_row_to_sRGB ( DeVAS_Tone_Pipeline *pipeline,
+	    const DeVAS_RGBf *src, DeVAS_RGB *dst, int n );
+void	DeVAS_tone_row_to_HDR ( DeVAS_Tone_Pipeline *pipeline,
+	    DeVAS_HDR_Transfer transfer, const DeVAS_RGBf *src,
+	    uint16_t *dst, int n );
+
+void	DeVAS_tone_rows ( DeVAS_Tone_Pipeline *pipeline, DeVAS_RGBf **src,
+	    DeVAS_RGBf **dst, int n_rows, int n_cols,
+	    DeVAS_Image_Stats *stats );
+void	DeVAS_tone_rows_to_sRGB ( DeVAS_Tone_Pipeline *pipeline,
+	    DeVAS_RGBf **src, DeVAS_RGB **dst, int n_rows, int n_cols );
+
+void	DeVAS_tone_RGBf_image ( DeVAS_Tone_Pipeline *pipeline,
+	    DeVAS_RGBf_image *image, int keep_stats );
+DeVAS_RGB_image *DeVAS_tone_RGBf_image_to_sRGB (
+	    DeVAS_Tone_Pipeline *pipeline, DeVAS_RGBf_image *image );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __DeVAS_TONE_H */
@@ -0,0 +1,298 @@
+/*
+ * Zero-copy adapters between DeVAS images (devas-image.h) and TT images
+ * (tifftoolsimage.h) with the same pixel layout.  See devas-tt-image.h.
+ *
+ * A TT image sharing DeVAS storage holds a reference to the
+ * DeVAS_Image_Storage through its owner/release fields.  Going the other
+ * way, the malloc'ed pixel block of a TT image is adopted by a new
+ * DeVAS_Image_Storage, and the TT image is then given a reference to
+ * that storage, so from then on both share one reference count.
+ */
+
+#include <stdlib.h>
+#include <stddef.h>		/* for offsetof */
+#include <assert.h>
+#include <string.h>
+#include "devas-tt-image.h"
+#include "devas-image-map.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+static void
+DeVAS_TT_release_storage ( void *storage )
+/*
+ * release function for TT images using DeVAS storage
+ */
+{
+    DeVAS_image_storage_release ( (DeVAS_Image_Storage *) storage );
+}
+
+void
+DeVAS_TT_check_layouts ( void )
+/*
+ * The adapters reinterpret pixel arrays of one system as the other, so
+ * make sure the paired pixel types really are laid out the same way.
+ */
+{
+    assert ( sizeof ( DeVAS_gray ) == sizeof ( TT_gray ) );
+    assert ( sizeof ( DeVAS_float ) == sizeof ( TT_float ) );
+
+    assert ( sizeof ( DeVAS_RGB ) == sizeof ( TT_RGB ) );
+    assert ( offsetof ( DeVAS_RGB, red ) == offsetof ( TT_RGB, red ) );
+    assert ( offsetof ( DeVAS_RGB, green ) == offsetof ( TT_RGB, green ) );
+    assert ( offsetof ( DeVAS_RGB, blue ) == offsetof ( TT_RGB, blue ) );
+
+    assert ( sizeof ( DeVAS_RGBf ) == sizeof ( TT_RGBf ) );
+    assert ( offsetof ( DeVAS_RGBf, red ) == offsetof ( TT_RGBf, red ) );
+    assert ( offsetof ( DeVAS_RGBf, green ) == offsetof ( TT_RGBf, green ) );
+    assert ( offsetof ( DeVAS_RGBf, blue ) == offsetof ( TT_RGBf, blue ) );
+
+    assert ( sizeof ( DeVAS_XYZ ) == sizeof ( TT_XYZ ) );
+    assert ( offsetof ( DeVAS_XYZ, X ) == offsetof ( TT_XYZ, X ) );
+    assert ( offsetof ( DeVAS_XYZ, Y ) == offsetof ( TT_XYZ, Y ) );
+    assert ( offsetof ( DeVAS_XYZ, Z ) == offsetof ( TT_XYZ, Z ) );
+
+    assert ( sizeof ( DeVAS_xyY ) == sizeof ( TT_xyY ) );
+    assert ( offsetof ( DeVAS_xyY, x ) == offsetof ( TT_xyY, x ) );
+    assert ( offsetof ( DeVAS_xyY, y ) == offsetof ( TT_xyY, y ) );
+    assert ( offsetof ( DeVAS_xyY, Y ) == offsetof ( TT_xyY, Y ) );
+}
+
+#define DeVAS_TT_ADAPTERS( TYPE )					\
+TT_##TYPE##_image *							\
+DeVAS_##TYPE##_image_as_TT ( DeVAS_##TYPE##_image *image )		\
+{									\
+    TT_##TYPE##_image	*tt_image;					\
+    int			row;						\
+									\
+    DeVAS_TT_check_layouts ( );						\
+									\
+    tt_image = (TT_##TYPE##_image *)					\
+	malloc ( sizeof ( TT_##TYPE##_image ) );			\
+    if ( tt_image == NULL ) {						\
+	fprintf ( stderr, "DeVAS_image_as_TT: malloc failed!" );	\
+	DeVAS_print_file_lineno ( __FILE__, __LINE__ );			\
+	exit ( EXIT_FAILURE );						\
+    }									\
+									\
+    tt_image->n_rows = DeVAS_image_n_rows ( image );			\
+    tt_image->n_cols = DeVAS_image_n_cols ( image );			\
+									\
+    tt_image->data = (TT_##TYPE **) malloc ( ( tt_image->n_rows > 0 ?	\
+		tt_image->n_rows : 1 ) * sizeof ( TT_##TYPE * ) );	\
+    if ( tt_image->data == NULL ) {					\
+	fprintf ( stderr, "DeVAS_image_as_TT: malloc failed!" );	\
+	DeVAS_print_file_lineno ( __FILE__, __LINE__ );			\
+	exit ( EXIT_FAILURE );						\
+    }									\
+    for ( row = 0; row < tt_image->n_rows; row++ ) {			\
+	tt_image->data[row] = (TT_##TYPE *) image->data[row];		\
+    }									\
+    tt_image->start_data = (TT_##TYPE *) image->start_data;		\
+									\
+    image->storage->ref_count++;					\
+    tt_image->owner = (void *) image->storage;				\
+    tt_image->release = DeVAS_TT_release_storage;			\
+    tt_image->stats = NULL;						\
+									\
+    return ( tt_image );						\
+}									\
+									\
+DeVAS_##TYPE##_image *							\
+TT_##TYPE##_image_as_DeVAS ( TT_##TYPE##_image *tt_image )		\
+{									\
+    DeVAS_##TYPE##_image    *image;					\
+    DeVAS_Image_Storage	    *storage;					\
+    int			    row;					\
+    VIEW		    nullview = NULLVIEW;			\
+									\
+    DeVAS_TT_check_layouts ( );						\
+									\
+    if ( tt_image->release == DeVAS_TT_release_storage ) {		\
+	/* already backed by DeVAS storage */				\
+	storage = (DeVAS_Image_Storage *) tt_image->owner;		\
+	storage->ref_count++;						\
+    } else if ( tt_image->release == NULL ) {				\
+	/* start_data was malloc'ed by TT_image_new */			\
+	storage = DeVAS_image_storage_adopt ( tt_image->start_data,	\
+		( (size_t) tt_image->n_rows ) * tt_image->n_cols *	\
+		sizeof ( TT_##TYPE ), DeVAS_STORAGE_MALLOC,		\
+		"TT_" #TYPE );						\
+	storage->ref_count++;		/* one for each image object */	\
+	tt_image->owner = (void *) storage;				\
+	tt_image->release = DeVAS_TT_release_storage;			\
+    } else {								\
+	fprintf ( stderr,						\
+		"TT_image_as_DeVAS: unknown owner of pixel storage!\n" );	\
+	DeVAS_print_file_lineno ( __FILE__, __LINE__ );			\
+	exit ( EXIT_FAILURE );						\
+    }									\
+									\
+    image = (DeVAS_##TYPE##_image *)					\
+	malloc ( sizeof ( DeVAS_##TYPE##_image ) );			\
+    if ( image == NULL ) {						\
+	fprintf ( stderr, "TT_image_as_DeVAS: malloc failed!" );	\
+	DeVAS_print_file_lineno ( __FILE__, __LINE__ );			\
+	exit ( EXIT_FAILURE );						\
+    }									\
+									\
+    image->n_rows = tt_image->n_rows;					\
+    image->n_cols = tt_image->n_cols;					\
+									\
+    image->exposure_set = FALSE;					\
+    image->exposure = 1.0;						\
+									\
+    image->image_info.view = nullview;					\
+    image->image_info.description = NULL;				\
+									\
+    image->data = (DeVAS_##TYPE **) malloc ( ( image->n_rows > 0 ?	\
+		image->n_rows : 1 ) * sizeof ( DeVAS_##TYPE * ) );	\
+    if ( image->data == NULL ) {					\
+	fprintf ( stderr, "TT_image_as_DeVAS: malloc failed!" );	\
+	DeVAS_print_file_lineno ( __FILE__, __LINE__ );			\
+	exit ( EXIT_FAILURE );						\
+    }									\
+    for ( row = 0; row < image->n_rows; row++ ) {			\
+	image->data[row] = (DeVAS_##TYPE *) tt_image->data[row];	\
+    }									\
+    image->start_data = (DeVAS_##TYPE *) tt_image->start_data;		\
+									\
+    /* TT image may itself be an adapted DeVAS view */			\
+    image->row_stride = ( image->n_rows > 1 ) ?				\
+	( image->data[1] - image->data[0] ) : image->n_cols;		\
+									\
+    image->storage = storage;						\
+    image->stats = NULL;						\
+									\
+    return ( image );							\
+}
+
+DeVAS_TT_ADAPTERS ( gray )
+DeVAS_TT_ADAPTERS ( float )
+DeVAS_TT_ADAPTERS ( RGB )
+DeVAS_TT_ADAPTERS ( RGBf )
+DeVAS_TT_ADAPTERS ( XYZ )
+DeVAS_TT_ADAPTERS ( xyY )
+
+static unsigned long
+DeVAS_TT_generation ( void *owner, void (*release) ( void *owner ) )
+/*
+ * TT images backed by DeVAS storage share its generation, so that
+ * modifications through DeVAS image objects are noticed.  Other TT images
+ * are only modified through themselves, and drop their statistics when
+ * that happens.
+ */
+{
+    if ( release == DeVAS_TT_release_storage ) {
+	return ( ( (DeVAS_Image_Storage *) owner )->generation );
+    }
+
+    return ( 0 );
+}
+
+void
+DeVAS_TT_modified ( void **stats, void *owner, void (*release) ( void *owner ) )
+/*
+ * See TT_image_modified in devas-tt-image.h.
+ */
+{
+    if ( release == DeVAS_TT_release_storage ) {
+	DeVAS_image_storage_modified ( (DeVAS_Image_Storage *) owner );
+    }
+
+    free ( *stats );
+    *stats = NULL;
+}
+
+DeVAS_Image_Stats *
+TT_RGBf_image_stats ( TT_RGBf_image *image )
+/*
+ * As DeVAS_RGBf_image_stats.
+ */
+{
+    DeVAS_Image_Stats	*stats;
+
+    DeVAS_TT_check_layouts ( );
+
+    stats = (DeVAS_Image_Stats *) image->stats;
+    if ( ( stats != NULL ) && ( stats->generation ==
+		DeVAS_TT_generation ( image->owner, image->release ) ) ) {
+	return ( stats );
+    }
+
+    if ( stats == NULL ) {
+	stats = (DeVAS_Image_Stats *) malloc ( sizeof ( DeVAS_Image_Stats ) );
+	if ( stats == NULL ) {
+	    fprintf ( stderr, "TT_RGBf_image_stats: malloc failed!\n" );
+	    exit ( EXIT_FAILURE );
+	}
+	image->stats = (void *) stats;
+    }
+
+    DeVAS_image_stats_clear ( stats );
+    DeVAS_image_stats_add_RGBf_rows ( stats, (DeVAS_RGBf **) image->data,
+	    TT_image_n_rows ( image ), TT_image_n_cols ( image ) );
+    stats->generation = DeVAS_TT_generation ( image->owner, image->release );
+
+    return ( stats );
+}
+
+void
+TT_RGBf_image_set_stats ( TT_RGBf_image *image, DeVAS_Image_Stats *stats )
+/*
+ * As DeVAS_RGBf_image_set_stats.  Call after TT_image_modified.
+ */
+{
+    if ( image->stats == NULL ) {
+	image->stats = malloc ( sizeof ( DeVAS_Image_Stats ) );
+	if ( image->stats == NULL ) {
+	    fprintf ( stderr, "TT_RGBf_image_set_stats: malloc failed!\n" );
+	    exit ( EXIT_FAILURE );
+	}
+    }
+
+    *( (DeVAS_Image_Stats *) image->stats ) = *stats;
+    ( (DeVAS_Image_Stats *) image->stats )->generation =
+	DeVAS_TT_generation ( image->owner, image->release );
+}
+
+DeVAS_DEFINE_IMAGE_MAP ( TT_gray, TT_image_modified )
+DeVAS_DEFINE_IMAGE_MAP ( TT_float, TT_image_modified )
+DeVAS_DEFINE_IMAGE_MAP ( TT_RGB, TT_image_modified )
+DeVAS_DEFINE_IMAGE_MAP ( TT_RGBf, TT_image_modified )
+DeVAS_DEFINE_IMAGE_MAP ( TT_XYZ, TT_image_modified )
+DeVAS_DEFINE_IMAGE_MAP ( TT_xyY, TT_image_modified )
+
+#define DeVAS_TT_IMAGE_RESAMPLE( TYPE, CHANNELS, LOAD, STORE )		\
+TT_##TYPE##_image *							\
+TT_##TYPE##_image_resample ( TT_##TYPE##_image *image, int n_rows,	\
+	int n_cols, DeVAS_Resample_Filter filter )			\
+/*									\
+ * As the DeVAS version, on the TT row pointers.			\
+ */									\
+{									\
+    TT_##TYPE##_image	*resampled;					\
+									\
+    if ( ( n_rows < 1 ) || ( n_cols < 1 ) ) {				\
+	fprintf ( stderr, "TT_" #TYPE "_image_resample: invalid size!\n" ); \
+	exit ( EXIT_FAILURE );						\
+    }									\
+									\
+    resampled = TT_##TYPE##_image_new ( n_rows, n_cols );		\
+									\
+    DeVAS_resample_rows ( (void **) image->data, TT_image_n_rows ( image ), \
+	    TT_image_n_cols ( image ), LOAD, (void **) resampled->data,	\
+	    n_rows, n_cols, STORE, CHANNELS, filter );			\
+									\
+    TT_image_modified ( resampled );					\
+									\
+    return ( resampled );						\
+}
+
+DeVAS_TT_IMAGE_RESAMPLE ( gray, 1, DeVAS_resample_load_uint8,
+	DeVAS_resample_store_uint8 )
+DeVAS_TT_IMAGE_RESAMPLE ( float, 1, DeVAS_resample_load_float,
+	DeVAS_resample_store_float )
+DeVAS_TT_IMAGE_RESAMPLE ( RGB, 3, DeVAS_resample_load_uint8,
+	DeVAS_resample_store_uint8 )
+DeVAS_TT_IMAGE_RESAMPLE ( RGBf, 3, DeVAS_resample_load_float,
+	DeVAS_resample_store_float )
@@ -0,0 +1,95 @@
+/*
+ * Zero-copy adapters between DeVAS images (devas-image.h) and TT images
+ * (tifftoolsimage.h) with the same pixel layout.
+ *
+ * The adapted image shares the pixel storage of the original.  Storage
+ * is reference counted across both image systems, so the two image
+ * objects can be deleted in either order with the usual
+ * <type>_image_delete functions.  Pixels written through one are seen
+ * through the other.
+ *
+ *   TT_<type>_image *DeVAS_<type>_image_as_TT ( DeVAS_<type>_image * )
+ *
+ *   DeVAS_<type>_image *TT_<type>_image_as_DeVAS ( TT_<type>_image * )
+ *
+ * for <type> = gray, float, RGB, RGBf, XYZ, xyY.
+ *
+ * TT images carry no view, exposure, or description, so a DeVAS image
+ * made from a TT image gets the same defaults as DeVAS_<type>_image_new.
+ *
+ * Cached statistics (see DeVAS_RGBf_image_stats) for TT images:
+ *
+ *   DeVAS_Image_Stats *TT_RGBf_image_stats ( TT_RGBf_image * )
+ *
+ *   TT_image_modified ( <tt_image> )
+ *
+ *	Call after changing pixel values.  If the pixels are shared with
+ *	DeVAS image objects, their statistics are invalidated too.
+ *
+ * Parallel loops (see devas-image-map.h):
+ *
+ *   TT_<type>_image_map, TT_<type>_image_map2, TT_<type>_image_reduce,
+ *   TT_<type>_image_rowband_for
+ *
+ *	for <type> = gray, float, RGB, RGBf, XYZ, xyY.
+ *
+ * Resizing (see devas-resample.h):
+ *
+ *   TT_<type>_image_resample ( <tt_image>, n_rows, n_cols, <filter> )
+ *
+ *	for <type> = gray, float, RGB, RGBf.
+ */
+
+#ifndef __DeVAS_TT_IMAGE_H
+#define __DeVAS_TT_IMAGE_H
+
+#include "devas-image.h"
+#include "tifftoolsimage.h"
+#include "devas-image-map.h"
+#include "devas-resample.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DeVAS_PROTOTYPE_TT_ADAPTERS( TYPE )				\
+TT_##TYPE##_image	*DeVAS_##TYPE##_image_as_TT ( DeVAS_##TYPE##_image *image ); \
+DeVAS_##TYPE##_image	*TT_##TYPE##_image_as_DeVAS ( TT_##TYPE##_image *image );
+
+DeVAS_PROTOTYPE_TT_ADAPTERS ( gray )
+DeVAS_PROTOTYPE_TT_ADAPTERS ( float )
+DeVAS_PROTOTYPE_TT_ADAPTERS ( RGB )
+DeVAS_PROTOTYPE_TT_ADAPTERS ( RGBf )
+DeVAS_PROTOTYPE_TT_ADAPTERS ( XYZ )
+DeVAS_PROTOTYPE_TT_ADAPTERS ( xyY )
+
+void	DeVAS_TT_check_layouts ( void );
+
+#define	TT_image_modified(tt_image)					\
+		DeVAS_TT_modified ( &(tt_image)->stats, (tt_image)->owner,	\
+		    (tt_image)->release )
+
+void	DeVAS_TT_modified ( void **stats, void *owner,
+	    void (*release) ( void *owner ) );
+DeVAS_Image_Stats *TT_RGBf_image_stats ( TT_RGBf_image *image );
+void	TT_RGBf_image_set_stats ( TT_RGBf_image *image,
+	    DeVAS_Image_Stats *stats );
+
+DeVAS_PROTOTYPE_IMAGE_MAP ( TT_gray )
+DeVAS_PROTOTYPE_IMAGE_MAP ( TT_float )
+DeVAS_PROTOTYPE_IMAGE_MAP ( TT_RGB )
+DeVAS_PROTOTYPE_IMAGE_MAP ( TT_RGBf )
+DeVAS_PROTOTYPE_IMAGE_MAP ( TT_XYZ )
+DeVAS_PROTOTYPE_IMAGE_MAP ( TT_xyY )
+
+DeVAS_PROTOTYPE_IMAGE_RESAMPLE ( TT_gray )
+DeVAS_PROTOTYPE_IMAGE_RESAMPLE ( TT_float )
+DeVAS_PROTOTYPE_IMAGE_RESAMPLE ( TT_RGB )
+DeVAS_PROTOTYPE_IMAGE_RESAMPLE ( TT_RGBf )
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __DeVAS_TT_IMAGE_H */
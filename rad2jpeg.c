@@ -3,10 +3,27 @@
  *
  * Radiance values from 0.0 to 1.0 remapped to 8-bit unsigned int using
  * sRGB convention.  Subtleties such as blackpoint and whitepoint are ignored.
+ * --colorspace=DisplayP3 or --colorspace=Rec2020 converts to those
+ * primaries and transfer functions instead, and attaches a matching ICC
+ * profile (see devas-color-space.h).
  *
  * Ignores EXPOSURE record in Radiance header, which is consistent with
  * the Radiance convension that the numeric values in the file are what
  * the file creator thinks are appropriately scaled for display.
+ *
+ * --max-memory=size limits memory use.  Images too big to convert in
+ * memory are converted a band of rows at a time (see devas-memory-budget.h),
+ * with results identical to in-memory conversion.
+ *
+ * --resize=n_rows,n_cols or --ppd=pixels_per_degree resizes the image
+ * before conversion (see devas-resample.h), with --filter=box, bilinear,
+ * or lanczos3 (the default).  --ppd needs a VIEW record in the header.
+ * Neither can be used with --max-memory.
+ *
+ * --preview=N reads the image at 1/N size in each direction, averaging
+ * N x N blocks of pixels as they are decoded, without holding the full
+ * size image in memory (see DeVAS_RGBf_image_preview_from_radiance_stream
+ * in radiance-stream.h).
  */
 
 #include <stdlib.h>
@@ -14,29 +31,39 @@
 #include <math.h>
 #include "devas-image.h"
 #include "radianceIO.h"
+#include "radiance-stream.h"
+#include "devas-memory-budget.h"
+#include "devas-tone.h"
+#include "devas-color-space.h"
 #include "devas-jpeg.h"
 #include "iccjpeg.h"
-#include "devas-sRGB.h"
-#include "sRGB_radiance.h"
+#include "devas-resample.h"
 #include "radiance/color.h"
 #include "radiance-conversion-version.h"
 #include "devas-license.h"
 
-#define GLARE_LEVEL_RATIO	5.0	/* RADIANCE identifies glare sources */
-					/* as being brighter than 7 times the */
-					/* average luminance level. This is */
-					/* slightly more conservative.  */
+#define	JPEG_BYTES_PER_COLUMN	( 2 * 3 * 16 )	/* libjpeg MCU row buffers */
 
 char	*Usage =
-	    "rad2jpeg [--exposure=stops] [--autoadjust] input.hdr output.jpg";
+	    "rad2jpeg [--exposure=stops] [--autoadjust] [--max-memory=size]"
+	    "\n\t[--colorspace=sRGB|DisplayP3|Rec2020]"
+	    "\n\t[--resize=n_rows,n_cols] [--ppd=pixels_per_degree]"
+	    " [--filter=box|bilinear|lanczos3]"
+	    "\n\t[--preview=N]"
+	    "\n\tinput.hdr output.jpg";
 int	args_needed = 2;
 
 #include "sRGB_IEC61966-2-1_black_scaled.c"	/* hardwired binary profile */
 
-double	find_glare_threshold ( DeVAS_RGBf_image *image );
-double	fmax3 ( double v1, double v2, double v3 );
-void	DeVAS_RGBf_rescale ( DeVAS_RGBf_image *image, float new_max,
-	    float new_min );
+void	RGB_image_to_filename ( char *filename, DeVAS_RGB_image *image,
+	    char *comment, const DeVAS_Color_Space *color_space );
+void	convert_in_bands ( DeVAS_Radiance_Stream *stream,
+	    DeVAS_Memory_Plan plan, COLORMAT radrgb2outputmat,
+	    const DeVAS_Color_Space *color_space,
+	    int autoadjust_flag, int exposure_flag, double exposure_adjust,
+	    char *filename, char *new_description );
+DeVAS_RGBf_image *resize ( DeVAS_RGBf_image *image, int n_rows, int n_cols,
+	    double ppd, DeVAS_Resample_Filter filter );
 
 int
 main ( int argc, char *argv[] )
@@ -46,18 +73,27 @@ main ( int argc, char *argv[] )
     double	    exposure_adjust = 1.0;
     int		    autoadjust_flag = FALSE;
     float	    adjust_max;
+    int		    max_memory_flag = FALSE;
+    size_t	    max_memory;
+    DeVAS_Radiance_Stream *stream;
+    DeVAS_Memory_Plan plan;
     DeVAS_RGBf_image *input_image;
     DeVAS_RGB_image  *sRGB_image;
-    int		    row, col;
+    DeVAS_Tone_Pipeline primaries;
+    DeVAS_Tone_Pipeline tone;
     char	    *new_description = NULL;
-    RGBPRIMS	    radiance_prims = STDPRIMS;
-    RGBPRIMS	    sRGB_prims = sRGBPRIMS;
-    COLORMAT	    radrgb2sRGBmat;
-    COLOR	    radiance_pixel_in;
-    COLOR	    radiance_pixel_out;
-    DeVAS_RGBf	    DeVAS_pixel;
+    const DeVAS_Color_Space *color_space;
+    int		    resize_flag = FALSE;
+    int		    resize_n_rows = 0, resize_n_cols = 0;
+    double	    ppd = 0.0;
+    DeVAS_Resample_Filter filter = DeVAS_filter_lanczos3;
+    int		    preview_factor = 0;
+    char	    *end;
+    COLORMAT	    radrgb2outputmat;
     int		    argpt = 1;
 
+    color_space = DeVAS_color_space_lookup ( "sRGB" );
+
     while ( ( ( argc - argpt ) >= 1 ) && ( argv[argpt][0] == '-' ) ) {
 	if ( strcmp ( argv[argpt], "-" ) == 0 ) {
 	    break;	/* read from stdin */
@@ -75,6 +111,72 @@ main ( int argc, char *argv[] )
 		( strcmp ( argv[argpt], "-autoadjust" ) == 0 ) ) {
 	    autoadjust_flag = TRUE;
 	    argpt++;
+	} else if ( ( strncmp ( argv[argpt], "--max-memory=",
+			strlen ( "--max-memory=" ) ) == 0 ) ||
+		( strncmp ( argv[argpt], "-max-memory=",
+			    strlen ( "-max-memory=" ) ) == 0 ) ) {
+	    if ( !DeVAS_parse_memory_size ( strchr ( argv[argpt], '=' ) + 1,
+			&max_memory ) ) {
+		fprintf ( stderr, "invalid memory size (%s)!\n", argv[argpt] );
+		return ( EXIT_FAILURE );	/* error return */
+	    }
+	    max_memory_flag = TRUE;
+	    argpt++;
+	} else if ( ( strncmp ( argv[argpt], "--colorspace=",
+			strlen ( "--colorspace=" ) ) == 0 ) ||
+		( strncmp ( argv[argpt], "-colorspace=",
+			    strlen ( "-colorspace=" ) ) == 0 ) ) {
+	    color_space = DeVAS_color_space_lookup ( strchr ( argv[argpt],
+			'=' ) + 1 );
+	    if ( color_space == NULL ) {
+		fprintf ( stderr, "unknown color space (%s)!\n", argv[argpt] );
+		return ( EXIT_FAILURE );	/* error return */
+	    }
+	    argpt++;
+	} else if ( ( strncmp ( argv[argpt], "--resize=",
+			strlen ( "--resize=" ) ) == 0 ) ||
+		( strncmp ( argv[argpt], "-resize=",
+			    strlen ( "-resize=" ) ) == 0 ) ) {
+	    if ( !DeVAS_resample_parse_size ( strchr ( argv[argpt], '=' ) + 1,
+			&resize_n_rows, &resize_n_cols ) ) {
+		fprintf ( stderr, "invalid image size (%s)!\n", argv[argpt] );
+		return ( EXIT_FAILURE );	/* error return */
+	    }
+	    resize_flag = TRUE;
+	    argpt++;
+	} else if ( ( strncmp ( argv[argpt], "--ppd=",
+			strlen ( "--ppd=" ) ) == 0 ) ||
+		( strncmp ( argv[argpt], "-ppd=",
+			    strlen ( "-ppd=" ) ) == 0 ) ) {
+	    ppd = atof ( strchr ( argv[argpt], '=' ) + 1 );
+	    if ( ppd <= 0.0 ) {
+		fprintf ( stderr, "invalid pixels per degree (%s)!\n",
+			argv[argpt] );
+		return ( EXIT_FAILURE );	/* error return */
+	    }
+	    argpt++;
+	} else if ( ( strncmp ( argv[argpt], "--filter=",
+			strlen ( "--filter=" ) ) == 0 ) ||
+		( strncmp ( argv[argpt], "-filter=",
+			    strlen ( "-filter=" ) ) == 0 ) ) {
+	    if ( !DeVAS_resample_filter_lookup (
+			strchr ( argv[argpt], '=' ) + 1, &filter ) ) {
+		fprintf ( stderr, "unknown filter (%s)!\n", argv[argpt] );
+		return ( EXIT_FAILURE );	/* error return */
+	    }
+	    argpt++;
+	} else if ( ( strncmp ( argv[argpt], "--preview=",
+			strlen ( "--preview=" ) ) == 0 ) ||
+		( strncmp ( argv[argpt], "-preview=",
+			    strlen ( "-preview=" ) ) == 0 ) ) {
+	    preview_factor = strtol ( strchr ( argv[argpt], '=' ) + 1, &end,
+		    10 );
+	    if ( ( preview_factor < 1 ) || ( *end != '\0' ) ) {
+		fprintf ( stderr, "invalid preview factor (%s)!\n",
+			argv[argpt] );
+		return ( EXIT_FAILURE );	/* error return */
+	    }
+	    argpt++;
 
 	/* hidden options */
 	} else if ( strncmp ( argv[argpt], "-description=",
@@ -97,65 +199,96 @@ main ( int argc, char *argv[] )
 	return ( EXIT_FAILURE );        /* error return */
     }
 
-    input_image = DeVAS_RGBf_image_from_radfilename ( argv[argpt++] );
-
-    /* convert to sRGB primaries */
-
-    comprgb2rgbWBmat ( radrgb2sRGBmat, radiance_prims, sRGB_prims );
-
-    for ( row = 0; row < DeVAS_image_n_rows ( input_image ); row++ ) {
-	for ( col = 0; col < DeVAS_image_n_cols ( input_image ); col++ ) {
-	    DeVAS_pixel = DeVAS_image_data ( input_image, row, col );
-
-	    colval ( radiance_pixel_in, RED ) = DeVAS_pixel.red;
-	    colval ( radiance_pixel_in, GRN ) = DeVAS_pixel.green;
-	    colval ( radiance_pixel_in, BLU ) = DeVAS_pixel.blue;
+    if ( resize_flag && ( ppd > 0.0 ) ) {
+	fprintf ( stderr, "can't mix --resize and --ppd!\n" );
+	return ( EXIT_FAILURE );	/* error return */
+    }
+    if ( ( resize_flag || ( ppd > 0.0 ) ) && max_memory_flag ) {
+	fprintf ( stderr, "can't mix --resize or --ppd with --max-memory!\n" );
+	return ( EXIT_FAILURE );	/* error return */
+    }
+    if ( ( preview_factor > 0 ) && max_memory_flag ) {
+	fprintf ( stderr, "can't mix --preview with --max-memory!\n" );
+	return ( EXIT_FAILURE );	/* error return */
+    }
 
-	    colortrans ( radiance_pixel_out, radrgb2sRGBmat,
-		    radiance_pixel_in );
+    DeVAS_color_space_matrix ( color_space, radrgb2outputmat );
 
-	    DeVAS_pixel.red = colval ( radiance_pixel_out, RED );
-	    DeVAS_pixel.green = colval ( radiance_pixel_out, GRN );
-	    DeVAS_pixel.blue = colval ( radiance_pixel_out, BLU );
+    if ( exposure_flag ) {
+	exposure_adjust = pow ( 2.0, exposure_stops );
+    }
 
-	    DeVAS_image_data ( input_image, row, col ) = DeVAS_pixel;
+    if ( preview_factor > 0 ) {
+	/* block averages, as read */
+	stream = DeVAS_radiance_stream_open ( argv[argpt++] );
+	input_image = DeVAS_RGBf_image_preview_from_radiance_stream ( stream,
+		preview_factor );
+	DeVAS_radiance_stream_close ( stream );
+    } else if ( max_memory_flag ) {
+	/* header gives image size, which determines how to proceed */
+	stream = DeVAS_radiance_stream_open ( argv[argpt++] );
+	plan = DeVAS_plan_memory ( max_memory,
+		DeVAS_radiance_stream_n_rows ( stream ),
+		DeVAS_radiance_stream_n_cols ( stream ),
+		sizeof ( DeVAS_RGBf ) + sizeof ( DeVAS_RGB ),
+		sizeof ( DeVAS_RGBf ),
+		( ( JPEG_BYTES_PER_COLUMN + sizeof ( DeVAS_RGB ) ) *
+		    DeVAS_radiance_stream_n_cols ( stream ) ) +
+		DeVAS_radiance_stream_held_bytes ( stream ),
+		autoadjust_flag ? 2 : 1 );
+	if ( plan.strategy != DeVAS_strategy_in_memory ) {
+	    convert_in_bands ( stream, plan, radrgb2outputmat, color_space,
+		    autoadjust_flag, exposure_flag, exposure_adjust,
+		    argv[argpt++],
+		    new_description );
+	    DeVAS_radiance_stream_close ( stream );
+	    return ( EXIT_SUCCESS );	/* normal exit */
 	}
+	input_image = DeVAS_RGBf_image_from_radiance_stream ( stream );
+	DeVAS_radiance_stream_close ( stream );
+    } else {
+	input_image = DeVAS_RGBf_image_from_radfilename ( argv[argpt++] );
+    }
+
+    if ( resize_flag || ( ppd > 0.0 ) ) {
+	input_image = resize ( input_image, resize_n_rows, resize_n_cols, ppd,
+		filter );
     }
 
+    /*
+     * Conversion to output (normally sRGB) primaries, rescaling, exposure
+     * adjustment, and 8-bit/color non-linear encoding are done in a single
+     * pass, except that --autoadjust needs statistics of the image in the
+     * output primaries first (collected in the same pass as the
+     * conversion).
+     */
+    DeVAS_tone_pipeline_init ( &primaries );
+    DeVAS_tone_add_matrix ( &primaries, radrgb2outputmat );
+
+    DeVAS_tone_pipeline_init ( &tone );
+    DeVAS_tone_set_transfer ( &tone, color_space->transfer );
     if ( autoadjust_flag ) {
-	adjust_max = find_glare_threshold ( input_image );
-	if ( adjust_max > 0.0 ) {
-	    DeVAS_RGBf_rescale ( input_image, adjust_max, 0 );
+	DeVAS_tone_RGBf_image ( &primaries, input_image, TRUE );
+	adjust_max = DeVAS_image_stats_glare_threshold (
+		DeVAS_RGBf_image_stats ( input_image ) );
+	if ( ( adjust_max > 0.0 ) && !DeVAS_tone_add_stats_rescale ( &tone,
+		    DeVAS_RGBf_image_stats ( input_image ), adjust_max, 0 ) ) {
+	    fprintf ( stderr,
+		    "DeVAS_RGBf_rescale: no variability in values "
+		    "(warning)\n" );
 	}
+    } else {
+	DeVAS_tone_add_matrix ( &tone, radrgb2outputmat );
     }
 
     if ( exposure_flag ) {
-	exposure_adjust = pow ( 2.0, exposure_stops );
-	for ( row = 0; row < DeVAS_image_n_rows ( input_image ); row++ ) {
-	    for ( col = 0; col < DeVAS_image_n_cols ( input_image ); col++ ) {
-		DeVAS_image_data ( input_image, row, col ).red *=
-		    					exposure_adjust;
-		DeVAS_image_data ( input_image, row, col ).green *=
-		   					exposure_adjust;
-		DeVAS_image_data ( input_image, row, col ).blue *=
-		    					exposure_adjust;
-	    }
-	}
+	DeVAS_tone_add_scale ( &tone, exposure_adjust );
     }
 
-    /* convert to 8-bit/color using sRGB non-linear encoding */
-    sRGB_image = DeVAS_RGB_image_new ( DeVAS_image_n_rows ( input_image ),
-	    DeVAS_image_n_cols ( input_image ) );
+    sRGB_image = DeVAS_tone_RGBf_image_to_sRGB ( &tone, input_image );
 
-    for ( row = 0; row < DeVAS_image_n_rows ( input_image ); row++ ) {
-	for ( col = 0; col < DeVAS_image_n_cols ( input_image ); col++ ) {
-	    DeVAS_image_data ( sRGB_image, row, col ) =
-		RGBf_to_sRGB ( DeVAS_image_data ( input_image, row, col ) );
-	}
-    }
-
-    DeVAS_RGB_image_to_filename_jpg ( argv[argpt++], sRGB_image,
-	    new_description );
+    RGB_image_to_filename ( argv[argpt++], sRGB_image, new_description,
+	    color_space );
 
     DeVAS_RGB_image_delete ( sRGB_image );
     DeVAS_RGBf_image_delete ( input_image );
@@ -163,147 +296,177 @@ main ( int argc, char *argv[] )
     return ( EXIT_SUCCESS );	/* normal exit */
 }
 
-double
-find_glare_threshold ( DeVAS_RGBf_image *image )
+void
+RGB_image_to_filename ( char *filename, DeVAS_RGB_image *image,
+	char *comment, const DeVAS_Color_Space *color_space )
 /*
- * Suggests a luminance level above which pixel should be considered
- * a glare source.  (This version uses maximum over R, G, and B, instead 
- * of luminance.)
- *
- * Uses a variant of the RADIANCE glare identification heuristic.  First,
- * average luminance is computed and used to set a preliminary glare
- * threshold value.  This average is not a robust estimator, since it is
- * strongly affected by very bright glare pixels or glare pixels covering
- * a large portion of the image.  To compensate for this, a second pass
- * is done in which a revised average luminance is computed based only on
- * pixels <= the preliminary glare threshold.  This revised average luminance
- * is then used to compute a revised glare threshold, which is returned as
- * the value of the function.
+ * As DeVAS_RGB_image_to_filename_jpg, but with the ICC profile for
+ * color_space (see devas-color-space.h).
  */
 {
-    int		    row, col;
-    double	    max_pixel_value;
-    double	    max_value;
-    double	    average_value_initial;
-    double	    glare_cutoff_initial;
-
-    max_value = average_value_initial = 0.0;
-
-    for ( row = 0; row < DeVAS_image_n_rows ( image ); row++ ) {
-	for ( col = 0; col < DeVAS_image_n_cols ( image ); col++ ) {
-	    max_pixel_value = fmax3 ( DeVAS_image_data (image, row, col ) . red,
-		    DeVAS_image_data (image, row, col ) . green,
-		    DeVAS_image_data (image, row, col ) . blue );
-	    if ( max_value < max_pixel_value ) {
-		max_value = max_pixel_value;
-	    }
-
-	    average_value_initial += max_pixel_value;
-	}
+    FILE		*output;
+    DeVAS_JPEG_writer	*writer;
+    unsigned char	*profile;
+    unsigned int	profile_length;
+    int			row;
+
+    profile = DeVAS_color_space_icc_profile ( color_space, &profile_length );
+    if ( profile == NULL ) {
+	DeVAS_RGB_image_to_filename_jpg ( filename, image, comment );
+	return;
     }
 
-    average_value_initial /=
-	( ((double) DeVAS_image_n_rows ( image ) ) *
-	    ((double) DeVAS_image_n_cols ( image ) ) );
-    glare_cutoff_initial = GLARE_LEVEL_RATIO * average_value_initial;
-
-    if ( glare_cutoff_initial >= max_value ) {
-	/* no need for glare source clipping */
-	return ( max_value );
+    output = fopen ( filename, "wb" );
+    if ( output == NULL ) {
+	perror ( filename );
+	exit ( EXIT_FAILURE );
     }
-
-    max_value = 0.0;
+    writer = DeVAS_RGB_open_write_jpg_profile ( output,
+	    DeVAS_image_n_rows ( image ), DeVAS_image_n_cols ( image ),
+	    comment, profile, profile_length );
 
     for ( row = 0; row < DeVAS_image_n_rows ( image ); row++ ) {
-	for ( col = 0; col < DeVAS_image_n_cols ( image ); col++ ) {
-	    max_pixel_value = fmax3 ( DeVAS_image_data (image, row, col ) . red,
-		    DeVAS_image_data (image, row, col ) . green,
-		    DeVAS_image_data (image, row, col ) . blue );
-	    if ( max_pixel_value <= glare_cutoff_initial ) {
-		if ( max_value < max_pixel_value ) {
-		    max_value = max_pixel_value;
-		}
-	    }
-	}
+	DeVAS_RGB_write_jpg ( writer, &DeVAS_image_data ( image, row, 0 ) );
     }
 
-    return ( max_value );
-}
+    DeVAS_RGB_close_write_jpg ( writer );
+    fclose ( output );
 
-double
-fmax3 ( double v1, double v2, double v3 )
-{
-    return ( fmax ( v1, fmax ( v2, v3 ) ) );
+    free ( profile );
 }
 
 void
-DeVAS_RGBf_rescale ( DeVAS_RGBf_image *image, float new_max, float new_min )
+convert_in_bands ( DeVAS_Radiance_Stream *stream, DeVAS_Memory_Plan plan,
+	COLORMAT radrgb2outputmat, const DeVAS_Color_Space *color_space,
+	int autoadjust_flag, int exposure_flag, double exposure_adjust,
+	char *filename, char *new_description )
+/*
+ * Same conversion as in main, plan.band_rows rows at a time.  --autoadjust
+ * needs statistics over the whole image before the first output row can
+ * be produced, and so takes two passes over the stream.
+ */
 {
-    int	    row, col;
-    int	    n_rows, n_cols;
-    double  old_max, old_min;
-    double  old_max_red, old_max_green, old_max_blue;
-    double  old_min_red, old_min_green, old_min_blue;
-    double  rescale;
-
-    n_rows = DeVAS_image_n_rows ( image );
-    n_cols = DeVAS_image_n_cols ( image );
-
-    old_max_red = old_min_red = DeVAS_image_data ( image, 0, 0 ).red;
-    old_max_green = old_min_green = DeVAS_image_data ( image, 0, 0 ).green;
-    old_max_blue = old_min_blue = DeVAS_image_data ( image, 0, 0 ).blue;
-
-    for ( row = 0; row < n_rows; row++ ) {
-	for ( col = 0; col < n_cols; col++ ) {
-	    old_max_red =
-		fmax ( old_max_red, DeVAS_image_data ( image, row, col ).red );
-	    old_max_green =
-		fmax ( old_max_green,
-			DeVAS_image_data ( image, row, col ).green );
-	    old_max_blue =
-		fmax ( old_max_blue, DeVAS_image_data ( image, row, col ).blue );
-
-	    old_min_red =
-		fmin ( old_min_red, DeVAS_image_data ( image, row, col ).red );
-	    old_min_green =
-		fmin ( old_min_green,
-			DeVAS_image_data ( image, row, col ).green );
-	    old_min_blue =
-		fmin ( old_min_blue, DeVAS_image_data ( image, row, col ).blue );
-	}
+    DeVAS_RGBf_image	*band;
+    DeVAS_RGBf_image	*rows;
+    DeVAS_RGB		*sRGB_row;
+    DeVAS_Image_Stats	stats;
+    DeVAS_Tone_Pipeline	primaries;
+    DeVAS_Tone_Pipeline	tone;
+    DeVAS_JPEG_writer	*writer;
+    unsigned char	*profile;
+    unsigned int	profile_length;
+    FILE		*output;
+    float		adjust_max = 0.0;
+    int			row;
+
+    if ( plan.strategy == DeVAS_strategy_packed ) {
+	DeVAS_radiance_stream_retain ( stream, DeVAS_retain_packed );
+    } else if ( plan.strategy == DeVAS_strategy_compressed ) {
+	DeVAS_radiance_stream_retain ( stream, DeVAS_retain_compressed );
+	DeVAS_radiance_stream_retain_limit ( stream, plan.retain_bytes );
+    } else if ( plan.strategy == DeVAS_strategy_file_backed ) {
+	DeVAS_radiance_stream_retain ( stream, DeVAS_retain_file );
     }
 
-    old_max = fmax ( old_max_red, fmax ( old_max_green, old_max_blue ) );
-    old_min = fmin ( old_min_red, fmin ( old_min_green, old_min_blue ) );
+    band = DeVAS_RGBf_image_new ( plan.band_rows,
+	    DeVAS_radiance_stream_n_cols ( stream ) );
+
+    DeVAS_tone_pipeline_init ( &primaries );
+    DeVAS_tone_add_matrix ( &primaries, radrgb2outputmat );
+
+    if ( autoadjust_flag ) {
+	/* statistics for the glare threshold and DeVAS_RGBf_rescale */
+	DeVAS_image_stats_clear ( &stats );
+	while ( ( rows = DeVAS_radiance_stream_read_band ( stream, band ) )
+		!= NULL ) {
+	    DeVAS_tone_rows ( &primaries, rows->data, rows->data,
+		    DeVAS_image_n_rows ( rows ), DeVAS_image_n_cols ( rows ),
+		    &stats );
+	    DeVAS_RGBf_image_delete ( rows );
+	}
+	DeVAS_radiance_stream_rewind ( stream );
+
+	adjust_max = DeVAS_image_stats_glare_threshold ( &stats );
+    }
 
-    if ( old_max == old_min ) {
+    /* as in main, but from the unconverted pixels */
+    DeVAS_tone_pipeline_init ( &tone );
+    DeVAS_tone_set_transfer ( &tone, color_space->transfer );
+    DeVAS_tone_add_matrix ( &tone, radrgb2outputmat );
+    if ( autoadjust_flag && ( adjust_max > 0.0 ) &&
+	    !DeVAS_tone_add_stats_rescale ( &tone, &stats, adjust_max, 0 ) ) {
 	fprintf ( stderr,
 		"DeVAS_RGBf_rescale: no variability in values (warning)\n" );
+    }
+    if ( exposure_flag ) {
+	DeVAS_tone_add_scale ( &tone, exposure_adjust );
+    }
 
-	for ( row = 0; row < n_rows; row++ ) {
-	    for ( col = 0; col < n_cols; col++ ) {
-		DeVAS_image_data ( image, row, col ).red =
-		    DeVAS_image_data ( image, row, col ).green =
-		    DeVAS_image_data ( image, row, col ).blue =
-		   	 0.5 * ( new_max + new_min );
-	    }
+    output = fopen ( filename, "wb" );
+    if ( output == NULL ) {
+	perror ( filename );
+	exit ( EXIT_FAILURE );
+    }
+    profile = DeVAS_color_space_icc_profile ( color_space, &profile_length );
+    writer = DeVAS_RGB_open_write_jpg_profile ( output,
+	    DeVAS_radiance_stream_n_rows ( stream ),
+	    DeVAS_radiance_stream_n_cols ( stream ), new_description,
+	    profile, profile_length );
+
+    sRGB_row = (DeVAS_RGB *) malloc ( DeVAS_radiance_stream_n_cols ( stream )
+	    * sizeof ( DeVAS_RGB ) );
+    if ( sRGB_row == NULL ) {
+	fprintf ( stderr, "convert_in_bands: malloc failed!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    while ( ( rows = DeVAS_radiance_stream_read_band ( stream, band ) )
+	    != NULL ) {
+	for ( row = 0; row < DeVAS_image_n_rows ( rows ); row++ ) {
+	    DeVAS_tone_row_to_sRGB ( &tone, rows->data[row], sRGB_row,
+		    DeVAS_image_n_cols ( rows ) );
+	    DeVAS_RGB_write_jpg ( writer, sRGB_row );
 	}
-	return;
+
+	DeVAS_RGBf_image_delete ( rows );
     }
 
-    rescale = ( new_max - new_min ) / ( old_max - old_min );
-
-    for ( row = 0; row < n_rows; row++ ) {
-	for ( col = 0; col < n_cols; col++ ) {
-	    DeVAS_image_data ( image, row, col ).red = ( rescale *
-		    ( DeVAS_image_data ( image, row, col ).red - old_min ) ) +
-				new_min;
-	    DeVAS_image_data ( image, row, col ).green = ( rescale *
-		    ( DeVAS_image_data ( image, row, col ).green - old_min ) ) +
-				new_min;
-	    DeVAS_image_data ( image, row, col ).blue = ( rescale *
-		    ( DeVAS_image_data ( image, row, col ).blue - old_min ) ) +
-				new_min;
+    DeVAS_RGB_close_write_jpg ( writer );
+    fclose ( output );
+
+    free ( profile );
+    free ( sRGB_row );
+    DeVAS_RGBf_image_delete ( band );
+}
+
+DeVAS_RGBf_image *
+resize ( DeVAS_RGBf_image *image, int n_rows, int n_cols, double ppd,
+	DeVAS_Resample_Filter filter )
+/*
+ * --resize (n_rows and n_cols, one possibly 0) or --ppd.  Deletes image.
+ */
+{
+    DeVAS_RGBf_image	*resized;
+
+    if ( ppd > 0.0 ) {
+	if ( !DeVAS_resample_size_for_ppd ( &DeVAS_image_view ( image ),
+		    DeVAS_image_n_rows ( image ), DeVAS_image_n_cols ( image ),
+		    ppd, &n_rows, &n_cols ) ) {
+	    fprintf ( stderr, "--ppd needs a VIEW with a field of view!\n" );
+	    exit ( EXIT_FAILURE );
 	}
+    } else {
+	DeVAS_resample_size ( DeVAS_image_n_rows ( image ),
+		DeVAS_image_n_cols ( image ), &n_rows, &n_cols );
     }
+
+    if ( ( n_rows == DeVAS_image_n_rows ( image ) ) &&
+	    ( n_cols == DeVAS_image_n_cols ( image ) ) ) {
+	return ( image );	/* already the right size */
+    }
+
+    resized = DeVAS_RGBf_image_resample ( image, n_rows, n_cols, filter );
+    DeVAS_RGBf_image_delete ( image );
+
+    return ( resized );
 }
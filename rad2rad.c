@@ -0,0 +1,303 @@
+/*
+ * Lossless exposure shift, crop, and flip of a RADIANCE image file.
+ *
+ * Works directly on the COLR (rgbe or xyze) scanlines, which are never
+ * converted to floating point, so pixels that aren't changed come out
+ * bit-for-bit the same.  --exposure must be a whole number of stops: a
+ * change by a power of two is an addition to the shared exponent.  The
+ * EXPOSURE record in the header is updated to match, as RADIANCE pfilt
+ * does.  --crop keeps the region of n_rows x n_cols pixels starting at
+ * (first_row, first_col), counting from 0 at the top left, and adjusts
+ * the VIEW record to match.  Flips apply after cropping.
+ *
+ * The image is processed a row at a time, except that --flip-vertical
+ * keeps the output rows, as 4 byte/pixel COLR values, until the end.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include "radiance-header.h"
+#include "radiance-stream.h"
+#include "radiance-colr.h"
+#include "devas-memory.h"
+#include "radiance/color.h"
+#include "radiance-conversion-version.h"
+#include "devas-license.h"
+
+char	*Usage =
+	    "rad2rad [--exposure=stops] "
+	    "[--crop=first_row,first_col,n_rows,n_cols]"
+	    "\n\t[--flip-horizontal] [--flip-vertical] input.hdr output.hdr";
+int	args_needed = 2;
+
+/* the whole range of the shared exponent, so larger shifts gain nothing */
+#define	MAX_EXPOSURE_STOPS	255
+
+int	parse_crop ( char *spec, int *first_row, int *first_col, int *n_rows,
+	    int *n_cols );
+void	write_scanline ( FILE *output, COLR *scanline, int n_cols,
+	    unsigned char *encoded );
+
+int
+main ( int argc, char *argv[] )
+{
+    int		    exposure_stops = 0;
+    long	    stops;
+    char	    *end;
+    int		    crop_flag = FALSE;
+    int		    first_row = 0, first_col = 0;
+    int		    n_rows, n_cols;
+    int		    end_row;
+    int		    flip_horizontal_flag = FALSE;
+    int		    flip_vertical_flag = FALSE;
+    DeVAS_Radiance_Stream *stream;
+    VIEW	    view;
+    int		    exposure_set;
+    double	    exposure;
+    FILE	    *output;
+    COLR	    *scanline;
+    COLR	    *kept_rows = NULL;
+    unsigned char   *encoded;
+    int		    row;
+    long	    n_inexact;
+    int		    argpt = 1;
+
+    while ( ( ( argc - argpt ) >= 1 ) && ( argv[argpt][0] == '-' ) ) {
+	if ( strcmp ( argv[argpt], "-" ) == 0 ) {
+	    break;	/* read from stdin */
+	} else if ( ( strncmp ( argv[argpt], "--exposure=",
+			strlen ( "--exposure=" ) ) == 0 ) ||
+		( strncmp ( argv[argpt], "-exposure=",
+			    strlen ( "-exposure=" ) ) == 0 ) ) {
+	    stops = strtol ( strchr ( argv[argpt], '=' ) + 1, &end, 10 );
+	    if ( ( end == strchr ( argv[argpt], '=' ) + 1 ) ||
+		    ( *end != '\0' ) ) {
+		fprintf ( stderr,
+			"exposure must be a whole number of stops (%s)!\n",
+			argv[argpt] );
+		return ( EXIT_FAILURE );	/* error return */
+	    }
+	    if ( ( stops > MAX_EXPOSURE_STOPS ) ||
+		    ( stops < -MAX_EXPOSURE_STOPS ) ) {
+		fprintf ( stderr,
+			"exposure must be between %d and %d stops (%s)!\n",
+			-MAX_EXPOSURE_STOPS, MAX_EXPOSURE_STOPS, argv[argpt] );
+		return ( EXIT_FAILURE );	/* error return */
+	    }
+	    exposure_stops = (int) stops;
+	    argpt++;
+	} else if ( ( strncmp ( argv[argpt], "--crop=",
+			strlen ( "--crop=" ) ) == 0 ) ||
+		( strncmp ( argv[argpt], "-crop=",
+			    strlen ( "-crop=" ) ) == 0 ) ) {
+	    if ( !parse_crop ( strchr ( argv[argpt], '=' ) + 1, &first_row,
+			&first_col, &n_rows, &n_cols ) ) {
+		fprintf ( stderr, "invalid crop region (%s)!\n", argv[argpt] );
+		return ( EXIT_FAILURE );	/* error return */
+	    }
+	    crop_flag = TRUE;
+	    argpt++;
+	} else if ( ( strcmp ( argv[argpt], "--flip-horizontal" ) == 0 ) ||
+		( strcmp ( argv[argpt], "-flip-horizontal" ) == 0 ) ) {
+	    flip_horizontal_flag = TRUE;
+	    argpt++;
+	} else if ( ( strcmp ( argv[argpt], "--flip-vertical" ) == 0 ) ||
+		( strcmp ( argv[argpt], "-flip-vertical" ) == 0 ) ) {
+	    flip_vertical_flag = TRUE;
+	    argpt++;
+	} else {
+	    fprintf ( stderr, "unknown argument!\n" );
+	    return ( EXIT_FAILURE );	/* error return */
+	}
+    }
+
+    if ( ( argc - argpt ) != args_needed ) {
+	fprintf ( stderr, "%s\n", Usage );
+	return ( EXIT_FAILURE );        /* error return */
+    }
+
+    stream = DeVAS_radiance_stream_open ( argv[argpt++] );
+
+    if ( crop_flag ) {
+	/* compared without adding, which could overflow */
+	if ( ( n_rows > DeVAS_radiance_stream_n_rows ( stream ) ) ||
+		( first_row > DeVAS_radiance_stream_n_rows ( stream ) -
+		  n_rows ) ||
+		( n_cols > DeVAS_radiance_stream_n_cols ( stream ) ) ||
+		( first_col > DeVAS_radiance_stream_n_cols ( stream ) -
+		  n_cols ) ) {
+	    fprintf ( stderr, "crop region outside of %d x %d image!\n",
+		    DeVAS_radiance_stream_n_rows ( stream ),
+		    DeVAS_radiance_stream_n_cols ( stream ) );
+	    return ( EXIT_FAILURE );	/* error return */
+	}
+    } else {
+	n_rows = DeVAS_radiance_stream_n_rows ( stream );
+	n_cols = DeVAS_radiance_stream_n_cols ( stream );
+    }
+    end_row = first_row + n_rows;	/* within the image, so no overflow */
+
+    view = stream->view;
+    if ( crop_flag && !DeVAS_view_crop ( &view,
+		DeVAS_radiance_stream_n_rows ( stream ),
+		DeVAS_radiance_stream_n_cols ( stream ), first_row, first_col,
+		n_rows, n_cols ) ) {
+	fprintf ( stderr,
+		"can't crop this view type, VIEW dropped (warning)\n" );
+	view.type = 0;
+    }
+    if ( flip_horizontal_flag && flip_vertical_flag ) {
+	DeVAS_view_rotate_180 ( &view );
+    } else if ( ( flip_horizontal_flag || flip_vertical_flag ) &&
+	    ( view.type != 0 ) ) {
+	fprintf ( stderr,
+		"mirror image has no view, VIEW dropped (warning)\n" );
+	view.type = 0;
+    }
+
+    exposure_set = stream->exposure_set || ( exposure_stops != 0 );
+    exposure = ( stream->exposure_set ? stream->exposure : 1.0 ) *
+	ldexp ( 1.0, exposure_stops );
+
+    if ( strcmp ( argv[argpt], "-" ) == 0 ) {
+	output = stdout;
+    } else {
+	output = fopen ( argv[argpt], "wb" );
+	if ( output == NULL ) {
+	    perror ( argv[argpt] );
+	    return ( EXIT_FAILURE );	/* error return */
+	}
+    }
+    argpt++;
+
+    DeVAS_write_radiance_header ( output, n_rows, n_cols,
+	    stream->color_format, view, exposure_set, exposure,
+	    stream->description );
+
+    scanline = (COLR *) malloc ( DeVAS_radiance_stream_n_cols ( stream ) *
+	    sizeof ( COLR ) );
+    encoded = (unsigned char *) malloc ( DeVAS_rle_max_size ( n_cols ) );
+    if ( ( scanline == NULL ) || ( encoded == NULL ) ) {
+	fprintf ( stderr, "rad2rad: malloc failed!\n" );
+	return ( EXIT_FAILURE );	/* error return */
+    }
+    if ( flip_vertical_flag ) {
+	kept_rows = (COLR *) malloc ( ( (size_t) n_rows ) * n_cols *
+		sizeof ( COLR ) );
+	if ( kept_rows == NULL ) {
+	    fprintf ( stderr, "rad2rad: malloc failed!\n" );
+	    return ( EXIT_FAILURE );	/* error return */
+	}
+	DeVAS_memory_allocated ( "COLR", ( (size_t) n_rows ) * n_cols *
+		sizeof ( COLR ) );
+    }
+
+    /* rows below the region are never read */
+    n_inexact = 0;
+    for ( row = 0; row < end_row; row++ ) {
+	DeVAS_radiance_stream_read_COLR ( stream, scanline );
+	if ( row < first_row ) {
+	    continue;
+	}
+
+	n_inexact += DeVAS_colr_shift_exposure ( scanline + first_col,
+		n_cols, exposure_stops );
+	if ( flip_horizontal_flag ) {
+	    DeVAS_colr_flip ( scanline + first_col, n_cols );
+	}
+
+	if ( flip_vertical_flag ) {
+	    memcpy ( kept_rows +
+		    ( (size_t) ( end_row - 1 - row ) ) * n_cols,
+		    scanline + first_col, n_cols * sizeof ( COLR ) );
+	} else {
+	    write_scanline ( output, scanline + first_col, n_cols, encoded );
+	}
+    }
+
+    if ( flip_vertical_flag ) {
+	for ( row = 0; row < n_rows; row++ ) {
+	    write_scanline ( output, kept_rows + ( (size_t) row ) * n_cols,
+		    n_cols, encoded );
+	}
+	free ( kept_rows );
+	DeVAS_memory_freed ( "COLR", ( (size_t) n_rows ) * n_cols *
+		sizeof ( COLR ) );
+    }
+
+    if ( n_inexact > 0 ) {
+	fprintf ( stderr,
+		"%ld pixels out of range after exposure shift (warning)\n",
+		n_inexact );
+    }
+
+    if ( fflush ( output ) != 0 ) {
+	perror ( "rad2rad" );
+	return ( EXIT_FAILURE );	/* error return */
+    }
+    if ( output != stdout ) {
+	fclose ( output );
+    }
+
+    free ( scanline );
+    free ( encoded );
+    DeVAS_radiance_stream_close ( stream );
+
+    return ( EXIT_SUCCESS );	/* normal exit */
+}
+
+int
+parse_crop ( char *spec, int *first_row, int *first_col, int *n_rows,
+	int *n_cols )
+/*
+ * first_row,first_col,n_rows,n_cols
+ *
+ * Each must be a whole number that fits in an int, the first two at
+ * least 0 and the sizes at least 1.
+ */
+{
+    int	    *values[4];
+    int	    minimum;
+    long    value;
+    char    *end;
+    int	    i;
+
+    values[0] = first_row;
+    values[1] = first_col;
+    values[2] = n_rows;
+    values[3] = n_cols;
+
+    for ( i = 0; i < 4; i++ ) {
+	value = strtol ( spec, &end, 10 );
+	if ( ( end == spec ) || ( *end != ( ( i < 3 ) ? ',' : '\0' ) ) ) {
+	    return ( FALSE );
+	}
+	minimum = ( i < 2 ) ? 0 : 1;
+	if ( ( value < minimum ) || ( value > INT_MAX ) ) {
+	    return ( FALSE );
+	}
+	*values[i] = (int) value;
+	spec = end + 1;
+    }
+
+    return ( TRUE );
+}
+
+void
+write_scanline ( FILE *output, COLR *scanline, int n_cols,
+	unsigned char *encoded )
+/*
+ * Same bytes as RADIANCE fwritecolrs, a scanline at a time.
+ */
+{
+    int	    n_bytes;
+
+    n_bytes = DeVAS_rle_encode ( scanline, n_cols, encoded );
+    if ( fwrite ( encoded, 1, n_bytes, output ) != n_bytes ) {
+	perror ( "rad2rad" );
+	exit ( EXIT_FAILURE );
+    }
+}
@@ -11,12 +11,31 @@
  *
  * --fullrange flag causes output values to be linearly remapped to fill
  *  (almost) all of the available range.
+ *
+ * --hdr=PQ or --hdr=HLG output is 16-bit/color PQ or HLG encoded BT.2020
+ * values computed from absolute luminance (see devas-hdr-transfer.h).
+ *
+ * --max-memory=size limits memory use.  Images too big to convert in
+ * memory are converted a band of rows at a time (see devas-memory-budget.h),
+ * with results identical to in-memory conversion.
+ *
+ * --resize=n_rows,n_cols or --ppd=pixels_per_degree resizes the image
+ * before conversion (see devas-resample.h), with --filter=box, bilinear,
+ * or lanczos3 (the default).  --ppd takes the field of view from the VIEW
+ * record as a perspective view, as for the FOV tags.  Neither can be used
+ * with --max-memory or --hdr.
  */
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
 #include "radiance-tiff.h"
+#include "radiance-stream.h"
+#include "devas-memory-budget.h"
+#include "devas-tone.h"
+#include "devas-hdr-transfer.h"
+#include "devas-tt-image.h"
+#include "devas-resample.h"
 #include "FOV.h"
 #include "TT-sRGB.h"
 #include "sRGB_radiance.h"
@@ -25,16 +44,14 @@
 #include "radiance-conversion-version.h"
 #include "devas-license.h"
 
-#define	GLARE_LEVEL_RATIO	5.0	/* RADIANCE identifies glare sources */
-					/* as being brighter than 7 times the */
-					/* average luminance level. This is */
-					/* slightly more conservative.  */ 
-
 char	*Usage =
 "rad2tiff [--ldr] [--exposure=stops] [--fullrange] [--sRGBencoding]"
     "\n\t[--autoadjust] [--original-units|--photometric-units]"
     "\n\t[--compresszip] [--compresszipp] [--compresslzw] [--compresslzwp]"
-    "\n\t\tinput.hdr output.tif";
+    "\n\t[--max-memory=size] [--hdr=PQ|HLG]"
+    "\n\t[--resize=n_rows,n_cols] [--ppd=pixels_per_degree]"
+    " [--filter=box|bilinear|lanczos3]"
+    "\n\tinput.hdr output.tif";
 int	args_needed = 2;
 
 #include "sRGB_IEC61966-2-1_black_scaled.c"	/* hardwired binary profile */
@@ -55,14 +72,54 @@ typedef	enum { none,
 		compresslzwp
 	    } COMPRESSION;
 
-void	TT_RGBf_rescale ( TT_RGBf_image *image, float new_max, float new_min );
-void	TT_RGBf_invert ( TT_RGBf_image *image );
+#define	TIFF_BYTES_PER_COLUMN	( 2 * sizeof ( TT_RGBf ) )
+				/* strip buffer, compression, output row */
+
+#define	HDR_BAND_ROWS		16	/* --hdr is converted in bands */
+
+typedef struct {		/* conversion settings for convert_in_bands */
+    int		units_flag;	/* --original-units or --photometric-units */
+    double	units_multiplier;
+    int		exposure_flag;
+    double	exposure_adjust;
+    int		invert_flag;
+    int		rescale_flag;
+    int		autoadjust_flag;
+    float	new_max, new_min;	/* for rescale_flag */
+    int		sRGBencoding_flag;
+    int		ldr_flag;
+    int		original_units_flag;
+    int		photometric_units_flag;
+    COMPRESSION	compression_type;
+    char	*new_description;
+} BAND_CONVERSION;
+
+void	add_rescale ( DeVAS_Tone_Pipeline *tone, DeVAS_Image_Stats *stats,
+	    int invert, float new_max, float new_min );
+void	tone_image ( DeVAS_Tone_Pipeline *tone, TT_RGBf_image *image,
+	    int keep_stats );
+void	add_units_and_exposure ( DeVAS_Tone_Pipeline *tone,
+	    BAND_CONVERSION *conversion );
 void	set_compression ( TIFF *file, COMPRESSION compression_type );
-double	find_glare_threshold ( TT_RGBf_image *image );
-double	fmax3 ( double v1, double v2, double v3 );
-TT_RGBf	TT_RGBf_scalar_mult ( TT_RGBf original, double multiplier );
-void	original_units ( TT_RGBf_image *image, RadianceHeader *header );
-void	photometric_units ( TT_RGBf_image *image, RadianceHeader *header );
+void	set_stonits ( TIFF *output, int original_units_flag,
+	    int photometric_units_flag, RadianceHeader *header );
+void	set_description_and_fov ( TIFF *output, char *new_description,
+	    RadianceHeader *header, int n_rows, int n_cols );
+TT_RGBf_image	*next_band ( DeVAS_Radiance_Stream *stream,
+	    DeVAS_RGBf_image *band, DeVAS_Tone_Pipeline *tone,
+	    DeVAS_Image_Stats *stats );
+void	convert_in_bands ( DeVAS_Radiance_Stream *stream,
+	    DeVAS_Memory_Plan plan, BAND_CONVERSION *conversion,
+	    RadianceHeader *header, char *filename );
+void	convert_hdr ( DeVAS_Radiance_Stream *stream,
+	    DeVAS_HDR_Transfer transfer, BAND_CONVERSION *conversion,
+	    RadianceHeader *header, char *filename );
+void	set_header ( RadianceHeader *header, VIEW *view, int exposure_set,
+	    double exposure, char *description );	/* radiance-tiff.c */
+void	set_fov_in_view ( VIEW *view, RadianceHeader *header );
+							/* radiance-tiff.c */
+TT_RGBf_image	*resize ( TT_RGBf_image *image, RadianceHeader *header,
+	    int n_rows, int n_cols, double ppd, DeVAS_Resample_Filter filter );
 
 int
 main ( int argc, char *argv[] )
@@ -70,11 +127,12 @@ main ( int argc, char *argv[] )
     COMPRESSION	    compression_type = none;
     TT_RGBf_image   *input_image;
     TT_RGB_image    *sRGB_image;
+    DeVAS_Tone_Pipeline tone;
     int		    sRGBencoding_flag = FALSE;
     int		    ldr_flag = FALSE;
     int		    exposure_flag = FALSE;
     double	    exposure_stops = 1.0;
-    double	    exposure_adjust;
+    double	    exposure_adjust = 1.0;
     int		    fullrange_flag = FALSE;
     int		    fullrange_invert_flag = FALSE;
     int		    halfrange_flag = FALSE;
@@ -82,19 +140,26 @@ main ( int argc, char *argv[] )
     int		    autoadjust_flag = FALSE;
     int		    original_units_flag = FALSE;
     int		    photometric_units_flag = FALSE;
+    int		    hdr_flag = FALSE;
+    DeVAS_HDR_Transfer hdr_transfer;
+    int		    resize_flag = FALSE;
+    int		    resize_n_rows = 0, resize_n_cols = 0;
+    double	    ppd = 0.0;
+    DeVAS_Resample_Filter filter = DeVAS_filter_lanczos3;
     int		    exposure_flag_count;
     float	    adjust_max;
+    int		    max_memory_flag = FALSE;
+    size_t	    max_memory;
+    DeVAS_Radiance_Stream *stream;
+    DeVAS_Memory_Plan plan;
+    BAND_CONVERSION conversion;
+    DeVAS_RGBf_image *DeVAS_input_image;
     TIFF	    *output;
     RadianceHeader  header;
-    int		    row, col;
-    DeVAS_FOV	    fov;
     char	    *new_description = NULL;
     RGBPRIMS	    radiance_prims = STDPRIMS;
     RGBPRIMS	    sRGB_prims = sRGBPRIMS;
     COLORMAT	    radrgb2sRGBmat;
-    COLOR	    radiance_pixel_in;
-    COLOR	    radiance_pixel_out;
-    TT_RGBf	    TT_pixel;
     int		    argpt = 1;
 
     while ( ( ( argc - argpt ) >= 1 ) && ( argv[argpt][0] == '-' ) ) {
@@ -168,6 +233,61 @@ main ( int argc, char *argv[] )
 	    }
 	    compression_type = compresslzwp;
 	    argpt++;
+	} else if ( ( strncmp ( argv[argpt], "--max-memory=",
+			strlen ( "--max-memory=" ) ) == 0 ) ||
+		( strncmp ( argv[argpt], "-max-memory=",
+			    strlen ( "-max-memory=" ) ) == 0 ) ) {
+	    if ( !DeVAS_parse_memory_size ( strchr ( argv[argpt], '=' ) + 1,
+			&max_memory ) ) {
+		fprintf ( stderr, "invalid memory size (%s)!\n", argv[argpt] );
+		return ( EXIT_FAILURE );	/* error return */
+	    }
+	    max_memory_flag = TRUE;
+	    argpt++;
+	} else if ( ( strncmp ( argv[argpt], "--hdr=",
+			strlen ( "--hdr=" ) ) == 0 ) ||
+		( strncmp ( argv[argpt], "-hdr=",
+			    strlen ( "-hdr=" ) ) == 0 ) ) {
+	    if ( !DeVAS_hdr_transfer_lookup ( strchr ( argv[argpt], '=' ) + 1,
+			&hdr_transfer ) ) {
+		fprintf ( stderr, "unknown HDR encoding (%s)!\n",
+			argv[argpt] );
+		return ( EXIT_FAILURE );	/* error return */
+	    }
+	    hdr_flag = TRUE;
+	    argpt++;
+	} else if ( ( strncmp ( argv[argpt], "--resize=",
+			strlen ( "--resize=" ) ) == 0 ) ||
+		( strncmp ( argv[argpt], "-resize=",
+			    strlen ( "-resize=" ) ) == 0 ) ) {
+	    if ( !DeVAS_resample_parse_size ( strchr ( argv[argpt], '=' ) + 1,
+			&resize_n_rows, &resize_n_cols ) ) {
+		fprintf ( stderr, "invalid image size (%s)!\n", argv[argpt] );
+		return ( EXIT_FAILURE );	/* error return */
+	    }
+	    resize_flag = TRUE;
+	    argpt++;
+	} else if ( ( strncmp ( argv[argpt], "--ppd=",
+			strlen ( "--ppd=" ) ) == 0 ) ||
+		( strncmp ( argv[argpt], "-ppd=",
+			    strlen ( "-ppd=" ) ) == 0 ) ) {
+	    ppd = atof ( strchr ( argv[argpt], '=' ) + 1 );
+	    if ( ppd <= 0.0 ) {
+		fprintf ( stderr, "invalid pixels per degree (%s)!\n",
+			argv[argpt] );
+		return ( EXIT_FAILURE );	/* error return */
+	    }
+	    argpt++;
+	} else if ( ( strncmp ( argv[argpt], "--filter=",
+			strlen ( "--filter=" ) ) == 0 ) ||
+		( strncmp ( argv[argpt], "-filter=",
+			    strlen ( "-filter=" ) ) == 0 ) ) {
+	    if ( !DeVAS_resample_filter_lookup (
+			strchr ( argv[argpt], '=' ) + 1, &filter ) ) {
+		fprintf ( stderr, "unknown filter (%s)!\n", argv[argpt] );
+		return ( EXIT_FAILURE );	/* error return */
+	    }
+	    argpt++;
 
 	    /* hidden options */
 	} else if ( ( strcmp ( argv[argpt], "--fullrangeinvert" ) == 0 ) ||
@@ -202,6 +322,26 @@ main ( int argc, char *argv[] )
 	return ( EXIT_FAILURE );	/* error return */
     }
 
+    if ( hdr_flag && ( ldr_flag || sRGBencoding_flag || autoadjust_flag ||
+		original_units_flag || photometric_units_flag ||
+		fullrange_flag || fullrange_invert_flag || halfrange_flag ||
+		halfrange_invert_flag ) ) {
+	fprintf ( stderr, "--hdr can only be used with --exposure, "
+		"compression, and --max-memory!\n" );
+	return ( EXIT_FAILURE );	/* error return */
+    }
+
+    if ( resize_flag && ( ppd > 0.0 ) ) {
+	fprintf ( stderr, "can't mix --resize and --ppd!\n" );
+	return ( EXIT_FAILURE );	/* error return */
+    }
+    if ( ( resize_flag || ( ppd > 0.0 ) ) &&
+	    ( hdr_flag || max_memory_flag ) ) {
+	fprintf ( stderr,
+		"can't mix --resize or --ppd with --hdr or --max-memory!\n" );
+	return ( EXIT_FAILURE );	/* error return */
+    }
+
     exposure_flag_count = 0;
     if ( exposure_flag ) { exposure_flag_count++; }
     if ( fullrange_flag ) { exposure_flag_count++; }
@@ -218,65 +358,150 @@ main ( int argc, char *argv[] )
 	return ( EXIT_FAILURE );	/* error return */
     }
 
-    input_image = TT_RGBf_image_from_radfilename ( argv[argpt++], &header );
+    if ( exposure_flag ) {
+	exposure_adjust = pow ( 2.0, exposure_stops );
+    }
+
+    if ( hdr_flag ) {
+	/* one pass with nothing kept between rows, so always in bands */
+	stream = DeVAS_radiance_stream_open ( argv[argpt++] );
+	stream->xyze_divisor = 1.0;	/* as TT_RGBf_image_from_radfile */
+	set_header ( &header, &stream->view, stream->exposure_set,
+		stream->exposure, stream->description );
+
+	/* as --photometric-units */
+	conversion.units_flag = TRUE;
+	conversion.units_multiplier = WHTEFFICACY / header.exposure;
+	header.exposure = 1.0;
+	conversion.exposure_flag = exposure_flag;
+	conversion.exposure_adjust = exposure_adjust;
+	conversion.compression_type = compression_type;
+	conversion.new_description = new_description;
+
+	convert_hdr ( stream, hdr_transfer, &conversion, &header,
+		argv[argpt++] );
+	DeVAS_radiance_stream_close ( stream );
+	return ( EXIT_SUCCESS );	/* normal exit */
+    }
+
+    if ( max_memory_flag ) {
+	/* header gives image size, which determines how to proceed */
+	stream = DeVAS_radiance_stream_open ( argv[argpt++] );
+	stream->xyze_divisor = 1.0;	/* as TT_RGBf_image_from_radfile */
+	set_header ( &header, &stream->view, stream->exposure_set,
+		stream->exposure, stream->description );
+
+	plan = DeVAS_plan_memory ( max_memory,
+		DeVAS_radiance_stream_n_rows ( stream ),
+		DeVAS_radiance_stream_n_cols ( stream ),
+		sizeof ( TT_RGBf ) + ( ldr_flag ? sizeof ( TT_RGB ) : 0 ),
+		sizeof ( TT_RGBf ),
+		( TIFF_BYTES_PER_COLUMN *
+		    DeVAS_radiance_stream_n_cols ( stream ) ) +
+		DeVAS_radiance_stream_held_bytes ( stream ),
+		( fullrange_flag || fullrange_invert_flag || halfrange_flag ||
+		    halfrange_invert_flag || autoadjust_flag ) ? 2 : 1 );
+
+	if ( plan.strategy != DeVAS_strategy_in_memory ) {
+	    conversion.units_flag = original_units_flag ||
+		photometric_units_flag;
+	    if ( original_units_flag ) {
+		conversion.units_multiplier = 1.0 / header.exposure;
+		header.exposure = 1.0;
+	    } else if ( photometric_units_flag ) {
+		conversion.units_multiplier = WHTEFFICACY / header.exposure;
+		header.exposure = 1.0;
+	    }
+	    conversion.exposure_flag = exposure_flag;
+	    conversion.exposure_adjust = exposure_adjust;
+	    /* at most one of these (see exposure_flag_count) */
+	    conversion.invert_flag = fullrange_invert_flag ||
+		halfrange_invert_flag;
+	    conversion.rescale_flag = fullrange_flag ||
+		fullrange_invert_flag || halfrange_flag ||
+		halfrange_invert_flag;
+	    conversion.autoadjust_flag = autoadjust_flag &&
+		!conversion.rescale_flag;
+	    if ( fullrange_flag || fullrange_invert_flag ) {
+		conversion.new_max = FULLRANGE_MAX;
+		conversion.new_min = FULLRANGE_MIN;
+	    } else {
+		conversion.new_max = HALFRANGE_MAX;
+		conversion.new_min = HALFRANGE_MIN;
+	    }
+	    conversion.sRGBencoding_flag = sRGBencoding_flag;
+	    conversion.ldr_flag = ldr_flag;
+	    conversion.original_units_flag = original_units_flag;
+	    conversion.photometric_units_flag = photometric_units_flag;
+	    conversion.compression_type = compression_type;
+	    conversion.new_description = new_description;
+
+	    convert_in_bands ( stream, plan, &conversion, &header,
+		    argv[argpt++] );
+	    DeVAS_radiance_stream_close ( stream );
+	    return ( EXIT_SUCCESS );	/* normal exit */
+	}
+
+	DeVAS_input_image = DeVAS_RGBf_image_from_radiance_stream ( stream );
+	DeVAS_radiance_stream_close ( stream );
+	input_image = DeVAS_RGBf_image_as_TT ( DeVAS_input_image );
+	DeVAS_RGBf_image_delete ( DeVAS_input_image );
+    } else {
+	input_image = TT_RGBf_image_from_radfilename ( argv[argpt++],
+		&header );
+    }
+
+    if ( resize_flag || ( ppd > 0.0 ) ) {
+	input_image = resize ( input_image, &header, resize_n_rows,
+		resize_n_cols, ppd, filter );
+    }
+
+    /*
+     * Units and exposure adjustment, rescaling, conversion to sRGB
+     * primaries, and sRGB encoding are done in a single pass over the
+     * pixels.  Rescaling needs statistics of the adjusted (and inverted)
+     * pixels first, which are collected in the same pass as the
+     * adjustment (and inversion).
+     */
+    DeVAS_tone_pipeline_init ( &tone );
 
     if ( original_units_flag ) {
-	original_units ( input_image, &header );
+	DeVAS_tone_add_scale ( &tone, 1.0 / header.exposure );
+	header.exposure = 1.0;
     } else if ( photometric_units_flag ) {
-	photometric_units ( input_image, &header );
+	DeVAS_tone_add_scale ( &tone, WHTEFFICACY / header.exposure );
+	header.exposure = 1.0;
     }
 
     if ( exposure_flag ) {
-	exposure_adjust = pow ( 2.0, exposure_stops );
-	for ( row = 0; row < TT_image_n_rows ( input_image ); row++ ) {
-	    for ( col = 0; col < TT_image_n_cols ( input_image ); col++ ) {
-		TT_image_data ( input_image, row, col ).red *= exposure_adjust;
-		TT_image_data ( input_image, row, col ).green
-		    *= exposure_adjust;
-		TT_image_data ( input_image, row, col ).blue *= exposure_adjust;
-	    }
-	}
+	DeVAS_tone_add_scale ( &tone, exposure_adjust );
     }
 
-    if ( fullrange_flag ) {
-	TT_RGBf_rescale ( input_image, FULLRANGE_MAX, FULLRANGE_MIN );
-    } else if ( fullrange_invert_flag ) {
-	TT_RGBf_invert ( input_image );
-	TT_RGBf_rescale ( input_image, FULLRANGE_MAX, FULLRANGE_MIN );
-    } else if ( halfrange_flag ) {
-	TT_RGBf_rescale ( input_image, HALFRANGE_MAX, HALFRANGE_MIN );
-    } else if ( halfrange_invert_flag ) {
-	TT_RGBf_invert ( input_image );
-	TT_RGBf_rescale ( input_image, HALFRANGE_MAX, HALFRANGE_MIN );
+    if ( fullrange_flag || fullrange_invert_flag || halfrange_flag ||
+	    halfrange_invert_flag || autoadjust_flag ) {
+	tone_image ( &tone, input_image, TRUE );
+	DeVAS_tone_pipeline_init ( &tone );
+    }
+
+    if ( fullrange_flag || fullrange_invert_flag ) {
+	add_rescale ( &tone, TT_RGBf_image_stats ( input_image ),
+		fullrange_invert_flag, FULLRANGE_MAX, FULLRANGE_MIN );
+    } else if ( halfrange_flag || halfrange_invert_flag ) {
+	add_rescale ( &tone, TT_RGBf_image_stats ( input_image ),
+		halfrange_invert_flag, HALFRANGE_MAX, HALFRANGE_MIN );
     } else if ( autoadjust_flag ) {
-	adjust_max = find_glare_threshold ( input_image );
+	adjust_max = DeVAS_image_stats_glare_threshold (
+		TT_RGBf_image_stats ( input_image ) );
 	if ( adjust_max > 0.0 ) {
-	    TT_RGBf_rescale ( input_image, adjust_max, 0 );
+	    add_rescale ( &tone, TT_RGBf_image_stats ( input_image ), FALSE,
+		    adjust_max, 0 );
 	}
     }
 
     if ( sRGBencoding_flag ) {
 	/* convert to sRGB primaries */
 	comprgb2rgbWBmat ( radrgb2sRGBmat, radiance_prims, sRGB_prims );
-
-	for ( row = 0; row < TT_image_n_rows ( input_image ); row++ ) {
-	    for ( col = 0; col < TT_image_n_cols ( input_image ); col++ ) {
-		TT_pixel = TT_image_data ( input_image, row, col );
-
-		colval ( radiance_pixel_in, RED ) = TT_pixel.red;
-		colval ( radiance_pixel_in, GRN ) = TT_pixel.green;
-		colval ( radiance_pixel_in, BLU ) = TT_pixel.blue;
-
-		colortrans ( radiance_pixel_out, radrgb2sRGBmat,
-			radiance_pixel_in );
-
-		TT_pixel.red = colval ( radiance_pixel_out, RED );
-		TT_pixel.green = colval ( radiance_pixel_out, GRN );
-		TT_pixel.blue = colval ( radiance_pixel_out, BLU );
-
-		TT_image_data ( input_image, row, col ) = TT_pixel;
-	    }
-	}
+	DeVAS_tone_add_matrix ( &tone, radrgb2sRGBmat );
     }
 
     if ( ldr_flag ) {
@@ -293,58 +518,22 @@ main ( int argc, char *argv[] )
 	    exit ( EXIT_FAILURE );
 	}
 
-	if ( original_units_flag ) {
-	    if ( !TIFFSetField ( output, TIFFTAG_STONITS, WHTEFFICACY ) ) {
-		fprintf (stderr, "Can't set TIFFTAG_STONITS!\n" );
-		exit ( EXIT_FAILURE );
-	    }
-	} else if ( photometric_units_flag ) {
-	    if ( !TIFFSetField ( output, TIFFTAG_STONITS, 1.0 ) ) {
-		fprintf (stderr, "Can't set TIFFTAG_STONITS!\n" );
-		exit ( EXIT_FAILURE );
-	    }
-	} else {
-	    if ( !TIFFSetField ( output, TIFFTAG_STONITS,
-			WHTEFFICACY / header.exposure ) ) {
-		fprintf (stderr, "Can't set TIFFTAG_STONITS!\n" );
-		exit ( EXIT_FAILURE );
-	    }
-	}
+	set_stonits ( output, original_units_flag, photometric_units_flag,
+		&header );
 
 	sRGB_image = TT_RGB_image_new ( TT_image_n_rows ( input_image ),
 		TT_image_n_cols ( input_image ) );
 
 	/* convert to 8-bit values using sRGB non-linear encoding */
-	for ( row = 0; row < TT_image_n_rows ( input_image ); row++ ) {
-	    for ( col = 0; col < TT_image_n_cols ( input_image ); col++ ) {
-		TT_image_data ( sRGB_image, row, col ) =
-		    RGBf_to_sRGB ( TT_image_data ( input_image, row, col ) );
-	    }
-	}
+	DeVAS_tone_rows_to_sRGB ( &tone, (DeVAS_RGBf **) input_image->data,
+		(DeVAS_RGB **) sRGB_image->data,
+		TT_image_n_rows ( input_image ),
+		TT_image_n_cols ( input_image ) );
 
 	TT_RGB_image_to_file ( output, sRGB_image );
-	if ( new_description == NULL ) {
-	    /* strip trailing newline if present */
-	    if ( ( header.header_text != NULL ) &&
-		    ( strlen ( header.header_text ) >= 1 ) &&
-		    (header.header_text[strlen ( header.header_text ) - 1]
-		     == '\n' ) ) {
-		header.header_text[strlen ( header.header_text ) - 1] = '\0';
-	    }
-	    TT_set_description ( output, header.header_text );
-	} else {
-	    TT_set_description ( output, new_description );
-	}
-	if ( fmax ( header.hFOV, header.vFOV ) > 0.0 ) {
-	    /* based on diagonal */
-	    fov.v_fov = header.vFOV;
-	    fov.h_fov = header.hFOV;
-	    set_tiff_fov_diag ( output, fov, TT_image_n_rows ( input_image ),
-		    TT_image_n_cols ( input_image ) );
-	    /************************* based on longest side
-	      set_tiff_fov ( output, fmax ( header.hFOV, header.vFOV ) );
-	     *************************/
-	}
+	set_description_and_fov ( output, new_description, &header,
+		TT_image_n_rows ( input_image ),
+		TT_image_n_cols ( input_image ) );
 	TIFFClose ( output );
 	TT_RGB_image_delete ( sRGB_image );
     } else {
@@ -363,47 +552,14 @@ main ( int argc, char *argv[] )
 	    }
 	}
 
-	if ( original_units_flag ) {
-	    if ( !TIFFSetField ( output, TIFFTAG_STONITS, WHTEFFICACY ) ) {
-		fprintf (stderr, "Can't set TIFFTAG_STONITS!\n" );
-		exit ( EXIT_FAILURE );
-	    }
-	} else if ( photometric_units_flag ) {
-	    if ( !TIFFSetField ( output, TIFFTAG_STONITS, 1.0 ) ) {
-		fprintf (stderr, "Can't set TIFFTAG_STONITS!\n" );
-		exit ( EXIT_FAILURE );
-	    }
-	} else {
-	    if ( !TIFFSetField ( output, TIFFTAG_STONITS,
-			WHTEFFICACY / header.exposure ) ) {
-		fprintf (stderr, "Can't set TIFFTAG_STONITS!\n" );
-		exit ( EXIT_FAILURE );
-	    }
-	}
+	set_stonits ( output, original_units_flag, photometric_units_flag,
+		&header );
 
+	tone_image ( &tone, input_image, FALSE );
 	TT_RGBf_image_to_file ( output, input_image );
-	if ( new_description == NULL ) {
-	    /* strip trailing newline if present */
-	    if ( ( header.header_text != NULL ) &&
-		    ( strlen ( header.header_text ) >= 1 ) &&
-		    ( header.header_text[strlen(header.header_text)-1]
-		      == '\n' ) ) {
-		header.header_text[strlen ( header.header_text ) - 1] = '\0';
-	    }
-	    TT_set_description ( output, header.header_text );
-	} else {
-	    TT_set_description ( output, new_description );
-	}
-	if ( fmax ( header.hFOV, header.vFOV ) > 0.0 ) {
-	    /* based on diagonal */
-	    fov.v_fov = header.vFOV;
-	    fov.h_fov = header.hFOV;
-	    set_tiff_fov_diag ( output, fov, TT_image_n_rows ( input_image ),
-		    TT_image_n_cols ( input_image ) );
-	    /************************* based on longest side
-	      set_tiff_fov ( output, fmax ( header.hFOV, header.vFOV ) );
-	     *************************/
-	}
+	set_description_and_fov ( output, new_description, &header,
+		TT_image_n_rows ( input_image ),
+		TT_image_n_cols ( input_image ) );
 	TIFFClose ( output );
     }
 
@@ -413,128 +569,68 @@ main ( int argc, char *argv[] )
 }
 
 void
-TT_RGBf_rescale ( TT_RGBf_image *image, float new_max, float new_min )
+add_rescale ( DeVAS_Tone_Pipeline *tone, DeVAS_Image_Stats *stats,
+	int invert, float new_max, float new_min )
+/*
+ * Adds steps to tone linearly mapping the range of values in stats, or
+ * of the inverted values if invert is TRUE, to [new_min,new_max].
+ */
 {
-    int	    row, col;
-    int	    n_rows, n_cols;
-    double  old_max, old_min;
-    double  old_max_red, old_max_green, old_max_blue;
-    double  old_min_red, old_min_green, old_min_blue;
-    double  rescale;
-
-    n_rows = TT_image_n_rows ( image );
-    n_cols = TT_image_n_cols ( image );
-
-    old_max_red = old_min_red = TT_image_data ( image, 0, 0 ).red;
-    old_max_green = old_min_green = TT_image_data ( image, 0, 0 ).green;
-    old_max_blue = old_min_blue = TT_image_data ( image, 0, 0 ).blue;
-
-    for ( row = 0; row < n_rows; row++ ) {
-	for ( col = 0; col < n_cols; col++ ) {
-	    old_max_red =
-		fmax ( old_max_red, TT_image_data ( image, row, col ).red );
-	    old_max_green =
-		fmax ( old_max_green, TT_image_data ( image, row, col ).green );
-	    old_max_blue =
-		fmax ( old_max_blue, TT_image_data ( image, row, col ).blue );
-
-	    old_min_red =
-		fmin ( old_min_red, TT_image_data ( image, row, col ).red );
-	    old_min_green =
-		fmin ( old_min_green, TT_image_data ( image, row, col ).green );
-	    old_min_blue =
-		fmin ( old_min_blue, TT_image_data ( image, row, col ).blue );
+    int	    varies;
+
+    if ( invert ) {
+	varies = DeVAS_tone_add_stats_invert_rescale ( tone, stats, new_max,
+		new_min );
+	if ( !varies ) {
+	    fprintf ( stderr,
+		    "TT_RGBf_invert: no variability in values (warning)\n" );
 	}
+    } else {
+	varies = DeVAS_tone_add_stats_rescale ( tone, stats, new_max,
+		new_min );
     }
 
-    old_max = fmax ( old_max_red, fmax ( old_max_green, old_max_blue ) );
-    old_min = fmin ( old_min_red, fmin ( old_min_green, old_min_blue ) );
-
-    if ( old_max == old_min ) {
+    if ( !varies ) {
 	fprintf ( stderr,
 		"TT_RGBf_rescale: no variability in values (warning)\n" );
-
-	for ( row = 0; row < n_rows; row++ ) {
-	    for ( col = 0; col < n_cols; col++ ) {
-		TT_image_data ( image, row, col ).red =
-		    TT_image_data ( image, row, col ).green =
-		    TT_image_data ( image, row, col ).blue =
-		   	 0.5 * ( new_max + new_min );
-	    }
-	}
-	return;
-    }
-
-    rescale = ( new_max - new_min ) / ( old_max - old_min );
-
-    for ( row = 0; row < n_rows; row++ ) {
-	for ( col = 0; col < n_cols; col++ ) {
-	    TT_image_data ( image, row, col ).red = ( rescale *
-		    ( TT_image_data ( image, row, col ).red - old_min ) ) +
-				new_min;
-	    TT_image_data ( image, row, col ).green = ( rescale *
-		    ( TT_image_data ( image, row, col ).green - old_min ) ) +
-				new_min;
-	    TT_image_data ( image, row, col ).blue = ( rescale *
-		    ( TT_image_data ( image, row, col ).blue - old_min ) ) +
-				new_min;
-	}
     }
 }
 
 void
-TT_RGBf_invert ( TT_RGBf_image *image )
+tone_image ( DeVAS_Tone_Pipeline *tone, TT_RGBf_image *image,
+	int keep_stats )
+/*
+ * DeVAS_tone_RGBf_image for a TT image.
+ */
 {
-    int	    row, col;
-    int	    n_rows, n_cols;
-    double  old_max, old_min;
-    double  old_max_red, old_max_green, old_max_blue;
-    double  old_min_red, old_min_green, old_min_blue;
-
-    n_rows = TT_image_n_rows ( image );
-    n_cols = TT_image_n_cols ( image );
-
-    old_max_red = old_min_red = TT_image_data ( image, 0, 0 ).red;
-    old_max_green = old_min_green = TT_image_data ( image, 0, 0 ).green;
-    old_max_blue = old_min_blue = TT_image_data ( image, 0, 0 ).blue;
-
-    for ( row = 0; row < n_rows; row++ ) {
-	for ( col = 0; col < n_cols; col++ ) {
-	    old_max_red =
-		fmax ( old_max_red, TT_image_data ( image, row, col ).red );
-	    old_max_green =
-		fmax ( old_max_green, TT_image_data ( image, row, col ).green );
-	    old_max_blue =
-		fmax ( old_max_blue, TT_image_data ( image, row, col ).blue );
-
-	    old_min_red =
-		fmin ( old_min_red, TT_image_data ( image, row, col ).red );
-	    old_min_green =
-		fmin ( old_min_green, TT_image_data ( image, row, col ).green );
-	    old_min_blue =
-		fmin ( old_min_blue, TT_image_data ( image, row, col ).blue );
-	}
-    }
+    DeVAS_Image_Stats	stats;
 
-    old_max = fmax ( old_max_red, fmax ( old_max_green, old_max_blue ) );
-    old_min = fmin ( old_min_red, fmin ( old_min_green, old_min_blue ) );
+    if ( keep_stats ) {
+	DeVAS_image_stats_clear ( &stats );
+    }
 
-    if ( old_max == old_min ) {
-	fprintf ( stderr,
-		"TT_RGBf_invert: no variability in values (warning)\n" );
+    DeVAS_tone_rows ( tone, (DeVAS_RGBf **) image->data,
+	    (DeVAS_RGBf **) image->data, TT_image_n_rows ( image ),
+	    TT_image_n_cols ( image ), keep_stats ? &stats : NULL );
 
-	return;
+    TT_image_modified ( image );
+    if ( keep_stats ) {
+	TT_RGBf_image_set_stats ( image, &stats );
     }
+}
 
-    for ( row = 0; row < n_rows; row++ ) {
-	for ( col = 0; col < n_cols; col++ ) {
-	    TT_image_data ( image, row, col ).red = old_max -
-		( TT_image_data ( image, row, col ).red - old_min );
-	    TT_image_data ( image, row, col ).green = old_max -
-		( TT_image_data ( image, row, col ).green - old_min );
-	    TT_image_data ( image, row, col ).blue = old_max -
-		( TT_image_data ( image, row, col ).blue - old_min );
-	}
+void
+add_units_and_exposure ( DeVAS_Tone_Pipeline *tone,
+	BAND_CONVERSION *conversion )
+/*
+ * Steps for units and exposure adjustment, as in main.
+ */
+{
+    if ( conversion->units_flag ) {
+	DeVAS_tone_add_scale ( tone, conversion->units_multiplier );
+    }
+    if ( conversion->exposure_flag ) {
+	DeVAS_tone_add_scale ( tone, conversion->exposure_adjust );
     }
 }
 
@@ -568,127 +664,313 @@ set_compression ( TIFF *file, COMPRESSION compression_type )
     }
 }
 
-double
-find_glare_threshold ( TT_RGBf_image *image )
-/*
- * Suggests a luminance level above which pixel should be considered
- * a glare source.  (This version uses maximum over R, G, and B, instead 
- * of luminance.)
- *
- * Uses a variant of the RADIANCE glare identification heuristic.  First,
- * average luminance is computed and used to set a preliminary glare
- * threshold value.  This average is not a robust estimator, since it is
- * strongly affected by very bright glare pixels or glare pixels covering
- * a large portion of the image.  To compensate for this, a second pass
- * is done in which a revised average luminance is computed based only on
- * pixels <= the preliminary glare threshold.  This revised average luminance
- * is then used to compute a revised glare threshold, which is returned as
- * the value of the function.
- */
+void
+set_stonits ( TIFF *output, int original_units_flag,
+	int photometric_units_flag, RadianceHeader *header )
 {
-    int		    row, col;
-    double	    max_pixel_value;
-    double	    max_value;
-    double	    average_value_initial;
-    double	    glare_cutoff_initial;
-
-    max_value = average_value_initial = 0.0;
-
-    for ( row = 0; row < TT_image_n_rows ( image ); row++ ) {
-	for ( col = 0; col < TT_image_n_cols ( image ); col++ ) {
-	    max_pixel_value = fmax3 ( TT_image_data (image, row, col ) . red,
-		    TT_image_data (image, row, col ) . green,
-		    TT_image_data (image, row, col ) . blue );
-	    if ( max_value < max_pixel_value ) {
-		max_value = max_pixel_value;
-	    }
-
-	    average_value_initial += max_pixel_value;
+    if ( original_units_flag ) {
+	if ( !TIFFSetField ( output, TIFFTAG_STONITS, WHTEFFICACY ) ) {
+	    fprintf (stderr, "Can't set TIFFTAG_STONITS!\n" );
+	    exit ( EXIT_FAILURE );
+	}
+    } else if ( photometric_units_flag ) {
+	if ( !TIFFSetField ( output, TIFFTAG_STONITS, 1.0 ) ) {
+	    fprintf (stderr, "Can't set TIFFTAG_STONITS!\n" );
+	    exit ( EXIT_FAILURE );
+	}
+    } else {
+	if ( !TIFFSetField ( output, TIFFTAG_STONITS,
+		    WHTEFFICACY / header->exposure ) ) {
+	    fprintf (stderr, "Can't set TIFFTAG_STONITS!\n" );
+	    exit ( EXIT_FAILURE );
 	}
     }
+}
 
-    average_value_initial /=
-	( ((double) TT_image_n_rows ( image ) ) *
-	    ((double) TT_image_n_cols ( image ) ) );
-    glare_cutoff_initial = GLARE_LEVEL_RATIO * average_value_initial;
+void
+set_description_and_fov ( TIFF *output, char *new_description,
+	RadianceHeader *header, int n_rows, int n_cols )
+{
+    DeVAS_FOV	    fov;
 
-    if ( glare_cutoff_initial >= max_value ) {
-	/* no need for glare source clipping */
-	return ( max_value );
+    if ( new_description == NULL ) {
+	/* strip trailing newline if present */
+	if ( ( header->header_text != NULL ) &&
+		( strlen ( header->header_text ) >= 1 ) &&
+		( header->header_text[strlen ( header->header_text ) - 1]
+		  == '\n' ) ) {
+	    header->header_text[strlen ( header->header_text ) - 1] = '\0';
+	}
+	TT_set_description ( output, header->header_text );
+    } else {
+	TT_set_description ( output, new_description );
+    }
+    if ( fmax ( header->hFOV, header->vFOV ) > 0.0 ) {
+	/* based on diagonal */
+	fov.v_fov = header->vFOV;
+	fov.h_fov = header->hFOV;
+	set_tiff_fov_diag ( output, fov, n_rows, n_cols );
+	/************************* based on longest side
+	  set_tiff_fov ( output, fmax ( header->hFOV, header->vFOV ) );
+	 *************************/
     }
+}
 
-    max_value = 0.0;
+TT_RGBf_image *
+next_band ( DeVAS_Radiance_Stream *stream, DeVAS_RGBf_image *band,
+	DeVAS_Tone_Pipeline *tone, DeVAS_Image_Stats *stats )
+/*
+ * Next band of rows, as a TT image, with the steps in tone applied.  If
+ * stats is not NULL, the statistics of the result are accumulated into it.
+ * NULL after the last band.
+ */
+{
+    DeVAS_RGBf_image	*rows;
+    TT_RGBf_image	*TT_rows;
 
-    for ( row = 0; row < TT_image_n_rows ( image ); row++ ) {
-	for ( col = 0; col < TT_image_n_cols ( image ); col++ ) {
-	    max_pixel_value = fmax3 ( TT_image_data (image, row, col ) . red,
-		    TT_image_data (image, row, col ) . green,
-		    TT_image_data (image, row, col ) . blue );
-	    if ( max_pixel_value <= glare_cutoff_initial ) {
-		if ( max_value < max_pixel_value ) {
-		    max_value = max_pixel_value;
-		}
-	    }
-	}
+    rows = DeVAS_radiance_stream_read_band ( stream, band );
+    if ( rows == NULL ) {
+	return ( NULL );
     }
 
-    return ( max_value );
-}
+    DeVAS_tone_rows ( tone, rows->data, rows->data,
+	    DeVAS_image_n_rows ( rows ), DeVAS_image_n_cols ( rows ), stats );
+    DeVAS_image_modified ( rows );
 
-double
-fmax3 ( double v1, double v2, double v3 )
-{
-    return ( fmax ( v1, fmax ( v2, v3 ) ) );
+    TT_rows = DeVAS_RGBf_image_as_TT ( rows );	/* shares pixels */
+    DeVAS_RGBf_image_delete ( rows );
+
+    return ( TT_rows );
 }
 
-TT_RGBf
-TT_RGBf_scalar_mult ( TT_RGBf original, double multiplier )
+void
+convert_hdr ( DeVAS_Radiance_Stream *stream, DeVAS_HDR_Transfer transfer,
+	BAND_CONVERSION *conversion, RadianceHeader *header, char *filename )
+/*
+ * --hdr: units (cd/m^2) and exposure as set in conversion, BT.2020
+ * primaries, then PQ or HLG encoded.
+ */
 {
-    TT_RGBf new_value;
+    DeVAS_RGBf_image	*band;
+    DeVAS_RGBf_image	*rows;
+    uint16_t		*hdr_row;
+    DeVAS_Tone_Pipeline	tone;
+    COLORMAT		radrgb2rec2020mat;
+    TIFF		*output;
+    int			n_rows, n_cols;
+    int			output_row;
+    int			row;
+
+    n_rows = DeVAS_radiance_stream_n_rows ( stream );
+    n_cols = DeVAS_radiance_stream_n_cols ( stream );
+
+    DeVAS_tone_pipeline_init ( &tone );
+    add_units_and_exposure ( &tone, conversion );
+    DeVAS_color_space_matrix ( DeVAS_color_space_lookup ( "Rec2020" ),
+	    radrgb2rec2020mat );
+    DeVAS_tone_add_matrix ( &tone, radrgb2rec2020mat );
+
+    output = TT_RGB16_open_write ( filename, n_rows, n_cols );
+    set_compression ( output, conversion->compression_type );
+
+    band = DeVAS_RGBf_image_new ( HDR_BAND_ROWS, n_cols );
+    hdr_row = (uint16_t *) malloc ( 3 * n_cols * sizeof ( uint16_t ) );
+    if ( hdr_row == NULL ) {
+	fprintf ( stderr, "convert_hdr: malloc failed!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    output_row = 0;
+    while ( ( rows = DeVAS_radiance_stream_read_band ( stream, band ) )
+	    != NULL ) {
+	for ( row = 0; row < DeVAS_image_n_rows ( rows ); row++ ) {
+	    DeVAS_tone_row_to_HDR ( &tone, transfer, rows->data[row], hdr_row,
+		    n_cols );
+	    if ( TIFFWriteScanline ( output, hdr_row, output_row, 0 ) != 1 ) {
+		/* libtiff should print error message */
+		exit ( EXIT_FAILURE );
+	    }
+	    output_row++;
+	}
+
+	DeVAS_RGBf_image_delete ( rows );
+    }
 
-    new_value.red = multiplier * original.red;
-    new_value.green = multiplier * original.green;
-    new_value.blue = multiplier * original.blue;
+    set_description_and_fov ( output, conversion->new_description, header,
+	    n_rows, n_cols );
+    TIFFClose ( output );
 
-    return ( new_value );
+    free ( hdr_row );
+    DeVAS_RGBf_image_delete ( band );
 }
 
 void
-original_units ( TT_RGBf_image *image, RadianceHeader *header )
+convert_in_bands ( DeVAS_Radiance_Stream *stream, DeVAS_Memory_Plan plan,
+	BAND_CONVERSION *conversion, RadianceHeader *header, char *filename )
+/*
+ * Same conversion as in main, plan.band_rows rows at a time.  Rescaling
+ * and --autoadjust need statistics over the whole image before the first
+ * output row can be produced, and so take two passes over the stream.
+ */
 {
-    int	    n_rows, n_cols;
-    int	    row, col;
+    DeVAS_RGBf_image	*band;
+    DeVAS_RGBf_image	*input_rows;
+    TT_RGBf_image	*rows;
+    DeVAS_RGB		*sRGB_row;
+    TIFF		*output;
+    int			n_rows, n_cols;
+    int			output_row;
+    int			row;
+    DeVAS_Image_Stats	stats;
+    DeVAS_Tone_Pipeline	adjust;		/* units and exposure */
+    DeVAS_Tone_Pipeline	tone;		/* everything */
+    float		adjust_max = 0.0;
+    RGBPRIMS		radiance_prims = STDPRIMS;
+    RGBPRIMS		sRGB_prims = sRGBPRIMS;
+    COLORMAT		radrgb2sRGBmat;
+
+    n_rows = DeVAS_radiance_stream_n_rows ( stream );
+    n_cols = DeVAS_radiance_stream_n_cols ( stream );
+
+    if ( plan.strategy == DeVAS_strategy_packed ) {
+	DeVAS_radiance_stream_retain ( stream, DeVAS_retain_packed );
+    } else if ( plan.strategy == DeVAS_strategy_compressed ) {
+	DeVAS_radiance_stream_retain ( stream, DeVAS_retain_compressed );
+	DeVAS_radiance_stream_retain_limit ( stream, plan.retain_bytes );
+    } else if ( plan.strategy == DeVAS_strategy_file_backed ) {
+	DeVAS_radiance_stream_retain ( stream, DeVAS_retain_file );
+    }
+
+    band = DeVAS_RGBf_image_new ( plan.band_rows, n_cols );
+
+    DeVAS_image_stats_clear ( &stats );
 
-    n_rows = TT_image_n_rows ( image );
-    n_cols = TT_image_n_cols ( image );
+    DeVAS_tone_pipeline_init ( &adjust );
+    add_units_and_exposure ( &adjust, conversion );
 
-    for ( row = 0; row < n_rows; row++ ) {
-	for ( col = 0; col < n_cols; col++ ) {
-	    TT_image_data ( image, row, col ) =
-		TT_RGBf_scalar_mult ( TT_image_data ( image, row, col ),
-			1.0 / header->exposure );
+    if ( conversion->rescale_flag || conversion->autoadjust_flag ) {
+	while ( ( rows = next_band ( stream, band, &adjust, &stats ) )
+		!= NULL ) {
+	    TT_RGBf_image_delete ( rows );
 	}
+	DeVAS_radiance_stream_rewind ( stream );
     }
 
-    header->exposure = 1.0;
-}
+    if ( conversion->autoadjust_flag ) {
+	adjust_max = DeVAS_image_stats_glare_threshold ( &stats );
+    }
 
-void
-photometric_units ( TT_RGBf_image *image, RadianceHeader *header )
-{
-    int	    n_rows, n_cols;
-    int	    row, col;
+    /* as in main, but from the unadjusted pixels */
+    tone = adjust;
+    if ( conversion->rescale_flag ) {
+	add_rescale ( &tone, &stats, conversion->invert_flag,
+		conversion->new_max, conversion->new_min );
+    } else if ( conversion->autoadjust_flag && ( adjust_max > 0.0 ) ) {
+	add_rescale ( &tone, &stats, FALSE, adjust_max, 0 );
+    }
+    if ( conversion->sRGBencoding_flag ) {
+	comprgb2rgbWBmat ( radrgb2sRGBmat, radiance_prims, sRGB_prims );
+	DeVAS_tone_add_matrix ( &tone, radrgb2sRGBmat );
+    }
+
+    if ( conversion->ldr_flag ) {
+	output = TT_RGB_open_write ( filename, n_rows, n_cols );
+    } else {
+	output = TT_RGBf_open_write ( filename, n_rows, n_cols );
+    }
+
+    set_compression ( output, conversion->compression_type );
+
+    if ( conversion->ldr_flag ) {
+	/* attach sRGB color profile */
+	if ( !TIFFSetField ( output, TIFFTAG_ICCPROFILE, sizeof ( icc_sRGB ),
+		    icc_sRGB ) ) {
+	    fprintf (stderr, "can't set TIFFTAG_ICCPROFILE!\n" );
+	    exit ( EXIT_FAILURE );
+	}
+    } else if ( conversion->sRGBencoding_flag ) {
+	/* attach sRGB color profile */
+	if ( !TIFFSetField ( output, TIFFTAG_ICCPROFILE,
+		    sizeof ( icc_sRGB_linear ), icc_sRGB_linear ) ) {
+	    fprintf (stderr, "Can't set TIFFTAG_ICCPROFILE!\n" );
+	    exit ( EXIT_FAILURE );
+	}
+    }
+
+    set_stonits ( output, conversion->original_units_flag,
+	    conversion->photometric_units_flag, header );
+
+    sRGB_row = (DeVAS_RGB *) malloc ( n_cols * sizeof ( DeVAS_RGB ) );
+    if ( sRGB_row == NULL ) {
+	fprintf ( stderr, "convert_in_bands: malloc failed!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    output_row = 0;
+    while ( ( input_rows = DeVAS_radiance_stream_read_band ( stream, band ) )
+	    != NULL ) {
+	for ( row = 0; row < DeVAS_image_n_rows ( input_rows ); row++ ) {
+	    if ( conversion->ldr_flag ) {
+		/* convert to 8-bit values using sRGB non-linear encoding */
+		DeVAS_tone_row_to_sRGB ( &tone, input_rows->data[row],
+			sRGB_row, n_cols );
+		if ( TIFFWriteScanline ( output, sRGB_row, output_row, 0 )
+			!= 1 ) {
+		    /* libtiff should print error message */
+		    exit ( EXIT_FAILURE );
+		}
+	    } else {
+		DeVAS_tone_row ( &tone, input_rows->data[row],
+			input_rows->data[row], n_cols, NULL );
+		if ( TIFFWriteScanline ( output, input_rows->data[row],
+			    output_row, 0 ) != 1 ) {
+		    /* libtiff should print error message */
+		    exit ( EXIT_FAILURE );
+		}
+	    }
+	    output_row++;
+	}
 
-    n_rows = TT_image_n_rows ( image );
-    n_cols = TT_image_n_cols ( image );
+	DeVAS_RGBf_image_delete ( input_rows );
+    }
+
+    set_description_and_fov ( output, conversion->new_description, header,
+	    n_rows, n_cols );
+    TIFFClose ( output );
+
+    free ( sRGB_row );
+    DeVAS_RGBf_image_delete ( band );
+}
 
-    for ( row = 0; row < n_rows; row++ ) {
-	for ( col = 0; col < n_cols; col++ ) {
-	    TT_image_data ( image, row, col ) =
-		TT_RGBf_scalar_mult ( TT_image_data ( image, row, col ),
-			WHTEFFICACY / header->exposure );
+TT_RGBf_image *
+resize ( TT_RGBf_image *image, RadianceHeader *header, int n_rows,
+	int n_cols, double ppd, DeVAS_Resample_Filter filter )
+/*
+ * --resize (n_rows and n_cols, one possibly 0) or --ppd.  Deletes image.
+ */
+{
+    TT_RGBf_image   *resized;
+    VIEW	    view = NULLVIEW;
+
+    if ( ppd > 0.0 ) {
+	set_fov_in_view ( &view, header );
+	if ( !DeVAS_resample_size_for_ppd ( &view, TT_image_n_rows ( image ),
+		    TT_image_n_cols ( image ), ppd, &n_rows, &n_cols ) ) {
+	    fprintf ( stderr, "--ppd needs a VIEW with a field of view!\n" );
+	    exit ( EXIT_FAILURE );
 	}
+    } else {
+	DeVAS_resample_size ( TT_image_n_rows ( image ),
+		TT_image_n_cols ( image ), &n_rows, &n_cols );
     }
 
-    header->exposure = 1.0;
+    if ( ( n_rows == TT_image_n_rows ( image ) ) &&
+	    ( n_cols == TT_image_n_cols ( image ) ) ) {
+	return ( image );	/* already the right size */
+    }
+
+    resized = TT_RGBf_image_resample ( image, n_rows, n_cols, filter );
+    TT_RGBf_image_delete ( image );
+
+    return ( resized );
 }
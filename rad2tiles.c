@@ -0,0 +1,529 @@
+/*
+ * Converts a RADIANCE image file to a Deep Zoom (DZI) tile pyramid of
+ * JPEG or PNG tiles, for multi-resolution web viewers.
+ *
+ * output.dzi is the XML manifest, and the tiles of level L are in
+ * output_files/L/<col>_<row>.jpg (or .png).  Level 0 is a single pixel and
+ * the highest level is full size, each level half the size of the next
+ * (rounded up), as in the Deep Zoom format.  Tiles are --tile-size pixels
+ * square (254 by default), plus --overlap pixels (1 by default) shared with
+ * each neighboring tile.
+ *
+ * The input is read once, a row at a time.  Each level keeps only the
+ * rows of its current row of tiles (tile_size + 2 * overlap rows), and
+ * passes its rows on to the next smaller level in pairs, averaged 2 x 2.
+ * When a row of tiles is complete, its tiles are converted to sRGB and
+ * encoded on the worker threads of devas-parallel.h.
+ *
+ * Values are converted to sRGB as rad2jpeg and rad2png do, with
+ * --exposure applied.  As with those programs, the EXPOSURE record in
+ * the Radiance header is ignored.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include "devas-image.h"
+#include "radiance-stream.h"
+#include "devas-tone.h"
+#include "devas-color-space.h"
+#include "devas-parallel.h"
+#include "devas-jpeg.h"
+#include "devas-png.h"
+#include "radiance/color.h"
+#include "radiance-conversion-version.h"
+#include "devas-license.h"
+
+#ifdef	_mingw64_cross
+#define	make_directory(path)	mkdir ( path )
+#else
+#define	make_directory(path)	mkdir ( path, 0777 )
+#endif	/* _mingw64_cross */
+
+#define	DEFAULT_TILE_SIZE	254	/* 256 with the default overlap */
+#define	DEFAULT_OVERLAP		1
+
+char	*Usage =
+	    "rad2tiles [--exposure=stops] [--tile-size=n] [--overlap=n]"
+	    "\n\t[--format=jpg|png] input.hdr output";
+int	args_needed = 2;
+
+typedef struct {		/* one level of the pyramid */
+    int		level;		/* Deep Zoom level number */
+    int		n_rows, n_cols;
+    int		n_tile_cols;
+    DeVAS_RGBf_image *band;	/* storage for rows */
+    DeVAS_RGBf	**rows;		/* held rows, oldest first */
+    int		first_row;	/* level row in rows[0] */
+    int		n_held;		/* rows held */
+    int		tile_row;	/* next row of tiles */
+    DeVAS_RGBf	*pending;	/* row waiting to be averaged with the next */
+    DeVAS_RGBf	*half;		/* 2 x 2 averages, for the next level */
+    int		n_received;	/* rows received so far */
+} LEVEL;
+
+typedef struct {		/* shared by the tile encoders */
+    LEVEL		*level;
+    int			tile_row;
+    int			tile_size;
+    int			overlap;
+    char		*format;
+    char		*directory;	/* output_files */
+    DeVAS_Tone_Pipeline	*tone;
+} TILE_ROW;
+
+typedef struct {		/* everything add_row needs */
+    LEVEL		*levels;	/* levels[level] */
+    int			tile_size;
+    int			overlap;
+    char		*format;
+    char		*directory;
+    DeVAS_Tone_Pipeline	*tone;
+} PYRAMID;
+
+int	parse_count ( char *arg, int minimum, int *value );
+void	add_row ( PYRAMID *pyramid, int level, DeVAS_RGBf *row );
+void	write_tile_row ( PYRAMID *pyramid, LEVEL *level );
+void	write_tile ( void *context, int band, int first_tile_col,
+	    int n_tile_cols );
+void	write_manifest ( char *filename, char *format, int tile_size,
+	    int overlap, int n_rows, int n_cols );
+void	create_directory ( char *path );
+
+int
+main ( int argc, char *argv[] )
+{
+    int		    exposure_flag = FALSE;
+    double	    exposure_stops = 0.0;
+    int		    tile_size = DEFAULT_TILE_SIZE;
+    int		    overlap = DEFAULT_OVERLAP;
+    char	    *format = "jpg";
+    DeVAS_Radiance_Stream *stream;
+    DeVAS_Tone_Pipeline tone;
+    COLORMAT	    radrgb2sRGBmat;
+    PYRAMID	    pyramid;
+    LEVEL	    *level;
+    DeVAS_RGBf	    *row_values;
+    char	    *output_name;
+    char	    *path;
+    int		    n_levels;
+    int		    level_number, row;
+    int		    argpt = 1;
+
+    while ( ( ( argc - argpt ) >= 1 ) && ( argv[argpt][0] == '-' ) ) {
+	if ( strcmp ( argv[argpt], "-" ) == 0 ) {
+	    break;	/* read from stdin */
+	} else if ( ( strncmp ( argv[argpt], "--exposure=",
+			strlen ( "--exposure=" ) ) == 0 ) ||
+		( strncmp ( argv[argpt], "-exposure=",
+			    strlen ( "-exposure=" ) ) == 0 ) ) {
+	    exposure_stops = atof ( strchr ( argv[argpt], '=' ) + 1 );
+	    exposure_flag = TRUE;
+	    argpt++;
+	} else if ( ( strncmp ( argv[argpt], "--tile-size=",
+			strlen ( "--tile-size=" ) ) == 0 ) ||
+		( strncmp ( argv[argpt], "-tile-size=",
+			    strlen ( "-tile-size=" ) ) == 0 ) ) {
+	    if ( !parse_count ( strchr ( argv[argpt], '=' ) + 1, 1,
+			&tile_size ) ) {
+		fprintf ( stderr, "invalid tile size (%s)!\n", argv[argpt] );
+		return ( EXIT_FAILURE );	/* error return */
+	    }
+	    argpt++;
+	} else if ( ( strncmp ( argv[argpt], "--overlap=",
+			strlen ( "--overlap=" ) ) == 0 ) ||
+		( strncmp ( argv[argpt], "-overlap=",
+			    strlen ( "-overlap=" ) ) == 0 ) ) {
+	    if ( !parse_count ( strchr ( argv[argpt], '=' ) + 1, 0,
+			&overlap ) ) {
+		fprintf ( stderr, "invalid overlap (%s)!\n", argv[argpt] );
+		return ( EXIT_FAILURE );	/* error return */
+	    }
+	    argpt++;
+	} else if ( ( strncmp ( argv[argpt], "--format=",
+			strlen ( "--format=" ) ) == 0 ) ||
+		( strncmp ( argv[argpt], "-format=",
+			    strlen ( "-format=" ) ) == 0 ) ) {
+	    format = strchr ( argv[argpt], '=' ) + 1;
+	    if ( strcmp ( format, "jpeg" ) == 0 ) {
+		format = "jpg";
+	    }
+	    if ( ( strcmp ( format, "jpg" ) != 0 ) &&
+		    ( strcmp ( format, "png" ) != 0 ) ) {
+		fprintf ( stderr, "unknown tile format (%s)!\n", argv[argpt] );
+		return ( EXIT_FAILURE );	/* error return */
+	    }
+	    argpt++;
+	} else {
+	    fprintf ( stderr, "unknown argument!\n" );
+	    return ( EXIT_FAILURE );	/* error return */
+	}
+    }
+
+    if ( ( argc - argpt ) != args_needed ) {
+	fprintf ( stderr, "%s\n", Usage );
+	return ( EXIT_FAILURE );        /* error return */
+    }
+
+    if ( overlap > tile_size ) {
+	fprintf ( stderr, "overlap can't be larger than the tile size!\n" );
+	return ( EXIT_FAILURE );	/* error return */
+    }
+
+    stream = DeVAS_radiance_stream_open ( argv[argpt++] );
+    output_name = argv[argpt++];
+
+    /* as rad2png without --autoadjust */
+    DeVAS_color_space_matrix ( DeVAS_color_space_lookup ( "sRGB" ),
+	    radrgb2sRGBmat );
+    DeVAS_tone_pipeline_init ( &tone );
+    DeVAS_tone_set_transfer ( &tone,
+	    DeVAS_color_space_lookup ( "sRGB" )->transfer );
+    DeVAS_tone_add_matrix ( &tone, radrgb2sRGBmat );
+    if ( exposure_flag ) {
+	DeVAS_tone_add_scale ( &tone, pow ( 2.0, exposure_stops ) );
+    }
+
+    /* Deep Zoom levels run from 1 x 1 to full size */
+    n_levels = 1;
+    while ( ( 1 << ( n_levels - 1 ) ) <
+	    ( ( DeVAS_radiance_stream_n_rows ( stream ) >
+		DeVAS_radiance_stream_n_cols ( stream ) ) ?
+	      DeVAS_radiance_stream_n_rows ( stream ) :
+	      DeVAS_radiance_stream_n_cols ( stream ) ) ) {
+	n_levels++;
+    }
+
+    path = (char *) malloc ( strlen ( output_name ) + 32 );
+    if ( path == NULL ) {
+	fprintf ( stderr, "rad2tiles: malloc failed!\n" );
+	return ( EXIT_FAILURE );	/* error return */
+    }
+
+    pyramid.levels = (LEVEL *) malloc ( n_levels * sizeof ( LEVEL ) );
+    pyramid.tile_size = tile_size;
+    pyramid.overlap = overlap;
+    pyramid.format = format;
+    pyramid.directory = (char *) malloc ( strlen ( output_name ) + 8 );
+    pyramid.tone = &tone;
+    row_values = (DeVAS_RGBf *) malloc (
+	    DeVAS_radiance_stream_n_cols ( stream ) * sizeof ( DeVAS_RGBf ) );
+    if ( ( pyramid.levels == NULL ) || ( pyramid.directory == NULL ) ||
+	    ( row_values == NULL ) ) {
+	fprintf ( stderr, "rad2tiles: malloc failed!\n" );
+	return ( EXIT_FAILURE );	/* error return */
+    }
+
+    sprintf ( pyramid.directory, "%s_files", output_name );
+    create_directory ( pyramid.directory );
+
+    for ( level_number = n_levels - 1; level_number >= 0; level_number-- ) {
+	level = &pyramid.levels[level_number];
+	level->level = level_number;
+	if ( level_number == n_levels - 1 ) {
+	    level->n_rows = DeVAS_radiance_stream_n_rows ( stream );
+	    level->n_cols = DeVAS_radiance_stream_n_cols ( stream );
+	} else {
+	    level->n_rows =
+		( pyramid.levels[level_number + 1].n_rows + 1 ) / 2;
+	    level->n_cols =
+		( pyramid.levels[level_number + 1].n_cols + 1 ) / 2;
+	}
+	level->n_tile_cols = ( level->n_cols + tile_size - 1 ) / tile_size;
+	level->band = DeVAS_RGBf_image_new ( tile_size + 2 * overlap,
+		level->n_cols );
+	level->rows = (DeVAS_RGBf **) malloc ( ( tile_size + 2 * overlap ) *
+		sizeof ( DeVAS_RGBf * ) );
+	level->pending = (DeVAS_RGBf *) malloc ( level->n_cols *
+		sizeof ( DeVAS_RGBf ) );
+	level->half = (DeVAS_RGBf *) malloc ( ( ( level->n_cols + 1 ) / 2 ) *
+		sizeof ( DeVAS_RGBf ) );
+	if ( ( level->rows == NULL ) || ( level->pending == NULL ) ||
+		( level->half == NULL ) ) {
+	    fprintf ( stderr, "rad2tiles: malloc failed!\n" );
+	    return ( EXIT_FAILURE );	/* error return */
+	}
+	for ( row = 0; row < tile_size + 2 * overlap; row++ ) {
+	    level->rows[row] = level->band->data[row];
+	}
+	level->first_row = 0;
+	level->n_held = 0;
+	level->tile_row = 0;
+	level->n_received = 0;
+
+	sprintf ( path, "%s/%d", pyramid.directory, level_number );
+	create_directory ( path );
+    }
+
+    for ( row = 0; row < DeVAS_radiance_stream_n_rows ( stream ); row++ ) {
+	DeVAS_radiance_stream_read_RGBf ( stream, row_values );
+	add_row ( &pyramid, n_levels - 1, row_values );
+    }
+
+    sprintf ( path, "%s.dzi", output_name );
+    write_manifest ( path, format, tile_size, overlap,
+	    DeVAS_radiance_stream_n_rows ( stream ),
+	    DeVAS_radiance_stream_n_cols ( stream ) );
+
+    for ( level_number = 0; level_number < n_levels; level_number++ ) {
+	DeVAS_RGBf_image_delete ( pyramid.levels[level_number].band );
+	free ( pyramid.levels[level_number].rows );
+	free ( pyramid.levels[level_number].pending );
+	free ( pyramid.levels[level_number].half );
+    }
+    free ( pyramid.levels );
+    free ( pyramid.directory );
+    free ( row_values );
+    free ( path );
+    DeVAS_radiance_stream_close ( stream );
+
+    return ( EXIT_SUCCESS );	/* normal exit */
+}
+
+int
+parse_count ( char *arg, int minimum, int *value )
+{
+    char    *end;
+
+    *value = strtol ( arg, &end, 10 );
+
+    return ( ( end != arg ) && ( *end == '\0' ) && ( *value >= minimum ) );
+}
+
+void
+add_row ( PYRAMID *pyramid, int level_number, DeVAS_RGBf *row )
+/*
+ * Adds the next row of a level, writes its row of tiles if that row
+ * completes it, and passes the row on to the next smaller level.
+ */
+{
+    LEVEL	*level;
+    DeVAS_RGBf	*half;
+    DeVAS_RGBf	*recycled;
+    int		last_row;	/* last row of the current row of tiles */
+    int		n_drop;
+    int		col, half_col;
+    int		i;
+
+    level = &pyramid->levels[level_number];
+
+    memcpy ( level->rows[level->n_held++], row,
+	    level->n_cols * sizeof ( DeVAS_RGBf ) );
+    level->n_received++;
+
+    last_row = ( level->tile_row + 1 ) * pyramid->tile_size +
+	pyramid->overlap - 1;
+    if ( last_row > level->n_rows - 1 ) {
+	last_row = level->n_rows - 1;
+    }
+    if ( level->first_row + level->n_held - 1 == last_row ) {
+	write_tile_row ( pyramid, level );
+	level->tile_row++;
+
+	/* keep the rows that the next row of tiles overlaps */
+	n_drop = level->tile_row * pyramid->tile_size - pyramid->overlap -
+	    level->first_row;
+	if ( n_drop > level->n_held ) {
+	    n_drop = level->n_held;
+	}
+	for ( i = 0; i < n_drop; i++ ) {
+	    recycled = level->rows[0];
+	    memmove ( level->rows, level->rows + 1,
+		    ( pyramid->tile_size + 2 * pyramid->overlap - 1 ) *
+		    sizeof ( DeVAS_RGBf * ) );
+	    level->rows[pyramid->tile_size + 2 * pyramid->overlap - 1] =
+		recycled;
+	}
+	level->first_row += n_drop;
+	level->n_held -= n_drop;
+    }
+
+    if ( level_number == 0 ) {
+	return;
+    }
+
+    /* 2 x 2 averages for the next level; odd edges average fewer */
+    if ( ( level->n_received % 2 ) == 1 ) {
+	if ( level->n_received < level->n_rows ) {
+	    memcpy ( level->pending, row,
+		    level->n_cols * sizeof ( DeVAS_RGBf ) );
+	    return;	/* wait for the other row of the pair */
+	}
+	memcpy ( level->pending, row, level->n_cols * sizeof ( DeVAS_RGBf ) );
+    }
+
+    half = level->half;
+    for ( half_col = 0, col = 0; col < level->n_cols; half_col++, col += 2 ) {
+	if ( col + 1 < level->n_cols ) {
+	    half[half_col].red = 0.25 * ( level->pending[col].red +
+		    level->pending[col + 1].red + row[col].red +
+		    row[col + 1].red );
+	    half[half_col].green = 0.25 * ( level->pending[col].green +
+		    level->pending[col + 1].green + row[col].green +
+		    row[col + 1].green );
+	    half[half_col].blue = 0.25 * ( level->pending[col].blue +
+		    level->pending[col + 1].blue + row[col].blue +
+		    row[col + 1].blue );
+	} else {
+	    half[half_col].red = 0.5 * ( level->pending[col].red +
+		    row[col].red );
+	    half[half_col].green = 0.5 * ( level->pending[col].green +
+		    row[col].green );
+	    half[half_col].blue = 0.5 * ( level->pending[col].blue +
+		    row[col].blue );
+	}
+    }
+
+    add_row ( pyramid, level_number - 1, half );
+}
+
+void
+write_tile_row ( PYRAMID *pyramid, LEVEL *level )
+/*
+ * One tile per band, so tiles are encoded concurrently.
+ */
+{
+    TILE_ROW	tile_row;
+
+    tile_row.level = level;
+    tile_row.tile_row = level->tile_row;
+    tile_row.tile_size = pyramid->tile_size;
+    tile_row.overlap = pyramid->overlap;
+    tile_row.format = pyramid->format;
+    tile_row.directory = pyramid->directory;
+    tile_row.tone = pyramid->tone;
+
+    DeVAS_parallel_bands ( level->n_tile_cols, 1, write_tile,
+	    (void *) &tile_row );
+}
+
+void
+write_tile ( void *context, int band, int first_tile_col, int n_tile_cols )
+/*
+ * Runs on the worker threads, so uses plain malloc rather than image
+ * objects (whose memory accounting isn't thread safe).
+ */
+{
+    TILE_ROW		*tile_row;
+    LEVEL		*level;
+    int			first_row, last_row;	/* level rows */
+    int			first_col, last_col;	/* level columns */
+    int			tile_col;
+    char		*filename;
+    FILE		*output;
+    DeVAS_RGB		*sRGB_row;
+    DeVAS_JPEG_writer	*jpeg_writer = NULL;
+    DeVAS_PNG_writer	*png_writer = NULL;
+    int			row;
+
+    tile_row = (TILE_ROW *) context;
+    level = tile_row->level;
+    tile_col = first_tile_col;
+
+    first_row = tile_row->tile_row * tile_row->tile_size - tile_row->overlap;
+    if ( first_row < 0 ) {
+	first_row = 0;
+    }
+    last_row = ( tile_row->tile_row + 1 ) * tile_row->tile_size +
+	tile_row->overlap - 1;
+    if ( last_row > level->n_rows - 1 ) {
+	last_row = level->n_rows - 1;
+    }
+    first_col = tile_col * tile_row->tile_size - tile_row->overlap;
+    if ( first_col < 0 ) {
+	first_col = 0;
+    }
+    last_col = ( tile_col + 1 ) * tile_row->tile_size + tile_row->overlap - 1;
+    if ( last_col > level->n_cols - 1 ) {
+	last_col = level->n_cols - 1;
+    }
+
+    filename = (char *) malloc ( strlen ( tile_row->directory ) + 64 );
+    sRGB_row = (DeVAS_RGB *) malloc ( ( last_col - first_col + 1 ) *
+	    sizeof ( DeVAS_RGB ) );
+    if ( ( filename == NULL ) || ( sRGB_row == NULL ) ) {
+	fprintf ( stderr, "rad2tiles: malloc failed!\n" );
+	exit ( EXIT_FAILURE );
+    }
+    sprintf ( filename, "%s/%d/%d_%d.%s", tile_row->directory, level->level,
+	    tile_col, tile_row->tile_row, tile_row->format );
+
+    output = fopen ( filename, "wb" );
+    if ( output == NULL ) {
+	perror ( filename );
+	exit ( EXIT_FAILURE );
+    }
+    if ( strcmp ( tile_row->format, "png" ) == 0 ) {
+	png_writer = DeVAS_RGB_open_write_png ( output,
+		last_row - first_row + 1, last_col - first_col + 1 );
+    } else {
+	jpeg_writer = DeVAS_RGB_open_write_jpg ( output,
+		last_row - first_row + 1, last_col - first_col + 1, NULL );
+    }
+
+    for ( row = first_row; row <= last_row; row++ ) {
+	DeVAS_tone_row_to_sRGB ( tile_row->tone,
+		level->rows[row - level->first_row] + first_col, sRGB_row,
+		last_col - first_col + 1 );
+	if ( png_writer != NULL ) {
+	    DeVAS_RGB_write_png ( png_writer, sRGB_row );
+	} else {
+	    DeVAS_RGB_write_jpg ( jpeg_writer, sRGB_row );
+	}
+    }
+
+    if ( png_writer != NULL ) {
+	DeVAS_RGB_close_write_png ( png_writer );
+    } else {
+	DeVAS_RGB_close_write_jpg ( jpeg_writer );
+    }
+    if ( fclose ( output ) != 0 ) {
+	perror ( filename );
+	exit ( EXIT_FAILURE );
+    }
+
+    free ( filename );
+    free ( sRGB_row );
+}
+
+void
+write_manifest ( char *filename, char *format, int tile_size, int overlap,
+	int n_rows, int n_cols )
+{
+    FILE    *output;
+
+    output = fopen ( filename, "w" );
+    if ( output == NULL ) {
+	perror ( filename );
+	exit ( EXIT_FAILURE );
+    }
+
+    fprintf ( output, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" );
+    fprintf ( output, "<Image xmlns=\"http://schemas.microsoft.com/"
+	    "deepzoom/2008\"\n" );
+    fprintf ( output, "  Format=\"%s\" Overlap=\"%d\" TileSize=\"%d\">\n",
+	    format, overlap, tile_size );
+    fprintf ( output, "  <Size Width=\"%d\" Height=\"%d\"/>\n", n_cols,
+	    n_rows );
+    fprintf ( output, "</Image>\n" );
+
+    if ( fclose ( output ) != 0 ) {
+	perror ( filename );
+	exit ( EXIT_FAILURE );
+    }
+}
+
+void
+create_directory ( char *path )
+/*
+ * An existing directory is reused.
+ */
+{
+    if ( ( make_directory ( path ) != 0 ) && ( errno != EEXIST ) ) {
+	perror ( path );
+	exit ( EXIT_FAILURE );
+    }
+}
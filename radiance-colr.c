@@ -0,0 +1,223 @@
+/*
+ * Lossless operations on Radiance COLR scanlines.  See radiance-colr.h.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#ifdef	__SSE2__
+#include <emmintrin.h>
+#endif	/* __SSE2__ */
+#include "radiance-colr.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+#ifndef M_PI
+#define	M_PI		3.14159265358979323846
+#endif
+
+#define	DeVAS_COLR_MAX_EXPONENT	255
+#define	DeVAS_COLR_BLOCK	32	/* transpose block (4 KB of COLR) */
+
+int
+DeVAS_colr_shift_exposure ( COLR *scanline, int n, int stops )
+{
+    int	    col;
+    int	    exponent;
+    int	    shift;
+    int	    n_inexact;
+
+    if ( stops == 0 ) {
+	return ( 0 );
+    }
+
+    n_inexact = 0;
+    for ( col = 0; col < n; col++ ) {
+	if ( scanline[col][EXP] == 0 ) {
+	    continue;		/* zero stays zero */
+	}
+
+	exponent = scanline[col][EXP] + stops;
+	if ( exponent > DeVAS_COLR_MAX_EXPONENT ) {
+	    scanline[col][EXP] = DeVAS_COLR_MAX_EXPONENT;
+	    n_inexact++;
+	} else if ( exponent < 1 ) {
+	    shift = 1 - exponent;
+	    if ( shift > 8 ) {
+		shift = 8;
+	    }
+	    if ( ( ( scanline[col][RED] | scanline[col][GRN] |
+			    scanline[col][BLU] ) & ( ( 1 << shift ) - 1 ) )
+		    != 0 ) {
+		n_inexact++;
+	    }
+	    scanline[col][RED] >>= shift;
+	    scanline[col][GRN] >>= shift;
+	    scanline[col][BLU] >>= shift;
+	    if ( ( scanline[col][RED] | scanline[col][GRN] |
+			scanline[col][BLU] ) == 0 ) {
+		scanline[col][EXP] = 0;
+	    } else {
+		scanline[col][EXP] = 1;
+	    }
+	} else {
+	    scanline[col][EXP] = exponent;
+	}
+    }
+
+    return ( n_inexact );
+}
+
+void
+DeVAS_colr_flip ( COLR *scanline, int n )
+{
+    int	    left, right;
+    COLR    temp;
+
+    for ( left = 0, right = n - 1; left < right; left++, right-- ) {
+	memcpy ( temp, scanline[left], sizeof ( COLR ) );
+	memcpy ( scanline[left], scanline[right], sizeof ( COLR ) );
+	memcpy ( scanline[right], temp, sizeof ( COLR ) );
+    }
+}
+
+static void
+DeVAS_colr_transpose_block ( const COLR *src, int src_stride, COLR *dst,
+	int dst_stride, int n_rows, int n_cols )
+/*
+ * One block, small enough that the src rows and dst rows touched all stay
+ * in cache.
+ */
+{
+    int	    row, col;
+
+    row = 0;
+#ifdef	__SSE2__
+    /* a COLR is 32 bits, so 4 x 4 pixel tiles transpose as 32 bit words */
+    for ( ; row + 4 <= n_rows; row += 4 ) {
+	for ( col = 0; col + 4 <= n_cols; col += 4 ) {
+	    __m128i r0, r1, r2, r3;
+	    __m128i t0, t1, t2, t3;
+
+	    r0 = _mm_loadu_si128 ( (const __m128i *)
+		    src[( row + 0 ) * src_stride + col] );
+	    r1 = _mm_loadu_si128 ( (const __m128i *)
+		    src[( row + 1 ) * src_stride + col] );
+	    r2 = _mm_loadu_si128 ( (const __m128i *)
+		    src[( row + 2 ) * src_stride + col] );
+	    r3 = _mm_loadu_si128 ( (const __m128i *)
+		    src[( row + 3 ) * src_stride + col] );
+
+	    t0 = _mm_unpacklo_epi32 ( r0, r1 );	/* 00 10 01 11 */
+	    t1 = _mm_unpacklo_epi32 ( r2, r3 );	/* 20 30 21 31 */
+	    t2 = _mm_unpackhi_epi32 ( r0, r1 );	/* 02 12 03 13 */
+	    t3 = _mm_unpackhi_epi32 ( r2, r3 );	/* 22 32 23 33 */
+
+	    _mm_storeu_si128 ( (__m128i *) dst[( col + 0 ) * dst_stride + row],
+		    _mm_unpacklo_epi64 ( t0, t1 ) );
+	    _mm_storeu_si128 ( (__m128i *) dst[( col + 1 ) * dst_stride + row],
+		    _mm_unpackhi_epi64 ( t0, t1 ) );
+	    _mm_storeu_si128 ( (__m128i *) dst[( col + 2 ) * dst_stride + row],
+		    _mm_unpacklo_epi64 ( t2, t3 ) );
+	    _mm_storeu_si128 ( (__m128i *) dst[( col + 3 ) * dst_stride + row],
+		    _mm_unpackhi_epi64 ( t2, t3 ) );
+	}
+	for ( ; col < n_cols; col++ ) {
+	    memcpy ( dst[col * dst_stride + row],
+		    src[( row + 0 ) * src_stride + col], sizeof ( COLR ) );
+	    memcpy ( dst[col * dst_stride + row + 1],
+		    src[( row + 1 ) * src_stride + col], sizeof ( COLR ) );
+	    memcpy ( dst[col * dst_stride + row + 2],
+		    src[( row + 2 ) * src_stride + col], sizeof ( COLR ) );
+	    memcpy ( dst[col * dst_stride + row + 3],
+		    src[( row + 3 ) * src_stride + col], sizeof ( COLR ) );
+	}
+    }
+#endif	/* __SSE2__ */
+    for ( ; row < n_rows; row++ ) {
+	for ( col = 0; col < n_cols; col++ ) {
+	    memcpy ( dst[col * dst_stride + row], src[row * src_stride + col],
+		    sizeof ( COLR ) );
+	}
+    }
+}
+
+void
+DeVAS_colr_transpose ( const COLR *src, int src_stride, COLR *dst,
+	int dst_stride, int n_rows, int n_cols )
+{
+    int	    row, col;
+    int	    block_rows, block_cols;
+
+    for ( row = 0; row < n_rows; row += DeVAS_COLR_BLOCK ) {
+	block_rows = ( n_rows - row < DeVAS_COLR_BLOCK ) ? n_rows - row :
+	    DeVAS_COLR_BLOCK;
+	for ( col = 0; col < n_cols; col += DeVAS_COLR_BLOCK ) {
+	    block_cols = ( n_cols - col < DeVAS_COLR_BLOCK ) ? n_cols - col :
+		DeVAS_COLR_BLOCK;
+	    DeVAS_colr_transpose_block ( src + ( (size_t) row ) * src_stride +
+		    col, src_stride, dst + ( (size_t) col ) * dst_stride + row,
+		    dst_stride, block_rows, block_cols );
+	}
+    }
+}
+
+static double
+DeVAS_view_crop_size ( int type, double size, double fraction )
+/*
+ * View size (degrees for perspective, world units for parallel) of a
+ * fraction of the image.
+ */
+{
+    if ( type == VT_PER ) {
+	return ( atan ( fraction * tan ( size * ( M_PI / 360.0 ) ) ) *
+		( 360.0 / M_PI ) );
+    } else {
+	return ( fraction * size );
+    }
+}
+
+int
+DeVAS_view_crop ( VIEW *view, int n_rows, int n_cols, int first_row,
+	int first_col, int crop_rows, int crop_cols )
+{
+    double  h_fraction, v_fraction;
+    double  h_center, v_center;
+
+    if ( view->type == 0 ) {
+	return ( TRUE );	/* no view */
+    }
+    if ( ( view->type != VT_PER ) && ( view->type != VT_PAR ) ) {
+	return ( FALSE );
+    }
+
+    h_fraction = ( (double) crop_cols ) / n_cols;
+    v_fraction = ( (double) crop_rows ) / n_rows;
+
+    /* center of the region, relative to the image center, in image */
+    /* widths and heights (up is positive; row 0 is the top row) */
+    h_center = ( first_col + 0.5 * crop_cols ) / n_cols - 0.5;
+    v_center = 0.5 - ( first_row + 0.5 * crop_rows ) / n_rows;
+
+    view->horiz = DeVAS_view_crop_size ( view->type, view->horiz,
+	    h_fraction );
+    view->vert = DeVAS_view_crop_size ( view->type, view->vert, v_fraction );
+    view->hoff = ( view->hoff + h_center ) / h_fraction;
+    view->voff = ( view->voff + v_center ) / v_fraction;
+
+    return ( TRUE );
+}
+
+void
+DeVAS_view_rotate_180 ( VIEW *view )
+{
+    if ( view->type == 0 ) {
+	return;
+    }
+
+    view->vup[0] = -view->vup[0];
+    view->vup[1] = -view->vup[1];
+    view->vup[2] = -view->vup[2];
+    view->hoff = -view->hoff;
+    view->voff = -view->voff;
+}
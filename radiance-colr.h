@@ -0,0 +1,65 @@
+/*
+ * Lossless operations on Radiance COLR (rgbe or xyze) scanlines, with no
+ * conversion to floating point.
+ *
+ *   DeVAS_colr_shift_exposure ( <scanline>, n, stops )
+ *
+ *	Multiplies n pixels by 2^stops by adding stops to the shared
+ *	exponent, which is exact.  Returns the number of pixels that
+ *	couldn't be represented exactly: too bright ones are clipped to
+ *	the largest exponent, and too dark ones are denormalized (mantissas
+ *	shifted right, dropping bits) or become zero.
+ *
+ *   DeVAS_colr_flip ( <scanline>, n )
+ *
+ *	Reverses the order of n pixels.
+ *
+ *   DeVAS_colr_transpose ( <src>, src_stride, <dst>, dst_stride, n_rows,
+ *	    n_cols )
+ *
+ *	Copies the n_rows x n_cols block at src (rows src_stride pixels
+ *	apart) to the n_cols x n_rows block at dst (rows dst_stride pixels
+ *	apart), transposed: dst[col * dst_stride + row] = src[row *
+ *	src_stride + col].  Works on 32 x 32 pixel blocks that fit in the
+ *	L1 cache, with an SSE2 4 x 4 kernel where available.
+ *
+ *   DeVAS_view_crop ( &<view>, n_rows, n_cols, first_row, first_col,
+ *	    crop_rows, crop_cols )
+ *
+ *	Adjusts the view of an n_rows x n_cols image to be the view of the
+ *	crop_rows x crop_cols region starting at (first_row, first_col),
+ *	by changing the view size and offsets.  FALSE if the view type is
+ *	one for which that can't be done (only perspective and parallel
+ *	views can be cropped).
+ *
+ *   DeVAS_view_rotate_180 ( &<view> )
+ *
+ *	Adjusts a view for an image that has been flipped both
+ *	horizontally and vertically.  (A flip in only one direction is a
+ *	mirror image, which no VIEW describes.)
+ */
+
+#ifndef __DeVAS_RADIANCE_COLR_H
+#define __DeVAS_RADIANCE_COLR_H
+
+#include "radiance-header.h"
+#include "radiance/color.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int	DeVAS_colr_shift_exposure ( COLR *scanline, int n, int stops );
+void	DeVAS_colr_flip ( COLR *scanline, int n );
+void	DeVAS_colr_transpose ( const COLR *src, int src_stride, COLR *dst,
+	    int dst_stride, int n_rows, int n_cols );
+int	DeVAS_view_crop ( VIEW *view, int n_rows, int n_cols, int first_row,
+	    int first_col, int crop_rows, int crop_cols );
+void	DeVAS_view_rotate_180 ( VIEW *view );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __DeVAS_RADIANCE_COLR_H */
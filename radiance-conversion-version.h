@@ -1,7 +1,7 @@
 #ifndef __RADIANCECONVERSION_VERSION_H
 #define __RADIANCECONVERSION_VERSION_H
 
-#define	RADIANCECONVERSION_VERSION		3.1.02
-#define	RADIANCECONVERSION_VERSION_STRING	"3.1.02"
+#define	RADIANCECONVERSION_VERSION		3.2.00
+#define	RADIANCECONVERSION_VERSION_STRING	"3.2.00"
 
 #endif  /* __RADIANCECONVERSION_VERSION_H */
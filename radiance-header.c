@@ -11,6 +11,8 @@
 #include <string.h>
 #include <ctype.h>
 #include "radiance-header.h"
+#include "radiance-colr.h"
+#include "devas-memory.h"
 #include "radiance/color.h"
 #include "radiance/platform.h"
 #include "radiance/resolu.h"
@@ -22,6 +24,8 @@
 				0.,0.,0.,0.,0.,0.,0., \
 				{0.,0.,0.},{0.,0.,0.},0.,0.}
 
+#define	DeVAS_SCANLINE_STRIP	32	/* column scanlines per transpose */
+
 VIEW DeVAS_null_view = NULLVIEW;	/* available to calling programs */
 
 /* need to be global because of the way Radiance reads header lines */
@@ -44,7 +48,10 @@ static int		    indented_view_set;	/* pcomp generated files */
 static VIEW		    indented_view;	/* which can have multiple */
 						/* VIEW records, some or all */
 						/* of which are indented */
+static int		    scanline_ordering;	/* of last header read */
 
+static void	find_scanlines ( DeVAS_Radiance_Scanlines *scanlines );
+static void	read_reoriented ( DeVAS_Radiance_Scanlines *scanlines );
 static void	initialize_headline ( void );
 static int	headline ( char *s, void *p );
 static char	*strcat_safe ( char *dest, char *src );
@@ -64,7 +71,10 @@ DeVAS_read_radiance_header ( FILE *radiance_fp, int *n_rows_p, int *n_cols_p,
  *
  * [All of the following are returned only if the arguement point is not NULL.]
  *
- * n_rows_p, n_cols_p:	Size of image data in file.
+ * n_rows_p, n_cols_p:	Size of image data in file, in the standard
+ *			orientation (rows top to bottom), whatever the
+ *			scanline ordering.  Use DeVAS_radiance_scanlines_start
+ *			to read the rows in that orientation.
  *
  * color_format_p:	radcolor_unknown, radcolor_missing, radcolor_rgbe, or
  *			radcolor_xyze.
@@ -83,7 +93,7 @@ DeVAS_read_radiance_header ( FILE *radiance_fp, int *n_rows_p, int *n_cols_p,
  */
 {
     int	    n_rows, n_cols;
-    int	    scanline_ordering;
+    int	    scanline_length, n_scanlines;
 
     if ( radiance_fp == NULL ) {
 	fprintf ( stderr,
@@ -110,16 +120,19 @@ DeVAS_read_radiance_header ( FILE *radiance_fp, int *n_rows_p, int *n_cols_p,
 
     /* get size and pixel ordering */
     if ( ( scanline_ordering =
-		fgetresolu ( &n_cols, &n_rows, radiance_fp ) ) < 0 ) {
+		fgetresolu ( &scanline_length, &n_scanlines, radiance_fp ) )
+	    < 0 ) {
 	fprintf ( stderr,
 		"DeVAS_read_radiance_header: invalid file header!\n" );
 	exit ( EXIT_FAILURE );
     }
 
-    if ( scanline_ordering != PIXSTANDARD ) {
-	fprintf ( stderr,
-	    "DeVAS_read_radiance_header: non-standard scanline ordering!\n" );
-	exit ( EXIT_FAILURE );
+    if ( scanline_ordering & YMAJOR ) {
+	n_rows = n_scanlines;		/* scanlines are rows */
+	n_cols = scanline_length;
+    } else {
+	n_rows = scanline_length;	/* scanlines are columns */
+	n_cols = n_scanlines;
     }
 
     /* return requested information */
@@ -161,6 +174,283 @@ DeVAS_read_radiance_header ( FILE *radiance_fp, int *n_rows_p, int *n_cols_p,
     }
 }
 
+void
+DeVAS_radiance_scanlines_start ( DeVAS_Radiance_Scanlines *scanlines,
+	FILE *radiance_fp, int n_rows, int n_cols )
+/*
+ * Must directly follow DeVAS_read_radiance_header for radiance_fp, and
+ * uses the scanline ordering it found.  n_rows and n_cols are as returned
+ * by DeVAS_read_radiance_header.  Seekable files in a +Y ordering are
+ * read through here to find their scanlines.  No image is held yet.
+ */
+{
+    long    offset;
+
+    scanlines->radiance_fp = radiance_fp;
+    scanlines->scanline_ordering = scanline_ordering;
+    scanlines->n_rows = n_rows;
+    scanlines->n_cols = n_cols;
+    scanlines->row = 0;
+    scanlines->scanline = NULL;
+    scanlines->offsets = NULL;
+    scanlines->in_memory = FALSE;
+    scanlines->image = NULL;
+
+    if ( !( scanline_ordering & YMAJOR ) ) {
+	scanlines->in_memory = TRUE;	/* scanlines are columns */
+	return;
+    }
+
+    if ( !( scanline_ordering & YDECR ) ) {
+	/* bottom row first, so seek to each row if possible */
+	offset = ftell ( radiance_fp );
+	if ( ( offset < 0 ) ||
+		( fseek ( radiance_fp, offset, SEEK_SET ) != 0 ) ) {
+	    scanlines->in_memory = TRUE;	/* e.g., a pipe */
+	    return;
+	}
+    }
+
+    scanlines->scanline = (COLR *) malloc ( n_cols * sizeof ( COLR ) );
+    if ( scanlines->scanline == NULL ) {
+	fprintf ( stderr,
+		"DeVAS_radiance_scanlines_start: malloc failed!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    if ( !( scanline_ordering & YDECR ) ) {
+	find_scanlines ( scanlines );
+    }
+}
+
+static void
+find_scanlines ( DeVAS_Radiance_Scanlines *scanlines )
+/*
+ * Records the offset of each scanline of a seekable file in a +Y ordering,
+ * indexed by the row it belongs to.  Scanlines are run-length encoded, so
+ * the only way to find them is to decode them all.
+ */
+{
+    int	    scanline;
+
+    scanlines->offsets = (long *) malloc ( scanlines->n_rows *
+	    sizeof ( long ) );
+    if ( scanlines->offsets == NULL ) {
+	fprintf ( stderr, "DeVAS_radiance_scanlines_start: malloc failed!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    for ( scanline = 0; scanline < scanlines->n_rows; scanline++ ) {
+	scanlines->offsets[scanlines->n_rows - 1 - scanline] =
+	    ftell ( scanlines->radiance_fp );
+	if ( freadcolrs ( scanlines->scanline, scanlines->n_cols,
+		    scanlines->radiance_fp ) < 0 ) {
+	    fprintf ( stderr, "DeVAS_radiance_scanlines_start: "
+		    "error reading Radiance file!\n" );
+	    exit ( EXIT_FAILURE );
+	}
+    }
+}
+
+static void
+read_reoriented ( DeVAS_Radiance_Scanlines *scanlines )
+/*
+ * Reads a whole file that can't be read a row at a time into
+ * scanlines->image, in standard order.
+ *
+ * Scanlines that are rows go straight to their row, reversed if XDECR.
+ * Scanlines that are columns (no YMAJOR) are read DeVAS_SCANLINE_STRIP at
+ * a time into a strip, each reversed if not YDECR (so the strip rows run
+ * top to bottom) and placed in reverse order if XDECR (so they run left
+ * to right), and then the strip is transposed into its columns.
+ */
+{
+    int	    n_rows, n_cols;
+    int	    n_scanlines, scanline_length;
+    int	    scanline, strip_first, strip_scanlines;
+    int	    ordering;
+    COLR    *strip;
+    COLR    *colrs;
+
+    n_rows = scanlines->n_rows;
+    n_cols = scanlines->n_cols;
+    ordering = scanlines->scanline_ordering;
+
+    scanlines->image = (COLR *) malloc ( ( (size_t) n_rows ) * n_cols *
+	    sizeof ( COLR ) );
+    if ( scanlines->image == NULL ) {
+	fprintf ( stderr, "DeVAS_radiance_scanlines_next: malloc failed!\n" );
+	exit ( EXIT_FAILURE );
+    }
+    DeVAS_memory_allocated ( "COLR", ( (size_t) n_rows ) * n_cols *
+	    sizeof ( COLR ) );
+
+    if ( ordering & YMAJOR ) {
+	for ( scanline = 0; scanline < n_rows; scanline++ ) {
+	    colrs = scanlines->image + ( (size_t) ( ( ordering & YDECR ) ?
+			scanline : n_rows - 1 - scanline ) ) * n_cols;
+	    if ( freadcolrs ( colrs, n_cols, scanlines->radiance_fp ) < 0 ) {
+		fprintf ( stderr, "DeVAS_radiance_scanlines_next: "
+			"error reading Radiance file!\n" );
+		exit ( EXIT_FAILURE );
+	    }
+	    if ( ordering & XDECR ) {
+		DeVAS_colr_flip ( colrs, n_cols );
+	    }
+	}
+	return;
+    }
+
+    n_scanlines = n_cols;
+    scanline_length = n_rows;
+
+    strip = (COLR *) malloc ( ( (size_t) DeVAS_SCANLINE_STRIP ) *
+	    scanline_length * sizeof ( COLR ) );
+    if ( strip == NULL ) {
+	fprintf ( stderr, "DeVAS_radiance_scanlines_next: malloc failed!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    for ( strip_first = 0; strip_first < n_scanlines;
+	    strip_first += DeVAS_SCANLINE_STRIP ) {
+	strip_scanlines = ( n_scanlines - strip_first < DeVAS_SCANLINE_STRIP ) ?
+	    n_scanlines - strip_first : DeVAS_SCANLINE_STRIP;
+
+	for ( scanline = 0; scanline < strip_scanlines; scanline++ ) {
+	    colrs = strip + ( (size_t) ( ( ordering & XDECR ) ?
+			strip_scanlines - 1 - scanline : scanline ) ) *
+		scanline_length;
+	    if ( freadcolrs ( colrs, scanline_length,
+			scanlines->radiance_fp ) < 0 ) {
+		fprintf ( stderr, "DeVAS_radiance_scanlines_next: "
+			"error reading Radiance file!\n" );
+		exit ( EXIT_FAILURE );
+	    }
+	    if ( !( ordering & YDECR ) ) {
+		DeVAS_colr_flip ( colrs, scanline_length );
+	    }
+	}
+
+	/* file scanlines strip_first ... are image columns counting */
+	/* from the left, or from the right if XDECR */
+	DeVAS_colr_transpose ( strip, scanline_length, scanlines->image +
+		( ( ordering & XDECR ) ?
+		  n_cols - strip_first - strip_scanlines : strip_first ),
+		n_cols, strip_scanlines, scanline_length );
+    }
+
+    free ( strip );
+}
+
+COLR *
+DeVAS_radiance_scanlines_next ( DeVAS_Radiance_Scanlines *scanlines )
+/*
+ * Returns the next row, valid until the next call, or NULL if it can't be
+ * read.
+ */
+{
+    COLR    *colrs;
+
+    if ( scanlines->row >= scanlines->n_rows ) {
+	return ( NULL );
+    }
+
+    if ( scanlines->in_memory ) {
+	if ( scanlines->image == NULL ) {
+	    read_reoriented ( scanlines );
+	}
+	colrs = scanlines->image +
+	    ( (size_t) scanlines->row ) * scanlines->n_cols;
+    } else {
+	colrs = scanlines->scanline;
+	if ( ( scanlines->offsets != NULL ) &&
+		( fseek ( scanlines->radiance_fp,
+			  scanlines->offsets[scanlines->row],
+			  SEEK_SET ) != 0 ) ) {
+	    return ( NULL );
+	}
+	if ( freadcolrs ( colrs, scanlines->n_cols,
+		    scanlines->radiance_fp ) < 0 ) {
+	    return ( NULL );
+	}
+	if ( scanlines->scanline_ordering & XDECR ) {
+	    DeVAS_colr_flip ( colrs, scanlines->n_cols );
+	}
+    }
+
+    scanlines->row++;
+
+    return ( colrs );
+}
+
+int
+DeVAS_radiance_scanlines_read ( DeVAS_Radiance_Scanlines *scanlines,
+	COLOR *scanline )
+/*
+ * Same as RADIANCE freadscan, for the next row.  Returns -1 if it can't
+ * be read, 0 otherwise.
+ */
+{
+    COLR    *colrs;
+    int	    col;
+
+    if ( ( colrs = DeVAS_radiance_scanlines_next ( scanlines ) ) == NULL ) {
+	return ( -1 );
+    }
+
+    for ( col = 0; col < scanlines->n_cols; col++ ) {
+	colr_color ( scanline[col], colrs[col] );
+    }
+
+    return ( 0 );
+}
+
+void
+DeVAS_radiance_scanlines_rewind ( DeVAS_Radiance_Scanlines *scanlines )
+/*
+ * Starts again at the top row.  Unless DeVAS_radiance_scanlines_rereadable,
+ * the caller must first seek back to the first scanline.
+ */
+{
+    scanlines->row = 0;
+}
+
+size_t
+DeVAS_radiance_scanlines_held_bytes ( DeVAS_Radiance_Scanlines *scanlines )
+/*
+ * Memory for the whole image if it must be held, or for the scanline
+ * offsets if it is read by seeking.
+ */
+{
+    if ( scanlines->in_memory ) {
+	return ( ( (size_t) scanlines->n_rows ) * scanlines->n_cols *
+		sizeof ( COLR ) );
+    } else if ( scanlines->offsets != NULL ) {
+	return ( scanlines->n_rows * sizeof ( long ) );
+    } else {
+	return ( 0 );
+    }
+}
+
+void
+DeVAS_radiance_scanlines_end ( DeVAS_Radiance_Scanlines *scanlines )
+{
+    if ( scanlines->image != NULL ) {
+	free ( scanlines->image );
+	DeVAS_memory_freed ( "COLR", ( (size_t) scanlines->n_rows ) *
+		scanlines->n_cols * sizeof ( COLR ) );
+    }
+    if ( scanlines->scanline != NULL ) {
+	free ( scanlines->scanline );
+    }
+    if ( scanlines->offsets != NULL ) {
+	free ( scanlines->offsets );
+    }
+    scanlines->image = NULL;
+    scanlines->scanline = NULL;
+    scanlines->offsets = NULL;
+}
+
 static void
 initialize_headline ( void )
 /*
@@ -20,6 +20,41 @@
 #define	FALSE		0
 #endif	/* FALSE */
 
+/*
+ * Scanlines of a Radiance file in standard order (top row first, each row
+ * left to right), whatever the ordering given by the resolution line of
+ * the file.  Set up with DeVAS_radiance_scanlines_start, which must follow
+ * DeVAS_read_radiance_header on the same file.
+ *
+ * Files in the standard ordering (-Y N +X M) and in -Y N -X M are read a
+ * scanline at a time, the latter flipped as it is read.  Files in +Y N +X M
+ * or +Y N -X M store the bottom row first.  If the input is seekable,
+ * DeVAS_radiance_scanlines_start reads through it once to find where each
+ * scanline starts (a long per row), and each row is then read by seeking
+ * to it.  Otherwise, and for the four orderings whose scanlines are
+ * columns, the whole image is read and reoriented when the first row is
+ * asked for and held in memory as COLR values (4 bytes/pixel).  Column
+ * scanlines are transposed while decoding, 32 at a time.
+ *
+ * DeVAS_radiance_scanlines_held_bytes returns how much memory is (or will
+ * be) held beyond a single scanline, so callers can budget for it before
+ * reading any pixels.  DeVAS_radiance_scanlines_rereadable is TRUE if
+ * DeVAS_radiance_scanlines_rewind alone restarts at the top row.
+ */
+typedef struct {
+    FILE	*radiance_fp;
+    int		scanline_ordering;  /* as in the file (radiance/resolu.h) */
+    int		n_rows, n_cols;	    /* standard order */
+    int		row;		    /* next row */
+    COLR	*scanline;	    /* unless in_memory */
+    long	*offsets;	    /* of each row, +Y orderings if seekable */
+    int		in_memory;	    /* TRUE if the image must be held */
+    COLR	*image;		    /* in_memory, once the first row is read */
+} DeVAS_Radiance_Scanlines;
+
+#define	DeVAS_radiance_scanlines_rereadable(scanlines)	\
+	( (scanlines)->in_memory || ( (scanlines)->offsets != NULL ) )
+
 typedef enum {
     radcolor_unknown,
     radcolor_missing,
@@ -36,6 +71,26 @@ DeVAS_read_radiance_header ( FILE *radiance_fp, int *n_rows_p, int *n_cols_p,
 	RadianceColorFormat *color_format_p, VIEW *view_p, int *exposure_set_p,
 	double *exposure_p, char **header_text_p );
 
+void
+DeVAS_radiance_scanlines_start ( DeVAS_Radiance_Scanlines *scanlines,
+	FILE *radiance_fp, int n_rows, int n_cols );
+
+COLR *
+DeVAS_radiance_scanlines_next ( DeVAS_Radiance_Scanlines *scanlines );
+
+int
+DeVAS_radiance_scanlines_read ( DeVAS_Radiance_Scanlines *scanlines,
+	COLOR *scanline );
+
+void
+DeVAS_radiance_scanlines_rewind ( DeVAS_Radiance_Scanlines *scanlines );
+
+size_t
+DeVAS_radiance_scanlines_held_bytes ( DeVAS_Radiance_Scanlines *scanlines );
+
+void
+DeVAS_radiance_scanlines_end ( DeVAS_Radiance_Scanlines *scanlines );
+
 void
 DeVAS_write_radiance_header ( FILE *radiance_fp, int n_rows, int n_cols,
 	RadianceColorFormat color_format, VIEW view, int set_exposure,
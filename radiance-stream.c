@@ -0,0 +1,723 @@
+/*
+ * Row-at-a-time reading of Radiance files.  See radiance-stream.h.
+ *
+ * Requires the same RADIANCE routines as radiance-header.c.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "radiance-stream.h"
+#include "radiance-header.h"
+#include "devas-memory.h"
+#include "radiance/color.h"
+#include "radiance/platform.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+/* as in radiance/color.c */
+#define	DeVAS_RLE_MINELEN	8	/* minimum scanline length for encoding */
+#define	DeVAS_RLE_MAXELEN	0x7fff	/* maximum scanline length for encoding */
+#define	DeVAS_RLE_MINRUN	4	/* minimum run length */
+
+static void	DeVAS_radiance_stream_compress ( DeVAS_Radiance_Stream *stream,
+		    COLR *colrs );
+static void	DeVAS_radiance_stream_uncompress ( DeVAS_Radiance_Stream *stream,
+		    COLR *colrs );
+static void	DeVAS_radiance_stream_stop_compressing (
+		    DeVAS_Radiance_Stream *stream );
+
+DeVAS_Radiance_Stream *
+DeVAS_radiance_stream_open ( char *filename )
+/*
+ * A pathname of "-" specifies standard input.
+ */
+{
+    FILE		    *radiance_fp;
+    DeVAS_Radiance_Stream   *stream;
+
+    if ( strcmp ( filename, "-" ) == 0 ) {
+	radiance_fp = stdin;
+    } else {
+	radiance_fp = fopen ( filename, "r" );
+	if ( radiance_fp == NULL ) {
+	    perror ( filename );
+	    exit ( EXIT_FAILURE );
+	}
+    }
+
+    stream = DeVAS_radiance_stream_from_file ( radiance_fp );
+    stream->close_fp = TRUE;
+
+    return ( stream );
+}
+
+DeVAS_Radiance_Stream *
+DeVAS_radiance_stream_from_file ( FILE *radiance_fp )
+/*
+ * Reads the header.  The file is left at the start of the first scanline,
+ * unless it is in a +Y ordering and had to be read through to find them.
+ */
+{
+    DeVAS_Radiance_Stream   *stream;
+
+    stream = (DeVAS_Radiance_Stream *)
+	malloc ( sizeof ( DeVAS_Radiance_Stream ) );
+    if ( stream == NULL ) {
+	fprintf ( stderr, "DeVAS_radiance_stream_from_file: malloc failed!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    DeVAS_read_radiance_header ( radiance_fp, &stream->n_rows,
+	    &stream->n_cols, &stream->color_format, &stream->view,
+	    &stream->exposure_set, &stream->exposure, &stream->description );
+
+    if ( ( stream->color_format != radcolor_rgbe ) &&
+	    ( stream->color_format != radcolor_xyze ) ) {
+	fprintf ( stderr,
+	    "DeVAS_radiance_stream_from_file: unsupported color format!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    DeVAS_radiance_scanlines_start ( &stream->scanlines, radiance_fp,
+	    stream->n_rows, stream->n_cols );
+
+    stream->radiance_fp = radiance_fp;
+    stream->close_fp = FALSE;
+    stream->xyze_divisor = DeVAS_WHTEFFICACY;
+    stream->retention = DeVAS_retain_none;
+    stream->row = 0;
+    stream->pass = 0;
+    stream->packed = NULL;
+    stream->compressed = NULL;
+    stream->compressed_size = 0;
+    stream->compressed_allocated = 0;
+    stream->compressed_limit = 0;
+    stream->compressed_next = 0;
+    stream->data_offset = -1;
+    stream->spool = NULL;
+
+    stream->scanline = (COLR *) malloc ( stream->n_cols * sizeof ( COLR ) );
+    if ( stream->scanline == NULL ) {
+	fprintf ( stderr, "DeVAS_radiance_stream_from_file: malloc failed!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    return ( stream );
+}
+
+void
+DeVAS_radiance_stream_retain ( DeVAS_Radiance_Stream *stream,
+	DeVAS_Radiance_Retention retention )
+{
+    if ( ( stream->row != 0 ) || ( stream->pass != 0 ) ) {
+	fprintf ( stderr,
+	    "DeVAS_radiance_stream_retain: must precede first read!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    stream->retention = retention;
+
+    if ( DeVAS_radiance_scanlines_rereadable ( &stream->scanlines ) ) {
+	return;		/* held or seekable rows, nothing more to keep */
+    }
+
+    if ( retention == DeVAS_retain_packed ) {
+	stream->packed = (COLR *) malloc ( ( (size_t) stream->n_rows ) *
+		( (size_t) stream->n_cols ) * sizeof ( COLR ) );
+	if ( stream->packed == NULL ) {
+	    fprintf ( stderr, "DeVAS_radiance_stream_retain: malloc failed!\n" );
+	    exit ( EXIT_FAILURE );
+	}
+	DeVAS_memory_allocated ( "COLR", ( (size_t) stream->n_rows ) *
+		( (size_t) stream->n_cols ) * sizeof ( COLR ) );
+    } else if ( ( retention == DeVAS_retain_file ) ||
+	    ( retention == DeVAS_retain_compressed ) ) {
+	/* DeVAS_retain_compressed may fall back on re-reading the file */
+	stream->data_offset = ftell ( stream->radiance_fp );
+	if ( ( stream->data_offset < 0 ) ||
+		( fseek ( stream->radiance_fp, stream->data_offset,
+			  SEEK_SET ) != 0 ) ) {
+	    /* not seekable, so keep a copy */
+	    stream->data_offset = -1;
+	    if ( retention == DeVAS_retain_file ) {
+		stream->spool = tmpfile ( );
+		if ( stream->spool == NULL ) {
+		    perror ( "DeVAS_radiance_stream_retain" );
+		    exit ( EXIT_FAILURE );
+		}
+	    }
+	}
+    }
+}
+
+void
+DeVAS_radiance_stream_retain_limit ( DeVAS_Radiance_Stream *stream,
+	size_t max_bytes )
+/*
+ * Limit on the size of a DeVAS_retain_compressed image.  0 means no
+ * limit.
+ */
+{
+    stream->compressed_limit = max_bytes;
+}
+
+int
+DeVAS_rle_encode ( COLR *scanline, int len, unsigned char *out )
+/*
+ * Same encoding and same bytes as fwritecolrs in radiance/color.c, but to
+ * memory.  Returns the number of bytes written, which is at most
+ * DeVAS_rle_max_size ( len ).
+ */
+{
+    int		    i, j, beg, cnt = 1;
+    int		    c2;
+    unsigned char   *start = out;
+
+    if ( ( len < DeVAS_RLE_MINELEN ) | ( len > DeVAS_RLE_MAXELEN ) ) {
+	/* OOBs, write out flat */
+	memcpy ( out, scanline, len * sizeof ( COLR ) );
+	return ( len * sizeof ( COLR ) );
+    }
+
+    *out++ = 2;			/* magic header */
+    *out++ = 2;
+    *out++ = len >> 8;
+    *out++ = len & 255;
+
+    for ( i = 0; i < 4; i++ ) {	/* components separately */
+	for ( j = 0; j < len; j += cnt ) {	/* find next run */
+	    for ( beg = j; beg < len; beg += cnt ) {
+		for ( cnt = 1; cnt < 127 && beg + cnt < len &&
+			scanline[beg + cnt][i] == scanline[beg][i]; cnt++ )
+		    ;
+		if ( cnt >= DeVAS_RLE_MINRUN ) {
+		    break;		/* long enough */
+		}
+	    }
+	    if ( beg - j > 1 && beg - j < DeVAS_RLE_MINRUN ) {
+		c2 = j + 1;
+		while ( scanline[c2++][i] == scanline[j][i] ) {
+		    if ( c2 == beg ) {	/* short run */
+			*out++ = 128 + beg - j;
+			*out++ = scanline[j][i];
+			j = beg;
+			break;
+		    }
+		}
+	    }
+	    while ( j < beg ) {		/* non-run */
+		if ( ( c2 = beg - j ) > 128 ) {
+		    c2 = 128;
+		}
+		*out++ = c2;
+		while ( c2-- ) {
+		    *out++ = scanline[j++][i];
+		}
+	    }
+	    if ( cnt >= DeVAS_RLE_MINRUN ) {	/* run */
+		*out++ = 128 + cnt;
+		*out++ = scanline[beg][i];
+	    } else {
+		cnt = 0;
+	    }
+	}
+    }
+
+    return ( out - start );
+}
+
+size_t
+DeVAS_rle_max_size ( int len )
+/*
+ * Non-runs take one count byte per 128 values, short and long runs no
+ * more bytes than values, and each component ends with at most one
+ * partial non-run.
+ */
+{
+    return ( 4 + ( 4 * ( len + ( len / 128 ) + 2 ) ) );
+}
+
+static unsigned char *
+DeVAS_rle_decode ( unsigned char *in, COLR *scanline, int len )
+/*
+ * Inverse of DeVAS_rle_encode.  Returns the start of the next encoded
+ * scanline.
+ */
+{
+    int	    i, j;
+    int	    code;
+
+    if ( ( len < DeVAS_RLE_MINELEN ) | ( len > DeVAS_RLE_MAXELEN ) ) {
+	memcpy ( scanline, in, len * sizeof ( COLR ) );
+	return ( in + ( len * sizeof ( COLR ) ) );
+    }
+
+    in += 4;			/* magic header */
+
+    for ( i = 0; i < 4; i++ ) {
+	for ( j = 0; j < len; ) {
+	    code = *in++;
+	    if ( code > 128 ) {	/* run */
+		code &= 127;
+		if ( j + code > len ) {
+		    break;
+		}
+		while ( code-- ) {
+		    scanline[j++][i] = *in;
+		}
+		in++;
+	    } else {		/* non-run */
+		if ( j + code > len ) {
+		    break;
+		}
+		while ( code-- ) {
+		    scanline[j++][i] = *in++;
+		}
+	    }
+	}
+	if ( j != len ) {
+	    fprintf ( stderr,
+		"DeVAS_radiance_stream_read: corrupt compressed scanline!\n" );
+	    exit ( EXIT_FAILURE );
+	}
+    }
+
+    return ( in );
+}
+
+static void
+DeVAS_radiance_stream_compress ( DeVAS_Radiance_Stream *stream, COLR *colrs )
+/*
+ * Append a row to the retained compressed image, first pass only.
+ */
+{
+    size_t	    needed;
+    size_t	    new_allocated;
+    unsigned char   *new_compressed;
+
+    needed = stream->compressed_size + DeVAS_rle_max_size ( stream->n_cols );
+
+    if ( needed > stream->compressed_allocated ) {
+	new_allocated = 2 * stream->compressed_allocated;
+	if ( new_allocated < needed ) {
+	    new_allocated = needed + ( 64 * 1024 );
+	}
+	if ( ( stream->compressed_limit > 0 ) &&
+		( new_allocated > stream->compressed_limit ) ) {
+	    new_allocated = stream->compressed_limit;
+	}
+	if ( new_allocated < needed ) {
+	    /* over budget */
+	    DeVAS_radiance_stream_stop_compressing ( stream );
+	    return;
+	}
+
+	new_compressed = (unsigned char *) realloc ( stream->compressed,
+		new_allocated );
+	if ( new_compressed == NULL ) {
+	    fprintf ( stderr,
+		    "DeVAS_radiance_stream_read: realloc failed!\n" );
+	    exit ( EXIT_FAILURE );
+	}
+	if ( stream->compressed != NULL ) {
+	    DeVAS_memory_freed ( "RLE", stream->compressed_allocated );
+	}
+	DeVAS_memory_allocated ( "RLE", new_allocated );
+	stream->compressed = new_compressed;
+	stream->compressed_allocated = new_allocated;
+    }
+
+    stream->compressed_size += DeVAS_rle_encode ( colrs, stream->n_cols,
+	    stream->compressed + stream->compressed_size );
+}
+
+static void
+DeVAS_radiance_stream_uncompress ( DeVAS_Radiance_Stream *stream,
+	COLR *colrs )
+/*
+ * Next row of the retained compressed image, later passes.
+ */
+{
+    stream->compressed_next = DeVAS_rle_decode ( stream->compressed +
+	    stream->compressed_next, colrs, stream->n_cols ) -
+	stream->compressed;
+}
+
+static void
+DeVAS_radiance_stream_stop_compressing ( DeVAS_Radiance_Stream *stream )
+/*
+ * The compressed image doesn't fit in its limit, so switch to
+ * DeVAS_retain_file part way through the first pass.  If the input can't
+ * be re-read, the rows compressed so far are copied to the spool file,
+ * where the remaining rows will follow them.
+ */
+{
+    int	    row;
+    COLR    *colrs;
+
+    if ( getenv ( "DeVAS_MEMORY_PLAN" ) != NULL ) {
+	fprintf ( stderr, "memory plan: image doesn't compress enough, "
+		"switching to file-backed\n" );
+    }
+
+    if ( stream->data_offset < 0 ) {
+	stream->spool = tmpfile ( );
+	if ( stream->spool == NULL ) {
+	    perror ( "DeVAS_radiance_stream_read" );
+	    exit ( EXIT_FAILURE );
+	}
+	/* stream->scanline holds the current row, so decode elsewhere */
+	colrs = (COLR *) malloc ( stream->n_cols * sizeof ( COLR ) );
+	if ( colrs == NULL ) {
+	    fprintf ( stderr, "DeVAS_radiance_stream_read: malloc failed!\n" );
+	    exit ( EXIT_FAILURE );
+	}
+	stream->compressed_next = 0;
+	for ( row = 0; row < stream->row; row++ ) {
+	    DeVAS_radiance_stream_uncompress ( stream, colrs );
+	    if ( fwrite ( colrs, sizeof ( COLR ), stream->n_cols,
+			stream->spool ) != stream->n_cols ) {
+		perror ( "DeVAS_radiance_stream_read" );
+		exit ( EXIT_FAILURE );
+	    }
+	}
+	free ( colrs );
+    }
+
+    if ( stream->compressed != NULL ) {
+	free ( stream->compressed );
+	DeVAS_memory_freed ( "RLE", stream->compressed_allocated );
+    }
+    stream->compressed = NULL;
+    stream->compressed_size = stream->compressed_allocated = 0;
+    stream->compressed_next = 0;
+
+    stream->retention = DeVAS_retain_file;
+}
+
+static COLR *
+DeVAS_radiance_stream_next_colrs ( DeVAS_Radiance_Stream *stream )
+/*
+ * COLR values for the next row, from the file on the first pass or from
+ * wherever they have been retained on later passes.
+ */
+{
+    COLR    *colrs;
+
+    if ( stream->row >= stream->n_rows ) {
+	fprintf ( stderr,
+		"DeVAS_radiance_stream_read: read past end of image!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    if ( DeVAS_radiance_scanlines_rereadable ( &stream->scanlines ) ) {
+	/* reoriented, every pass */
+	colrs = DeVAS_radiance_scanlines_next ( &stream->scanlines );
+	if ( colrs == NULL ) {
+	    fprintf ( stderr,
+		    "DeVAS_radiance_stream_read: error reading Radiance file!\n" );
+	    exit ( EXIT_FAILURE );
+	}
+    } else if ( ( stream->pass > 0 ) &&
+	    ( stream->retention == DeVAS_retain_packed ) ) {
+	colrs = stream->packed + ( ( (size_t) stream->row ) *
+		( (size_t) stream->n_cols ) );
+    } else if ( ( stream->pass > 0 ) &&
+	    ( stream->retention == DeVAS_retain_compressed ) ) {
+	colrs = stream->scanline;
+	DeVAS_radiance_stream_uncompress ( stream, colrs );
+    } else if ( ( stream->pass > 0 ) && ( stream->spool != NULL ) ) {
+	colrs = stream->scanline;
+	if ( fread ( colrs, sizeof ( COLR ), stream->n_cols, stream->spool )
+		!= stream->n_cols ) {
+	    fprintf ( stderr,
+		    "DeVAS_radiance_stream_read: error reading spool file!\n" );
+	    exit ( EXIT_FAILURE );
+	}
+    } else {
+	colrs = DeVAS_radiance_scanlines_next ( &stream->scanlines );
+	if ( colrs == NULL ) {
+	    fprintf ( stderr,
+		    "DeVAS_radiance_stream_read: error reading Radiance file!\n" );
+	    exit ( EXIT_FAILURE );
+	}
+	if ( stream->pass == 0 ) {
+	    if ( stream->retention == DeVAS_retain_compressed ) {
+		/* may fall back to DeVAS_retain_file */
+		DeVAS_radiance_stream_compress ( stream, colrs );
+	    }
+	    if ( stream->retention == DeVAS_retain_packed ) {
+		memcpy ( stream->packed + ( ( (size_t) stream->row ) *
+			    ( (size_t) stream->n_cols ) ), colrs,
+			stream->n_cols * sizeof ( COLR ) );
+	    } else if ( stream->spool != NULL ) {
+		if ( fwrite ( colrs, sizeof ( COLR ), stream->n_cols,
+			    stream->spool ) != stream->n_cols ) {
+		    perror ( "DeVAS_radiance_stream_read" );
+		    exit ( EXIT_FAILURE );
+		}
+	    }
+	}
+    }
+
+    stream->row++;
+
+    return ( colrs );
+}
+
+void
+DeVAS_radiance_stream_read_COLR ( DeVAS_Radiance_Stream *stream, COLR *row )
+/*
+ * Reads the next row into row[0..n_cols-1] as the COLR values stored in
+ * the file (rgbe or xyze, as given by stream->color_format), with no
+ * conversion.
+ */
+{
+    memcpy ( row, DeVAS_radiance_stream_next_colrs ( stream ),
+	    stream->n_cols * sizeof ( COLR ) );
+}
+
+void
+DeVAS_radiance_stream_read_RGBf ( DeVAS_Radiance_Stream *stream,
+	DeVAS_RGBf *row )
+/*
+ * Reads the next row into row[0..n_cols-1].  Values are the same as those
+ * produced by DeVAS_RGBf_image_from_radfile (with xyze_divisor left at its
+ * default) or TT_RGBf_image_from_radfile (with xyze_divisor set to 1.0).
+ */
+{
+    COLR    *colrs;
+    COLOR   pixel;
+    COLOR   RGBf_rad_pixel;
+    int	    col;
+
+    colrs = DeVAS_radiance_stream_next_colrs ( stream );
+
+    if ( stream->color_format == radcolor_rgbe ) {
+	for ( col = 0; col < stream->n_cols; col++ ) {
+	    colr_color ( pixel, colrs[col] );
+	    row[col].red = colval ( pixel, RED );
+	    row[col].green = colval ( pixel, GRN );
+	    row[col].blue = colval ( pixel, BLU );
+	}
+    } else {
+	for ( col = 0; col < stream->n_cols; col++ ) {
+	    colr_color ( pixel, colrs[col] );
+	    colortrans ( RGBf_rad_pixel, xyz2rgbmat, pixel );
+	    row[col].red = colval ( RGBf_rad_pixel, RED ) /
+		stream->xyze_divisor;
+	    row[col].green = colval ( RGBf_rad_pixel, GRN ) /
+		stream->xyze_divisor;
+	    row[col].blue = colval ( RGBf_rad_pixel, BLU ) /
+		stream->xyze_divisor;
+	}
+    }
+}
+
+DeVAS_RGBf_image *
+DeVAS_radiance_stream_read_band ( DeVAS_Radiance_Stream *stream,
+	DeVAS_RGBf_image *band )
+/*
+ * Fills band with as many of the remaining rows as will fit and returns
+ * a region of the rows read, or NULL if there are no rows left.  The region
+ * must be deleted by the caller.
+ */
+{
+    int	    n_rows;
+    int	    row;
+
+    if ( DeVAS_image_n_cols ( band ) != stream->n_cols ) {
+	fprintf ( stderr,
+	    "DeVAS_radiance_stream_read_band: band width doesn't match!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    n_rows = stream->n_rows - stream->row;
+    if ( n_rows <= 0 ) {
+	return ( NULL );
+    }
+    if ( n_rows > DeVAS_image_n_rows ( band ) ) {
+	n_rows = DeVAS_image_n_rows ( band );
+    }
+
+    for ( row = 0; row < n_rows; row++ ) {
+	DeVAS_radiance_stream_read_RGBf ( stream,
+		&DeVAS_image_data ( band, row, 0 ) );
+    }
+
+    return ( DeVAS_RGBf_image_region ( band, 0, 0, n_rows, stream->n_cols ) );
+}
+
+void
+DeVAS_radiance_stream_rewind ( DeVAS_Radiance_Stream *stream )
+/*
+ * Start another pass at the first row.  Every row of the previous pass
+ * must have been read.
+ */
+{
+    if ( stream->retention == DeVAS_retain_none ) {
+	fprintf ( stderr,
+		"DeVAS_radiance_stream_rewind: stream not retained!\n" );
+	exit ( EXIT_FAILURE );
+    }
+    if ( stream->row != stream->n_rows ) {
+	fprintf ( stderr,
+		"DeVAS_radiance_stream_rewind: incomplete pass!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    if ( DeVAS_radiance_scanlines_rereadable ( &stream->scanlines ) ) {
+	DeVAS_radiance_scanlines_rewind ( &stream->scanlines );
+    } else if ( stream->retention == DeVAS_retain_compressed ) {
+	stream->compressed_next = 0;
+    } else if ( stream->retention == DeVAS_retain_file ) {
+	if ( stream->spool != NULL ) {
+	    if ( fseek ( stream->spool, 0L, SEEK_SET ) != 0 ) {
+		perror ( "DeVAS_radiance_stream_rewind" );
+		exit ( EXIT_FAILURE );
+	    }
+	} else if ( fseek ( stream->radiance_fp, stream->data_offset,
+		    SEEK_SET ) != 0 ) {
+	    perror ( "DeVAS_radiance_stream_rewind" );
+	    exit ( EXIT_FAILURE );
+	} else {
+	    DeVAS_radiance_scanlines_rewind ( &stream->scanlines );
+	}
+    }
+
+    stream->row = 0;
+    stream->pass++;
+}
+
+void
+DeVAS_radiance_stream_close ( DeVAS_Radiance_Stream *stream )
+{
+    if ( stream->close_fp ) {
+	fclose ( stream->radiance_fp );
+    }
+    if ( stream->spool != NULL ) {
+	fclose ( stream->spool );	/* tmpfile is removed on close */
+    }
+    if ( stream->packed != NULL ) {
+	free ( stream->packed );
+	DeVAS_memory_freed ( "COLR", ( (size_t) stream->n_rows ) *
+		( (size_t) stream->n_cols ) * sizeof ( COLR ) );
+    }
+    if ( stream->compressed != NULL ) {
+	free ( stream->compressed );
+	DeVAS_memory_freed ( "RLE", stream->compressed_allocated );
+    }
+    DeVAS_radiance_scanlines_end ( &stream->scanlines );
+    free ( stream->scanline );
+    free ( stream );
+}
+
+DeVAS_RGBf_image *
+DeVAS_RGBf_image_from_radiance_stream ( DeVAS_Radiance_Stream *stream )
+/*
+ * Reads the remaining rows of the stream into an in-memory image, as
+ * DeVAS_RGBf_image_from_radfile does for a whole file.
+ */
+{
+    DeVAS_RGBf_image	*RGBf;
+    int			row;
+
+    RGBf = DeVAS_RGBf_image_new ( stream->n_rows, stream->n_cols );
+    DeVAS_image_view ( RGBf ) = stream->view;
+    DeVAS_image_description ( RGBf ) = stream->description;
+    DeVAS_image_exposure_set ( RGBf ) = stream->exposure_set;
+    DeVAS_image_exposure ( RGBf ) = stream->exposure;
+
+    for ( row = stream->row; row < stream->n_rows; row++ ) {
+	DeVAS_radiance_stream_read_RGBf ( stream,
+		&DeVAS_image_data ( RGBf, row, 0 ) );
+    }
+
+    return ( RGBf );
+}
+
+DeVAS_RGBf_image *
+DeVAS_RGBf_image_preview_from_radiance_stream ( DeVAS_Radiance_Stream *stream,
+	int factor )
+/*
+ * Box filtered and subsampled while decoding.  Memory used is a row of
+ * input values and a row of block sums, plus the preview image.
+ */
+{
+    DeVAS_RGBf_image	*preview;
+    DeVAS_RGBf		*row_values;
+    DeVAS_RGBf		*sums;
+    int			*block_cols;	/* input columns in each block */
+    int			n_rows, n_cols;
+    int			col, in_col, out_row, out_col;
+    int			n_block_rows;
+    float		scale;
+
+    if ( factor < 1 ) {
+	fprintf ( stderr,
+		"DeVAS_RGBf_image_preview_from_radiance_stream: "
+		"invalid factor!\n" );
+	exit ( EXIT_FAILURE );
+    }
+
+    n_rows = ( stream->n_rows - stream->row + factor - 1 ) / factor;
+    n_cols = ( stream->n_cols + factor - 1 ) / factor;
+
+    preview = DeVAS_RGBf_image_new ( n_rows, n_cols );
+    DeVAS_image_view ( preview ) = stream->view;
+    DeVAS_image_description ( preview ) = stream->description;
+    DeVAS_image_exposure_set ( preview ) = stream->exposure_set;
+    DeVAS_image_exposure ( preview ) = stream->exposure;
+
+    row_values = (DeVAS_RGBf *) malloc ( stream->n_cols *
+	    sizeof ( DeVAS_RGBf ) );
+    sums = (DeVAS_RGBf *) malloc ( n_cols * sizeof ( DeVAS_RGBf ) );
+    block_cols = (int *) malloc ( n_cols * sizeof ( int ) );
+    if ( ( row_values == NULL ) || ( sums == NULL ) ||
+	    ( block_cols == NULL ) ) {
+	fprintf ( stderr,
+		"DeVAS_RGBf_image_preview_from_radiance_stream: "
+		"malloc failed!\n" );
+	exit ( EXIT_FAILURE );
+    }
+    for ( out_col = 0; out_col < n_cols; out_col++ ) {
+	block_cols[out_col] = ( ( out_col + 1 ) * factor <= stream->n_cols ) ?
+	    factor : stream->n_cols - ( out_col * factor );
+    }
+
+    for ( out_row = 0; out_row < n_rows; out_row++ ) {
+	memset ( sums, 0, n_cols * sizeof ( DeVAS_RGBf ) );
+
+	n_block_rows = 0;
+	while ( ( n_block_rows < factor ) &&
+		( stream->row < stream->n_rows ) ) {
+	    DeVAS_radiance_stream_read_RGBf ( stream, row_values );
+	    for ( col = 0, out_col = 0; col < stream->n_cols;
+		    col += factor, out_col++ ) {
+		for ( in_col = col; in_col < col + block_cols[out_col];
+			in_col++ ) {
+		    sums[out_col].red += row_values[in_col].red;
+		    sums[out_col].green += row_values[in_col].green;
+		    sums[out_col].blue += row_values[in_col].blue;
+		}
+	    }
+	    n_block_rows++;
+	}
+
+	for ( out_col = 0; out_col < n_cols; out_col++ ) {
+	    scale = 1.0 / ( n_block_rows * block_cols[out_col] );
+	    DeVAS_image_data ( preview, out_row, out_col ).red =
+		sums[out_col].red * scale;
+	    DeVAS_image_data ( preview, out_row, out_col ).green =
+		sums[out_col].green * scale;
+	    DeVAS_image_data ( preview, out_row, out_col ).blue =
+		sums[out_col].blue * scale;
+	}
+    }
+
+    free ( row_values );
+    free ( sums );
+    free ( block_cols );
+
+    return ( preview );
+}
@@ -0,0 +1,142 @@
+/*
+ * Row-at-a-time reading of Radiance rgbe and xyze files.
+ *
+ * The header, including the image size, is read when the stream is
+ * opened, so callers can decide how much of the image to hold in memory
+ * before reading any pixels.  Rows are returned as DeVAS_RGBf values,
+ * converted from xyze if necessary.
+ *
+ * Multi-pass processing requires the stream to retain the image, which
+ * must be requested before the first row is read:
+ *
+ *   DeVAS_retain_none	  Single pass only (the default).
+ *
+ *   DeVAS_retain_packed  The first pass keeps each scanline in memory as
+ *			  4 byte/pixel COLR values.  Later passes decode from
+ *			  memory.
+ *
+ *   DeVAS_retain_compressed  The first pass keeps each scanline in memory
+ *			  in the run-length encoded form used in Radiance
+ *			  files (byte-for-byte what Radiance's fwritecolrs
+ *			  would write), typically 3-6 times smaller than
+ *			  COLR values.  Later passes decode from memory.
+ *			  DeVAS_radiance_stream_retain_limit sets a limit
+ *			  on the encoded size; if it is exceeded, the
+ *			  stream falls back to DeVAS_retain_file.
+ *
+ *   DeVAS_retain_file	  Later passes re-read the input file.  If the input
+ *			  is not seekable (e.g., a pipe), the first pass
+ *			  copies the COLR scanlines to a temporary file.
+ *
+ * Files in scanline orderings other than the standard one (-Y N +X M)
+ * are reoriented as they are read (see DeVAS_Radiance_Scanlines in
+ * radiance-header.h).  -Y N -X M files stream like standard ones.  +Y
+ * files are read by seeking to each row if the input is seekable; those
+ * from pipes, and files whose scanlines are columns, are held in memory
+ * as COLR values once the first row is read.  In both cases later passes
+ * start again on the file or the held image, whatever the retention.
+ * DeVAS_radiance_stream_held_bytes ( stream ) gives the memory this will
+ * hold, for budgeting before any pixels are read.
+ *
+ * DeVAS_radiance_stream_read_COLR returns rows as stored in the file,
+ * without conversion.  DeVAS_rle_encode ( scanline, len, out ) run-length
+ * encodes a COLR scanline into out (at least DeVAS_rle_max_size ( len )
+ * bytes) exactly as Radiance's fwritecolrs would write it, and returns
+ * the number of bytes used.
+ *
+ * DeVAS_RGBf_image_preview_from_radiance_stream ( stream, factor ) reads
+ * the remaining rows into an image smaller by factor in each direction,
+ * each pixel the average of a factor x factor block (smaller at the right
+ * and bottom edges if the size isn't a multiple of factor).  Rows are
+ * summed into a single row of block sums as they are decoded, so the full
+ * size image is never held in memory.
+ */
+
+#ifndef __DeVAS_RADIANCE_STREAM_H
+#define __DeVAS_RADIANCE_STREAM_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "devas-image.h"
+#include "radiance-header.h"
+#include "radiance/color.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+typedef enum {
+    DeVAS_retain_none,
+    DeVAS_retain_packed,
+    DeVAS_retain_compressed,
+    DeVAS_retain_file
+} DeVAS_Radiance_Retention;
+
+typedef struct {
+    FILE		*radiance_fp;
+    int			close_fp;	/* TRUE if opened by stream */
+    int			n_rows, n_cols;
+    RadianceColorFormat	color_format;
+    VIEW		view;
+    int			exposure_set;
+    double		exposure;
+    char		*description;	/* owned by radiance-header.c */
+    double		xyze_divisor;	/* xyze -> rgb values are divided */
+					/* by this (default */
+					/* DeVAS_WHTEFFICACY, as in */
+					/* DeVAS_RGBf_image_from_radfile) */
+    DeVAS_Radiance_Retention retention;
+    int			row;		/* next row to be read */
+    int			pass;		/* number of rewinds */
+    COLR		*scanline;	/* one COLR scanline */
+    COLR		*packed;	/* DeVAS_retain_packed */
+    unsigned char	*compressed;	/* DeVAS_retain_compressed */
+    size_t		compressed_size;    /* bytes used */
+    size_t		compressed_allocated;
+    size_t		compressed_limit;   /* 0 if no limit */
+    size_t		compressed_next;    /* next row on later passes */
+    long		data_offset;	/* DeVAS_retain_file, seekable input */
+    FILE		*spool;		/* DeVAS_retain_file, otherwise */
+    DeVAS_Radiance_Scanlines scanlines;	/* rows from the file */
+} DeVAS_Radiance_Stream;
+
+#define	DeVAS_radiance_stream_n_rows(stream)	( (stream)->n_rows )
+#define	DeVAS_radiance_stream_n_cols(stream)	( (stream)->n_cols )
+#define	DeVAS_radiance_stream_held_bytes(stream)	\
+	DeVAS_radiance_scanlines_held_bytes ( &(stream)->scanlines )
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+DeVAS_Radiance_Stream	*DeVAS_radiance_stream_open ( char *filename );
+DeVAS_Radiance_Stream	*DeVAS_radiance_stream_from_file ( FILE *radiance_fp );
+void			DeVAS_radiance_stream_retain (
+			    DeVAS_Radiance_Stream *stream,
+			    DeVAS_Radiance_Retention retention );
+void			DeVAS_radiance_stream_retain_limit (
+				    DeVAS_Radiance_Stream *stream,
+				    size_t max_bytes );
+void			DeVAS_radiance_stream_read_RGBf (
+			    DeVAS_Radiance_Stream *stream, DeVAS_RGBf *row );
+void			DeVAS_radiance_stream_read_COLR (
+			    DeVAS_Radiance_Stream *stream, COLR *row );
+DeVAS_RGBf_image	*DeVAS_radiance_stream_read_band (
+			    DeVAS_Radiance_Stream *stream,
+			    DeVAS_RGBf_image *band );
+void			DeVAS_radiance_stream_rewind (
+			    DeVAS_Radiance_Stream *stream );
+void			DeVAS_radiance_stream_close (
+			    DeVAS_Radiance_Stream *stream );
+
+DeVAS_RGBf_image	*DeVAS_RGBf_image_from_radiance_stream (
+			    DeVAS_Radiance_Stream *stream );
+DeVAS_RGBf_image	*DeVAS_RGBf_image_preview_from_radiance_stream (
+			    DeVAS_Radiance_Stream *stream, int factor );
+
+int			DeVAS_rle_encode ( COLR *scanline, int len,
+			    unsigned char *out );
+size_t			DeVAS_rle_max_size ( int len );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __DeVAS_RADIANCE_STREAM_H */
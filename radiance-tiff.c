@@ -62,9 +62,12 @@ TT_float_image_from_radfile ( FILE *radiance_fp, RadianceHeader *header )
     int			row, col;
     int			n_rows, n_cols;
     char		*description;
+    DeVAS_Radiance_Scanlines scanlines;
 
     DeVAS_read_radiance_header ( radiance_fp, &n_rows, &n_cols,
 	    &color_format, &view, &exposure_set, &exposure, &description );
+    DeVAS_radiance_scanlines_start ( &scanlines, radiance_fp, n_rows,
+	    n_cols );
 
     radiance_scanline = (COLOR *) malloc ( n_cols * sizeof ( COLOR ) );
     if ( radiance_scanline == NULL ) {
@@ -77,7 +80,8 @@ TT_float_image_from_radfile ( FILE *radiance_fp, RadianceHeader *header )
     set_header ( header, &view, exposure_set, exposure, description );
 
     for ( row = 0; row < n_rows; row++ ) {
-	if ( freadscan( radiance_scanline, n_cols, radiance_fp ) < 0 ) {
+	if ( DeVAS_radiance_scanlines_read ( &scanlines,
+		    radiance_scanline ) < 0 ) {
 	    fprintf ( stderr,
 		"TT_float_image_from_radfile: error reading Radiance file!" );
 	    exit ( EXIT_FAILURE );
@@ -100,6 +104,7 @@ TT_float_image_from_radfile ( FILE *radiance_fp, RadianceHeader *header )
     }
 
     free ( radiance_scanline );
+    DeVAS_radiance_scanlines_end ( &scanlines );
 
     return ( luminance );
 }
@@ -214,9 +219,12 @@ TT_RGBf_image_from_radfile ( FILE *radiance_fp, RadianceHeader *header )
     int			row, col;
     int			n_rows, n_cols;
     char		*description;
+    DeVAS_Radiance_Scanlines scanlines;
 
     DeVAS_read_radiance_header ( radiance_fp, &n_rows, &n_cols,
 	    &color_format, &view, &exposure_set, &exposure, &description );
+    DeVAS_radiance_scanlines_start ( &scanlines, radiance_fp, n_rows,
+	    n_cols );
 
     radiance_scanline = (COLOR *) malloc ( n_cols * sizeof ( COLOR ) );
     if ( radiance_scanline == NULL ) {
@@ -229,7 +237,8 @@ TT_RGBf_image_from_radfile ( FILE *radiance_fp, RadianceHeader *header )
     set_header ( header, &view, exposure_set, exposure, description );
 
     for ( row = 0; row < n_rows; row++ ) {
-	if ( freadscan( radiance_scanline, n_cols, radiance_fp ) < 0 ) {
+	if ( DeVAS_radiance_scanlines_read ( &scanlines,
+		    radiance_scanline ) < 0 ) {
 	    fprintf ( stderr,
 		"TT_RGBf_image_from_radfile: error reading Radiance file!" );
 	    exit ( EXIT_FAILURE );
@@ -262,6 +271,7 @@ TT_RGBf_image_from_radfile ( FILE *radiance_fp, RadianceHeader *header )
     }
 
     free ( radiance_scanline );
+    DeVAS_radiance_scanlines_end ( &scanlines );
 
     return ( RGBf );
 }
@@ -377,9 +387,12 @@ TT_XYZ_image_from_radfile ( FILE *radiance_fp, RadianceHeader *header )
     int			row, col;
     int			n_rows, n_cols;
     char		*description;
+    DeVAS_Radiance_Scanlines scanlines;
 
     DeVAS_read_radiance_header ( radiance_fp, &n_rows, &n_cols,
 	    &color_format, &view, &exposure_set, &exposure, &description );
+    DeVAS_radiance_scanlines_start ( &scanlines, radiance_fp, n_rows,
+	    n_cols );
 
     radiance_scanline = (COLOR *) malloc ( n_cols * sizeof ( COLOR ) );
     if ( radiance_scanline == NULL ) {
@@ -392,7 +405,8 @@ TT_XYZ_image_from_radfile ( FILE *radiance_fp, RadianceHeader *header )
     set_header ( header, &view, exposure_set, exposure, description );
 
     for ( row = 0; row < n_rows; row++ ) {
-	if ( freadscan( radiance_scanline, n_cols, radiance_fp ) < 0 ) {
+	if ( DeVAS_radiance_scanlines_read ( &scanlines,
+		    radiance_scanline ) < 0 ) {
 	    fprintf ( stderr,
 		    "TT_XYZ_image_from_radfile: error reading Radiance file!" );
 	    exit ( EXIT_FAILURE );
@@ -425,6 +439,7 @@ TT_XYZ_image_from_radfile ( FILE *radiance_fp, RadianceHeader *header )
     }
 
     free ( radiance_scanline );
+    DeVAS_radiance_scanlines_end ( &scanlines );
 
     return ( XYZ );
 }
@@ -543,9 +558,12 @@ TT_xyY_image_from_radfile ( FILE *radiance_fp, RadianceHeader *header )
     int			row, col;
     int			n_rows, n_cols;
     char		*description;
+    DeVAS_Radiance_Scanlines scanlines;
 
     DeVAS_read_radiance_header ( radiance_fp, &n_rows, &n_cols,
 	    &color_format, &view, &exposure_set, &exposure, &description );
+    DeVAS_radiance_scanlines_start ( &scanlines, radiance_fp, n_rows,
+	    n_cols );
 
     radiance_scanline = (COLOR *) malloc ( n_cols * sizeof ( COLOR ) );
     if ( radiance_scanline == NULL ) {
@@ -558,7 +576,8 @@ TT_xyY_image_from_radfile ( FILE *radiance_fp, RadianceHeader *header )
     set_header ( header, &view, exposure_set, exposure, description );
 
     for ( row = 0; row < n_rows; row++ ) {
-	if ( freadscan( radiance_scanline, n_cols, radiance_fp ) < 0 ) {
+	if ( DeVAS_radiance_scanlines_read ( &scanlines,
+		    radiance_scanline ) < 0 ) {
 	    fprintf ( stderr,
 		"TT_xyY_image_from_radfile: error reading Radiance file!" );
 	    exit ( EXIT_FAILURE );
@@ -592,6 +611,7 @@ TT_xyY_image_from_radfile ( FILE *radiance_fp, RadianceHeader *header )
     }
 
     free ( radiance_scanline );
+    DeVAS_radiance_scanlines_end ( &scanlines );
 
     return ( xyY );
 }
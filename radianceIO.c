@@ -59,9 +59,12 @@ DeVAS_brightness_image_from_radfile ( FILE *radiance_fp )
     int			row, col;
     int			n_rows, n_cols;
     char		*description;
+    DeVAS_Radiance_Scanlines scanlines;
 
     DeVAS_read_radiance_header ( radiance_fp, &n_rows, &n_cols,
 	    &color_format, &view, &exposure_set, &exposure, &description );
+    DeVAS_radiance_scanlines_start ( &scanlines, radiance_fp, n_rows,
+	    n_cols );
 
     radiance_scanline = (COLOR *) malloc ( n_cols * sizeof ( COLOR ) );
     if ( radiance_scanline == NULL ) {
@@ -77,7 +80,8 @@ DeVAS_brightness_image_from_radfile ( FILE *radiance_fp )
     DeVAS_image_exposure ( brightness ) = exposure;
 
     for ( row = 0; row < n_rows; row++ ) {
-	if ( freadscan( radiance_scanline, n_cols, radiance_fp ) < 0 ) {
+	if ( DeVAS_radiance_scanlines_read ( &scanlines,
+		    radiance_scanline ) < 0 ) {
 	    fprintf ( stderr,
 	  "DeVAS_brightness_image_from_radfile: error reading Radiance file!" );
 	    exit ( EXIT_FAILURE );
@@ -100,6 +104,7 @@ DeVAS_brightness_image_from_radfile ( FILE *radiance_fp )
     }
 
     free ( radiance_scanline );
+    DeVAS_radiance_scanlines_end ( &scanlines );
 
     return ( brightness );
 }
@@ -240,9 +245,12 @@ DeVAS_luminance_image_from_radfile ( FILE *radiance_fp )
     int			row, col;
     int			n_rows, n_cols;
     char		*description;
+    DeVAS_Radiance_Scanlines scanlines;
 
     DeVAS_read_radiance_header ( radiance_fp, &n_rows, &n_cols,
 	    &color_format, &view, &exposure_set, &exposure, &description );
+    DeVAS_radiance_scanlines_start ( &scanlines, radiance_fp, n_rows,
+	    n_cols );
 
     radiance_scanline = (COLOR *) malloc ( n_cols * sizeof ( COLOR ) );
     if ( radiance_scanline == NULL ) {
@@ -256,7 +264,8 @@ DeVAS_luminance_image_from_radfile ( FILE *radiance_fp )
     DeVAS_image_description ( luminance ) = description;
 
     for ( row = 0; row < n_rows; row++ ) {
-	if ( freadscan ( radiance_scanline, n_cols, radiance_fp ) < 0 ) {
+	if ( DeVAS_radiance_scanlines_read ( &scanlines,
+		    radiance_scanline ) < 0 ) {
 	    fprintf ( stderr,
 	  "DeVAS_luminance_image_from_radfile: error reading Radiance file!" );
 	    exit ( EXIT_FAILURE );
@@ -279,6 +288,7 @@ DeVAS_luminance_image_from_radfile ( FILE *radiance_fp )
     }
 
     free ( radiance_scanline );
+    DeVAS_radiance_scanlines_end ( &scanlines );
 
     return ( luminance );
 }
@@ -406,7 +416,6 @@ DeVAS_RGBf_image_from_radfile ( FILE *radiance_fp )
 {
     DeVAS_RGBf_image	*RGBf;
     COLOR		*radiance_scanline;
-    COLOR		RGBf_rad_pixel;
     RadianceColorFormat	color_format;
     VIEW		view;
     int			exposure_set;
@@ -414,9 +423,12 @@ DeVAS_RGBf_image_from_radfile ( FILE *radiance_fp )
     int			row, col;
     int			n_rows, n_cols;
     char		*description;
+    DeVAS_Radiance_Scanlines scanlines;
 
     DeVAS_read_radiance_header ( radiance_fp, &n_rows, &n_cols,
 	    &color_format, &view, &exposure_set, &exposure, &description );
+    DeVAS_radiance_scanlines_start ( &scanlines, radiance_fp, n_rows,
+	    n_cols );
 
     radiance_scanline = (COLOR *) malloc ( n_cols * sizeof ( COLOR ) );
     if ( radiance_scanline == NULL ) {
@@ -431,7 +443,8 @@ DeVAS_RGBf_image_from_radfile ( FILE *radiance_fp )
     DeVAS_image_exposure ( RGBf ) = exposure;
 
     for ( row = 0; row < n_rows; row++ ) {
-	if ( freadscan( radiance_scanline, n_cols, radiance_fp ) < 0 ) {
+	if ( DeVAS_radiance_scanlines_read ( &scanlines,
+		    radiance_scanline ) < 0 ) {
 	    fprintf ( stderr,
 		"DeVAS_RGBf_image_from_radfile: error reading Radiance file!" );
 	    exit ( EXIT_FAILURE );
@@ -446,16 +459,8 @@ DeVAS_RGBf_image_from_radfile ( FILE *radiance_fp )
 		    		colval ( radiance_scanline[col], BLU );
 	    }
 	} else if ( color_format == radcolor_xyze ) {
-	    for ( col = 0; col < n_cols; col++ ) {
-		colortrans ( RGBf_rad_pixel, xyz2rgbmat,
-			radiance_scanline[col] );
-		DeVAS_image_data ( RGBf, row, col ) . red =
-		    colval ( RGBf_rad_pixel, RED ) / DeVAS_WHTEFFICACY;
-		DeVAS_image_data ( RGBf, row, col ) . green =
-		    colval ( RGBf_rad_pixel, GRN ) / DeVAS_WHTEFFICACY;
-		DeVAS_image_data ( RGBf, row, col ) . blue =
-		    colval ( RGBf_rad_pixel, BLU ) / DeVAS_WHTEFFICACY;
-	    }
+	    DeVAS_XYZ_row_to_RGBf ( (DeVAS_XYZ *) radiance_scanline,
+		    RGBf->data[row], n_cols );
 	} else {
 	    fprintf ( stderr,
 		    "DeVAS_RGBf_image_from_radfile: internal error!\n" );
@@ -464,6 +469,7 @@ DeVAS_RGBf_image_from_radfile ( FILE *radiance_fp )
     }
 
     free ( radiance_scanline );
+    DeVAS_radiance_scanlines_end ( &scanlines );
 
     return ( RGBf );
 }
@@ -576,7 +582,6 @@ DeVAS_XYZ_image_from_radfile ( FILE *radiance_fp )
 {
     DeVAS_XYZ_image	*XYZ;
     COLOR		*radiance_scanline;
-    COLOR		XYZ_rad_pixel;
     RadianceColorFormat	color_format;
     VIEW		view;
     int			exposure_set;
@@ -584,9 +589,12 @@ DeVAS_XYZ_image_from_radfile ( FILE *radiance_fp )
     int			row, col;
     int			n_rows, n_cols;
     char		*description;
+    DeVAS_Radiance_Scanlines scanlines;
 
     DeVAS_read_radiance_header ( radiance_fp, &n_rows, &n_cols,
 	    &color_format, &view, &exposure_set, &exposure, &description );
+    DeVAS_radiance_scanlines_start ( &scanlines, radiance_fp, n_rows,
+	    n_cols );
 
     SET_FILE_BINARY ( radiance_fp );	/* only affects Windows systems */
 
@@ -603,22 +611,15 @@ DeVAS_XYZ_image_from_radfile ( FILE *radiance_fp )
     DeVAS_image_exposure ( XYZ ) = exposure;
 
     for ( row = 0; row < n_rows; row++ ) {
-	if ( freadscan( radiance_scanline, n_cols, radiance_fp ) < 0 ) {
+	if ( DeVAS_radiance_scanlines_read ( &scanlines,
+		    radiance_scanline ) < 0 ) {
 	    fprintf ( stderr,
 		"DeVAS_XYZ_image_from_radfile: error reading Radiance file!" );
 	    exit ( EXIT_FAILURE );
 	}
 	if ( color_format == radcolor_rgbe ) {
-	    for ( col = 0; col < n_cols; col++ ) {
-		colortrans ( XYZ_rad_pixel, rgb2xyzmat,
-			radiance_scanline[col] );
-		DeVAS_image_data ( XYZ, row, col ) . X =
-		    colval ( XYZ_rad_pixel, CIEX ) * DeVAS_WHTEFFICACY;
-		DeVAS_image_data ( XYZ, row, col ) . Y =
-		    colval ( XYZ_rad_pixel, CIEY ) * DeVAS_WHTEFFICACY;
-		DeVAS_image_data ( XYZ, row, col ) . Z =
-		    colval ( XYZ_rad_pixel, CIEZ ) * DeVAS_WHTEFFICACY;
-	    }
+	    DeVAS_RGBf_row_to_XYZ ( (DeVAS_RGBf *) radiance_scanline,
+		    XYZ->data[row], n_cols );
 	} else if ( color_format == radcolor_xyze ) {
 	    for ( col = 0; col < n_cols; col++ ) {
 		DeVAS_image_data ( XYZ, row, col ) . X =
@@ -636,6 +637,7 @@ DeVAS_XYZ_image_from_radfile ( FILE *radiance_fp )
     }
 
     free ( radiance_scanline );
+    DeVAS_radiance_scanlines_end ( &scanlines );
 
     return ( XYZ );
 }
@@ -757,18 +759,19 @@ DeVAS_xyY_image_from_radfile ( FILE *radiance_fp )
 {
     DeVAS_xyY_image	*xyY;
     COLOR		*radiance_scanline;
-    COLOR		XYZ_rad_pixel;
-    DeVAS_XYZ		XYZ_DeVAS_pixel;
     RadianceColorFormat	color_format;
     VIEW		view;
     int			exposure_set;
     double		exposure;
-    int			row, col;
+    int			row;
     int			n_rows, n_cols;
     char		*description;
+    DeVAS_Radiance_Scanlines scanlines;
 
     DeVAS_read_radiance_header ( radiance_fp, &n_rows, &n_cols,
 	    &color_format, &view, &exposure_set, &exposure, &description );
+    DeVAS_radiance_scanlines_start ( &scanlines, radiance_fp, n_rows,
+	    n_cols );
 
     radiance_scanline = (COLOR *) malloc ( n_cols * sizeof ( COLOR ) );
     if ( radiance_scanline == NULL ) {
@@ -783,38 +786,18 @@ DeVAS_xyY_image_from_radfile ( FILE *radiance_fp )
     DeVAS_image_exposure ( xyY ) = exposure;
 
     for ( row = 0; row < n_rows; row++ ) {
-	if ( freadscan( radiance_scanline, n_cols, radiance_fp ) < 0 ) {
+	if ( DeVAS_radiance_scanlines_read ( &scanlines,
+		    radiance_scanline ) < 0 ) {
 	    fprintf ( stderr,
 		"DeVAS_xyY_image_from_radfile: error reading Radiance file!" );
 	    exit ( EXIT_FAILURE );
 	}
 	if ( color_format == radcolor_rgbe ) {
-	    for ( col = 0; col < n_cols; col++ ) {
-		colortrans ( XYZ_rad_pixel, rgb2xyzmat,
-			radiance_scanline[col] );
-
-		XYZ_DeVAS_pixel.X =
-		    colval ( XYZ_rad_pixel, CIEX ) * DeVAS_WHTEFFICACY;
-		XYZ_DeVAS_pixel.Y =
-		    colval ( XYZ_rad_pixel, CIEY ) * DeVAS_WHTEFFICACY;
-		XYZ_DeVAS_pixel.Z =
-		    colval ( XYZ_rad_pixel, CIEZ ) * DeVAS_WHTEFFICACY;
-
-		DeVAS_image_data ( xyY, row, col ) =
-		    DeVAS_XYZ2xyY ( XYZ_DeVAS_pixel );
-	    }
+	    DeVAS_RGBf_row_to_xyY ( (DeVAS_RGBf *) radiance_scanline,
+		    xyY->data[row], n_cols );
 	} else if ( color_format == radcolor_xyze ) {
-	    for ( col = 0; col < n_cols; col++ ) {
-		XYZ_DeVAS_pixel.X =
-		    colval ( radiance_scanline[col], CIEX );
-		XYZ_DeVAS_pixel.Y =
-		    colval ( radiance_scanline[col], CIEY );
-		XYZ_DeVAS_pixel.Z =
-		    colval ( radiance_scanline[col], CIEZ );
-
-		DeVAS_image_data ( xyY, row, col ) =
-		    DeVAS_XYZ2xyY ( XYZ_DeVAS_pixel );
-	    }
+	    DeVAS_XYZ_row_to_xyY ( (DeVAS_XYZ *) radiance_scanline,
+		    xyY->data[row], n_cols );
 	} else {
 	    fprintf ( stderr,
 		    "DeVAS_XYZ_image_from_radfile: internal error!\n" );
@@ -823,6 +806,7 @@ DeVAS_xyY_image_from_radfile ( FILE *radiance_fp )
     }
 
     free ( radiance_scanline );
+    DeVAS_radiance_scanlines_end ( &scanlines );
 
     return ( xyY );
 }
@@ -860,7 +844,6 @@ DeVAS_xyY_image_to_radfile ( FILE *radiance_fp, DeVAS_xyY_image *xyY )
     int			exposure_set;
     double		exposure;
     char		*description;
-    DeVAS_XYZ		XYZ_DeVAS_pixel;
     COLOR		XYZ_rad_pixel;
     COLOR		*radiance_scanline;
 
@@ -886,15 +869,15 @@ DeVAS_xyY_image_to_radfile ( FILE *radiance_fp, DeVAS_xyY_image *xyY )
     }
 
     for ( row = 0; row < n_rows; row++ ) {
+	DeVAS_xyY_row_to_XYZ ( xyY->data[row],
+		(DeVAS_XYZ *) radiance_scanline, n_cols );
 	for ( col = 0; col < n_cols; col++ ) {
-	    XYZ_DeVAS_pixel =
-		DeVAS_xyY2XYZ ( DeVAS_image_data ( xyY, row,col ) );
 	    colval ( XYZ_rad_pixel, CIEX ) =
-		XYZ_DeVAS_pixel.X / DeVAS_WHTEFFICACY;
+		colval ( radiance_scanline[col], CIEX ) / DeVAS_WHTEFFICACY;
 	    colval ( XYZ_rad_pixel, CIEY ) =
-		XYZ_DeVAS_pixel.Y / DeVAS_WHTEFFICACY;
+		colval ( radiance_scanline[col], CIEY ) / DeVAS_WHTEFFICACY;
 	    colval ( XYZ_rad_pixel, CIEZ ) =
-		XYZ_DeVAS_pixel.Z / DeVAS_WHTEFFICACY;
+		colval ( radiance_scanline[col], CIEZ ) / DeVAS_WHTEFFICACY;
 
 	    colortrans ( radiance_scanline[col], xyz2rgbmat, XYZ_rad_pixel );
 	}
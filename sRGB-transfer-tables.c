@@ -0,0 +1,281 @@
+/*
+ * Generated by sRGB-transfer.c with DeVAS_SRGB_MAKE_TABLES defined.  Don't edit.
+ */
+
+const float DeVAS_sRGB_decode_table[256] = {
+    0x0p+0, 0x1.3e4568p-12, 0x1.3e4568p-11, 0x1.dd681cp-11,
+    0x1.3e4568p-10, 0x1.8dd6c2p-10, 0x1.dd681cp-10, 0x1.167cbap-9,
+    0x1.3e4568p-9, 0x1.660e16p-9, 0x1.8dd6c2p-9, 0x1.b6a31cp-9,
+    0x1.e1e31ep-9, 0x1.07c38cp-8, 0x1.1fcc2cp-8, 0x1.390ffcp-8,
+    0x1.53936ep-8, 0x1.6f5aep-8, 0x1.8c6a96p-8, 0x1.aac6c2p-8,
+    0x1.ca7384p-8, 0x1.eb74e2p-8, 0x1.06e76cp-7, 0x1.18c2a6p-7,
+    0x1.2b4e0ap-7, 0x1.3e8b7cp-7, 0x1.527cd6p-7, 0x1.6723fp-7,
+    0x1.7c8292p-7, 0x1.929a8ap-7, 0x1.a96d92p-7, 0x1.c0fd68p-7,
+    0x1.d94bcp-7, 0x1.f25a48p-7, 0x1.061552p-6, 0x1.135f4p-6,
+    0x1.210bbap-6, 0x1.2f1b8ep-6, 0x1.3d8f86p-6, 0x1.4c6868p-6,
+    0x1.5ba6fcp-6, 0x1.6b4c04p-6, 0x1.7b5844p-6, 0x1.8bcc76p-6,
+    0x1.9ca95ap-6, 0x1.adefaap-6, 0x1.bfa022p-6, 0x1.d1bb74p-6,
+    0x1.e4425ap-6, 0x1.f73586p-6, 0x1.054ad4p-5, 0x1.0f31bap-5,
+    0x1.194fccp-5, 0x1.23a55ep-5, 0x1.2e32cap-5, 0x1.38f86p-5,
+    0x1.43f678p-5, 0x1.4f2d64p-5, 0x1.5a9d76p-5, 0x1.664702p-5,
+    0x1.722a56p-5, 0x1.7e47c8p-5, 0x1.8a9fa4p-5, 0x1.97323ap-5,
+    0x1.a3ffdcp-5, 0x1.b108d2p-5, 0x1.be4d6ep-5, 0x1.cbcdfcp-5,
+    0x1.d98acap-5, 0x1.e7842p-5, 0x1.f5ba4cp-5, 0x1.0216ccp-4,
+    0x1.096f28p-4, 0x1.10e65ep-4, 0x1.187c92p-4, 0x1.2031eap-4,
+    0x1.280688p-4, 0x1.2ffa92p-4, 0x1.380e2cp-4, 0x1.404176p-4,
+    0x1.489496p-4, 0x1.5107aep-4, 0x1.599aep-4, 0x1.624e5p-4,
+    0x1.6b222p-4, 0x1.741672p-4, 0x1.7d2b66p-4, 0x1.86612p-4,
+    0x1.8fb7c2p-4, 0x1.992f6ap-4, 0x1.a2c83cp-4, 0x1.ac8258p-4,
+    0x1.b65ddcp-4, 0x1.c05aeep-4, 0x1.ca79aap-4, 0x1.d4ba32p-4,
+    0x1.df1ca4p-4, 0x1.e9a122p-4, 0x1.f447cap-4, 0x1.ff10bcp-4,
+    0x1.04fe0cp-3, 0x1.0a84fep-3, 0x1.101d44p-3, 0x1.15c6eep-3,
+    0x1.1b820ap-3, 0x1.214ea6p-3, 0x1.272cd4p-3, 0x1.2d1ca2p-3,
+    0x1.331e1ep-3, 0x1.39315ap-3, 0x1.3f566p-3, 0x1.458d42p-3,
+    0x1.4bd61p-3, 0x1.5230d4p-3, 0x1.589dap-3, 0x1.5f1c84p-3,
+    0x1.65ad8ap-3, 0x1.6c50c4p-3, 0x1.73063ep-3, 0x1.79ce06p-3,
+    0x1.80a82ep-3, 0x1.8794cp-3, 0x1.8e93ccp-3, 0x1.95a55ep-3,
+    0x1.9cc986p-3, 0x1.a40052p-3, 0x1.ab49cep-3, 0x1.b2a60ap-3,
+    0x1.ba1516p-3, 0x1.c196f8p-3, 0x1.c92bcp-3, 0x1.d0d38p-3,
+    0x1.d88e4p-3, 0x1.e05c12p-3, 0x1.e83dp-3, 0x1.f0311ap-3,
+    0x1.f8386ap-3, 0x1.00298p-2, 0x1.044074p-2, 0x1.086118p-2,
+    0x1.0c8b72p-2, 0x1.10bf88p-2, 0x1.14fd62p-2, 0x1.194504p-2,
+    0x1.1d9678p-2, 0x1.21f1cp-2, 0x1.2656e6p-2, 0x1.2ac5eep-2,
+    0x1.2f3eep-2, 0x1.33c1c2p-2, 0x1.384e9ap-2, 0x1.3ce56ep-2,
+    0x1.418644p-2, 0x1.463122p-2, 0x1.4ae61p-2, 0x1.4fa512p-2,
+    0x1.546e2ep-2, 0x1.59416ep-2, 0x1.5e1ed2p-2, 0x1.630666p-2,
+    0x1.67f82cp-2, 0x1.6cf42ap-2, 0x1.71fa6ap-2, 0x1.770aeep-2,
+    0x1.7c25bcp-2, 0x1.814adep-2, 0x1.867a56p-2, 0x1.8bb42ap-2,
+    0x1.90f862p-2, 0x1.964702p-2, 0x1.9ba012p-2, 0x1.a10396p-2,
+    0x1.a67194p-2, 0x1.abea12p-2, 0x1.b16d16p-2, 0x1.b6faa6p-2,
+    0x1.bc92c8p-2, 0x1.c2358p-2, 0x1.c7e2d4p-2, 0x1.cd9accp-2,
+    0x1.d35d6ap-2, 0x1.d92ab8p-2, 0x1.df02b8p-2, 0x1.e4e572p-2,
+    0x1.ead2eap-2, 0x1.f0cb26p-2, 0x1.f6ce2ep-2, 0x1.fcdc02p-2,
+    0x1.017a56p-1, 0x1.048c18p-1, 0x1.07a34ap-1, 0x1.0abffp-1,
+    0x1.0de20ap-1, 0x1.11099cp-1, 0x1.1436a8p-1, 0x1.176934p-1,
+    0x1.1aa13ep-1, 0x1.1ddeccp-1, 0x1.2121dep-1, 0x1.246a7ap-1,
+    0x1.27b8ap-1, 0x1.2b0c54p-1, 0x1.2e6598p-1, 0x1.31c47p-1,
+    0x1.3528dcp-1, 0x1.3892ep-1, 0x1.3c028p-1, 0x1.3f77bep-1,
+    0x1.42f29ap-1, 0x1.46731ap-1, 0x1.49f93ep-1, 0x1.4d850ap-1,
+    0x1.511682p-1, 0x1.54ada6p-1, 0x1.584a78p-1, 0x1.5becfep-1,
+    0x1.5f9538p-1, 0x1.63432ap-1, 0x1.66f6d4p-1, 0x1.6ab03cp-1,
+    0x1.6e6f62p-1, 0x1.723448p-1, 0x1.75fef4p-1, 0x1.79cf66p-1,
+    0x1.7da5ap-1, 0x1.8181a4p-1, 0x1.856378p-1, 0x1.894b1cp-1,
+    0x1.8d3892p-1, 0x1.912bdep-1, 0x1.952502p-1, 0x1.9923fep-1,
+    0x1.9d28dap-1, 0x1.a13392p-1, 0x1.a5442cp-1, 0x1.a95aacp-1,
+    0x1.ad771p-1, 0x1.b1995ep-1, 0x1.b5c198p-1, 0x1.b9efbep-1,
+    0x1.be23d4p-1, 0x1.c25ddep-1, 0x1.c69ddcp-1, 0x1.cae3d2p-1,
+    0x1.cf2fcp-1, 0x1.d381aap-1, 0x1.d7d994p-1, 0x1.dc377ep-1,
+    0x1.e09b6ap-1, 0x1.e5055cp-1, 0x1.e97556p-1, 0x1.edeb5cp-1,
+    0x1.f2676cp-1, 0x1.f6e98cp-1, 0x1.fb71bcp-1, 0x1p+0
+};
+
+/* smallest value encoded as each 8 bit value */
+static const float DeVAS_sRGB_thresholds[257] = {
+    0x0p+0, 0x1.3e4568p-13, 0x1.dd681cp-12, 0x1.8dd6c2p-11,
+    0x1.167cbcp-10, 0x1.660e16p-10, 0x1.b59f6ep-10, 0x1.029864p-9,
+    0x1.2a6112p-9, 0x1.5229bep-9, 0x1.79f26cp-9, 0x1.a1e59cp-9,
+    0x1.cbf734p-9, 0x1.f86802p-9, 0x1.13a0bcp-8, 0x1.2c4662p-8,
+    0x1.462978p-8, 0x1.614e5ep-8, 0x1.7db96ap-8, 0x1.9b6ed8p-8,
+    0x1.ba72ccp-8, 0x1.dac95cp-8, 0x1.fc7688p-8, 0x1.0fbf2p-7,
+    0x1.21f232p-7, 0x1.34d66p-7, 0x1.486d8ap-7, 0x1.5cb98ep-7,
+    0x1.71bc32p-7, 0x1.877746p-7, 0x1.9dec8cp-7, 0x1.b51dc4p-7,
+    0x1.cd0ca2p-7, 0x1.e5baep-7, 0x1.ff2a1cp-7, 0x1.0cae02p-6,
+    0x1.1a291cp-6, 0x1.280728p-6, 0x1.3648f4p-6, 0x1.44ef48p-6,
+    0x1.53faeep-6, 0x1.636ca4p-6, 0x1.73452ep-6, 0x1.83854ep-6,
+    0x1.942dc2p-6, 0x1.a53f44p-6, 0x1.b6ba9p-6, 0x1.c8a062p-6,
+    0x1.daf168p-6, 0x1.edae5ap-6, 0x1.006bf6p-5, 0x1.0a3766p-5,
+    0x1.1439d6p-5, 0x1.1e739ep-5, 0x1.28e51p-5, 0x1.338e8ap-5,
+    0x1.3e7056p-5, 0x1.498acep-5, 0x1.54de42p-5, 0x1.606b06p-5,
+    0x1.6c316cp-5, 0x1.7831c4p-5, 0x1.846c6p-5, 0x1.90e19p-5,
+    0x1.9d91ap-5, 0x1.aa7cep-5, 0x1.b7a3a6p-5, 0x1.c50632p-5,
+    0x1.d2a4d4p-5, 0x1.e07fdcp-5, 0x1.ee9794p-5, 0x1.fcec46p-5,
+    0x1.05bf2p-4, 0x1.0d26e4p-4, 0x1.14ad94p-4, 0x1.1c5354p-4,
+    0x1.24184cp-4, 0x1.2bfc9ap-4, 0x1.340068p-4, 0x1.3c23d4p-4,
+    0x1.446704p-4, 0x1.4cca1cp-4, 0x1.554d4p-4, 0x1.5df08ep-4,
+    0x1.66b42ap-4, 0x1.6f9836p-4, 0x1.789cd4p-4, 0x1.81c226p-4,
+    0x1.8b085p-4, 0x1.946f7p-4, 0x1.9df7a8p-4, 0x1.a7a11ap-4,
+    0x1.b16be6p-4, 0x1.bb582ep-4, 0x1.c5661p-4, 0x1.cf95acp-4,
+    0x1.d9e726p-4, 0x1.e45a9ep-4, 0x1.eef02ep-4, 0x1.f9a7f6p-4,
+    0x1.02410ep-3, 0x1.07bf5cp-3, 0x1.0d4ef6p-3, 0x1.12efeap-3,
+    0x1.18a24cp-3, 0x1.1e6626p-3, 0x1.243b88p-3, 0x1.2a2284p-3,
+    0x1.301b28p-3, 0x1.36258p-3, 0x1.3c41ap-3, 0x1.426f92p-3,
+    0x1.48af6ap-3, 0x1.4f0132p-3, 0x1.5564f8p-3, 0x1.5bdacep-3,
+    0x1.6262cp-3, 0x1.68fcdep-3, 0x1.6fa936p-3, 0x1.7667d6p-3,
+    0x1.7d38ccp-3, 0x1.841c28p-3, 0x1.8b11f4p-3, 0x1.921a42p-3,
+    0x1.99351ep-3, 0x1.a06296p-3, 0x1.a7a2b8p-3, 0x1.aef592p-3,
+    0x1.b65b32p-3, 0x1.bdd3acp-3, 0x1.c55fp-3, 0x1.ccfd42p-3,
+    0x1.d4ae8p-3, 0x1.dc72c6p-3, 0x1.e44a24p-3, 0x1.ec34a6p-3,
+    0x1.f4325ap-3, 0x1.fc434cp-3, 0x1.0233c4p-2, 0x1.064f9p-2,
+    0x1.0a750ep-2, 0x1.0ea444p-2, 0x1.12dd3cp-2, 0x1.171ff8p-2,
+    0x1.1b6c82p-2, 0x1.1fc2ep-2, 0x1.242316p-2, 0x1.288d2cp-2,
+    0x1.2d0128p-2, 0x1.317f12p-2, 0x1.3606f2p-2, 0x1.3a98c6p-2,
+    0x1.3f349ap-2, 0x1.43da74p-2, 0x1.488a58p-2, 0x1.4d445p-2,
+    0x1.52085ep-2, 0x1.56d68cp-2, 0x1.5baedcp-2, 0x1.609158p-2,
+    0x1.657e02p-2, 0x1.6a74e4p-2, 0x1.6f7602p-2, 0x1.748164p-2,
+    0x1.79970cp-2, 0x1.7eb704p-2, 0x1.83e14ep-2, 0x1.8915f4p-2,
+    0x1.8e54fap-2, 0x1.939e64p-2, 0x1.98f23cp-2, 0x1.9e5084p-2,
+    0x1.a3b944p-2, 0x1.a92c82p-2, 0x1.aeaa42p-2, 0x1.b4328ap-2,
+    0x1.b9c562p-2, 0x1.bf62cep-2, 0x1.c50ad4p-2, 0x1.cabd78p-2,
+    0x1.d07ac4p-2, 0x1.d642bep-2, 0x1.dc1564p-2, 0x1.e1f2c2p-2,
+    0x1.e7dadap-2, 0x1.edcdb2p-2, 0x1.f3cb52p-2, 0x1.f9d3cp-2,
+    0x1.ffe6fep-2, 0x1.03028ap-1, 0x1.061704p-1, 0x1.0930fp-1,
+    0x1.0c504ep-1, 0x1.0f7524p-1, 0x1.129f74p-1, 0x1.15cf3ep-1,
+    0x1.190488p-1, 0x1.1c3f54p-1, 0x1.1f7fa4p-1, 0x1.22c57cp-1,
+    0x1.2610dcp-1, 0x1.2961c8p-1, 0x1.2cb844p-1, 0x1.301452p-1,
+    0x1.3375f2p-1, 0x1.36dd2ap-1, 0x1.3a49fcp-1, 0x1.3dbc6ap-1,
+    0x1.413476p-1, 0x1.44b224p-1, 0x1.483576p-1, 0x1.4bbe72p-1,
+    0x1.4f4d14p-1, 0x1.52e16p-1, 0x1.567b5cp-1, 0x1.5a1b08p-1,
+    0x1.5dc066p-1, 0x1.616b7cp-1, 0x1.651c4ap-1, 0x1.68d2d2p-1,
+    0x1.6c8f18p-1, 0x1.70511ep-1, 0x1.7418e6p-1, 0x1.77e674p-1,
+    0x1.7bb9cap-1, 0x1.7f92eap-1, 0x1.8371d6p-1, 0x1.87569p-1,
+    0x1.8b411ep-1, 0x1.8f317ep-1, 0x1.9327b4p-1, 0x1.9723c4p-1,
+    0x1.9b25bp-1, 0x1.9f2d7ap-1, 0x1.a33b22p-1, 0x1.a74ebp-1,
+    0x1.ab682p-1, 0x1.af877ap-1, 0x1.b3acbcp-1, 0x1.b7d7ecp-1,
+    0x1.bc090ap-1, 0x1.c0401ep-1, 0x1.c47d22p-1, 0x1.c8c01ap-1,
+    0x1.cd090cp-1, 0x1.d157f8p-1, 0x1.d5ace2p-1, 0x1.da07cap-1,
+    0x1.de68b6p-1, 0x1.e2cfa4p-1, 0x1.e73c9ap-1, 0x1.ebaf9ap-1,
+    0x1.f028a4p-1, 0x1.f4a7bap-1, 0x1.f92ce2p-1, 0x1.fdb81cp-1,
+    HUGE_VALF
+};
+
+#define	DeVAS_SRGB_ENCODE_FIRST	0x391f
+
+/* encoding of the smallest value in each bucket */
+static const uint8_t DeVAS_sRGB_encode_table[1632] = {
+      0,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,   2,
+      2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,
+      2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,
+      2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,
+      2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,
+      2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,
+      2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,
+      2,   2,   2,   2,   2,   2,   2,   2,   3,   3,   3,   3,
+      3,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3,
+      3,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3,
+      3,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3,
+      3,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3,
+      3,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3,
+      3,   3,   3,   3,   3,   4,   4,   4,   4,   4,   4,   4,
+      4,   4,   4,   4,   4,   4,   4,   4,   4,   4,   4,   4,
+      4,   4,   4,   4,   4,   4,   4,   4,   4,   4,   4,   4,
+      4,   4,   4,   4,   4,   4,   4,   4,   4,   5,   5,   5,
+      5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,
+      5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,
+      5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,
+      6,   6,   6,   6,   6,   6,   6,   6,   6,   6,   6,   6,
+      6,   6,   6,   6,   6,   6,   6,   6,   6,   6,   6,   6,
+      6,   6,   6,   6,   6,   6,   6,   6,   6,   6,   6,   6,
+      6,   6,   6,   7,   7,   7,   7,   7,   7,   7,   7,   7,
+      7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   8,
+      8,   8,   8,   8,   8,   8,   8,   8,   8,   8,   8,   8,
+      8,   8,   8,   8,   8,   8,   8,   9,   9,   9,   9,   9,
+      9,   9,   9,   9,   9,   9,   9,   9,   9,   9,   9,   9,
+      9,   9,  10,  10,  10,  10,  10,  10,  10,  10,  10,  10,
+     10,  10,  10,  10,  10,  10,  10,  10,  10,  10,  11,  11,
+     11,  11,  11,  11,  11,  11,  11,  11,  11,  11,  11,  11,
+     11,  11,  11,  11,  11,  11,  11,  12,  12,  12,  12,  12,
+     12,  12,  12,  12,  12,  12,  12,  12,  12,  12,  12,  12,
+     12,  12,  12,  12,  12,  12,  13,  13,  13,  13,  13,  13,
+     13,  13,  13,  13,  13,  13,  13,  14,  14,  14,  14,  14,
+     14,  14,  14,  14,  14,  14,  14,  14,  15,  15,  15,  15,
+     15,  15,  15,  15,  15,  15,  15,  15,  15,  16,  16,  16,
+     16,  16,  16,  16,  16,  16,  16,  16,  16,  16,  17,  17,
+     17,  17,  17,  17,  17,  17,  17,  17,  17,  17,  17,  17,
+     18,  18,  18,  18,  18,  18,  18,  18,  18,  18,  18,  18,
+     18,  18,  18,  19,  19,  19,  19,  19,  19,  19,  19,  19,
+     19,  19,  19,  19,  19,  19,  19,  20,  20,  20,  20,  20,
+     20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  21,
+     21,  21,  21,  21,  21,  21,  21,  21,  21,  21,  21,  21,
+     21,  21,  21,  21,  22,  22,  22,  22,  22,  22,  22,  22,
+     22,  23,  23,  23,  23,  23,  23,  23,  23,  23,  24,  24,
+     24,  24,  24,  24,  24,  24,  24,  24,  25,  25,  25,  25,
+     25,  25,  25,  25,  25,  25,  26,  26,  26,  26,  26,  26,
+     26,  26,  26,  26,  27,  27,  27,  27,  27,  27,  27,  27,
+     27,  27,  28,  28,  28,  28,  28,  28,  28,  28,  28,  28,
+     28,  29,  29,  29,  29,  29,  29,  29,  29,  29,  29,  29,
+     30,  30,  30,  30,  30,  30,  30,  30,  30,  30,  30,  30,
+     31,  31,  31,  31,  31,  31,  31,  31,  31,  31,  31,  31,
+     32,  32,  32,  32,  32,  32,  32,  32,  32,  32,  32,  32,
+     33,  33,  33,  33,  33,  33,  33,  33,  33,  33,  33,  33,
+     33,  34,  34,  34,  34,  34,  34,  34,  35,  35,  35,  35,
+     35,  35,  35,  36,  36,  36,  36,  36,  36,  36,  37,  37,
+     37,  37,  37,  37,  37,  38,  38,  38,  38,  38,  38,  38,
+     39,  39,  39,  39,  39,  39,  39,  40,  40,  40,  40,  40,
+     40,  40,  40,  41,  41,  41,  41,  41,  41,  41,  41,  42,
+     42,  42,  42,  42,  42,  42,  42,  43,  43,  43,  43,  43,
+     43,  43,  43,  43,  44,  44,  44,  44,  44,  44,  44,  44,
+     45,  45,  45,  45,  45,  45,  45,  45,  45,  46,  46,  46,
+     46,  46,  46,  46,  46,  46,  47,  47,  47,  47,  47,  47,
+     47,  47,  47,  48,  48,  48,  48,  48,  48,  48,  48,  48,
+     49,  49,  49,  49,  49,  49,  49,  49,  49,  49,  50,  50,
+     50,  50,  50,  51,  51,  51,  51,  51,  52,  52,  52,  52,
+     52,  53,  53,  53,  53,  53,  54,  54,  54,  54,  54,  55,
+     55,  55,  55,  55,  55,  56,  56,  56,  56,  56,  57,  57,
+     57,  57,  57,  57,  58,  58,  58,  58,  58,  58,  59,  59,
+     59,  59,  59,  59,  60,  60,  60,  60,  60,  60,  61,  61,
+     61,  61,  61,  61,  62,  62,  62,  62,  62,  62,  63,  63,
+     63,  63,  63,  63,  64,  64,  64,  64,  64,  64,  64,  65,
+     65,  65,  65,  65,  65,  66,  66,  66,  66,  66,  66,  66,
+     67,  67,  67,  67,  67,  67,  67,  68,  68,  68,  68,  68,
+     68,  68,  69,  69,  69,  69,  69,  69,  69,  70,  70,  70,
+     70,  70,  70,  70,  71,  71,  71,  71,  72,  72,  72,  72,
+     73,  73,  73,  73,  74,  74,  74,  74,  75,  75,  75,  75,
+     76,  76,  76,  77,  77,  77,  77,  77,  78,  78,  78,  78,
+     79,  79,  79,  79,  80,  80,  80,  80,  81,  81,  81,  81,
+     82,  82,  82,  82,  83,  83,  83,  83,  83,  84,  84,  84,
+     84,  85,  85,  85,  85,  85,  86,  86,  86,  86,  87,  87,
+     87,  87,  87,  88,  88,  88,  88,  88,  89,  89,  89,  89,
+     90,  90,  90,  90,  90,  91,  91,  91,  91,  91,  92,  92,
+     92,  92,  92,  93,  93,  93,  93,  93,  94,  94,  94,  94,
+     94,  95,  95,  95,  95,  95,  96,  96,  96,  96,  96,  96,
+     97,  97,  97,  97,  97,  98,  98,  98,  98,  98,  99,  99,
+     99,  99,  99, 100, 100, 101, 101, 101, 102, 102, 102, 103,
+    103, 103, 104, 104, 104, 105, 105, 105, 106, 106, 106, 107,
+    107, 107, 108, 108, 108, 109, 109, 109, 110, 110, 110, 111,
+    111, 111, 112, 112, 112, 113, 113, 113, 114, 114, 114, 115,
+    115, 115, 115, 116, 116, 116, 117, 117, 117, 118, 118, 118,
+    118, 119, 119, 119, 120, 120, 120, 120, 121, 121, 121, 122,
+    122, 122, 122, 123, 123, 123, 124, 124, 124, 124, 125, 125,
+    125, 126, 126, 126, 126, 127, 127, 127, 127, 128, 128, 128,
+    129, 129, 129, 129, 130, 130, 130, 130, 131, 131, 131, 131,
+    132, 132, 132, 132, 133, 133, 133, 133, 134, 134, 134, 134,
+    135, 135, 135, 135, 136, 136, 136, 136, 137, 137, 137, 138,
+    138, 139, 139, 140, 140, 141, 141, 142, 142, 143, 143, 144,
+    144, 145, 145, 145, 146, 146, 147, 147, 148, 148, 149, 149,
+    149, 150, 150, 151, 151, 152, 152, 153, 153, 153, 154, 154,
+    155, 155, 155, 156, 156, 157, 157, 158, 158, 158, 159, 159,
+    160, 160, 160, 161, 161, 162, 162, 162, 163, 163, 164, 164,
+    164, 165, 165, 166, 166, 166, 167, 167, 167, 168, 168, 169,
+    169, 169, 170, 170, 170, 171, 171, 172, 172, 172, 173, 173,
+    173, 174, 174, 174, 175, 175, 176, 176, 176, 177, 177, 177,
+    178, 178, 178, 179, 179, 179, 180, 180, 180, 181, 181, 181,
+    182, 182, 183, 183, 183, 184, 184, 184, 185, 185, 185, 186,
+    186, 186, 187, 187, 187, 188, 188, 189, 189, 190, 191, 191,
+    192, 193, 193, 194, 195, 195, 196, 196, 197, 198, 198, 199,
+    199, 200, 201, 201, 202, 202, 203, 204, 204, 205, 205, 206,
+    207, 207, 208, 208, 209, 209, 210, 211, 211, 212, 212, 213,
+    213, 214, 214, 215, 216, 216, 217, 217, 218, 218, 219, 219,
+    220, 220, 221, 221, 222, 223, 223, 224, 224, 225, 225, 226,
+    226, 227, 227, 228, 228, 229, 229, 230, 230, 231, 231, 232,
+    232, 233, 233, 234, 234, 235, 235, 236, 236, 237, 237, 238,
+    238, 239, 239, 239, 240, 240, 241, 241, 242, 242, 243, 243,
+    244, 244, 245, 245, 246, 246, 246, 247, 247, 248, 248, 249,
+    249, 250, 250, 251, 251, 251, 252, 252, 253, 253, 254, 254
+};
@@ -0,0 +1,258 @@
+/*
+ * Table-driven sRGB transfer functions.  See sRGB-transfer.h.
+ *
+ * Algorithm and conversion values taken from
+ * <http://en.wikipedia.org/wiki/SRGB>.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "sRGB-transfer.h"
+#include "devas-license.h"	/* DeVAS open source license */
+
+/*
+ * Bits of a float value dropped to index DeVAS_sRGB_encode_table (leaving
+ * the exponent and 7 bits of mantissa).
+ */
+#define	DeVAS_SRGB_ENCODE_SHIFT	16
+
+#if	defined(DeVAS_SRGB_MAKE_TABLES) || defined(DeVAS_SRGB_CHECK_TABLES)
+
+/*
+ * The direct computations, as they were in devas-sRGB.c, TT-sRGB.c, and
+ * sRGB.c before being replaced by table lookup.
+ */
+
+static float
+reference_decode ( uint8_t gray )
+{
+    float   CsRGBf;
+    float   Clinear;
+
+    CsRGBf = gray / 255.0;
+
+    if ( CsRGBf <= 0.04045 ) {
+	Clinear = CsRGBf / 12.92;
+    } else {
+	Clinear =  pow ( ( CsRGBf + 0.055 ) / ( 1.0 + 0.055 ), 2.4 );
+    }
+
+    return ( Clinear );
+}
+
+static uint8_t
+reference_encode ( float Y )
+{
+    float   float_value;
+
+    if ( isnan ( Y ) ) {
+	return ( 0 );	/* (int) round ( NaN ), as it comes out on x86 */
+    }
+
+    if ( Y < 0.0 ) {
+	Y = 0.0;
+    }
+
+    if ( Y > 1.0 ) {
+	Y = 1.0;
+    }
+
+    if ( Y <= 0.0031308 ) {
+	float_value = 12.92 * Y;
+    } else {
+	float_value = ( ( 1.0 + 0.055 ) * powf ( Y, 1.0 / 2.4 ) ) - 0.055;
+    }
+
+    return ( (int) round ( 255.0 * float_value ) );
+}
+
+static float
+float_from_bits ( uint32_t bits )
+{
+    float   value;
+
+    memcpy ( &value, &bits, sizeof ( value ) );
+
+    return ( value );
+}
+
+#ifdef	DeVAS_SRGB_MAKE_TABLES
+
+static uint32_t
+bits_from_float ( float value )
+{
+    uint32_t	bits;
+
+    memcpy ( &bits, &value, sizeof ( bits ) );
+
+    return ( bits );
+}
+
+static float
+find_threshold ( int gray )
+/*
+ * Smallest non-negative float that encodes to gray or higher.  Relies on
+ * reference_encode being non-decreasing, which DeVAS_SRGB_CHECK_TABLES
+ * verifies.
+ */
+{
+    uint32_t	low, high, middle;
+
+    low = 0;
+    high = bits_from_float ( 1.0 );
+    while ( low < high ) {
+	middle = low + ( ( high - low ) / 2 );
+	if ( reference_encode ( float_from_bits ( middle ) ) >= gray ) {
+	    high = middle;
+	} else {
+	    low = middle + 1;
+	}
+    }
+
+    return ( float_from_bits ( low ) );
+}
+
+static void
+make_tables ( void )
+{
+    int		gray;
+    float	thresholds[257];
+    uint32_t	first, last, bucket;
+
+    printf ( "/*\n * Generated by sRGB-transfer.c with DeVAS_SRGB_MAKE_TABLES "
+	    "defined.  Don't edit.\n */\n\n" );
+
+    printf ( "const float DeVAS_sRGB_decode_table[256] = {\n" );
+    for ( gray = 0; gray < 256; gray++ ) {
+	printf ( "%s%a%s", ( gray % 4 ) == 0 ? "    " : " ",
+		reference_decode ( gray ), gray == 255 ? "\n" :
+		( ( gray % 4 ) == 3 ? ",\n" : "," ) );
+    }
+    printf ( "};\n\n" );
+
+    thresholds[0] = 0.0;
+    for ( gray = 1; gray < 256; gray++ ) {
+	thresholds[gray] = find_threshold ( gray );
+    }
+    thresholds[256] = HUGE_VALF;	/* never reached */
+
+    printf ( "/* smallest value encoded as each 8 bit value */\n" );
+    printf ( "static const float DeVAS_sRGB_thresholds[257] = {\n" );
+    for ( gray = 0; gray < 257; gray++ ) {
+	if ( gray == 256 ) {
+	    printf ( "    HUGE_VALF\n" );
+	} else {
+	    printf ( "%s%a%s", ( gray % 4 ) == 0 ? "    " : " ",
+		    thresholds[gray], ( gray % 4 ) == 3 ? ",\n" : "," );
+	}
+    }
+    printf ( "};\n\n" );
+
+    first = bits_from_float ( thresholds[1] ) >> DeVAS_SRGB_ENCODE_SHIFT;
+    last = bits_from_float ( thresholds[255] ) >> DeVAS_SRGB_ENCODE_SHIFT;
+
+    printf ( "#define\tDeVAS_SRGB_ENCODE_FIRST\t0x%x\n\n", first );
+    printf ( "/* encoding of the smallest value in each bucket */\n" );
+    printf ( "static const uint8_t DeVAS_sRGB_encode_table[%u] = {\n",
+	    last - first + 1 );
+    for ( bucket = first; bucket <= last; bucket++ ) {
+	printf ( "%s%3d%s", ( ( bucket - first ) % 12 ) == 0 ? "    " : " ",
+		reference_encode ( float_from_bits ( bucket <<
+			DeVAS_SRGB_ENCODE_SHIFT ) ),
+		bucket == last ? "\n" :
+		( ( ( bucket - first ) % 12 ) == 11 ? ",\n" : "," ) );
+    }
+    printf ( "};\n" );
+}
+
+int
+main ( int argc, char *argv[] )
+{
+    make_tables ( );
+
+    return ( EXIT_SUCCESS );
+}
+
+#endif	/* DeVAS_SRGB_MAKE_TABLES */
+
+#endif	/* DeVAS_SRGB_MAKE_TABLES || DeVAS_SRGB_CHECK_TABLES */
+
+#ifndef	DeVAS_SRGB_MAKE_TABLES
+
+#include "sRGB-transfer-tables.c"	/* generated, see sRGB-transfer.h */
+
+uint8_t
+DeVAS_sRGB_encode ( float Y )
+/*
+ * Y >= 0 floats order the same way as their bit patterns, so the high
+ * order bits give a bucket of Y values, and DeVAS_sRGB_encode_table holds
+ * the encoding of the smallest value in each bucket.  Values further into
+ * the bucket may encode higher.
+ */
+{
+    uint32_t	bits;
+    int		gray;
+
+    if ( !( Y >= DeVAS_sRGB_thresholds[1] ) ) {	/* includes NaN */
+	return ( 0 );
+    }
+    if ( Y >= DeVAS_sRGB_thresholds[255] ) {
+	return ( 255 );
+    }
+
+    memcpy ( &bits, &Y, sizeof ( bits ) );
+    gray = DeVAS_sRGB_encode_table[( bits >> DeVAS_SRGB_ENCODE_SHIFT ) -
+	DeVAS_SRGB_ENCODE_FIRST];
+
+    while ( Y >= DeVAS_sRGB_thresholds[gray + 1] ) {
+	gray++;
+    }
+
+    return ( gray );
+}
+
+#endif	/* DeVAS_SRGB_MAKE_TABLES */
+
+#ifdef	DeVAS_SRGB_CHECK_TABLES
+
+int
+main ( int argc, char *argv[] )
+/*
+ * Compare the tables against the reference computations for every
+ * 8 bit value and every float.
+ */
+{
+    int		gray;
+    uint32_t	bits;
+    float	Y;
+    long	n_bad = 0;
+
+    for ( gray = 0; gray < 256; gray++ ) {
+	if ( DeVAS_sRGB_decode_table[gray] != reference_decode ( gray ) ) {
+	    fprintf ( stderr, "decode %d: %a, should be %a\n", gray,
+		    DeVAS_sRGB_decode_table[gray], reference_decode ( gray ) );
+	    n_bad++;
+	}
+    }
+
+    bits = 0;
+    do {
+	Y = float_from_bits ( bits );
+	if ( DeVAS_sRGB_encode ( Y ) != reference_encode ( Y ) ) {
+	    if ( n_bad < 20 ) {
+		fprintf ( stderr, "encode %a: %d, should be %d\n", Y,
+			DeVAS_sRGB_encode ( Y ), reference_encode ( Y ) );
+	    }
+	    n_bad++;
+	}
+	bits++;
+    } while ( bits != 0 );
+
+    fprintf ( stderr, "%ld mismatches\n", n_bad );
+
+    return ( n_bad == 0 ? EXIT_SUCCESS : EXIT_FAILURE );
+}
+
+#endif	/* DeVAS_SRGB_CHECK_TABLES */
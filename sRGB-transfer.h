@@ -0,0 +1,50 @@
+/*
+ * Table-driven sRGB transfer functions, shared by devas-sRGB.c, TT-sRGB.c,
+ * and sRGB.c.
+ *
+ *   DeVAS_sRGB_decode_table[<8 bit value>]
+ *
+ *	Linear value for an sRGB encoded 8 bit value.
+ *
+ *   DeVAS_sRGB_encode ( <float> )
+ *
+ *	sRGB encoded 8 bit value for a linear value, clipped to [0.0 -- 1.0]
+ *	(NaN encodes as 0).
+ *
+ * Both give exactly the same values as the direct computation with pow
+ * and powf that they replace, which is kept in sRGB-transfer.c as the
+ * reference used to generate the tables.  Encoding looks up a first guess
+ * indexed by the high-order bits of the float value and then corrects it
+ * by comparing against the exact 8 bit decision thresholds (at most a
+ * couple of comparisons).
+ *
+ * The tables are in sRGB-transfer-tables.c, which is generated by
+ * compiling sRGB-transfer.c with DeVAS_SRGB_MAKE_TABLES defined, and
+ * checked against the reference for every 8 bit value and every float by
+ * compiling it with DeVAS_SRGB_CHECK_TABLES defined:
+ *
+ *   cc -DDeVAS_SRGB_MAKE_TABLES -o make-tables sRGB-transfer.c -lm
+ *   ./make-tables > sRGB-transfer-tables.c
+ *   cc -O2 -DDeVAS_SRGB_CHECK_TABLES -o check-tables sRGB-transfer.c -lm
+ *   ./check-tables
+ */
+
+#ifndef __DeVAS_sRGB_TRANSFER_H
+#define __DeVAS_sRGB_TRANSFER_H
+
+#include <stdint.h>
+#include "devas-license.h"	/* DeVAS open source license */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern const float  DeVAS_sRGB_decode_table[256];
+
+uint8_t		    DeVAS_sRGB_encode ( float Y );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __DeVAS_sRGB_TRANSFER_H */
@@ -29,6 +29,7 @@
  ****************************************************************************/
 
 #include "tifftoolsimage.h"
+#include "devas-memory.h"
 
 #define TT_IMAGE_NEW( TYPE )						\
 TYPE##_image *								\
@@ -53,6 +54,8 @@ TYPE##_image_new ( unsigned int n_rows, unsigned int n_cols  )		\
 	fprintf ( stderr, "tttools_image_new: malloc failed!" );	\
         exit ( EXIT_FAILURE );						\
     }									\
+    DeVAS_memory_allocated ( #TYPE, ( (size_t) n_rows ) * n_cols *	\
+	    sizeof ( TYPE ) );						\
 									\
     line_pointers = (TYPE **) malloc ( n_rows * sizeof ( TYPE * ) );	\
     if ( line_pointers == NULL ) {					\
@@ -66,6 +69,10 @@ TYPE##_image_new ( unsigned int n_rows, unsigned int n_cols  )		\
 									\
     new_image->data = &line_pointers[0];				\
 									\
+    new_image->owner = NULL;						\
+    new_image->release = NULL;						\
+    new_image->stats = NULL;						\
+									\
     return ( new_image );						\
 }
 
@@ -82,7 +89,14 @@ TT_IMAGE_NEW ( TT_float )
 void									\
 TYPE##_image_delete ( TYPE##_image *image )				\
 {									\
-    free ( image->start_data );						\
+    if ( image->release != NULL ) {					\
+	( *image->release ) ( image->owner );				\
+    } else {								\
+	free ( image->start_data );					\
+	DeVAS_memory_freed ( #TYPE, ( (size_t) image->n_rows ) *	\
+		image->n_cols * sizeof ( TYPE ) );			\
+    }									\
+    free ( image->stats );						\
     free ( image->data );						\
     free ( image );							\
 }
@@ -39,6 +39,11 @@ typedef struct {							     \
     unsigned int    n_rows, n_cols;	/* order reversed from x,y! */	     \
     TYPE    	    *start_data;	/* start of allocated data block */  \
     TYPE    	    **data;		/* array of pointers to array rows */\
+    void	    *owner;		/* if not NULL, pixels belong to */  \
+    void	    (*release) ( void *owner );	/* owner, and delete */	     \
+    					/* calls release ( owner ) instead */\
+    					/* of freeing start_data */	     \
+    void	    *stats;		/* cached statistics, or NULL */     \
 } TYPE##_image;
 
 TT_DEFINE_IMAGE_TYPE ( TT_gray )